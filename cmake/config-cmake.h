@@ -54,6 +54,12 @@
 /* Define to 1 if you have the 'gettimeofday' function. */
 #cmakedefine HAVE_GETTIMEOFDAY 1
 
+/* Define to 1 if you have the 'setitimer' function. */
+#cmakedefine HAVE_SETITIMER 1
+
+/* Define to 1 if you have the 'getrusage' function. */
+#cmakedefine HAVE_GETRUSAGE 1
+
 /* Define to 1 if you have the 'nanosleep' function. */
 #cmakedefine HAVE_NANOSLEEP 1
 
@@ -66,6 +72,9 @@
 /* Define to 1 if you have the 'statvfs' function. */
 #cmakedefine HAVE_STATVFS 1
 
+/* Define to 1 if you have the 'posix_openpt' function. */
+#cmakedefine HAVE_POSIX_OPENPT 1
+
 
 /* Relative path from bindir to datadir */
 #define BIN2DATADIR "@BIN2DATADIR@"
@@ -205,6 +205,12 @@ enum
 };
 
 
+/* When the serial line is idle, each bit would only be a '1' stop bit. In that case */
+/* we only need to call the timer every ACIA_IDLE_BITS bits to remain on the same bit */
+/* clock, instead of calling it for each bit */
+#define	ACIA_IDLE_BITS		256
+
+
 ACIA_STRUCT		ACIA_Array[ ACIA_MAX_NB ];
 ACIA_STRUCT		*pACIA_IKBD;
 ACIA_STRUCT		*pACIA_MIDI;
@@ -222,9 +228,12 @@ static void		ACIA_Set_Line_IRQ_MFP ( int bit );
 static Uint8 		ACIA_Get_Line_CTS_Dummy ( void );
 static Uint8 		ACIA_Get_Line_DCD_Dummy ( void );
 static void		ACIA_Set_Line_RTS_Dummy ( int bit );
+static Uint8 		ACIA_Get_Peer_Idle_Dummy ( void );
 
 static void		ACIA_Set_Timers_IKBD ( void *pACIA );
-static void		ACIA_Start_InterruptHandler_IKBD ( ACIA_STRUCT *pACIA , int InternalCycleOffset );
+static int		ACIA_Get_Bit_Cycles ( ACIA_STRUCT *pACIA );
+static void		ACIA_Start_InterruptHandler_IKBD ( ACIA_STRUCT *pACIA , int InternalCycleOffset , int NbBits );
+static bool		ACIA_Line_Is_Idle ( ACIA_STRUCT *pACIA );
 
 static Uint8		ACIA_MasterReset ( ACIA_STRUCT *pACIA , Uint8 CR );
 
@@ -295,6 +304,7 @@ static void	ACIA_Init_Pointers ( ACIA_STRUCT *pAllACIA )
 		pAllACIA[ i ].Get_Line_CTS = ACIA_Get_Line_CTS_Dummy;
 		pAllACIA[ i ].Get_Line_DCD = ACIA_Get_Line_DCD_Dummy;
 		pAllACIA[ i ].Set_Line_RTS = ACIA_Set_Line_RTS_Dummy;
+		pAllACIA[ i ].Get_Peer_Idle = ACIA_Get_Peer_Idle_Dummy;
 	}
 
 	strcpy ( pAllACIA[ 0 ].ACIA_Name , "ikbd" );
@@ -417,6 +427,16 @@ static void	ACIA_Set_Line_RTS_Dummy ( int bit )
 	LOG_TRACE ( TRACE_ACIA, "acia set rts val=%d VBL=%d HBL=%d\n" , bit , nVBLs , nHBL );
 }
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Tell if the device connected to RX/TX has nothing to send or receive.
+ * Note : by default we don't know, so we always return 0 to clock each bit.
+ */
+static Uint8 	ACIA_Get_Peer_Idle_Dummy ( void )
+{
+	return 0;
+}
+
 
 
 
@@ -428,7 +448,7 @@ static void	ACIA_Set_Line_RTS_Dummy ( int bit )
  */
 static void	ACIA_Set_Timers_IKBD ( void *pACIA )
 {
-	ACIA_Start_InterruptHandler_IKBD ( (ACIA_STRUCT *)pACIA , 0 );
+	ACIA_Start_InterruptHandler_IKBD ( (ACIA_STRUCT *)pACIA , 0 , 1 );
 }
 
 
@@ -436,18 +456,16 @@ static void	ACIA_Set_Timers_IKBD ( void *pACIA )
 
 /*-----------------------------------------------------------------------*/
 /**
- * Set a timer to handle the RX / TX bits at the expected baud rate.
+ * Return the number of CPU cycles needed to send / receive one bit.
  * NOTE : on ST, TX_Clock and RX_Clock are the same, so the timer's freq will be
  * TX_Clock / Divider and we only need one timer interrupt to handle both RX and TX.
  * This freq should be converted to CPU_CYCLE : 1 ACIA cycle = 16 CPU cycles
  * (with cpu running at 8 MHz)
- * InternalCycleOffset allows to compensate for a != 0 value in PendingInterruptCount
- * to keep a constant baud rate.
  * TODO : we use a fixed 8 MHz clock and nCpuFreqShift to convert cycles for our
  * internal timers in cycInt.c. This should be replaced some days by using
  * MachineClocks.CPU_Freq and not using nCpuFreqShift anymore.
  */
-static void	ACIA_Start_InterruptHandler_IKBD ( ACIA_STRUCT *pACIA , int InternalCycleOffset )
+static int	ACIA_Get_Bit_Cycles ( ACIA_STRUCT *pACIA )
 {
 	int		Cycles;
 
@@ -457,8 +475,30 @@ static void	ACIA_Start_InterruptHandler_IKBD ( ACIA_STRUCT *pACIA , int Internal
 	Cycles *= pACIA->Clock_Divider;
 	Cycles <<= nCpuFreqShift;					/* Compensate for x2 or x4 cpu speed */
 
-	LOG_TRACE ( TRACE_ACIA, "acia %s start timer divider=%d cpu_cycles=%d VBL=%d HBL=%d\n" , pACIA->ACIA_Name ,
-		pACIA->Clock_Divider , Cycles , nVBLs , nHBL );
+	return Cycles;
+}
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Set a timer to handle the RX / TX bits at the expected baud rate.
+ * The timer will expire after NbBits bits ; NbBits > 1 is used when the
+ * serial line is idle (see ACIA_IKBD_Wakeup).
+ * InternalCycleOffset allows to compensate for a != 0 value in PendingInterruptCount
+ * to keep a constant baud rate.
+ */
+static void	ACIA_Start_InterruptHandler_IKBD ( ACIA_STRUCT *pACIA , int InternalCycleOffset , int NbBits )
+{
+	int		Cycles;
+
+
+	Cycles = ACIA_Get_Bit_Cycles ( pACIA ) * NbBits;
+	pACIA->Timer_Idle = ( NbBits > 1 );
+
+	LOG_TRACE ( TRACE_ACIA, "acia %s start timer divider=%d bits=%d cpu_cycles=%d VBL=%d HBL=%d\n" , pACIA->ACIA_Name ,
+		pACIA->Clock_Divider , NbBits , Cycles , nVBLs , nHBL );
 
 	CycInt_AddRelativeInterruptWithOffset ( Cycles, INT_CPU_CYCLE, INTERRUPT_ACIA_IKBD , InternalCycleOffset );
 }
@@ -466,12 +506,71 @@ static void	ACIA_Start_InterruptHandler_IKBD ( ACIA_STRUCT *pACIA , int Internal
 
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if nothing is sent or received on the serial line, either
+ * by the ACIA or by the device connected to it. In that case, the next bits
+ * will all be '1' stop bits and clocking them will not change any state.
+ */
+static bool	ACIA_Line_Is_Idle ( ACIA_STRUCT *pACIA )
+{
+	if ( ( pACIA->TX_State != ACIA_STATE_IDLE ) || ( pACIA->RX_State != ACIA_STATE_IDLE ) )
+		return false;
+
+	if ( ( ( pACIA->SR & ACIA_SR_BIT_TDRE ) == 0 ) || ( pACIA->TX_Size > 0 ) || pACIA->TX_SendBrk )
+		return false;
+
+	return pACIA->Get_Peer_Idle () ? true : false;
+}
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Something new needs to be sent on the IKBD's serial line (a byte was written
+ * to the ACIA's TDR or the IKBD has new bytes to send).
+ * If the timer was running at the idle rate, restart it at the next bit
+ * boundary, as if it had been called for every bit. As all the skipped bits
+ * were idle bits, the state of the ACIA and the IKBD is the same as if they
+ * had been clocked for each bit.
+ */
+void	ACIA_IKBD_Wakeup ( void )
+{
+	int		CyclesLeft;
+
+
+	if ( !pACIA_IKBD->Timer_Idle )
+		return;
+
+	pACIA_IKBD->Timer_Idle = 0;
+	if ( !CycInt_InterruptActive ( INTERRUPT_ACIA_IKBD ) )
+		return;
+
+	/* Cycles left before the idle timer expires, this is always on a bit boundary */
+	CyclesLeft = CycInt_FindCyclesPassed ( INTERRUPT_ACIA_IKBD , INT_CPU_CYCLE );
+	if ( CyclesLeft <= 0 )						/* Timer already expired, it will be processed as a normal bit */
+		return;
+
+	CyclesLeft %= ACIA_Get_Bit_Cycles ( pACIA_IKBD );
+
+	LOG_TRACE ( TRACE_ACIA, "acia %s wakeup timer cpu_cycles=%d VBL=%d HBL=%d\n" , pACIA_IKBD->ACIA_Name ,
+		CyclesLeft , nVBLs , nHBL );
+
+	CycInt_AddRelativeInterrupt ( CyclesLeft , INT_CPU_CYCLE , INTERRUPT_ACIA_IKBD );
+}
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Interrupt called each time a new bit must be sent / received with the IKBD.
  * This interrupt will be called at freq ( 500 MHz / ACIA_CR_COUNTER_DIVIDE )
  * On ST, RX_Clock = TX_Clock = 500 MHz.
  * We continuously restart the interrupt, taking into account PendingCyclesOver.
+ * When the serial line is idle, the interrupt is restarted for ACIA_IDLE_BITS
+ * bits instead of 1 bit, until ACIA_IKBD_Wakeup() is called.
  */
 void	ACIA_InterruptHandler_IKBD ( void )
 {
@@ -490,7 +589,11 @@ void	ACIA_InterruptHandler_IKBD ( void )
 	ACIA_Clock_TX ( pACIA_IKBD );
 	ACIA_Clock_RX ( pACIA_IKBD );
 
-	ACIA_Start_InterruptHandler_IKBD ( pACIA_IKBD , -PendingCyclesOver );	/* Compensate for a != 0 value of PendingCyclesOver */
+	/* Compensate for a != 0 value of PendingCyclesOver */
+	if ( ACIA_Line_Is_Idle ( pACIA_IKBD ) )
+		ACIA_Start_InterruptHandler_IKBD ( pACIA_IKBD , -PendingCyclesOver , ACIA_IDLE_BITS );
+	else
+		ACIA_Start_InterruptHandler_IKBD ( pACIA_IKBD , -PendingCyclesOver , 1 );
 }
 
 
@@ -600,6 +703,9 @@ void	ACIA_IKBD_Write_CR ( void )
 				IoMem[0xfffc00], FrameCycles, LineCycles, HblCounterVideo, M68000_GetPC(), CurrentInstrCycles);
 
 	ACIA_Write_CR ( pACIA_IKBD , IoMem[0xfffc00] );
+
+	if ( pACIA_IKBD->TX_SendBrk )
+		ACIA_IKBD_Wakeup ();					/* Break bits must be sent now */
 }
 
 
@@ -620,6 +726,7 @@ void	ACIA_IKBD_Write_TDR ( void )
 				IoMem[0xfffc02], FrameCycles, LineCycles, HblCounterVideo, M68000_GetPC(), CurrentInstrCycles);
 
 	ACIA_Write_TDR ( pACIA_IKBD , IoMem[0xfffc02] );
+	ACIA_IKBD_Wakeup ();						/* Start sending TDR at the next bit */
 }
 
 
@@ -0,0 +1,190 @@
+/*
+  Hatari - benchmark.c
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  Emulation speed benchmarking.
+
+  With the --benchmark option, Hatari writes on exit a JSON file with the
+  emulated VBLs/s, process host CPU times, peak memory usage and how the
+  host CPU time was divided between emulation subsystems.  The JSON files
+  are collected and compared against a baseline by the tests/benchmark/
+  workload runner.
+
+  Subsystem CPU times are sampled: profiling timer signal adds a tick to
+  the subsystem which is currently active.  Entering and leaving a
+  subsystem (Benchmark_Enter() / Benchmark_Leave()) just sets a variable,
+  so this doesn't slow down even frequently called functions like DSP_Run().
+*/
+const char Benchmark_fileid[] = "Hatari benchmark.c : " __DATE__ " " __TIME__;
+
+#include <config.h>
+#include <SDL.h>
+#if HAVE_SETITIMER
+#include <sys/time.h>
+#endif
+#if HAVE_GETRUSAGE
+#include <sys/resource.h>
+#endif
+
+#include "main.h"
+#include "configuration.h"
+#include "benchmark.h"
+#include "file.h"
+#include "log.h"
+#include "version.h"
+
+
+#define BENCH_TICK_USECS  1000
+
+volatile sig_atomic_t Benchmark_Subsystem;
+
+static const char *SubsystemNames[BENCH_SUBSYSTEMS] = {
+	"cpu", "screen", "sound", "blitter", "dsp", "gemdos"
+};
+
+static char *OutputFile;
+static bool bActive;
+static Uint32 nStartTicks;
+static Uint32 nVBLs;
+static volatile Uint32 nSamples[BENCH_SUBSYSTEMS];
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Set file to which benchmark results are written on exit.
+ * Return false for invalid name.
+ */
+bool Benchmark_SetOutputFile(const char *filename)
+{
+	if (!filename || !*filename)
+		return false;
+	free(OutputFile);
+	OutputFile = strdup(filename);
+	return true;
+}
+
+#if HAVE_SETITIMER
+/**
+ * Profiling timer signal handler
+ */
+static void Benchmark_Sample(int signum)
+{
+	nSamples[Benchmark_Subsystem]++;
+}
+#endif
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Start benchmarking if output file is set, called when emulation starts
+ */
+void Benchmark_Init(void)
+{
+#if HAVE_SETITIMER
+	struct itimerval timer;
+#endif
+	int i;
+
+	if (!OutputFile || bActive)
+		return;
+
+#if HAVE_SETITIMER
+	signal(SIGPROF, Benchmark_Sample);
+	timer.it_interval.tv_sec = timer.it_value.tv_sec = 0;
+	timer.it_interval.tv_usec = timer.it_value.tv_usec = BENCH_TICK_USECS;
+	if (setitimer(ITIMER_PROF, &timer, NULL) != 0)
+		Log_Printf(LOG_WARN, "Benchmark profiling timer setup failed, no subsystem times!\n");
+#endif
+	for (i = 0; i < BENCH_SUBSYSTEMS; i++)
+		nSamples[i] = 0;
+	nVBLs = 0;
+	nStartTicks = SDL_GetTicks();
+	bActive = true;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Count emulated VBL
+ */
+void Benchmark_VBL(void)
+{
+	nVBLs++;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Stop benchmarking and write the results
+ */
+void Benchmark_UnInit(void)
+{
+	static const char *machines[] = { "st", "ste", "tt", "falcon", "megaste" };
+	double secs, sampletime, usersecs = 0.0, syssecs = 0.0;
+	long peakrss = 0;
+	int i, total;
+	FILE *fp;
+#if HAVE_SETITIMER
+	struct itimerval timer;
+#endif
+#if HAVE_GETRUSAGE
+	struct rusage usage;
+#endif
+
+	if (!bActive)
+		return;
+	bActive = false;
+
+#if HAVE_SETITIMER
+	memset(&timer, 0, sizeof(timer));
+	setitimer(ITIMER_PROF, &timer, NULL);
+#endif
+#if HAVE_GETRUSAGE
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+		usersecs = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1000000.0;
+		syssecs = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1000000.0;
+		peakrss = usage.ru_maxrss;	/* KiB on Linux */
+	}
+#endif
+	secs = (SDL_GetTicks() - nStartTicks) / 1000.0;
+	fp = File_Open(OutputFile, "w");
+	if (!fp)
+	{
+		Log_Printf(LOG_ERROR, "Can't write benchmark results to '%s'!\n", OutputFile);
+		return;
+	}
+	fprintf(fp, "{\n");
+	fprintf(fp, "  \"version\": \"%s\",\n", PROG_NAME);
+	fprintf(fp, "  \"machine\": \"%s\",\n", machines[ConfigureParams.System.nMachineType]);
+	fprintf(fp, "  \"vbls\": %u,\n", nVBLs);
+	fprintf(fp, "  \"secs\": %.3f,\n", secs);
+	fprintf(fp, "  \"vbls_per_sec\": %.1f,\n", secs > 0 ? nVBLs / secs : 0.0);
+	fprintf(fp, "  \"user_secs\": %.3f,\n", usersecs);
+	fprintf(fp, "  \"sys_secs\": %.3f,\n", syssecs);
+	fprintf(fp, "  \"peak_rss_kb\": %ld,\n", peakrss);
+
+	/* Timer signals can come less often than requested (kernel tick),
+	 * so divide the measured process CPU time by the sample counts
+	 * when it's available
+	 */
+	total = 0;
+	for (i = 0; i < BENCH_SUBSYSTEMS; i++)
+		total += nSamples[i];
+	if (total && usersecs + syssecs > 0.0)
+		sampletime = (usersecs + syssecs) / total;
+	else
+		sampletime = BENCH_TICK_USECS / 1000000.0;
+	fprintf(fp, "  \"subsystem_secs\": {");
+	for (i = 0; i < BENCH_SUBSYSTEMS; i++)
+	{
+		fprintf(fp, "%s\n    \"%s\": %.3f", i ? "," : "", SubsystemNames[i],
+		        nSamples[i] * sampletime);
+	}
+	fprintf(fp, "\n  },\n");
+	fprintf(fp, "  \"subsystem_samples\": %d\n", total);
+	fprintf(fp, "}\n");
+	File_Close(fp);
+
+	fprintf(stderr, "Benchmark: %u VBLs in %.1fs = %.1f VBLs/s, results in '%s'.\n",
+		nVBLs, secs, secs > 0 ? nVBLs / secs : 0.0, OutputFile);
+}
@@ -22,6 +22,14 @@
  * ----------------------------------------------------------------------------
  * Does smudge mode change the line register ?
  * ----------------------------------------------------------------------------
+ * Fast blitter mode (--fast-blitter):
+ * Instead of going through Blitter_Step() for every word, a kernel
+ * specialised for the current HOP/LOP combination processes the words
+ * of a line directly in ST RAM. Emulated cycles are the same as with the
+ * word based emulation, but pending interrupts are only handled at the
+ * end of each run (end of line or end of a non-hog bus slot) instead of
+ * after each word. Lines touching IO memory always use the word path.
+ * ----------------------------------------------------------------------------
  */
 
 const char Blitter_fileid[] = "Hatari blitter.c : " __DATE__ " " __TIME__;
@@ -31,6 +39,7 @@ const char Blitter_fileid[] = "Hatari blitter.c : " __DATE__ " " __TIME__;
 #include <stdlib.h>
 
 #include "main.h"
+#include "benchmark.h"
 #include "blitter.h"
 #include "configuration.h"
 #include "dmaSnd.h"
@@ -509,6 +518,242 @@ static void Blitter_Step(void)
 	}
 }
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Blitter emulation - fast line kernels
+ */
+
+/* Highest address + 1 that the word path reads/writes directly from ST RAM */
+#define BLITTER_RAM_END	0x00ff8000
+
+typedef void (*BLITTER_FAST_FUNC)(void);
+
+/**
+ * Return true if 'count' words starting at 'addr' and spaced by 'incr'
+ * bytes are all plain RAM/ROM accesses for Blitter_ReadWord/WriteWord.
+ */
+static bool Blitter_FastRangeValid(Uint32 addr, int incr, Uint32 count)
+{
+	Sint64 last;
+
+	if (count == 0)
+		return true;
+	if (addr >= BLITTER_RAM_END)
+		return false;
+	last = (Sint64)addr + (Sint64)incr * (Sint64)(count - 1);
+	return last >= 0 && last < BLITTER_RAM_END;
+}
+
+/**
+ * Return true if the rest of the current line can be done with a fast kernel.
+ */
+static bool Blitter_FastLineValid(void)
+{
+	Uint32 src_words;
+
+	if (BlitterRegs.words == BlitterVars.dst_words_reset)
+		src_words = BlitterVars.src_words_reset;
+	else
+		src_words = BlitterVars.src_words;
+
+	return Blitter_FastRangeValid(BlitterRegs.dst_addr, BlitterRegs.dst_x_incr, BlitterRegs.words)
+		&& Blitter_FastRangeValid(BlitterRegs.src_addr, BlitterRegs.src_x_incr, src_words);
+}
+
+/**
+ * Process words of the current line until the end of the line or, in
+ * non-hog mode, until the blitter has used its bus slot. This does
+ * exactly the same reads & writes in the same order as Blitter_Step(),
+ * 'hop' and 'lop' are constants in each instantiation so that the
+ * compiler can remove all the unused operations.
+ */
+static ALWAYS_INLINE void Blitter_FastRun(const int hop, const int lop)
+{
+	/* LOPs 0, 5, A and F don't evaluate the HOP (and read no source) */
+	const bool use_hop = !(lop == 0x0 || lop == 0x5 || lop == 0xA || lop == 0xF);
+	const bool use_dst = !(lop == 0x0 || lop == 0x3 || lop == 0xC || lop == 0xF);
+	const bool smudge = BlitterVars.smudge;
+	const bool use_src = use_hop && (hop >= 2 || (hop == 1 && smudge));
+	const bool hog = BlitterVars.hog;
+	const int budget = NONHOG_CYCLES - BlitterVars.pass_cycles;
+	const Uint32 dst_words_reset = BlitterVars.dst_words_reset;
+	const Uint16 halftone = BlitterHalftone[BlitterVars.line];
+	const short src_x_incr = BlitterRegs.src_x_incr;
+	const short src_y_incr = BlitterRegs.src_y_incr;
+	const short dst_x_incr = BlitterRegs.dst_x_incr;
+	const short dst_y_incr = BlitterRegs.dst_y_incr;
+	const Uint8 skew = BlitterVars.skew;
+	Uint32 src_addr = BlitterRegs.src_addr;
+	Uint32 dst_addr = BlitterRegs.dst_addr;
+	Uint32 words = BlitterRegs.words;
+	Uint32 src_words = BlitterVars.src_words;
+	Uint32 buffer = BlitterVars.buffer;
+	Uint16 src_word = 0, dst_word = 0, hop_word, end_mask, dst_data;
+	bool first, last, fxsr, nfsr;
+	int accesses = 0;
+
+#define BLITTER_FAST_SHIFT() \
+	do { \
+		if (src_x_incr < 0) \
+			buffer >>= 16; \
+		else \
+			buffer <<= 16; \
+	} while (0)
+
+#define BLITTER_FAST_FETCH() \
+	do { \
+		Uint32 fetched = (Uint32)STMemory_ReadWord(src_addr); \
+		if (src_x_incr < 0) \
+			buffer |= fetched << 16; \
+		else \
+			buffer |= fetched; \
+		if (src_words == 1) \
+			src_addr += src_y_incr; \
+		else { \
+			--src_words; \
+			src_addr += src_x_incr; \
+		} \
+		accesses++; \
+	} while (0)
+
+	do
+	{
+		first = (words == dst_words_reset);
+		last = (words == 1);
+		if (first)
+		{
+			src_words = BlitterVars.src_words_reset;
+			end_mask = BlitterRegs.end_mask_1;
+		}
+		else if (last)
+			end_mask = BlitterRegs.end_mask_3;
+		else
+			end_mask = BlitterRegs.end_mask_2;
+		fxsr = first && BlitterVars.fxsr;
+		nfsr = last && BlitterVars.nfsr;
+
+		if (use_src)
+		{
+			if (fxsr)
+			{
+				BLITTER_FAST_SHIFT();
+				BLITTER_FAST_FETCH();
+			}
+			BLITTER_FAST_SHIFT();
+			if (!nfsr)
+				BLITTER_FAST_FETCH();
+			src_word = (Uint16)(buffer >> skew);
+		}
+
+		switch (hop)
+		{
+		 case 0:
+			hop_word = 0xFFFF;
+			break;
+		 case 1:
+			hop_word = smudge ? BlitterHalftone[src_word & 15] : halftone;
+			break;
+		 case 2:
+			hop_word = src_word;
+			break;
+		 default:
+			hop_word = src_word & (smudge ? BlitterHalftone[src_word & 15] : halftone);
+			break;
+		}
+
+		/* when NFSR, a read-modify-write is always performed */
+		if (use_dst || nfsr || end_mask != 0xFFFF)
+		{
+			dst_word = STMemory_ReadWord(dst_addr);
+			accesses++;
+		}
+
+		switch (lop)
+		{
+		 case 0x0: dst_data = 0; break;
+		 case 0x1: dst_data = hop_word & dst_word; break;
+		 case 0x2: dst_data = hop_word & ~dst_word; break;
+		 case 0x3: dst_data = hop_word; break;
+		 case 0x4: dst_data = ~hop_word & dst_word; break;
+		 case 0x5: dst_data = dst_word; break;
+		 case 0x6: dst_data = hop_word ^ dst_word; break;
+		 case 0x7: dst_data = hop_word | dst_word; break;
+		 case 0x8: dst_data = ~hop_word & ~dst_word; break;
+		 case 0x9: dst_data = ~hop_word ^ dst_word; break;
+		 case 0xA: dst_data = ~dst_word; break;
+		 case 0xB: dst_data = hop_word | ~dst_word; break;
+		 case 0xC: dst_data = ~hop_word; break;
+		 case 0xD: dst_data = ~hop_word | dst_word; break;
+		 case 0xE: dst_data = ~hop_word | ~dst_word; break;
+		 default:  dst_data = 0xFFFF; break;
+		}
+
+		if (nfsr || end_mask != 0xFFFF)
+			dst_data = (dst_data & end_mask) | (dst_word & ~end_mask);
+
+		STMemory_WriteWord(dst_addr, dst_data);
+		accesses++;
+
+		if (last)
+		{
+			dst_addr += dst_y_incr;
+		}
+		else
+		{
+			--words;
+			dst_addr += dst_x_incr;
+		}
+	}
+	while (!last && (hog || accesses * 4 < budget));
+
+#undef BLITTER_FAST_SHIFT
+#undef BLITTER_FAST_FETCH
+
+	BlitterRegs.src_addr = src_addr;
+	BlitterRegs.dst_addr = dst_addr;
+	BlitterRegs.words = words;
+	BlitterVars.src_words = src_words;
+	BlitterVars.buffer = buffer;
+
+	/* 4 cycles per word read or written, like Blitter_ReadWord/WriteWord */
+	Blitter_AddCycles(accesses * 4);
+
+	if (last)
+		Blitter_EndLine();
+}
+
+#define BLITTER_FAST_KERNEL(h, l) \
+	static void Blitter_Fast_##h##_##l(void) { Blitter_FastRun(h, 0x##l); }
+
+#define BLITTER_FAST_KERNELS(h) \
+	BLITTER_FAST_KERNEL(h, 0) BLITTER_FAST_KERNEL(h, 1) \
+	BLITTER_FAST_KERNEL(h, 2) BLITTER_FAST_KERNEL(h, 3) \
+	BLITTER_FAST_KERNEL(h, 4) BLITTER_FAST_KERNEL(h, 5) \
+	BLITTER_FAST_KERNEL(h, 6) BLITTER_FAST_KERNEL(h, 7) \
+	BLITTER_FAST_KERNEL(h, 8) BLITTER_FAST_KERNEL(h, 9) \
+	BLITTER_FAST_KERNEL(h, A) BLITTER_FAST_KERNEL(h, B) \
+	BLITTER_FAST_KERNEL(h, C) BLITTER_FAST_KERNEL(h, D) \
+	BLITTER_FAST_KERNEL(h, E) BLITTER_FAST_KERNEL(h, F)
+
+BLITTER_FAST_KERNELS(0)
+BLITTER_FAST_KERNELS(1)
+BLITTER_FAST_KERNELS(2)
+BLITTER_FAST_KERNELS(3)
+
+#define BLITTER_FAST_ROW(h) \
+	{ Blitter_Fast_##h##_0, Blitter_Fast_##h##_1, Blitter_Fast_##h##_2, Blitter_Fast_##h##_3, \
+	  Blitter_Fast_##h##_4, Blitter_Fast_##h##_5, Blitter_Fast_##h##_6, Blitter_Fast_##h##_7, \
+	  Blitter_Fast_##h##_8, Blitter_Fast_##h##_9, Blitter_Fast_##h##_A, Blitter_Fast_##h##_B, \
+	  Blitter_Fast_##h##_C, Blitter_Fast_##h##_D, Blitter_Fast_##h##_E, Blitter_Fast_##h##_F }
+
+static const BLITTER_FAST_FUNC Blitter_Fast_Table[4][16] =
+{
+	BLITTER_FAST_ROW(0),
+	BLITTER_FAST_ROW(1),
+	BLITTER_FAST_ROW(2),
+	BLITTER_FAST_ROW(3)
+};
+
 /*-----------------------------------------------------------------------*/
 /**
  * Let's do the blit.
@@ -518,9 +763,14 @@ static void Blitter_Step(void)
  */
 static void Blitter_Start(void)
 {
+	BLITTER_FAST_FUNC fast_func = NULL;
+	int nBenchPrev = Benchmark_Enter(BENCH_BLITTER);
+
 	/* select HOP & LOP funcs */
 	Blitter_Select_HOP();
 	Blitter_Select_LOP();
+	if (ConfigureParams.System.bFastBlitter)
+		fast_func = Blitter_Fast_Table[BlitterRegs.hop][BlitterRegs.lop];
 
 	/* setup vars */
 	BlitterVars.pass_cycles = 0;
@@ -535,7 +785,10 @@ static void Blitter_Start(void)
 	/* Now we enter the main blitting loop */
 	do
 	{
-		Blitter_Step();
+		if (fast_func && Blitter_FastLineValid())
+			fast_func();
+		else
+			Blitter_Step();
 		Blitter_FlushCycles();
 	}
 	while (BlitterRegs.lines > 0
@@ -561,6 +814,7 @@ static void Blitter_Start(void)
 		/* Continue blitting later */
 		CycInt_AddRelativeInterrupt(NONHOG_CYCLES, INT_CPU_CYCLE, INTERRUPT_BLITTER);
 	}
+	Benchmark_Leave(nBenchPrev);
 }
 
 /*-----------------------------------------------------------------------*/
@@ -78,6 +78,10 @@ bool Change_DoNeedReset(CNF_PARAMS *current, CNF_PARAMS *changed)
 	if (strcmp(changed->Rom.szTosImageFileName, current->Rom.szTosImageFileName))
 		return true;
 
+	/* Did change IKBD ROM image? */
+	if (strcmp(changed->Rom.szIkbdRomFileName, current->Rom.szIkbdRomFileName))
+		return true;
+
 	/* Did change ACSI hard disk image? */
 	if (changed->HardDisk.bUseHardDiskImage != current->HardDisk.bUseHardDiskImage
 	    || (strcmp(changed->HardDisk.szHardDiskImage, current->HardDisk.szHardDiskImage)
@@ -19,11 +19,13 @@ const char Configuration_fileid[] = "Hatari configuration.c : " __DATE__ " " __T
 #include "audio.h"
 #include "sound.h"
 #include "file.h"
+#include "hostStream.h"
 #include "log.h"
 #include "m68000.h"
 #include "memorySnapShot.h"
 #include "paths.h"
 #include "screen.h"
+#include "screenSnapShot.h"
 #include "vdi.h"
 #include "video.h"
 #include "avi_record.h"
@@ -75,6 +77,7 @@ static const struct Config_Tag configs_Screen[] =
 	{ "nVdiWidth", Int_Tag, &ConfigureParams.Screen.nVdiWidth },
 	{ "nVdiHeight", Int_Tag, &ConfigureParams.Screen.nVdiHeight },
 	{ "nVdiColors", Int_Tag, &ConfigureParams.Screen.nVdiColors },
+	{ "bVdiNativeDraw", Bool_Tag, &ConfigureParams.Screen.bVdiNativeDraw },
 	{ "bShowStatusbar", Bool_Tag, &ConfigureParams.Screen.bShowStatusbar },
 	{ "bShowDriveLed", Bool_Tag, &ConfigureParams.Screen.bShowDriveLed },
 	{ "bCrop", Bool_Tag, &ConfigureParams.Screen.bCrop },
@@ -261,6 +264,7 @@ static const struct Config_Tag configs_Floppy[] =
 {
 	{ "bAutoInsertDiskB", Bool_Tag, &ConfigureParams.DiskImage.bAutoInsertDiskB },
 	{ "FastFloppy", Bool_Tag, &ConfigureParams.DiskImage.FastFloppy },
+	{ "TurboFloppy", Bool_Tag, &ConfigureParams.DiskImage.TurboFloppy },
 	{ "nWriteProtection", Int_Tag, &ConfigureParams.DiskImage.nWriteProtection },
 	{ "szDiskAZipPath", String_Tag, ConfigureParams.DiskImage.szDiskZipPath[0] },
 	{ "szDiskAFileName", String_Tag, ConfigureParams.DiskImage.szDiskFileName[0] },
@@ -293,6 +297,7 @@ static const struct Config_Tag configs_Rom[] =
 	{ "szTosImageFileName", String_Tag, ConfigureParams.Rom.szTosImageFileName },
 	{ "bPatchTos", Bool_Tag, &ConfigureParams.Rom.bPatchTos },
 	{ "szCartridgeImageFileName", String_Tag, ConfigureParams.Rom.szCartridgeImageFileName },
+	{ "szIkbdRomFileName", String_Tag, ConfigureParams.Rom.szIkbdRomFileName },
 	{ NULL , Error_Tag, NULL }
 };
 
@@ -300,6 +305,7 @@ static const struct Config_Tag configs_Rom[] =
 static const struct Config_Tag configs_Rs232[] =
 {
 	{ "bEnableRS232", Bool_Tag, &ConfigureParams.RS232.bEnableRS232 },
+	{ "bTurbo", Bool_Tag, &ConfigureParams.RS232.bTurbo },
 	{ "szOutFileName", String_Tag, ConfigureParams.RS232.szOutFileName },
 	{ "szInFileName", String_Tag, ConfigureParams.RS232.szInFileName },
 	{ NULL , Error_Tag, NULL }
@@ -330,10 +336,12 @@ static const struct Config_Tag configs_System[] =
 	{ "bCompatibleCpu", Bool_Tag, &ConfigureParams.System.bCompatibleCpu },
 	{ "nMachineType", Int_Tag, &ConfigureParams.System.nMachineType },
 	{ "bBlitter", Bool_Tag, &ConfigureParams.System.bBlitter },
+	{ "bFastBlitter", Bool_Tag, &ConfigureParams.System.bFastBlitter },
 	{ "nDSPType", Int_Tag, &ConfigureParams.System.nDSPType },
 	{ "bRealTimeClock", Bool_Tag, &ConfigureParams.System.bRealTimeClock },
 	{ "bPatchTimerD", Bool_Tag, &ConfigureParams.System.bPatchTimerD },
 	{ "bFastBoot", Bool_Tag, &ConfigureParams.System.bFastBoot },
+	{ "bSpinLoopSkip", Bool_Tag, &ConfigureParams.System.bSpinLoopSkip },
 	{ "bFastForward", Bool_Tag, &ConfigureParams.System.bFastForward },
 
 #if ENABLE_WINUAE_CPU
@@ -349,6 +357,7 @@ static const struct Config_Tag configs_System[] =
 /* Used to load/save video options */
 static const struct Config_Tag configs_Video[] =
 {
+	{ "ScreenShotFormat", Int_Tag, &ConfigureParams.Video.ScreenShotFormat },
 	{ "AviRecordVcodec", Int_Tag, &ConfigureParams.Video.AviRecordVcodec },
 	{ "AviRecordFps", Int_Tag, &ConfigureParams.Video.AviRecordFps },
 	{ "AviRecordFile", String_Tag, ConfigureParams.Video.AviRecordFile },
@@ -392,6 +401,7 @@ void Configuration_SetDefault(void)
 	/* Set defaults for floppy disk images */
 	ConfigureParams.DiskImage.bAutoInsertDiskB = true;
 	ConfigureParams.DiskImage.FastFloppy = false;
+	ConfigureParams.DiskImage.TurboFloppy = false;
 	ConfigureParams.DiskImage.nWriteProtection = WRITEPROT_OFF;
 	for (i = 0; i < 2; i++)
 	{
@@ -479,6 +489,7 @@ void Configuration_SetDefault(void)
 
 	/* Set defaults for RS232 */
 	ConfigureParams.RS232.bEnableRS232 = false;
+	ConfigureParams.RS232.bTurbo = false;
 	strcpy(ConfigureParams.RS232.szOutFileName, "/dev/modem");
 	strcpy(ConfigureParams.RS232.szInFileName, "/dev/modem");
 
@@ -501,6 +512,7 @@ void Configuration_SetDefault(void)
 	ConfigureParams.Screen.nVdiWidth = 640;
 	ConfigureParams.Screen.nVdiHeight = 480;
 	ConfigureParams.Screen.nVdiColors = GEMCOLOR_16;
+	ConfigureParams.Screen.bVdiNativeDraw = false;
 	ConfigureParams.Screen.bShowStatusbar = true;
 	ConfigureParams.Screen.bShowDriveLed = true;
 	ConfigureParams.Screen.bCrop = false;
@@ -524,6 +536,7 @@ void Configuration_SetDefault(void)
 	        Paths_GetDataDir(), PATHSEP);
 	ConfigureParams.Rom.bPatchTos = true;
 	strcpy(ConfigureParams.Rom.szCartridgeImageFileName, "");
+	strcpy(ConfigureParams.Rom.szIkbdRomFileName, "");
 
 	/* Set defaults for System */
 #if ENABLE_WINUAE_CPU
@@ -546,15 +559,19 @@ void Configuration_SetDefault(void)
 #endif
 	ConfigureParams.System.bCompatibleCpu = true;
 	ConfigureParams.System.bBlitter = false;
+	ConfigureParams.System.bFastBlitter = false;
 	ConfigureParams.System.bPatchTimerD = true;
 	ConfigureParams.System.bFastBoot = true;
+	ConfigureParams.System.bSpinLoopSkip = false;
 	ConfigureParams.System.bRealTimeClock = true;
 	ConfigureParams.System.bFastForward = false;
 
 	/* Set defaults for Video */
 #if HAVE_LIBPNG
+	ConfigureParams.Video.ScreenShotFormat = SCREENSHOT_FORMAT_PNG;
 	ConfigureParams.Video.AviRecordVcodec = AVI_RECORD_VIDEO_CODEC_PNG;
 #else
+	ConfigureParams.Video.ScreenShotFormat = SCREENSHOT_FORMAT_BMP;
 	ConfigureParams.Video.AviRecordVcodec = AVI_RECORD_VIDEO_CODEC_BMP;
 #endif
 	ConfigureParams.Video.AviRecordFps = 0;			/* automatic FPS */
@@ -573,6 +590,18 @@ void Configuration_SetDefault(void)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Make serial or MIDI stream file name absolute, unless it's a socket
+ * or pseudo terminal endpoint (see hostStream.c)
+ */
+static void Configuration_MakeAbsoluteStreamName(char *path)
+{
+	if (!HostStream_IsEndpoint(path))
+		File_MakeAbsoluteSpecialName(path);
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Copy details from configuration structure into global variables for system,
@@ -637,6 +666,8 @@ void Configuration_Apply(bool bReset)
 	File_MakeAbsoluteName(ConfigureParams.Rom.szTosImageFileName);
 	if (strlen(ConfigureParams.Rom.szCartridgeImageFileName) > 0)
 		File_MakeAbsoluteName(ConfigureParams.Rom.szCartridgeImageFileName);
+	if (strlen(ConfigureParams.Rom.szIkbdRomFileName) > 0)
+		File_MakeAbsoluteName(ConfigureParams.Rom.szIkbdRomFileName);
 	File_MakeAbsoluteName(ConfigureParams.HardDisk.szHardDiskImage);
 	File_CleanFileName(ConfigureParams.HardDisk.szHardDiskDirectories[0]);
 	File_MakeAbsoluteName(ConfigureParams.HardDisk.szHardDiskDirectories[0]);
@@ -649,10 +680,10 @@ void Configuration_Apply(bool bReset)
 	/* make path names absolute, but handle special file names */
 	File_MakeAbsoluteSpecialName(ConfigureParams.Log.sLogFileName);
 	File_MakeAbsoluteSpecialName(ConfigureParams.Log.sTraceFileName);
-	File_MakeAbsoluteSpecialName(ConfigureParams.RS232.szInFileName);
-	File_MakeAbsoluteSpecialName(ConfigureParams.RS232.szOutFileName);
-	File_MakeAbsoluteSpecialName(ConfigureParams.Midi.sMidiInFileName);
-	File_MakeAbsoluteSpecialName(ConfigureParams.Midi.sMidiOutFileName);
+	Configuration_MakeAbsoluteStreamName(ConfigureParams.RS232.szInFileName);
+	Configuration_MakeAbsoluteStreamName(ConfigureParams.RS232.szOutFileName);
+	Configuration_MakeAbsoluteStreamName(ConfigureParams.Midi.sMidiInFileName);
+	Configuration_MakeAbsoluteStreamName(ConfigureParams.Midi.sMidiOutFileName);
 	File_MakeAbsoluteSpecialName(ConfigureParams.Printer.szPrintToFileName);
 }
 
@@ -814,6 +845,7 @@ void Configuration_MemorySnapShot_Capture(bool bSave)
 #endif
 
 	MemorySnapShot_Store(&ConfigureParams.DiskImage.FastFloppy, sizeof(ConfigureParams.DiskImage.FastFloppy));
+	MemorySnapShot_Store(&ConfigureParams.DiskImage.TurboFloppy, sizeof(ConfigureParams.DiskImage.TurboFloppy));
 
 	if (!bSave)
 		Configuration_Apply(true);
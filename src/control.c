@@ -27,13 +27,18 @@ const char Control_fileid[] = "Hatari control.c : " __DATE__ " " __TIME__;
 #include "debugui.h"
 #include "file.h"
 #include "ikbd.h"
+#include "ioMem.h"
 #include "keymap.h"
 #include "log.h"
+#include "m68000.h"
 #include "midi.h"
 #include "printer.h"
 #include "rs232.h"
+#include "screen.h"
 #include "shortcut.h"
+#include "stMemory.h"
 #include "str.h"
+#include "video.h"
 
 typedef enum {
 	DO_DISABLE,
@@ -280,6 +285,7 @@ static bool Control_Usage(const char *cmd)
 		"- hatari-path <config name> <new path>\n"
 		"- hatari-shortcut <shortcut name>\n"
 		"- hatari-embed-info\n"
+		"- hatari-binary\n"
 		"- hatari-stop\n"
 		"- hatari-cont\n"
 		"The last two can be used to stop and continue the Hatari emulation.\n"
@@ -362,6 +368,727 @@ static int ControlSocket;
 static int Control_GetUISocket(void);
 
 
+/*-----------------------------------------------------------------------
+ * Binary remote control protocol.
+ *
+ * Sending "hatari-binary" text command line switches the control socket
+ * into binary mode, for the rest of the connection.  Hatari answers with
+ * "HBIN" and a 32-bit protocol version, and stops the emulation.  After
+ * that, emulation runs only while one of the RUN_* requests is active.
+ *
+ * All values are big endian.  Requests and replies have a common
+ * 8 byte header, followed by 'length' bytes of payload:
+ *	u8 opcode, u8 flags / reply status, u16 sequence, u32 length
+ *
+ * Client can send any number of requests without waiting for replies
+ * in between.  They're processed in order and the replies are written
+ * in the same order, with the request opcode & sequence number.
+ * Replies to RUN_* requests are sent only when the emulation stops
+ * again, so requests following them are processed after that.
+ */
+
+#define BIN_VERSION	1
+#define BIN_HEADER	8
+#define BIN_MAX_LENGTH	(32*1024*1024)
+#define BIN_READ_SIZE	(64*1024)
+
+enum {
+	BIN_INFO = 1,		/* -> version, machine, RAM size, cycles, VBLs */
+	BIN_MEM_READ,		/* u32 addr, u32 len -> data */
+	BIN_MEM_WRITE,		/* u32 addr, data */
+	BIN_IO_READ,		/* u32 addr, u16 size, u16 count -> values */
+	BIN_IO_WRITE,		/* u32 addr, u16 size, u16 count, values */
+	BIN_REGS_READ,		/* -> D0-D7, A0-A7, PC, SR (u32 each) */
+	BIN_REGS_WRITE,		/* (u16 reg, u32 value) pairs */
+	BIN_RUN_CYCLES,		/* u32 cycles -> stop info */
+	BIN_RUN_VBLS,		/* u32 VBLs -> stop info */
+	BIN_RUN_BREAK,		/* -> stop info */
+	BIN_PAUSE,		/* stop active run */
+	BIN_SCREENSHOT,		/* -> u16 width, u16 height, RGB data */
+	BIN_DEBUG,		/* debugger command string */
+	BIN_SCREEN_HASH		/* -> u32 screen hash, u32 VBL of the hashed frame */
+};
+
+enum {
+	BIN_OK,
+	BIN_ERR_OPCODE,		/* unknown opcode */
+	BIN_ERR_ARGS,		/* invalid payload size or values */
+	BIN_ERR_ADDRESS,	/* address range outside of accessible memory */
+	BIN_ERR_FAILED		/* operation failed */
+};
+
+/* reasons for emulation stopping, in RUN_* replies */
+enum {
+	BIN_STOP_CYCLES = 1,	/* requested cycle count done */
+	BIN_STOP_VBLS,		/* requested VBL count done */
+	BIN_STOP_PAUSE,		/* PAUSE request */
+	BIN_STOP_DEBUGGER	/* debugger invoked, reason in next byte */
+};
+
+#define BIN_REG_PC	16
+#define BIN_REG_SR	17
+
+static struct {
+	bool enabled;		/* socket in binary mode */
+	Uint8 *in, *out;	/* request & reply buffers */
+	int inlen, insize;
+	int outlen, outsize;
+	int run;		/* active RUN_* request opcode, or zero */
+	Uint16 runseq;		/* its sequence number */
+	Uint64 runcycles;	/* cycle counter value to stop at */
+	int runvbls;		/* VBL counter value to stop at */
+} Binary;
+
+
+static Uint16 Control_GetWord(const Uint8 *p)
+{
+	return (p[0] << 8) | p[1];
+}
+
+static Uint32 Control_GetLong(const Uint8 *p)
+{
+	return ((Uint32)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+/**
+ * Reserve 'len' bytes at the end of reply buffer, return pointer to them
+ */
+static Uint8 *Control_BinaryReserve(int len)
+{
+	Uint8 *ptr;
+
+	if (Binary.outlen + len > Binary.outsize)
+	{
+		int size = 2 * Binary.outsize + len;
+		ptr = realloc(Binary.out, size);
+		if (!ptr)
+		{
+			perror("Control_BinaryReserve");
+			exit(1);
+		}
+		Binary.out = ptr;
+		Binary.outsize = size;
+	}
+	ptr = Binary.out + Binary.outlen;
+	Binary.outlen += len;
+	return ptr;
+}
+
+static void Control_BinaryPutWord(Uint16 value)
+{
+	Uint8 *p = Control_BinaryReserve(2);
+	p[0] = value >> 8;
+	p[1] = value;
+}
+
+static void Control_BinaryPutLong(Uint32 value)
+{
+	Control_BinaryPutWord(value >> 16);
+	Control_BinaryPutWord(value);
+}
+
+/**
+ * Add reply header, return its offset so that its length
+ * can be updated with Control_BinaryEndReply()
+ */
+static int Control_BinaryReply(int opcode, int status, Uint16 seq)
+{
+	int offset = Binary.outlen;
+	Uint8 *p = Control_BinaryReserve(2);
+
+	p[0] = opcode;
+	p[1] = status;
+	Control_BinaryPutWord(seq);
+	Control_BinaryPutLong(0);
+	return offset;
+}
+
+static void Control_BinaryEndReply(int offset)
+{
+	Uint32 len = Binary.outlen - offset - BIN_HEADER;
+	Uint8 *p = Binary.out + offset + 4;
+
+	p[0] = len >> 24;
+	p[1] = len >> 16;
+	p[2] = len >> 8;
+	p[3] = len;
+}
+
+/**
+ * Write all buffered replies to the socket
+ */
+static void Control_BinaryFlush(void)
+{
+	ssize_t bytes;
+	int done = 0;
+
+	while (done < Binary.outlen && ControlSocket)
+	{
+		bytes = write(ControlSocket, Binary.out + done, Binary.outlen - done);
+		if (bytes < 0)
+		{
+			perror("Control socket write");
+			break;
+		}
+		done += bytes;
+	}
+	Binary.outlen = 0;
+}
+
+/**
+ * Add run request reply with info on why & where emulation stopped
+ */
+static void Control_BinaryStopped(int stop, int reason)
+{
+	int offset;
+
+	offset = Control_BinaryReply(Binary.run, BIN_OK, Binary.runseq);
+	Control_BinaryPutWord((stop << 8) | reason);
+	Control_BinaryPutWord(0);
+	Control_BinaryPutLong(M68000_GetPC());
+	Control_BinaryPutLong(CyclesGlobalClockCounter >> 32);
+	Control_BinaryPutLong(CyclesGlobalClockCounter);
+	Control_BinaryPutLong(nVBLs);
+	Control_BinaryEndReply(offset);
+	Binary.run = 0;
+}
+
+/**
+ * Copy guest memory to reply.  RAM & ROM are accessed directly,
+ * IO area without side-effects (i.e. last written values).
+ */
+static int Control_BinaryMemRead(Uint32 addr, Uint32 len)
+{
+	Uint8 *p;
+
+	if (len > BIN_MAX_LENGTH)
+		return BIN_ERR_ARGS;
+	/* written so that it doesn't wrap around */
+	if (addr >= 0x1000000 || len > 0x1000000 - addr)
+		return BIN_ERR_ADDRESS;
+	if (addr >= 0xff8000)
+	{
+		memcpy(Control_BinaryReserve(len), &IoMem[addr], len);
+		return BIN_OK;
+	}
+	if (!STMemory_ValidArea(addr, len))
+		return BIN_ERR_ADDRESS;
+	p = Control_BinaryReserve(len);
+	while (len--)
+		*p++ = STMemory_ReadByte(addr++);
+	return BIN_OK;
+}
+
+static int Control_BinaryMemWrite(Uint32 addr, const Uint8 *data, Uint32 len)
+{
+	if (addr >= 0xe00000 || len > 0xe00000 - addr || !STMemory_ValidArea(addr, len))
+		return BIN_ERR_ADDRESS;
+	while (len--)
+		STMemory_WriteByte(addr++, *data++);
+	return BIN_OK;
+}
+
+/**
+ * Read or write (if 'data' given) IO registers through their normal
+ * handlers, as supervisor mode CPU accesses of given size would do.
+ * Registers which would cause a bus error are rejected before any
+ * handler is called, so that no exception is raised in the emulation.
+ */
+static int Control_BinaryIoAccess(Uint32 addr, int size, int count, const Uint8 *data)
+{
+	int oldsuper;
+
+	if ((size != 1 && size != 2 && size != 4) || (size > 1 && (addr & 1)))
+		return BIN_ERR_ARGS;
+	if (addr < 0xff8000 || addr >= 0x1000000 || (Uint32)(size * count) > 0x1000000 - addr
+	    || IoMem_IsBusErrorRange(addr, size * count, data != NULL))
+		return BIN_ERR_ADDRESS;
+
+	oldsuper = regs.s;
+	regs.s = 1;
+	for (; count > 0; count--, addr += size)
+	{
+		if (data)
+		{
+			switch (size)
+			{
+			case 1: IoMem_bput(addr, data[0]); break;
+			case 2: IoMem_wput(addr, Control_GetWord(data)); break;
+			case 4: IoMem_lput(addr, Control_GetLong(data)); break;
+			}
+			data += size;
+			continue;
+		}
+		switch (size)
+		{
+		case 1: *Control_BinaryReserve(1) = IoMem_bget(addr); break;
+		case 2: Control_BinaryPutWord(IoMem_wget(addr)); break;
+		case 4: Control_BinaryPutLong(IoMem_lget(addr)); break;
+		}
+	}
+	regs.s = oldsuper;
+	return BIN_OK;
+}
+
+static int Control_BinaryRegsWrite(const Uint8 *data, Uint32 len)
+{
+	int reg;
+	Uint32 value;
+
+	if (len % 6)
+		return BIN_ERR_ARGS;
+	for (; len; len -= 6, data += 6)
+	{
+		reg = Control_GetWord(data);
+		value = Control_GetLong(data + 2);
+		if (reg <= REG_A7)
+			Regs[reg] = value;
+		else if (reg == BIN_REG_PC)
+			M68000_SetPC(value);
+		else if (reg == BIN_REG_SR)
+			M68000_SetSR(value);
+		else
+			return BIN_ERR_ARGS;
+	}
+	return BIN_OK;
+}
+
+/**
+ * Add current host screen contents as 24-bit RGB to reply
+ */
+static int Control_BinaryScreenshot(void)
+{
+	int x, y, bpp;
+	Uint8 *row, *p, r, g, b;
+	Uint32 pixel = 0;
+
+	if (!sdlscrn)
+		return BIN_ERR_FAILED;
+	bpp = sdlscrn->format->BytesPerPixel;
+	if (bpp != 1 && bpp != 2 && bpp != 4)
+		return BIN_ERR_FAILED;
+
+	Control_BinaryPutWord(sdlscrn->w);
+	Control_BinaryPutWord(sdlscrn->h);
+	p = Control_BinaryReserve(3 * sdlscrn->w * sdlscrn->h);
+
+	if (SDL_MUSTLOCK(sdlscrn))
+		SDL_LockSurface(sdlscrn);
+	for (y = 0; y < sdlscrn->h; y++)
+	{
+		row = (Uint8 *)sdlscrn->pixels + y * sdlscrn->pitch;
+		for (x = 0; x < sdlscrn->w; x++)
+		{
+			switch (bpp)
+			{
+			case 1: pixel = row[x]; break;
+			case 2: pixel = ((Uint16 *)row)[x]; break;
+			case 4: pixel = ((Uint32 *)row)[x]; break;
+			}
+			SDL_GetRGB(pixel, sdlscrn->format, &r, &g, &b);
+			*p++ = r;
+			*p++ = g;
+			*p++ = b;
+		}
+	}
+	if (SDL_MUSTLOCK(sdlscrn))
+		SDL_UnlockSurface(sdlscrn);
+	return BIN_OK;
+}
+
+/**
+ * Start emulation for given RUN_* request.
+ * Return status for (immediate) error reply, or BIN_OK.
+ */
+static int Control_BinaryRun(int opcode, Uint16 seq, const Uint8 *data, Uint32 len)
+{
+	Uint32 count = 0;
+
+	if (opcode != BIN_RUN_BREAK)
+	{
+		if (len != 4)
+			return BIN_ERR_ARGS;
+		count = Control_GetLong(data);
+	}
+	else if (len)
+		return BIN_ERR_ARGS;
+
+	Binary.run = opcode;
+	Binary.runseq = seq;
+	if (opcode == BIN_RUN_CYCLES)
+	{
+		Binary.runcycles = CyclesGlobalClockCounter + count;
+		/* get Control_BinaryCheckCycles() called for each instruction */
+		M68000_SetSpecial(SPCFLAG_DEBUGGER);
+	}
+	else if (opcode == BIN_RUN_VBLS)
+		Binary.runvbls = nVBLs + count;
+	return BIN_OK;
+}
+
+/**
+ * Process one request and add its reply, except for started run requests
+ */
+static void Control_BinaryRequest(int opcode, Uint16 seq, const Uint8 *data, Uint32 len)
+{
+	int status = BIN_OK, offset, i;
+	char *cmd;
+
+	switch (opcode)
+	{
+	case BIN_RUN_CYCLES:
+	case BIN_RUN_VBLS:
+	case BIN_RUN_BREAK:
+		status = Control_BinaryRun(opcode, seq, data, len);
+		if (status == BIN_OK)
+			return;
+		break;
+	default:
+		break;
+	}
+
+	offset = Control_BinaryReply(opcode, status, seq);
+	if (status != BIN_OK)
+	{
+		Control_BinaryEndReply(offset);
+		return;
+	}
+
+	switch (opcode)
+	{
+	case BIN_INFO:
+		Control_BinaryPutLong(BIN_VERSION);
+		Control_BinaryPutLong(ConfigureParams.System.nMachineType);
+		Control_BinaryPutLong(STRamEnd);
+		Control_BinaryPutLong(CyclesGlobalClockCounter >> 32);
+		Control_BinaryPutLong(CyclesGlobalClockCounter);
+		Control_BinaryPutLong(nVBLs);
+		break;
+	case BIN_MEM_READ:
+		if (len != 8)
+			status = BIN_ERR_ARGS;
+		else
+			status = Control_BinaryMemRead(Control_GetLong(data), Control_GetLong(data + 4));
+		break;
+	case BIN_MEM_WRITE:
+		if (len < 4)
+			status = BIN_ERR_ARGS;
+		else
+			status = Control_BinaryMemWrite(Control_GetLong(data), data + 4, len - 4);
+		break;
+	case BIN_IO_READ:
+		if (len != 8)
+			status = BIN_ERR_ARGS;
+		else
+			status = Control_BinaryIoAccess(Control_GetLong(data), Control_GetWord(data + 4),
+			                                Control_GetWord(data + 6), NULL);
+		break;
+	case BIN_IO_WRITE:
+		if (len < 8 || len - 8 != (Uint32)Control_GetWord(data + 4) * Control_GetWord(data + 6))
+			status = BIN_ERR_ARGS;
+		else
+			status = Control_BinaryIoAccess(Control_GetLong(data), Control_GetWord(data + 4),
+			                                Control_GetWord(data + 6), data + 8);
+		break;
+	case BIN_REGS_READ:
+		for (i = REG_D0; i <= REG_A7; i++)
+			Control_BinaryPutLong(Regs[i]);
+		Control_BinaryPutLong(M68000_GetPC());
+		Control_BinaryPutLong(M68000_GetSR());
+		break;
+	case BIN_REGS_WRITE:
+		status = Control_BinaryRegsWrite(data, len);
+		break;
+	case BIN_PAUSE:
+		/* emulation is already stopped */
+		break;
+	case BIN_SCREENSHOT:
+		status = Control_BinaryScreenshot();
+		break;
+	case BIN_SCREEN_HASH:
+		/* hashing starts on first request, hash VBL tells when it's valid */
+		Control_BinaryPutLong(Video_GetScreenHash());
+		Control_BinaryPutLong(Video_GetScreenHashVBL());
+		break;
+	case BIN_DEBUG:
+		cmd = malloc(len + 1);
+		if (!cmd)
+		{
+			status = BIN_ERR_FAILED;
+			break;
+		}
+		memcpy(cmd, data, len);
+		cmd[len] = '\0';
+		if (!DebugUI_ParseLine(cmd))
+			status = BIN_ERR_FAILED;
+		free(cmd);
+		break;
+	default:
+		status = BIN_ERR_OPCODE;
+		break;
+	}
+	if (status != BIN_OK)
+	{
+		/* drop partial reply payload */
+		Binary.outlen = offset + BIN_HEADER;
+		Binary.out[offset + 1] = status;
+	}
+	Control_BinaryEndReply(offset);
+}
+
+/**
+ * Close binary protocol connection, emulation continues normally
+ */
+static void Control_BinaryClose(void)
+{
+	if (ControlSocket) {
+		close(ControlSocket);
+		ControlSocket = 0;
+	}
+	free(Binary.in);
+	free(Binary.out);
+	memset(&Binary, 0, sizeof(Binary));
+	fprintf(stderr, "Binary control connection closed.\n");
+}
+
+/**
+ * Process queued requests until one of them starts emulation
+ * or there are no more complete requests
+ */
+static void Control_BinaryProcess(void)
+{
+	Uint8 *req;
+	Uint32 len;
+	int done = 0;
+
+	while (!Binary.run && Binary.inlen - done >= BIN_HEADER)
+	{
+		req = Binary.in + done;
+		len = Control_GetLong(req + 4);
+		if (len > BIN_MAX_LENGTH)
+		{
+			fprintf(stderr, "ERROR: binary control request too large (%u bytes)!\n", len);
+			Control_BinaryClose();
+			return;
+		}
+		if ((Uint32)(Binary.inlen - done - BIN_HEADER) < len)
+			break;
+		done += BIN_HEADER + len;
+		Control_BinaryRequest(req[0], Control_GetWord(req + 2), req + BIN_HEADER, len);
+	}
+	Binary.inlen -= done;
+	memmove(Binary.in, Binary.in + done, Binary.inlen);
+}
+
+/**
+ * Append given data to request buffer
+ */
+static void Control_BinaryAppend(const void *data, int len)
+{
+	Uint8 *ptr;
+
+	if (Binary.inlen + len > Binary.insize)
+	{
+		int size = 2 * Binary.insize + len;
+		ptr = realloc(Binary.in, size);
+		if (!ptr)
+		{
+			perror("Control_BinaryAppend");
+			exit(1);
+		}
+		Binary.in = ptr;
+		Binary.insize = size;
+	}
+	memcpy(Binary.in + Binary.inlen, data, len);
+	Binary.inlen += len;
+}
+
+/**
+ * Read all available data from control socket to request buffer.
+ * If 'block' is set, wait until there's something to read.
+ * Return false if connection got closed.
+ */
+static bool Control_BinaryRead(bool block)
+{
+	static Uint8 buffer[BIN_READ_SIZE];
+	struct timeval tv;
+	fd_set readfds;
+	ssize_t bytes;
+	int status;
+
+	for (;;)
+	{
+		FD_ZERO(&readfds);
+		FD_SET(ControlSocket, &readfds);
+		tv.tv_usec = tv.tv_sec = 0;
+		status = select(ControlSocket+1, &readfds, NULL, NULL, block ? NULL : &tv);
+		if (status < 0)
+		{
+			perror("Control socket select() error");
+			Control_BinaryClose();
+			return false;
+		}
+		if (status == 0)
+			return true;
+
+		bytes = read(ControlSocket, buffer, sizeof(buffer));
+		if (bytes <= 0)
+		{
+			if (bytes < 0)
+				perror("Control socket read");
+			Control_BinaryClose();
+			return false;
+		}
+		Control_BinaryAppend(buffer, bytes);
+		block = false;
+	}
+}
+
+/**
+ * Emulation is stopped, process requests until one of them
+ * continues emulation or connection gets closed
+ */
+static void Control_BinaryServe(void)
+{
+	while (Binary.enabled)
+	{
+		Control_BinaryProcess();
+		Control_BinaryFlush();
+		if (Binary.run || !Binary.enabled)
+			return;
+		if (!Control_BinaryRead(true))
+			return;
+	}
+}
+
+/**
+ * Stop emulation for given reason and serve requests until
+ * the next run request
+ */
+static void Control_BinaryStop(int stop, int reason)
+{
+	Control_BinaryStopped(stop, reason);
+	Control_BinaryServe();
+}
+
+/**
+ * Switch control socket to binary protocol mode, 'data' is what
+ * was received after the switch command.
+ */
+static void Control_BinaryStart(const char *data, int len)
+{
+	Uint8 *p;
+
+	if (bRemotePaused) {
+		Main_UnPauseEmulation();
+		bRemotePaused = false;
+	}
+	Binary.enabled = true;
+	Control_BinaryAppend(data, len);
+
+	p = Control_BinaryReserve(4);
+	memcpy(p, "HBIN", 4);
+	Control_BinaryPutLong(BIN_VERSION);
+	fprintf(stderr, "Control socket switched to binary protocol v%d.\n", BIN_VERSION);
+
+	Control_BinaryServe();
+}
+
+/**
+ * If given text buffer contains binary protocol switch command line,
+ * terminate text before it and return pointer to data after it,
+ * otherwise return NULL
+ */
+static char *Control_BinarySwitch(char *buffer)
+{
+	static const char cmd[] = "hatari-binary\n";
+	char *line = buffer;
+
+	while (line)
+	{
+		if (strncmp(line, cmd, sizeof(cmd)-1) == 0)
+		{
+			*line = '\0';
+			return line + sizeof(cmd)-1;
+		}
+		line = strchr(line, '\n');
+		if (line)
+			line++;
+	}
+	return NULL;
+}
+
+/**
+ * Return true if any of the queued requests is a pause request
+ * (which can be pipelined after other requests)
+ */
+static bool Control_BinaryPauseQueued(void)
+{
+	Uint32 offset = 0, len;
+
+	while (offset + BIN_HEADER <= (Uint32)Binary.inlen)
+	{
+		if (Binary.in[offset] == BIN_PAUSE)
+			return true;
+		len = Control_GetLong(Binary.in + offset + 4);
+		if (len > BIN_MAX_LENGTH)
+			break;
+		offset += BIN_HEADER + len;
+	}
+	return false;
+}
+
+/**
+ * Check for new requests while emulation is running, and whether
+ * they or a VBL run request should stop it
+ */
+static void Control_BinaryUpdate(void)
+{
+	if (!Control_BinaryRead(false))
+		return;
+	if (Control_BinaryPauseQueued())
+		Control_BinaryStop(BIN_STOP_PAUSE, 0);
+	else if (Binary.run == BIN_RUN_VBLS && nVBLs - Binary.runvbls >= 0)
+		Control_BinaryStop(BIN_STOP_VBLS, 0);
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Called by the debugger when it's invoked.  If binary protocol
+ * client runs the emulation, tell it why emulation stopped and
+ * serve its requests instead of the debugger console.
+ * 
+ * Return true if debugger console should be skipped, false otherwise
+ */
+bool Control_BinaryBreak(int reason)
+{
+	if (!Binary.enabled || !Binary.run)
+		return false;
+	Control_BinaryStop(BIN_STOP_DEBUGGER, reason);
+	return true;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if cycle count limited run is active, i.e.
+ * Control_BinaryCheckCycles() needs to be called after each instruction
+ */
+bool Control_BinaryCycleRun(void)
+{
+	return Binary.run == BIN_RUN_CYCLES;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Stop emulation if cycle count limited run is done
+ */
+void Control_BinaryCheckCycles(void)
+{
+	if (Binary.run == BIN_RUN_CYCLES && CyclesGlobalClockCounter >= Binary.runcycles)
+		Control_BinaryStop(BIN_STOP_CYCLES, 0);
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Check ControlSocket for new commands and execute them.
@@ -377,6 +1104,12 @@ bool Control_CheckUpdates(void)
 	fd_set readfds;
 	ssize_t bytes;
 	int status, sock;
+	char *binary;
+
+	if (Binary.enabled) {
+		Control_BinaryUpdate();
+		return false;
+	}
 
 	/* socket of file? */
 	if (ControlSocket) {
@@ -432,7 +1165,14 @@ bool Control_CheckUpdates(void)
 			return false;
 		}
 		buffer[bytes] = '\0';
-		Control_ProcessBuffer(buffer);
+		binary = Control_BinarySwitch(buffer);
+		if (*buffer) {
+			Control_ProcessBuffer(buffer);
+		}
+		if (binary) {
+			Control_BinaryStart(binary, bytes - (binary - buffer));
+			return false;
+		}
 
 	} while (bRemotePaused);
 	
@@ -468,6 +1208,9 @@ const char *Control_SetSocket(const char *socketpath)
 		return "connection to control socket failed";
 	}
 				
+	if (Binary.enabled) {
+		Control_BinaryClose();
+	}
 	if (ControlSocket) {
 		close(ControlSocket);
 	}
@@ -545,7 +1288,7 @@ void Control_ReparentWindow(int width, int height, bool noembed)
 		XReparentWindow(display, sdl_win, parent_win, 0, 0);
 
 		/* whether to send new window size */
-		if (bSendEmbedInfo && ControlSocket) {
+		if (bSendEmbedInfo && ControlSocket && !Binary.enabled) {
 			fprintf(stderr, "New %dx%d SDL window with ID: %lx\n",
 				width, height, sdl_win);
 			sprintf(buffer, "%dx%d", width, height);
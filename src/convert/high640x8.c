@@ -24,6 +24,14 @@ static void ConvertHighRes_640x8Bit(void)
 
 	for (y = STScreenStartHorizLine; y < STScreenEndHorizLine; y++)
 	{
+		if (!Convert_LineChanged(update, y))
+		{
+			/* Same as in previous frame, skip to next line */
+			edi += 40;
+			ebp += 40;
+			esi += PCScreenBytesPerLine/4;
+			continue;
+		}
 
 		for (x = 0; x < 40; x++)
 		{
@@ -33,7 +41,7 @@ static void ConvertHighRes_640x8Bit(void)
 
 			if (update || ebx != *ebp)  /* Does differ? */
 			{
-				bScreenContentsChanged = true;
+				Convert_SpanChanged(esi, esi + 4, 1);
 
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
 				/* Plot in 'right-order' on big endian systems */
@@ -27,6 +27,13 @@ static void ConvertLowRes_320x16Bit(void)
 
 		update = AdjustLinePaletteRemap(y) & PALETTEMASK_UPDATEMASK;
 
+		if (!Convert_LineChanged(update, y))
+		{
+			/* Same as in previous frame, nothing to convert */
+			pPCScreenDest = (((Uint8 *)pPCScreenDest)+PCScreenBytesPerLine);
+			continue;
+		}
+
 		x = STScreenWidthBytes>>3; /* Amount to draw across in 16-pixels (8 bytes) */
 
 		do    /* x-loop */
@@ -39,7 +46,7 @@ static void ConvertLowRes_320x16Bit(void)
 			{
 				/* copy word */
 
-				bScreenContentsChanged = true;
+				Convert_SpanChanged(esi, esi + 16, 1);
 
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
 				/* Plot pixels */
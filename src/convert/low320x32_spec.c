@@ -98,4 +98,5 @@ static void ConvertLowRes_320x32Bit_Spec(void)
 	}
 
 	bScreenContentsChanged = true;
+	bDirtyFull = true;               /* every line is converted */
 }
@@ -30,6 +30,13 @@ static void ConvertLowRes_320x8Bit(void)
 
 		update = AdjustLinePaletteRemap(y) & PALETTEMASK_UPDATEMASK;
 
+		if (!Convert_LineChanged(update, y))
+		{
+			/* Same as in previous frame, nothing to convert */
+			pPCScreenDest = (((Uint8 *)pPCScreenDest)+PCScreenBytesPerLine);  /* Offset to next line */
+			continue;
+		}
+
 		x = STScreenWidthBytes>>3;   /* Amount to draw across in 16-pixels(8 bytes) */
 
 		do    /* x-loop */
@@ -42,7 +49,7 @@ static void ConvertLowRes_320x8Bit(void)
 			{
 				/* copy word */
 
-				bScreenContentsChanged = true;
+				Convert_SpanChanged(esi, esi + 4, 1);
 
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
 				/* Plot pixels */
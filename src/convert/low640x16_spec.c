@@ -30,6 +30,7 @@ static void ConvertLowRes_640x16Bit_Spec(void)
 	}
 
         bScreenContentsChanged = true;
+        bDirtyFull = true;                /* every line is converted */
 }
 
 
@@ -27,7 +27,7 @@ static void Line_ConvertLowRes_640x8Bit(Uint32 *edi, Uint32 *ebp, Uint32 *esi, U
 		{
 			/* copy word */
 
-			bScreenContentsChanged = true;
+			Convert_SpanChanged(esi, esi + 8, bScrDoubleY ? 2 : 1);
 
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
 			/* Plot in 'right-order' on big endian systems */
@@ -98,7 +98,7 @@ static void ConvertLowRes_640x8Bit(void)
 	Uint32 *edi, *ebp;
 	Uint32 *esi;
 	Uint32 eax;
-	int y;
+	int y, mask;
 
 	Convert_StartFrame();           /* Start frame, track palettes */
 
@@ -111,10 +111,14 @@ static void ConvertLowRes_640x8Bit(void)
 		ebp = (Uint32 *)((Uint8 *)pSTScreenCopy + eax);   /* Previous ST format screen */
 		esi = (Uint32 *)pPCScreenDest;                    /* PC format screen */
 
-		if (AdjustLinePaletteRemap(y) & 0x00030000)       /* Change palette table */
-			Line_ConvertMediumRes_640x8Bit(edi, ebp, esi, eax);
-		else
-			Line_ConvertLowRes_640x8Bit(edi, ebp, esi, eax);
+		mask = AdjustLinePaletteRemap(y);
+		if (Convert_LineChanged(mask, y))
+		{
+			if (mask & 0x00030000)   /* Change palette table */
+				Line_ConvertMediumRes_640x8Bit(edi, ebp, esi, eax);
+			else
+				Line_ConvertLowRes_640x8Bit(edi, ebp, esi, eax);
+		}
 
 		pPCScreenDest = (((Uint8 *)pPCScreenDest)+PCScreenBytesPerLine*2);  /* Offset to next line */
 	}
@@ -12,7 +12,7 @@ static void ConvertMediumRes_640x16Bit(void)
 	Uint32 *edi, *ebp;
 	Uint16 *esi;
 	Uint32 eax;
-	int y;
+	int y, mask;
 
 	Convert_StartFrame();            /* Start frame, track palettes */
 
@@ -24,10 +24,14 @@ static void ConvertMediumRes_640x16Bit(void)
 		ebp = (Uint32 *)((Uint8 *)pSTScreenCopy + eax);    /* Previous ST format screen */
 		esi = (Uint16 *)pPCScreenDest;                     /* PC format screen */
 
-		if (AdjustLinePaletteRemap(y) & 0x00030000)        /* Change palette table */
-			Line_ConvertMediumRes_640x16Bit(edi, ebp, esi, eax);
-		else
-			Line_ConvertLowRes_640x16Bit(edi, ebp, (Uint32 *)esi, eax);
+		mask = AdjustLinePaletteRemap(y);
+		if (Convert_LineChanged(mask, y))
+		{
+			if (mask & 0x00030000)    /* Change palette table */
+				Line_ConvertMediumRes_640x16Bit(edi, ebp, esi, eax);
+			else
+				Line_ConvertLowRes_640x16Bit(edi, ebp, (Uint32 *)esi, eax);
+		}
 
 		/* Offset to next line */
 		pPCScreenDest = (((Uint8 *)pPCScreenDest) + PCScreenBytesPerLine * 2);
@@ -54,7 +58,7 @@ static void Line_ConvertMediumRes_640x16Bit(Uint32 *edi, Uint32 *ebp, Uint16 *es
 		{
 			/* copy word */
 
-			bScreenContentsChanged = true;
+			Convert_SpanChanged(esi, esi + 16, bScrDoubleY ? 2 : 1);
 
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
 			/* Plot in 'right-order' on big endian systems */
@@ -33,6 +33,7 @@ static void ConvertMediumRes_640x16Bit_Spec(void)
 	}
 
         bScreenContentsChanged = true;
+        bDirtyFull = true;                /* every line is converted */
 }
 
 
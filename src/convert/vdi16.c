@@ -26,6 +26,14 @@ static void ConvertVDIRes_16Colour(void)
 
 	for (y = 0; y < VDIHeight; y++)
 	{
+		if (!Convert_LineChanged(update, y))
+		{
+			/* Same as in previous frame, skip to next line */
+			edi += (VDIWidth >> 4) * 2;
+			ebp += (VDIWidth >> 4) * 2;
+			pPCScreenDest = (((Uint8 *)pPCScreenDest) + PCScreenBytesPerLine);
+			continue;
+		}
 
 		esi = (Uint32 *)pPCScreenDest;  /* PC format screen, byte per pixel 256 colors */
 
@@ -40,7 +48,7 @@ static void ConvertVDIRes_16Colour(void)
 			/* Full update? or just test changes? */
 			if (update || ebx != *ebp || ecx != *(ebp+1))   /* Does differ? */
 			{
-				bScreenContentsChanged = true;
+				Convert_SpanChanged(esi, esi + 4, 1);
 
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
 				/* Plot pixels */
@@ -21,6 +21,14 @@ static void ConvertVDIRes_2Colour(void)
 
 	for (y = 0; y < VDIHeight; y++)
 	{
+		if (!Convert_LineChanged(update, y))
+		{
+			/* Same as in previous frame, skip to next line */
+			edi += VDIWidth >> 4;
+			ebp += VDIWidth >> 4;
+			pPCScreenDest = (((Uint8 *)pPCScreenDest) + PCScreenBytesPerLine);
+			continue;
+		}
 
 		esi = (Uint32 *)pPCScreenDest;  /* PC format screen, byte per pixel 256 colors */
 
@@ -33,7 +41,7 @@ static void ConvertVDIRes_2Colour(void)
 
 			if (update || ebx != *ebp)  /* Does differ? */
 			{
-				bScreenContentsChanged = true;
+				Convert_SpanChanged(esi, esi + 4, 1);
 
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
 				/* Plot in 'right-order' on big endian systems */
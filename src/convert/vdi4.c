@@ -22,6 +22,14 @@ static void ConvertVDIRes_4Colour(void)
 
 	for (y = 0; y < VDIHeight; y++)
 	{
+		if (!Convert_LineChanged(update, y))
+		{
+			/* Same as in previous frame, skip to next line */
+			edi += VDIWidth >> 4;
+			ebp += VDIWidth >> 4;
+			pPCScreenDest = (((Uint8 *)pPCScreenDest) + PCScreenBytesPerLine);
+			continue;
+		}
 
 		esi = (Uint32 *)pPCScreenDest;  /* PC format screen, byte per pixel 256 colors */
 
@@ -34,7 +42,7 @@ static void ConvertVDIRes_4Colour(void)
 
 			if (update || ebx != *ebp)  /* Update? */
 			{
-				bScreenContentsChanged = true;
+				Convert_SpanChanged(esi, esi + 4, 1);
 
 				/* Plot pixels */
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
@@ -60,28 +60,50 @@ static inline bool is_unaligned(uaecptr addr, int size)
     return unlikely((addr & (size - 1)) && (addr ^ (addr + size - 1)) & 0x1000);
 }
 
+/* Physical accesses use the same RAM/ROM host page tables as get_*()/put_*() */
 static ALWAYS_INLINE void phys_put_long(uaecptr addr, uae_u32 l)
 {
-    longput(addr, l);
+    uae_u8 *p = mem_hostpage_write[bankindex(addr)];
+    if (p)
+	do_put_mem_long(p + hostpage_offset(addr), l);
+    else
+	longput(addr, l);
 }
 static ALWAYS_INLINE void phys_put_word(uaecptr addr, uae_u32 w)
 {
-    wordput(addr, w);
+    uae_u8 *p = mem_hostpage_write[bankindex(addr)];
+    if (p)
+	do_put_mem_word(p + hostpage_offset(addr), w);
+    else
+	wordput(addr, w);
 }
 static ALWAYS_INLINE void phys_put_byte(uaecptr addr, uae_u32 b)
 {
-    byteput(addr, b);
+    uae_u8 *p = mem_hostpage_write[bankindex(addr)];
+    if (p)
+	p[hostpage_offset(addr)] = b;
+    else
+	byteput(addr, b);
 }
 static ALWAYS_INLINE uae_u32 phys_get_long(uaecptr addr)
 {
+    uae_u8 *p = mem_hostpage_read[bankindex(addr)];
+    if (p)
+	return do_get_mem_long(p + hostpage_offset(addr));
     return longget (addr);
 }
 static ALWAYS_INLINE uae_u32 phys_get_word(uaecptr addr)
 {
+    uae_u8 *p = mem_hostpage_read[bankindex(addr)];
+    if (p)
+	return do_get_mem_word(p + hostpage_offset(addr));
     return wordget (addr);
 }
 static ALWAYS_INLINE uae_u32 phys_get_byte(uaecptr addr)
 {
+    uae_u8 *p = mem_hostpage_read[bankindex(addr)];
+    if (p)
+	return p[hostpage_offset(addr)];
     return byteget (addr);
 }
 
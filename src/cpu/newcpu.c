@@ -1446,13 +1446,18 @@ static void Exception_ce000 (int nr, uaecptr oldpc)
 	/* Handle Hatari GEM and BIOS traps */
 	if (bVdiAesIntercept && nr == 0x22) {
 		/* Intercept VDI & AES exceptions (Trap #2) */
-		if (VDI_AES_Entry()) {
+		switch (VDI_AES_Entry()) {
+		case VDI_ENTRY_DONE:
+			/* Call was done natively, skip the trap */
+			return;
+		case VDI_ENTRY_COMPLETE:
 			/* Set 'PC' to address of 'VDI_OPCODE' illegal instruction.
 			 * This will call OpCode_VDI() after completion of Trap call!
 			 * This is used to modify specific VDI return vectors contents.
 			*/
 			VDI_OldPC = currpc;
 			currpc = CART_VDI_OPCODE_ADDR;
+			break;
 		}
 	}
 	if (bBiosIntercept) {
@@ -1681,13 +1686,18 @@ static void Exception_normal (int nr, uaecptr oldpc, int ExceptionSource)
 	if (ExceptionSource == M68000_EXC_SRC_CPU) {
 		if (bVdiAesIntercept && nr == 0x22) {
 			/* Intercept VDI & AES exceptions (Trap #2) */
-			if (VDI_AES_Entry()) {
+			switch (VDI_AES_Entry()) {
+			case VDI_ENTRY_DONE:
+				/* Call was done natively, skip the trap */
+				return;
+			case VDI_ENTRY_COMPLETE:
 				/* Set 'PC' to address of 'VDI_OPCODE' illegal instruction.
 				 * This will call OpCode_VDI() after completion of Trap call!
 				 * This is used to modify specific VDI return vectors contents.
 				*/
 				VDI_OldPC = currpc;
 				currpc = CART_VDI_OPCODE_ADDR;
+				break;
 			}
 		}
 
@@ -59,6 +59,7 @@ const char CycInt_fileid[] = "Hatari cycInt.c : " __DATE__ " " __TIME__;
 #include "m68000.h"
 #include "mfp.h"
 #include "midi.h"
+#include "rs232.h"
 #include "memorySnapShot.h"
 #include "sound.h"
 #include "screen.h"
@@ -86,12 +87,14 @@ static void (* const pIntHandlerFunctions[MAX_INTERRUPTS])(void) =
 	ACIA_InterruptHandler_IKBD,
 	IKBD_InterruptHandler_ResetTimer,
 	IKBD_InterruptHandler_AutoSend,
+	IKBD_InterruptHandler_CPU,
 	DmaSnd_InterruptHandler_Microwire, /* Used for both STE and Falcon Microwire emulation */
 	Crossbar_InterruptHandler_25Mhz,
 	Crossbar_InterruptHandler_32Mhz,
 	FDC_InterruptHandler_Update,
 	Blitter_InterruptHandler,
 	Midi_InterruptHandler_Update,
+	RS232_InterruptHandler,
 
 };
 
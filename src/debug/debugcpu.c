@@ -17,6 +17,7 @@ const char DebugCpu_fileid[] = "Hatari debugcpu.c : " __DATE__ " " __TIME__;
 #include "main.h"
 #include "breakcond.h"
 #include "configuration.h"
+#include "control.h"
 #include "debugui.h"
 #include "debug_priv.h"
 #include "debugcpu.h"
@@ -632,6 +633,10 @@ void DebugCpu_Check(void)
 	{
 		Console_Check();
 	}
+	if (Control_BinaryCycleRun())
+	{
+		Control_BinaryCheckCycles();
+	}
 }
 
 /**
@@ -646,7 +651,7 @@ void DebugCpu_SetDebugging(void)
 
 	if (nCpuActiveCBs || nCpuSteps || bCpuProfiling || History_TrackCpu()
 	    || LOG_TRACE_LEVEL((TRACE_CPU_DISASM|TRACE_CPU_SYMBOLS))
-	    || ConOutDevice != CONOUT_DEVICE_NONE)
+	    || ConOutDevice != CONOUT_DEVICE_NONE || Control_BinaryCycleRun())
 	{
 		M68000_SetSpecial(SPCFLAG_DEBUGGER);
 		nCpuInstructions = 0;
@@ -24,6 +24,7 @@ const char DebugUI_fileid[] = "Hatari debugui.c : " __DATE__ " " __TIME__;
 #include "main.h"
 #include "change.h"
 #include "configuration.h"
+#include "control.h"
 #include "file.h"
 #include "log.h"
 #include "m68000.h"
@@ -990,6 +991,10 @@ void DebugUI(debug_reason_t reason)
 
 	History_Mark(reason);
 
+	/* binary control protocol client handles the stop instead? */
+	if (Control_BinaryBreak(reason))
+		return;
+
 	if (bInFullScreen)
 		Screen_ReturnFromFullScreen();
 
@@ -14,12 +14,16 @@
 const char Natfeats_fileid[] = "Hatari natfeats.c : " __DATE__ " " __TIME__;
 
 #include <stdio.h>
+#include <time.h>
+#include <SDL.h>
 #include "main.h"
 #include "version.h"
 #include "configuration.h"
+#include "cycles.h"
 #include "stMemory.h"
 #include "m68000.h"
 #include "natfeats.h"
+#include "profile.h"
 
 #define NF_DEBUG 1
 #if NF_DEBUG
@@ -91,6 +95,104 @@ static bool nf_shutdown(Uint32 stack, Uint32 subid, Uint32 *retval)
 	return true;
 }
 
+/**
+ * Store 64-bit value as two big endian longs to given address,
+ * if it's non-zero.  Return false if there was an exception.
+ */
+static bool nf_store_u64(Uint32 ptr, Uint64 value)
+{
+	if (!ptr) {
+		return true;
+	}
+	if (!STMemory_ValidArea(ptr, 2*SIZE_LONG)) {
+		M68000_BusError(ptr, BUS_ERROR_WRITE);
+		return false;
+	}
+	STMemory_WriteLong(ptr, value >> 32);
+	STMemory_WriteLong(ptr + SIZE_LONG, value & 0xffffffff);
+	return true;
+}
+
+/**
+ * subid 0: emulation clock counter (in 8Mhz cycles), its full 64-bit
+ *          value is also stored to (optional) pointer given as argument
+ * subid 1-: Hatari internal cycle counter (sound, video, CPU)
+ * Returns low 32 bits of the value.
+ */
+static bool nf_cycles(Uint32 stack, Uint32 subid, Uint32 *retval)
+{
+	//Dprintf(("NF cycles[%d]()\n", subid));
+	if (subid) {
+		if (subid > CYCLES_COUNTER_MAX) {
+			*retval = 0;
+			return true;
+		}
+		*retval = Cycles_GetCounter(subid - 1);
+		return true;
+	}
+	*retval = CyclesGlobalClockCounter & 0xffffffff;
+	return nf_store_u64(STMemory_ReadLong(stack), CyclesGlobalClockCounter);
+}
+
+/**
+ * Host monotonic clock in microseconds, full 64-bit value is also
+ * stored to (optional) pointer given as argument.
+ * Returns low 32 bits of the value.
+ */
+static bool nf_hosttime(Uint32 stack, Uint32 subid, Uint32 *retval)
+{
+	Uint64 usecs;
+#ifdef CLOCK_MONOTONIC
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	usecs = (Uint64)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+#else
+	usecs = (Uint64)SDL_GetTicks() * 1000;
+#endif
+	//Dprintf(("NF hosttime() -> %"PRIu64"\n", usecs));
+	*retval = usecs & 0xffffffff;
+	return nf_store_u64(STMemory_ReadLong(stack), usecs);
+}
+
+/**
+ * subid 0: begin named CPU profiling region, return its index + 1
+ * subid 1: end named (or innermost if name is NULL) region
+ * Returns zero on failure.
+ */
+static bool nf_profile(Uint32 stack, Uint32 subid, Uint32 *retval)
+{
+	char name[32];
+	Uint32 ptr;
+	int i;
+
+	ptr = STMemory_ReadLong(stack);
+	if (!ptr && subid) {
+		Dprintf(("NF profile end()\n"));
+		*retval = Profile_CpuRegionEnd(NULL);
+		return true;
+	}
+	if (!STMemory_ValidArea(ptr, 1)) {
+		M68000_BusError(ptr, BUS_ERROR_READ);
+		return false;
+	}
+	for (i = 0; i < (int)sizeof(name) - 1 && STMemory_ValidArea(ptr + i, 1); i++) {
+		name[i] = STMemory_ReadByte(ptr + i);
+		if (!name[i]) {
+			break;
+		}
+	}
+	name[i] = '\0';
+	Dprintf(("NF profile %s(\"%s\")\n", subid ? "end" : "begin", name));
+
+	if (subid) {
+		*retval = Profile_CpuRegionEnd(name);
+	} else {
+		*retval = Profile_CpuRegionBegin(name) + 1;
+	}
+	return true;
+}
+
 /* ---------------------------- */
 
 #define FEATNAME_MAX 16
@@ -103,7 +205,10 @@ static const struct {
 	{ "NF_NAME",     false, nf_name },
 	{ "NF_VERSION",  false, nf_version },
 	{ "NF_STDERR",   false, nf_stderr },
-	{ "NF_SHUTDOWN", true,  nf_shutdown }
+	{ "NF_SHUTDOWN", true,  nf_shutdown },
+	{ "NF_CYCLES",   false, nf_cycles },
+	{ "NF_HOSTTIME", false, nf_hosttime },
+	{ "NF_PROFILE",  false, nf_profile }
 };
 
 /* macros from Aranym */
@@ -31,6 +31,10 @@ extern bool Profile_CpuStart(void);
 extern void Profile_CpuUpdate(void);
 extern void Profile_CpuStop(void);
 
+/* CPU profile regions */
+extern int Profile_CpuRegionBegin(const char *name);
+extern bool Profile_CpuRegionEnd(const char *name);
+
 /* CPU profile results */
 extern bool Profile_CpuAddressData(Uint32 addr, float *percentage, Uint32 *count, Uint32 *cycles, Uint32 *misses);
 
@@ -90,6 +90,7 @@ extern void Profile_CpuShowCycles(int show);
 extern void Profile_CpuShowMisses(int show);
 extern void Profile_CpuShowStats(void);
 extern void Profile_CpuShowCallers(FILE *fp);
+extern void Profile_CpuShowRegions(FILE *out);
 extern void Profile_CpuSave(FILE *out);
 
 /* internal DSP profile results */
@@ -83,6 +83,24 @@ static struct {
 /* special hack for EmuTOS */
 static Uint32 etos_switcher;
 
+/* named profiling regions, set from emulated code through NatFeats */
+#define MAX_PROFILE_REGIONS	32
+#define MAX_REGION_DEPTH	8
+#define MAX_REGION_NAME		32
+
+typedef struct {
+	char name[MAX_REGION_NAME];
+	Uint32 entries;		/* how many times region was entered */
+	counters_t counters;	/* totals for everything done within region */
+} profile_region_t;
+
+static struct {
+	profile_region_t region[MAX_PROFILE_REGIONS];
+	int count;		/* number of named regions */
+	int stack[MAX_REGION_DEPTH];
+	int depth;		/* number of currently active regions */
+} cpu_regions;
+
 
 /* ------------------ CPU profile address mapping ----------------- */
 
@@ -217,6 +235,11 @@ void Profile_CpuShowStats(void)
 	fprintf(stderr, "\n= %.5fs\n",
 		(double)cpu_profile.all.cycles / MachineClocks.CPU_Freq);
 
+	if (cpu_regions.count) {
+		fprintf(stderr, "\nProfiling regions:\n");
+		Profile_CpuShowRegions(stderr);
+	}
+
 #if ENABLE_WINUAE_CPU
 	if (cpu_profile.all.misses) {	/* CPU cache in use? */
 		int i;
@@ -559,6 +582,116 @@ void Profile_CpuSave(FILE *out)
 	fprintf(out, "CARTRIDGE:\t0xfa0000-0xfc0000\n");
 	Profile_CpuShowAddresses(0, 0xFC0000-2, out);
 	Profile_CpuShowCallers(out);
+	Profile_CpuShowRegions(out);
+}
+
+/* ------------------ CPU profile regions ----------------- */
+
+/**
+ * Start named profiling region, return its index
+ * or -1 if there are too many regions.
+ */
+int Profile_CpuRegionBegin(const char *name)
+{
+	int i;
+
+	if (cpu_regions.depth >= MAX_REGION_DEPTH) {
+		fprintf(stderr, "WARNING: profile regions nested too deep, ignoring '%s'!\n", name);
+		return -1;
+	}
+	for (i = 0; i < cpu_regions.count; i++) {
+		if (strncmp(cpu_regions.region[i].name, name, MAX_REGION_NAME-1) == 0) {
+			break;
+		}
+	}
+	if (i == cpu_regions.count) {
+		if (i >= MAX_PROFILE_REGIONS) {
+			fprintf(stderr, "WARNING: too many profile regions, ignoring '%s'!\n", name);
+			return -1;
+		}
+		strncpy(cpu_regions.region[i].name, name, MAX_REGION_NAME-1);
+		cpu_regions.count++;
+	}
+	cpu_regions.region[i].entries++;
+	cpu_regions.stack[cpu_regions.depth++] = i;
+	return i;
+}
+
+/**
+ * End innermost named profiling region, or given one and the regions
+ * inside it if name is given.  Return false if there was no such region.
+ */
+bool Profile_CpuRegionEnd(const char *name)
+{
+	int depth;
+
+	for (depth = cpu_regions.depth; depth > 0; depth--) {
+		if (!name || strncmp(cpu_regions.region[cpu_regions.stack[depth-1]].name,
+				     name, MAX_REGION_NAME-1) == 0) {
+			cpu_regions.depth = depth - 1;
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Add cost of last instruction to all active regions,
+ * recursively entered regions are accounted only once.
+ */
+static void update_regions(Uint32 cycles, Uint32 misses)
+{
+	counters_t *counters;
+	int i, j, idx;
+
+	for (i = 0; i < cpu_regions.depth; i++) {
+		idx = cpu_regions.stack[i];
+		for (j = 0; j < i; j++) {
+			if (cpu_regions.stack[j] == idx) {
+				break;
+			}
+		}
+		if (j < i) {
+			continue;
+		}
+		counters = &(cpu_regions.region[idx].counters);
+		counters->misses += misses;
+		counters->cycles += cycles;
+		counters->count++;
+	}
+}
+
+/**
+ * Show named profiling region statistics.
+ */
+void Profile_CpuShowRegions(FILE *out)
+{
+	profile_region_t *region;
+	int i;
+
+	if (!cpu_regions.count) {
+		return;
+	}
+	fputs("# region <name>: <entries> (<instructions>, <cycles>, <i-cache misses>)\n", out);
+	for (i = 0; i < cpu_regions.count; i++) {
+		region = &(cpu_regions.region[i]);
+		fprintf(out, "region %s: %u (%"PRIu64", %"PRIu64", %"PRIu64")\n",
+			region->name, region->entries, region->counters.count,
+			region->counters.cycles, region->counters.misses);
+	}
+}
+
+/**
+ * Zero named profiling region counters, but keep active regions.
+ */
+static void reset_regions(void)
+{
+	int i;
+
+	for (i = 0; i < cpu_regions.count; i++) {
+		cpu_regions.region[i].entries = 0;
+		memset(&(cpu_regions.region[i].counters), 0, sizeof(counters_t));
+	}
 }
 
 /* ------------------ CPU profile control ----------------- */
@@ -615,6 +748,7 @@ bool Profile_CpuStart(void)
 	cpu_profile.loop_end = PC_UNDEFINED;
 	cpu_profile.loop_count = 0;
 	Profile_LoopReset();
+	reset_regions();
 
 	cpu_profile.disasm_addr = 0;
 	cpu_profile.processed = false;
@@ -871,6 +1005,10 @@ void Profile_CpuUpdate(void)
 	counters->cycles += cycles;
 	counters->count++;
 
+	if (unlikely(cpu_regions.depth)) {
+		update_regions(cycles, misses);
+	}
+
 #if DEBUG
 	if (unlikely(OpcodeFamily == 0)) {
 		Uint32 nextpc;
@@ -116,13 +116,13 @@ const char DmaSnd_fileid[] = "Hatari dmaSnd.c : " __DATE__ " " __TIME__;
 #define DMASND_FIFO_SIZE	8			/* 8 bytes : size of the DMA Audio's FIFO, filled on every HBL */
 #define DMASND_FIFO_SIZE_MASK	(DMASND_FIFO_SIZE-1)	/* mask to keep FIFO_pos in 0-7 range */
 
+#define DMASND_BLOCK_SIZE	512			/* max number of samples generated in one pass */
+
 
 /* Global variables that can be changed/read from other parts of Hatari */
 
-static void DmaSnd_Apply_LMC(int nMixBufIdx, int nSamplesToGenerate);
+static void DmaSnd_Apply_LMC(Sint16 (*pMix)[2], int nSamples);
 static void DmaSnd_Set_Tone_Level(int set_bass, int set_treb);
-static float DmaSnd_IIRfilterL(float xn);
-static float DmaSnd_IIRfilterR(float xn);
 static struct first_order_s *DmaSnd_Treble_Shelf(float g, float fc, float Fs);
 static struct first_order_s *DmaSnd_Bass_Shelf(float g, float fc, float Fs);
 static Sint16 DmaSnd_LowPassFilterLeft(Sint16 in);
@@ -178,6 +178,7 @@ struct lmc1992_s {
 static struct dma_s dma;
 static struct microwire_s microwire;
 static struct lmc1992_s lmc1992;
+static float lmc1992_data[2][2];		/* IIR filter state (wn-1, wn-2) for left & right */
 
 /* dB = 20log(gain)  :  gain = antilog(dB/20)                                */
 /* Table gain values = (int)(powf(10.0, dB/20.0)*65536.0 + 0.5)  2dB steps   */
@@ -214,6 +215,10 @@ static const int DmaSndSampleRates[4] =
 	6258, 12517, 25033, 50066
 };
 
+/* Ratio between each DMA sound frequency and host sound frequency, */
+/* with 32 bits fractional part (set for nAudioFrequency) */
+static Sint64 DmaSndFreqRatio[4];
+
 
 
 /*--------------------------------------------------------------*/
@@ -224,7 +229,6 @@ static void	DmaSnd_FIFO_Refill(void);
 static Sint8	DmaSnd_FIFO_PullByte(void);
 static void	DmaSnd_FIFO_SetStereo(void);
 
-static int	DmaSnd_DetectSampleRate(void);
 static void	DmaSnd_StartNewFrame(void);
 static inline int DmaSnd_EndOfFrameReached(void);
 
@@ -399,16 +403,6 @@ static void DmaSnd_FIFO_SetStereo(void)
 }
 
 
-/*-----------------------------------------------------------------------*/
-/**
- * Returns the frequency corresponding to the 2 lower bits of dma.soundMode
- */
-static int DmaSnd_DetectSampleRate(void)
-{
-	return DmaSndSampleRates[dma.soundMode & 3];
-}
-
-
 /*-----------------------------------------------------------------------*/
 /**
  * This function is called when a new sound frame is started.
@@ -457,7 +451,32 @@ static inline int DmaSnd_EndOfFrameReached(void)
 
 /*-----------------------------------------------------------------------*/
 /**
- * Mix DMA sound sample with the normal PSG sound samples.
+ * Get the next DMA sample(s) from the FIFO, through the anti-alias filter
+ */
+static inline void DmaSnd_PullFrame(void)
+{
+	Sint8 LeftByte , RightByte;
+
+	if (dma.soundMode & DMASNDMODE_MONO)
+	{
+		LeftByte = RightByte = DmaSnd_FIFO_PullByte ();
+	}
+	else
+	{
+		LeftByte = DmaSnd_FIFO_PullByte ();
+		RightByte = DmaSnd_FIFO_PullByte ();
+	}
+	dma.FrameLeft  = DmaSnd_LowPassFilterLeft( (Sint16)LeftByte );
+	dma.FrameRight = DmaSnd_LowPassFilterRight( (Sint16)RightByte );
+}
+
+
+/**
+ * Generate samples for a block which doesn't wrap around the end of MixBuffer.
+ * The DMA samples are first resampled to the host frequency in a separate
+ * pass (FIFO is accessed only there), then mixed with the YM samples, so
+ * that the mixing mode doesn't need to be checked for each sample.
+ *
  * Note: We adjust the volume level of the 8-bit DMA samples to factor
  * 0.75 compared to the PSG sound samples.
  *
@@ -473,156 +492,112 @@ static inline int DmaSnd_EndOfFrameReached(void)
  * Multiply DMA sound by -1 because the LMC1992 inverts the signal
  * ( YM sign is +1 :: -1(op-amp) * -1(Lmc1992) ).
  */
-
-
-void DmaSnd_GenerateSamples(int nMixBufIdx, int nSamplesToGenerate)
+static void DmaSnd_GenerateBlock(Sint16 (*pMix)[2], int nSamples)
 {
-	int i;
-	int nBufIdx;
-	Sint8 MonoByte , LeftByte , RightByte;
-	unsigned n;
+	Sint32 DmaLeft[DMASND_BLOCK_SIZE], DmaRight[DMASND_BLOCK_SIZE];
 	Sint64 FreqRatio;
+	bool bMono;
+	unsigned n;
+	int i;
 
-
-	/* DMA Audio OFF and FIFO empty : process YM2149's output */
 	if ( !(nDmaSoundControl & DMASNDCTRL_PLAY) && ( dma.FIFO_NbBytes == 0 ) )
 	{
-		for (i = 0; i < nSamplesToGenerate; i++)
+		/* DMA Audio OFF and FIFO empty : mix latest DMA values */
+		for (i = 0; i < nSamples; i++)
 		{
-			nBufIdx = (nMixBufIdx + i) % MIXBUFFER_SIZE;
-
-			switch (microwire.mixing) {
-				case 1:
-					/* DMA and (YM2149 0 dB) mixing */
-					MixBuffer[nBufIdx][1]  = MixBuffer[nBufIdx][0] + dma.FrameRight * -((256*3/4)/4)/4;	
-					MixBuffer[nBufIdx][0] += dma.FrameLeft * -((256*3/4)/4)/4;	
-					break;
-				case 2:
-					/* DMA only (but DMA is off in that case) */
-					MixBuffer[nBufIdx][0]  = MixBuffer[nBufIdx][1] = 0;
-				default:
-					/* DMA and (YM2149 -12 dB) mixing */
-					MixBuffer[nBufIdx][0] /= 4;
-					MixBuffer[nBufIdx][1]  = MixBuffer[nBufIdx][0] + dma.FrameRight * -((256*3/4)/4)/4;	
-					MixBuffer[nBufIdx][0] += dma.FrameLeft * -((256*3/4)/4)/4;	
-					break;
-			}
+			DmaLeft[i] = dma.FrameLeft * -((256*3/4)/4)/4;
+			DmaRight[i] = dma.FrameRight * -((256*3/4)/4)/4;
 		}
-
-		/* Apply LMC1992 sound modifications (Bass and Treble) */
-		DmaSnd_Apply_LMC ( nMixBufIdx , nSamplesToGenerate );
-
-		return;
 	}
-
-
-	/* DMA Audio ON or FIFO not empty yet */
-
-	/* Compute ratio between DMA's sound frequency and host computer's sound frequency, */
-	/* use << 32 to simulate floating point precision */
-	FreqRatio = ( ((Sint64)DmaSnd_DetectSampleRate()) << 32 ) / nAudioFrequency;
-
-	if (dma.soundMode & DMASNDMODE_MONO)
+	else
 	{
-		/* Mono 8-bit */
-		for (i = 0; i < nSamplesToGenerate; i++)
-		{
-			if ( DmaInitSample )
-			{
-				MonoByte = DmaSnd_FIFO_PullByte ();
-				dma.FrameLeft  = DmaSnd_LowPassFilterLeft( (Sint16)MonoByte );
-				dma.FrameRight = DmaSnd_LowPassFilterRight( (Sint16)MonoByte );
-				DmaInitSample = false;
-			}
+		/* DMA Audio ON or FIFO not empty yet : resample DMA sound */
+		FreqRatio = DmaSndFreqRatio[dma.soundMode & 3];
+		bMono = dma.soundMode & DMASNDMODE_MONO;
 
-			nBufIdx = (nMixBufIdx + i) % MIXBUFFER_SIZE;
-
-			switch (microwire.mixing) {
-				case 1:
-					/* DMA and (YM2149 0 dB) mixing */
-					MixBuffer[nBufIdx][0] = MixBuffer[nBufIdx][0] + dma.FrameLeft * -((256*3/4)/4)/4;
-					break;
-				case 2:
-					/* DMA only */
-					MixBuffer[nBufIdx][0] = dma.FrameLeft * -((256*3/4)/4)/4;
-					break;
-				default:
-					/* DMA and (YM2149 -12 dB) mixing */
-					/* instead of 16462 (-12 dB), we approximate by 16384 */
-					MixBuffer[nBufIdx][0] = (dma.FrameLeft * -((256*3/4)/4)/4) +
-								(((Sint32)MixBuffer[nBufIdx][0] * 16384)/65536);
-					break;
-			}
+		if ( DmaInitSample )
+		{
+			DmaSnd_PullFrame();
+			DmaInitSample = false;
+		}
 
-			MixBuffer[nBufIdx][1] = MixBuffer[nBufIdx][0];		/* right = left */
+		for (i = 0; i < nSamples; i++)
+		{
+			DmaLeft[i] = dma.FrameLeft * -((256*3/4)/4)/4;
+			if (bMono)
+				DmaRight[i] = DmaLeft[i];		/* right = left */
+			else
+				DmaRight[i] = dma.FrameRight * -((256*3/4)/4)/4;
 
 			/* Increase freq counter */
 			frameCounter_float += FreqRatio;
-			n = frameCounter_float >> 32;				/* number of samples to skip */
-			while ( n > 0 )						/* pull as many bytes from the FIFO as needed */
+			n = frameCounter_float >> 32;			/* number of samples to skip */
+			while ( n > 0 )					/* pull as many bytes from the FIFO as needed */
 			{
-				MonoByte = DmaSnd_FIFO_PullByte ();
-				dma.FrameLeft  = DmaSnd_LowPassFilterLeft( (Sint16)MonoByte );
-				dma.FrameRight = DmaSnd_LowPassFilterRight( (Sint16)MonoByte );
+				DmaSnd_PullFrame();
 				n--;
 			}
-			frameCounter_float &= 0xffffffff;			/* only keep the fractional part */
+			frameCounter_float &= 0xffffffff;		/* only keep the fractional part */
 		}
 	}
-	else
-	{
-		/* Stereo 8-bit */
-		for (i = 0; i < nSamplesToGenerate; i++)
-		{
-			if ( DmaInitSample )
+
+	/* Mix DMA and YM samples (YM sample is the same in both channels) */
+	switch (microwire.mixing) {
+		case 1:
+			/* DMA and (YM2149 0 dB) mixing */
+			for (i = 0; i < nSamples; i++)
 			{
-				LeftByte = DmaSnd_FIFO_PullByte ();
-				RightByte = DmaSnd_FIFO_PullByte ();
-				dma.FrameLeft  = DmaSnd_LowPassFilterLeft( (Sint16)LeftByte );
-				dma.FrameRight = DmaSnd_LowPassFilterRight( (Sint16)RightByte );
-				DmaInitSample = false;
+				pMix[i][0] = pMix[i][0] + DmaLeft[i];
+				pMix[i][1] = pMix[i][1] + DmaRight[i];
 			}
-
-			nBufIdx = (nMixBufIdx + i) % MIXBUFFER_SIZE;
-
-			switch (microwire.mixing) {
-				case 1:
-					/* DMA and (YM2149 0 dB) mixing */
-					MixBuffer[nBufIdx][0] = MixBuffer[nBufIdx][0] + dma.FrameLeft * -((256*3/4)/4)/4;
-					MixBuffer[nBufIdx][1] = MixBuffer[nBufIdx][1] + dma.FrameRight * -((256*3/4)/4)/4;
-					break;
-				case 2:
-					/* DMA only */
-					MixBuffer[nBufIdx][0] = dma.FrameLeft * -((256*3/4)/4)/4;
-					MixBuffer[nBufIdx][1] = dma.FrameRight * -((256*3/4)/4)/4;
-					break;
-				default:
-					/* DMA and (YM2149 -12 dB) mixing */
-					/* instead of 16462 (-12 dB), we approximate by 16384 */
-					MixBuffer[nBufIdx][0] = (dma.FrameLeft * -((256*3/4)/4)/4) +
-								(((Sint32)MixBuffer[nBufIdx][0] * 16384)/65536);
-					MixBuffer[nBufIdx][1] = (dma.FrameRight * -((256*3/4)/4)/4) +
-								(((Sint32)MixBuffer[nBufIdx][1] * 16384)/65536);
-					break;
+			break;
+		case 2:
+			/* DMA only */
+			for (i = 0; i < nSamples; i++)
+			{
+				pMix[i][0] = DmaLeft[i];
+				pMix[i][1] = DmaRight[i];
 			}
-
-			/* Increase freq counter */
-			frameCounter_float += FreqRatio;
-			n = frameCounter_float >> 32;				/* number of samples to skip */
-			while ( n > 0 )						/* pull as many bytes from the FIFO as needed */
+			break;
+		default:
+			/* DMA and (YM2149 -12 dB) mixing */
+			/* instead of 16462 (-12 dB), we approximate by 16384 */
+			for (i = 0; i < nSamples; i++)
 			{
-				LeftByte = DmaSnd_FIFO_PullByte ();
-				RightByte = DmaSnd_FIFO_PullByte ();
-				dma.FrameLeft  = DmaSnd_LowPassFilterLeft( (Sint16)LeftByte );
-				dma.FrameRight = DmaSnd_LowPassFilterRight( (Sint16)RightByte );
-				n--;
+				pMix[i][0] = DmaLeft[i] + (((Sint32)pMix[i][0] * 16384)/65536);
+				pMix[i][1] = DmaRight[i] + (((Sint32)pMix[i][1] * 16384)/65536);
 			}
-			frameCounter_float &= 0xffffffff;			/* only keep the fractional part */
-		}
+			break;
 	}
 
 	/* Apply LMC1992 sound modifications (Bass and Treble) */
-	DmaSnd_Apply_LMC ( nMixBufIdx , nSamplesToGenerate );
+	DmaSnd_Apply_LMC ( pMix , nSamples );
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Mix DMA sound samples with the YM samples already in MixBuffer
+ * and apply the LMC1992 volume and tone controls
+ */
+void DmaSnd_GenerateSamples(int nMixBufIdx, int nSamplesToGenerate)
+{
+	int nBlock;
+
+	/* Handle the samples in blocks which don't wrap around the end of the ring buffer */
+	while (nSamplesToGenerate > 0)
+	{
+		nBlock = MIXBUFFER_SIZE - nMixBufIdx;
+		if (nBlock > nSamplesToGenerate)
+			nBlock = nSamplesToGenerate;
+		if (nBlock > DMASND_BLOCK_SIZE)
+			nBlock = DMASND_BLOCK_SIZE;
+
+		DmaSnd_GenerateBlock ( &MixBuffer[nMixBufIdx] , nBlock );
+
+		nMixBufIdx = (nMixBufIdx + nBlock) % MIXBUFFER_SIZE;
+		nSamplesToGenerate -= nBlock;
+	}
 }
 
 
@@ -631,31 +606,67 @@ void DmaSnd_GenerateSamples(int nMixBufIdx, int nSamplesToGenerate)
  * Apply LMC1992 sound modifications (Bass and Treble)
  * The Bass and Treble get samples at nAudioFrequency rate.
  * The tone control's sampling frequency must be at least 22050 Hz to sound good.
+ *
+ * Both channels are filtered in the same loop, with the filter state
+ * kept in local variables, which allows the compiler to keep it in
+ * registers (and to handle the two channels in parallel).
  */
-static void DmaSnd_Apply_LMC(int nMixBufIdx, int nSamplesToGenerate)
+static void DmaSnd_Apply_LMC(Sint16 (*pMix)[2], int nSamples)
 {
-	int nBufIdx;
+	const float c0 = lmc1992.coef[0], c1 = lmc1992.coef[1], c2 = lmc1992.coef[2];
+	const float c3 = lmc1992.coef[3], c4 = lmc1992.coef[4];
+	const float gl = lmc1992.left_gain, gr = lmc1992.right_gain;
+	float l0 = lmc1992_data[0][0], l1 = lmc1992_data[0][1];
+	float r0 = lmc1992_data[1][0], r1 = lmc1992_data[1][1];
+	float al, ar, yl, yr;
+	Sint32 left, right;
 	int i;
-	Sint32 sample;
 
 	/* Apply LMC1992 sound modifications (Left, Right and Master Volume) */
-	for (i = 0; i < nSamplesToGenerate; i++) {
-		nBufIdx = (nMixBufIdx + i) % MIXBUFFER_SIZE;
-
-		sample = DmaSnd_IIRfilterL( Subsonic_IIR_HPF_Left( MixBuffer[nBufIdx][0]));
-		if (sample<-32767)						/* check for overflow to clip waveform */
-			sample = -32767;
-		else if (sample>32767)
-			sample = 32767;
-		MixBuffer[nBufIdx][0] = sample;
-
-		sample = DmaSnd_IIRfilterR( Subsonic_IIR_HPF_Right(MixBuffer[nBufIdx][1]));
-		if (sample<-32767)						/* check for overflow to clip waveform */
-			sample = -32767;
-		else if (sample>32767)
-			sample = 32767;
-		MixBuffer[nBufIdx][1] = sample;
- 	}
+	for (i = 0; i < nSamples; i++)
+	{
+		/* biquad  Note: 'a' coefficients are subtracted */
+		al  = gl * Subsonic_IIR_HPF_Left( pMix[i][0] );
+		ar  = gr * Subsonic_IIR_HPF_Right( pMix[i][1] );
+		al -= c0 * l0;
+		ar -= c0 * r0;
+		al -= c1 * l1;
+		ar -= c1 * r1;
+
+		yl  = c2 * al;
+		yr  = c2 * ar;
+		yl += c3 * l0;
+		yr += c3 * r0;
+		yl += c4 * l1;
+		yr += c4 * r1;
+
+		l1 = l0;  l0 = al;
+		r1 = r0;  r0 = ar;
+
+		left = yl;
+		right = yr;
+		if (left < -32767)				/* check for overflow to clip waveform */
+			left = -32767;
+		else if (left > 32767)
+			left = 32767;
+		if (right < -32767)
+			right = -32767;
+		else if (right > 32767)
+			right = 32767;
+		pMix[i][0] = left;
+		pMix[i][1] = right;
+	}
+
+	/* When the input is silent, filter state decays towards zero.  Flush
+	 * it before it becomes denormal, as those are very slow on many CPUs
+	 * (this doesn't change the output, as it's rounded to integers) */
+	if (fabsf(l0) < 1e-15f && fabsf(l1) < 1e-15f)
+		l0 = l1 = 0.0f;
+	if (fabsf(r0) < 1e-15f && fabsf(r1) < 1e-15f)
+		r0 = r1 = 0.0f;
+
+	lmc1992_data[0][0] = l0;  lmc1992_data[0][1] = l1;
+	lmc1992_data[1][0] = r0;  lmc1992_data[1][1] = r1;
 }
 
 
@@ -1150,59 +1161,6 @@ void DmaSnd_MicrowireMask_WriteWord(void)
 
 /*-------------------Bass / Treble filter ---------------------------*/
 
-/**
- * Left voice Filter for Bass/Treble.
- */
-static float DmaSnd_IIRfilterL(float xn)
-{
-	static float data[2] = { 0.0, 0.0 };
-	float a, yn;
-
-	/* Input coefficients */
-	/* biquad1  Note: 'a' coefficients are subtracted */
-	a  = lmc1992.left_gain * xn;		/* a=g*xn;               */
-	a -= lmc1992.coef[0] * data[0];		/* a1;  wn-1             */
-	a -= lmc1992.coef[1] * data[1];		/* a2;  wn-2             */
-						/* If coefficient scale  */
-						/* factor = 0.5 then     */
-						/* multiply by 2         */
-	/* Output coefficients */
-	yn  = lmc1992.coef[2] * a;		/* b0;                   */
-	yn += lmc1992.coef[3] * data[0];	/* b1;                   */
-	yn += lmc1992.coef[4] * data[1];	/* b2;                   */
-
-	data[1] = data[0];			/* wn-1 -> wn-2;         */
-	data[0] = a;				/* wn -> wn-1            */
-	return yn;
-}
-
-
-/**
- * Right voice Filter for Bass/Treble.
- */
-static float DmaSnd_IIRfilterR(float xn)
-{
-	static float data[2] = { 0.0, 0.0 };
-	float a, yn;
-
-	/* Input coefficients */
-	/* biquad1  Note: 'a' coefficients are subtracted */
-	a  = lmc1992.right_gain * xn;		/* a=g*xn;               */
-	a -= lmc1992.coef[0]*data[0];		/* a1;  wn-1             */
-	a -= lmc1992.coef[1]*data[1];		/* a2;  wn-2             */
-						/* If coefficient scale  */
-						/* factor = 0.5 then     */
-						/* multiply by 2         */
-	/* Output coefficients */
-	yn  = lmc1992.coef[2]*a;		/* b0;                   */
-	yn += lmc1992.coef[3]*data[0];		/* b1;                   */
-	yn += lmc1992.coef[4]*data[1];		/* b2;                   */
-
-	data[1] = data[0];			/* wn-1 -> wn-2;         */
-	data[0] = a;				/* wn -> wn-1            */
-	return yn;
-}
-
 /**
  * LowPass Filter Left
  */
@@ -1358,6 +1316,10 @@ void DmaSnd_Init_Bass_and_Treble_Tables(void)
 	lmc1992.left_gain = (microwire.leftVolume * (Uint32)microwire.masterVolume) * (2.0/(65536.0*65536.0));
 	lmc1992.right_gain = (microwire.rightVolume * (Uint32)microwire.masterVolume) * (2.0/(65536.0*65536.0));
 
+	/* DMA sound resampling steps for this nAudioFrequency */
+	for (n = 0; n < 4; n++)
+		DmaSndFreqRatio[n] = ( ((Sint64)DmaSndSampleRates[n]) << 32 ) / nAudioFrequency;
+
 	/* Anti-alias filter is not required when nAudioFrequency == 50066 Hz */
 	if (nAudioFrequency>50000 && nAudioFrequency<50100)
 		DmaSnd_LowPass = false;
@@ -115,6 +115,7 @@ static int  Crossbar_DetectSampleRate(Uint16 clock);
 static void Crossbar_Recalculate_Clocks_Cycles(void);
 static void Crossbar_Start_InterruptHandler_25Mhz(void);
 static void Crossbar_Start_InterruptHandler_32Mhz(void);
+static void Crossbar_Start_Clocks(void);
 
 /* Dma_Play sound functions */
 static void Crossbar_setDmaPlay_Settings(void);
@@ -366,10 +367,9 @@ void Crossbar_Reset(bool bCold)
 	crossbar.adc2dac_readBufferPosition = 0;
 	crossbar.adc2dac_readBufferPosition_float = 0;
 
-	/* Start 25 Mhz and 32 Mhz Clocks */
+	/* Compute 25 Mhz and 32 Mhz Clocks, they are started with the first transfer */
 	Crossbar_Recalculate_Clocks_Cycles();
-	Crossbar_Start_InterruptHandler_25Mhz();
-	Crossbar_Start_InterruptHandler_32Mhz();
+	Crossbar_Start_Clocks();
 
 	/* Start Microphone jack emulation */
 	if (crossbar.microphone_ADC_is_started == 0) { 
@@ -514,6 +514,8 @@ void Crossbar_DmaCtrlReg_WriteByte(void)
 		dmaRecord.loopMode = 0;
 		nCbar_DmaSoundControl = sndCtrl;
 	}
+
+	Crossbar_Start_Clocks();
 }
 
 
@@ -920,6 +922,8 @@ void Crossbar_SrcControler_WriteWord(void)
 	
 	crossbar.dspXmit_freq = (nCbSrc >> 5) & 0x3;
 	crossbar.dmaPlay_freq = (nCbSrc >> 1) & 0x3;
+
+	Crossbar_Start_Clocks();
 }
 
 /**
@@ -996,6 +1000,8 @@ void Crossbar_DstControler_WriteWord(void)
 	dmaPlay.handshakeMode_Frame = dmaPlay.isConnectedToDspInHandShakeMode;
 
 	dmaRecord.isConnectedToDspInHandShakeMode = ((destCtrl & 0xf) == 2 ? 1 : 0);
+
+	Crossbar_Start_Clocks();
 }
 
 /**
@@ -1017,6 +1023,7 @@ void Crossbar_FreqDivInt_WriteByte(void)
 
 	crossbar.int_freq_divider = clkDiv & 0xf;
 	Crossbar_Recalculate_Clocks_Cycles();
+	Crossbar_Start_Clocks();
 }
 
 /**
@@ -1182,6 +1189,47 @@ static int Crossbar_DetectSampleRate(Uint16 clock)
 	return Falcon_SampleRates_32Mhz[crossbar.int_freq_divider - 1];
 }
 
+/**
+ * Check if some transfer needs the crossbar clocks: a running DMA,
+ * or a DSP transmitter or ADC connected to some destination.
+ * Without these, clock ticks would only advance idle counters.
+ */
+static bool Crossbar_IsTransferActive(void)
+{
+	if (dmaPlay.isRunning || dmaRecord.isRunning)
+		return true;
+
+	if (!dspXmit.isTristated &&
+	    (dspXmit.isConnectedToCodec || dspXmit.isConnectedToDma || dspXmit.isConnectedToDsp))
+		return true;
+
+	return adc.isConnectedToCodec || adc.isConnectedToDma || adc.isConnectedToDsp;
+}
+
+/**
+ * Start the internal clock interrupts which are stopped, if they are
+ * needed by a transfer. The 32 Mhz clock isn't used in Ste frequency mode.
+ */
+static void Crossbar_Start_Clocks(void)
+{
+	if (!Crossbar_IsTransferActive())
+		return;
+
+	if (!CycInt_InterruptActive(INTERRUPT_CROSSBAR_25MHZ)) {
+		LOG_TRACE(TRACE_CROSSBAR, "Crossbar : start 25 Mhz clock\n");
+		crossbar.pendingCyclesOver25 = 0;
+		/* ADC samples were not consumed while the clock was stopped */
+		adc.readPosition = adc.writePosition;
+		Crossbar_Start_InterruptHandler_25Mhz();
+	}
+
+	if (!crossbar.isInSteFreqMode && !CycInt_InterruptActive(INTERRUPT_CROSSBAR_32MHZ)) {
+		LOG_TRACE(TRACE_CROSSBAR, "Crossbar : start 32 Mhz clock\n");
+		crossbar.pendingCyclesOver32 = 0;
+		Crossbar_Start_InterruptHandler_32Mhz();
+	}
+}
+
 /**
  * Start internal 25 Mhz clock interrupt.
  */
@@ -1254,8 +1302,9 @@ void Crossbar_InterruptHandler_25Mhz(void)
 		Crossbar_Process_DMAPlay_Transfer();
 		Crossbar_Process_ADCXmit_Transfer();
 		
-		/* Restart the 25 Mhz clock interrupt */
-		Crossbar_Start_InterruptHandler_25Mhz();
+		/* Restart the 25 Mhz clock interrupt if still needed */
+		if (Crossbar_IsTransferActive())
+			Crossbar_Start_InterruptHandler_25Mhz();
 		return;
 	}
 
@@ -1271,8 +1320,9 @@ void Crossbar_InterruptHandler_25Mhz(void)
 		Crossbar_Process_DMAPlay_Transfer();
 	}
 
-	/* Restart the 25 Mhz clock interrupt */
-	Crossbar_Start_InterruptHandler_25Mhz();
+	/* Restart the 25 Mhz clock interrupt if still needed */
+	if (Crossbar_IsTransferActive())
+		Crossbar_Start_InterruptHandler_25Mhz();
 }
 
 /**
@@ -1286,10 +1336,9 @@ void Crossbar_InterruptHandler_32Mhz(void)
 	/* Remove this interrupt from list and re-order */
 	CycInt_AcknowledgeInterrupt();
 
-	/* If transfer mode is in Ste mode, don't use this clock for all the transfers */
+	/* If transfer mode is in Ste mode, don't use this clock for all the transfers. */
+	/* It's started again by Crossbar_Start_Clocks() when leaving Ste mode. */
 	if (crossbar.isInSteFreqMode) {
-		/* Restart the 32 Mhz clock interrupt */
-		Crossbar_Start_InterruptHandler_32Mhz();
 		return;
 	}
 	
@@ -1303,8 +1352,9 @@ void Crossbar_InterruptHandler_32Mhz(void)
 		Crossbar_Process_DMAPlay_Transfer();
 	}
 
-	/* Restart the 32 Mhz clock interrupt */
-	Crossbar_Start_InterruptHandler_32Mhz();
+	/* Restart the 32 Mhz clock interrupt if still needed */
+	if (Crossbar_IsTransferActive())
+		Crossbar_Start_InterruptHandler_32Mhz();
 }
 
 
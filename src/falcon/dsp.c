@@ -23,6 +23,7 @@
 #include <ctype.h>
 
 #include "main.h"
+#include "benchmark.h"
 #include "sysdeps.h"
 #include "newcpu.h"
 #include "memorySnapShot.h"
@@ -165,6 +166,8 @@ void DSP_MemorySnapShot_Capture(bool bSave)
 void DSP_Run(int nHostCycles)
 {
 #if ENABLE_DSP_EMU
+        int nBenchPrev;
+
         save_cycles += nHostCycles * 2;
 
         if (dsp_core.running == 0)
@@ -173,6 +176,8 @@ void DSP_Run(int nHostCycles)
         if (save_cycles <= 0)
                 return;
 
+        nBenchPrev = Benchmark_Enter(BENCH_DSP);
+
         if (unlikely(bDspDebugging)) {
                 while (save_cycles > 0)
                 {
@@ -188,7 +193,7 @@ void DSP_Run(int nHostCycles)
                         save_cycles -= dsp_core.instr_cycle;
                 }
         }
-
+        Benchmark_Leave(nBenchPrev);
 #endif
 } 
 
@@ -18,6 +18,7 @@ const char HostScreen_fileid[] = "Hatari hostscreen.c : " __DATE__ " " __TIME__;
 #include "stMemory.h"
 #include "ioMem.h"
 #include "hostscreen.h"
+#include "videl.h"
 #include "resolution.h"
 #include "screen.h"
 #include "statusbar.h"
@@ -53,6 +54,7 @@ const char HostScreen_fileid[] = "Hatari hostscreen.c : " __DATE__ " " __TIME__;
 static Uint32 sdl_videoparams;
 static int hs_width, hs_height, hs_width_req, hs_height_req, hs_bpp;
 static bool   doUpdate; // the HW surface is available -> the SDL need not to update the surface after ->pixel access
+static int dirtyTop, dirtyBottom;	// host screen lines changed since last update
 
 static void HostScreen_remapPalette(void);
 
@@ -103,6 +105,9 @@ void HostScreen_setWindowSize(int width, int height, int bpp)
 	int screenwidth, screenheight, maxw, maxh;
 	int scalex, scaley, sbarheight;
 
+	/* screen gets cleared or re-created, convert it all again */
+	VIDEL_SetFullUpdate();
+
 	if (bpp == 24)
 		bpp = 32;
 
@@ -256,12 +261,44 @@ void HostScreen_setWindowSize(int width, int height, int bpp)
 }
 
 
+/**
+ * Update host screen lines changed since previous update to the
+ * screen, or the whole screen if forced.
+ */
 void HostScreen_update1(bool forced)
 {
+	int top = dirtyTop, bottom = dirtyBottom;
+
+	dirtyTop = dirtyBottom = 0;
 	if ( !forced && !doUpdate ) // the HW surface is available
 		return;
 
-	SDL_UpdateRect( sdlscrn, 0, 0, hs_width, hs_height );
+	if (forced) {
+		top = 0;
+		bottom = hs_height;
+	}
+	if (bottom > hs_height)
+		bottom = hs_height;
+	if (top >= bottom)
+		return;
+
+	SDL_UpdateRect( sdlscrn, 0, top, hs_width, bottom - top );
+}
+
+/**
+ * Mark host screen lines as changed for the next HostScreen_update1()
+ */
+void HostScreen_addDirtyLines(int top, int count)
+{
+	if (dirtyTop == dirtyBottom) {
+		dirtyTop = top;
+		dirtyBottom = top + count;
+		return;
+	}
+	if (top < dirtyTop)
+		dirtyTop = top;
+	if (top + count > dirtyBottom)
+		dirtyBottom = top + count;
 }
 
 
@@ -313,6 +350,7 @@ Uint32 HostScreen_getPaletteColor(Uint8 idx)
 void HostScreen_updatePalette(int colorCount)
 {
 	SDL_SetColors( sdlscrn, palette.standard, 0, colorCount );
+	HostScreen_addDirtyLines(0, hs_height);
 }
 
 static void HostScreen_remapPalette(void)
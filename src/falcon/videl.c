@@ -75,6 +75,7 @@ const char VIDEL_fileid[] = "Hatari videl.c : " __DATE__ " " __TIME__;
 #include "hostscreen.h"
 #include "screen.h"
 #include "stMemory.h"
+#include "video.h"
 #include "videl.h"
 
 
@@ -111,14 +112,36 @@ struct videl_zoom_s {
 	int *zoomytable;
 };
 
+/* Screen conversion state.  Video RAM lines of the previous frame are
+ * kept for comparison, so that only the changed lines are converted
+ * again.  Changes in anything else affecting the output (video mode,
+ * borders, palette, host screen) cause a full update.
+ */
+#define VIDEL_RENDER_KEYS 14
+
+struct videl_render_s {
+	Uint8 *prevVram;			/* video RAM lines of the previous frame */
+	int prevVramSize;
+	Uint8 *lineChanged;			/* lines changed since previous frame */
+	int lineChangedSize;
+	Uint8 *lineBuf;				/* one converted line for zooming & clipping */
+	int lineBufSize;
+	Uint32 palette[256];			/* host pixel values for bitplane mode colors */
+	Uint32 tcHigh[256];			/* host pixel values for true color high bytes */
+	Uint32 tcLow[256];			/* host pixel values for true color low bytes */
+	bool bHost565;				/* host pixel format is same as Falcon true color */
+	int key[VIDEL_RENDER_KEYS];		/* video mode & host screen geometry of previous frame */
+	bool bFullUpdate;			/* convert all lines on next frame */
+	bool bMonoChunky;			/* monoChunky[] table is set up */
+	Uint8 monoChunky[256][8];		/* monochrome bitplane byte -> 8 chunky pixels */
+};
+
 static struct videl_s videl;
 static struct videl_zoom_s videl_zoom;
+static struct videl_render_s videl_render;
 
 Uint16 vfc_counter;			/* counter for VFC register $ff82a0 (to be internalized when VIDEL emulation is complete) */
 
-static void VIDEL_memset_uint32(Uint32 *addr, Uint32 color, int count);
-static void VIDEL_memset_uint16(Uint16 *addr, Uint16 color, int count);
-static void VIDEL_memset_uint8(Uint8 *addr, Uint8 color, int count);
 
 /**
  *  Called upon startup and when CPU encounters a RESET instruction.
@@ -935,6 +958,9 @@ bool VIDEL_renderScreen(void)
 		HostScreen_setWindowSize(videl.save_scrWidth, videl.save_scrHeight, videl.save_scrBpp == 16 ? 16 : ConfigureParams.Screen.nForceBpp);
 	}
 
+	if ((vw<32) || (vh<32))
+		return false;
+
 	if (!HostScreen_renderBegin())
 		return false;
 
@@ -956,9 +982,6 @@ bool VIDEL_renderScreen(void)
 	*/
 	nextline = linewidth + lineoffset;
 
-	if ((vw<32) || (vh<32))
-		return false;
-
 	if (videl.save_scrBpp < 16 && videl.hostColorsSync == 0)
 		VIDEL_updateColors();
 
@@ -976,44 +999,83 @@ bool VIDEL_renderScreen(void)
 }
 
 
+/**
+ * Add the displayed Videl screen to given screen contents hash:
+ * video mode, the used palette and the displayed video RAM lines.
+ */
+Uint32 VIDEL_HashScreen(Uint32 hash)
+{
+	int vw	 = VIDEL_getScreenWidth();
+	int vh	 = VIDEL_getScreenHeight();
+	int vbpp = VIDEL_getScreenBpp();
+	int hscroll = IoMem_ReadByte(0xff8265) & 0x0f;
+	int nextline = (IoMem_ReadWord(0xff820e) & 0x01ff) + (IoMem_ReadWord(0xff8210) & 0x03ff);
+	Uint32 addr = VIDEL_getVideoramAddress();
+	int linebytes, colors, y;
+
+	hash = Video_HashValue(hash, vw << 16 | vh);
+	hash = Video_HashValue(hash, vbpp << 16 | hscroll);
+	if (vw < 32 || vh < 32)
+		return hash;
+
+	if (vbpp < 16) {
+		colors = 1 << vbpp;
+		if (videl.bUseSTShifter)
+			hash = Video_HashData(hash, &IoMem[0xff8240], colors * 2);
+		else
+			hash = Video_HashData(hash, &IoMem[VIDEL_COLOR_REGS_BEGIN], colors * 4);
+	}
+
+	/* same amount of data as the conversion functions read */
+	linebytes = vw * vbpp / 8;
+	if (hscroll) {
+		linebytes += vbpp * 2;
+		nextline += vbpp;
+	}
+	for (y = 0; y < vh; y++) {
+		if (!STMemory_ValidArea(addr, linebytes))
+			break;
+		hash = Video_HashData(hash, &STRam[addr], linebytes);
+		addr += nextline * 2;
+	}
+	return hash;
+}
+
+
 /**
  * Performs conversion from the TOS's bitplane word order (big endian) data
  * into the native chunky color index.
  */
-static void VIDEL_bitplaneToChunky(Uint16 *atariBitplaneData, Uint16 bpp,
-                                   Uint8 colorValues[16])
+static inline void VIDEL_bitplaneToChunky(const Uint16 *atariBitplaneData, const int bpp,
+                                          Uint8 colorValues[16])
 {
 	Uint32 a, b, c, d, x;
 
-	/* Obviously the different cases can be broken out in various
-	 * ways to lessen the amount of work needed for <8 bit modes.
-	 * It's doubtful if the usage of those modes warrants it, though.
-	 * The branches below should be ~100% correctly predicted and
-	 * thus be more or less for free.
-	 * Getting the palette values inline does not seem to help
-	 * enough to worry about. The palette lookup is much slower than
-	 * this code, though, so it would be nice to do something about it.
+	if (bpp == 1) {
+		/* Monochrome (e.g. TT high) doesn't need a bit transpose,
+		 * each byte is just looked up as 8 chunky pixels
+		 */
+		const Uint8 *data = (const Uint8 *)atariBitplaneData;
+		memcpy(colorValues, videl_render.monoChunky[data[0]], 8);
+		memcpy(colorValues + 8, videl_render.monoChunky[data[1]], 8);
+		return;
+	}
+
+	/* This is inlined to the line converters with a constant bpp,
+	 * so the compiler drops the branches for the other modes.
 	 */
 	if (bpp >= 4) {
-		d = *(Uint32 *)&atariBitplaneData[0];
-		c = *(Uint32 *)&atariBitplaneData[2];
+		d = *(const Uint32 *)&atariBitplaneData[0];
+		c = *(const Uint32 *)&atariBitplaneData[2];
 		if (bpp == 4) {
 			a = b = 0;
 		} else {
-			b = *(Uint32 *)&atariBitplaneData[4];
-			a = *(Uint32 *)&atariBitplaneData[6];
+			b = *(const Uint32 *)&atariBitplaneData[4];
+			a = *(const Uint32 *)&atariBitplaneData[6];
 		}
 	} else {
 		a = b = c = 0;
-		if (bpp == 2) {
-			d = *(Uint32 *)&atariBitplaneData[0];
-		} else {
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-			d = atariBitplaneData[0]<<16;
-#else
-			d = atariBitplaneData[0];
-#endif
-		}
+		d = *(const Uint32 *)&atariBitplaneData[0];
 	}
 
 	x = a;
@@ -1107,420 +1169,332 @@ static void VIDEL_bitplaneToChunky(Uint16 *atariBitplaneData, Uint16 bpp,
 #endif
 }
 
-void VIDEL_ConvertScreenNoZoom(int vw, int vh, int vbpp, int nextline)
-{
-	int scrpitch = HostScreen_getPitch();
-	int h, w, j;
 
-	Uint16 *fvram = (Uint16 *) Atari2HostAddr(videl.videoBaseAddr);
-	Uint16 *fvram_line;
-	Uint8 *hvram = HostScreen_getVideoramAddress();
-	SDL_PixelFormat *scrfmt = HostScreen_getFormat();
 
-	Uint16 lowBorderSize, rightBorderSize;
-	int scrwidth, scrheight;
-	int vw_clip, vh_clip;
+/**
+ * Convert all lines (not just the changed ones) on next frame
+ */
+void VIDEL_SetFullUpdate(void)
+{
+	videl_render.bFullUpdate = true;
+}
 
-	int hscrolloffset = IoMem_ReadByte(0xff8265) & 0x0f;
 
-	/* Horizontal scroll register set? */
-	if (hscrolloffset) {
-		/* Yes, so we need to adjust offset to next line: */
-		nextline += vbpp;
+/**
+ * Write 'count' chunky pixels to host screen, using host palette
+ */
+static inline void VIDEL_putPixels(Uint8 *hvram, const Uint8 *color, int count, const int hostbpp)
+{
+	const Uint32 *palette = videl_render.palette;
+	int i;
+
+	switch (hostbpp) {
+	case 1:
+		memcpy(hvram, color, count);
+		break;
+	case 2:
+		for (i = 0; i < count; i++)
+			((Uint16 *)hvram)[i] = palette[color[i]];
+		break;
+	case 4:
+		for (i = 0; i < count; i++)
+			((Uint32 *)hvram)[i] = palette[color[i]];
+		break;
 	}
+}
 
-	/* If emulated computer is the TT, we use the same rendering for display, but without the borders */
-	if (ConfigureParams.System.nMachineType == MACHINE_TT) {
-		videl.leftBorderSize = 0;
-		videl.rightBorderSize = 0;
-		videl.upperBorderSize = 0;
-		videl.lowerBorderSize = 0;
-		fvram = (Uint16 *) Atari2HostAddr(VIDEL_getVideoramAddress());
-	} else {
-		bTTSampleHold = false;
+/**
+ * Convert one video RAM line of 'vw' pixels to host pixels, starting
+ * 'hscroll' pixels into the first 16 pixel block.  This is inlined with
+ * constant 'vbpp' and 'hostbpp' (host bytes per pixel) to the converters
+ * in VIDEL_lineConverters[], so that the mode checks are done at compile
+ * time instead of for each pixel.
+ */
+static inline void VIDEL_convertLine(const Uint16 *fvram, Uint8 *hvram, int vw, int hscroll,
+                                     const int vbpp, const int hostbpp)
+{
+	Uint8 color[16];
+	Uint16 srcword;
+	int x, n;
+
+	if (vbpp == 16) {
+		/* Falcon true color: RRRRRGGG GGGBBBBB, big endian */
+		if (hostbpp == 1) {
+			for (x = 0; x < vw; x++) {
+				srcword = SDL_SwapBE16(fvram[x]);
+				hvram[x] = (((srcword>>13) & 7) << 5) + (((srcword>>8) & 7) << 2) + ((srcword>>2) & 3);
+			}
+		} else if (hostbpp == 2 && videl_render.bHost565) {
+			for (x = 0; x < vw; x++)
+				((Uint16 *)hvram)[x] = SDL_SwapBE16(fvram[x]);
+		} else {
+			const Uint8 *src = (const Uint8 *)fvram;
+			for (x = 0; x < vw; x++, src += 2) {
+				Uint32 pixel = videl_render.tcHigh[src[0]] | videl_render.tcLow[src[1]];
+				if (hostbpp == 2)
+					((Uint16 *)hvram)[x] = pixel;
+				else
+					((Uint32 *)hvram)[x] = pixel;
+			}
+		}
+		return;
 	}
 
-	/* Clip to SDL_Surface dimensions */
-	scrwidth = HostScreen_getWidth();
-	scrheight = HostScreen_getHeight();
-	vw_clip = vw;
-	vh_clip = vh;
-	if (vw>scrwidth) vw_clip = scrwidth;
-	if (vh>scrheight) vh_clip = scrheight;	
-
-	/* If emulated computer is the FALCON, we must take :
-	 * vw = X area display size and not all the X screen with the borders into account
-	 * vh = Y area display size and not all the Y screen with the borders into account
-	 */
-	if (ConfigureParams.System.nMachineType == MACHINE_FALCON) {
-		vw = videl.XSize;
-		vh = videl.YSize;
+	/* Bitplane modes */
+	for (x = 0; x < vw; x += n) {
+		n = vw - x;
+		if (hscroll == 0 && n >= 16) {
+			n = 16;
+			if (hostbpp == 1) {
+				/* chunky pixels are the 8-bit host pixels */
+				VIDEL_bitplaneToChunky(fvram, vbpp, hvram);
+			} else {
+				VIDEL_bitplaneToChunky(fvram, vbpp, color);
+				VIDEL_putPixels(hvram, color, 16, hostbpp);
+			}
+		} else {
+			VIDEL_bitplaneToChunky(fvram, vbpp, color);
+			if (n > 16 - hscroll)
+				n = 16 - hscroll;
+			VIDEL_putPixels(hvram, color + hscroll, n, hostbpp);
+			hscroll = 0;
+		}
+		fvram += vbpp;
+		hvram += n * hostbpp;
 	}
+}
 
-	/* If there's not enough space to display the left border, just return */
-	if (vw_clip < videl.leftBorderSize)
-		return;
-	/* If there's not enough space for the left border + the graphic area, we clip */ 
-	if (vw_clip < vw + videl.leftBorderSize) {
-		vw = vw_clip - videl.leftBorderSize;
-		rightBorderSize = 0;
+typedef void (*videl_line_converter_t)(const Uint16 *fvram, Uint8 *hvram, int vw, int hscroll);
+
+#define VIDEL_LINE_CONVERTER(vbpp, hostbpp) \
+static void VIDEL_convertLine_##vbpp##_##hostbpp(const Uint16 *fvram, Uint8 *hvram, int vw, int hscroll) \
+{ \
+	VIDEL_convertLine(fvram, hvram, vw, hscroll, vbpp, hostbpp); \
+}
+
+VIDEL_LINE_CONVERTER(1, 1)
+VIDEL_LINE_CONVERTER(1, 2)
+VIDEL_LINE_CONVERTER(1, 4)
+VIDEL_LINE_CONVERTER(2, 1)
+VIDEL_LINE_CONVERTER(2, 2)
+VIDEL_LINE_CONVERTER(2, 4)
+VIDEL_LINE_CONVERTER(4, 1)
+VIDEL_LINE_CONVERTER(4, 2)
+VIDEL_LINE_CONVERTER(4, 4)
+VIDEL_LINE_CONVERTER(8, 1)
+VIDEL_LINE_CONVERTER(8, 2)
+VIDEL_LINE_CONVERTER(8, 4)
+VIDEL_LINE_CONVERTER(16, 1)
+VIDEL_LINE_CONVERTER(16, 2)
+VIDEL_LINE_CONVERTER(16, 4)
+
+/* indexed by [log2(bpp)][host bytes per pixel / 2] */
+static const videl_line_converter_t VIDEL_lineConverters[5][3] = {
+	{ VIDEL_convertLine_1_1,  VIDEL_convertLine_1_2,  VIDEL_convertLine_1_4 },
+	{ VIDEL_convertLine_2_1,  VIDEL_convertLine_2_2,  VIDEL_convertLine_2_4 },
+	{ VIDEL_convertLine_4_1,  VIDEL_convertLine_4_2,  VIDEL_convertLine_4_4 },
+	{ VIDEL_convertLine_8_1,  VIDEL_convertLine_8_2,  VIDEL_convertLine_8_4 },
+	{ VIDEL_convertLine_16_1, VIDEL_convertLine_16_2, VIDEL_convertLine_16_4 }
+};
+
+/**
+ * Return line converter for given Atari bpp and host bytes per pixel,
+ * or NULL if there's none.
+ */
+static videl_line_converter_t VIDEL_getLineConverter(int vbpp, int hostbpp)
+{
+	int i, j;
+
+	switch (vbpp) {
+	case 1:  i = 0; break;
+	case 2:  i = 1; break;
+	case 4:  i = 2; break;
+	case 8:  i = 3; break;
+	case 16: i = 4; break;
+	default: return NULL;
 	}
-	/* if there's not enough space for the left border + the graphic area + the right border, we clip the border */
-	else if (vw_clip < vw + videl.leftBorderSize + videl.rightBorderSize)
-		rightBorderSize = vw_clip - videl.leftBorderSize - vw;
-	else
-		rightBorderSize = videl.rightBorderSize;
+	switch (hostbpp) {
+	case 1:  j = 0; break;
+	case 2:  j = 1; break;
+	case 4:  j = 2; break;
+	default: return NULL;
+	}
+	return VIDEL_lineConverters[i][j];
+}
 
-	/* If there's not enough space to display the upper border, just return */
-	if (vh_clip < videl.upperBorderSize)
-		return;
 
-	/* If there's not enough space for the upper border + the graphic area, we clip */ 
-	if (vh_clip < vh + videl.upperBorderSize) {
-		vh = vh_clip - videl.upperBorderSize;
-		lowBorderSize = 0;
+/**
+ * Fill 'count' host pixels with given color
+ */
+static void VIDEL_fillPixels(Uint8 *hvram, Uint32 color, int count, int hostbpp)
+{
+	int i;
+
+	switch (hostbpp) {
+	case 1:
+		memset(hvram, color, count);
+		break;
+	case 2:
+		for (i = 0; i < count; i++)
+			((Uint16 *)hvram)[i] = color;
+		break;
+	case 4:
+		for (i = 0; i < count; i++)
+			((Uint32 *)hvram)[i] = color;
+		break;
 	}
-	/* if there's not enough space for the upper border + the graphic area + the lower border, we clip the border */
-	else if (vh_clip < vh + videl.upperBorderSize + videl.lowerBorderSize)
-		lowBorderSize = vh_clip - videl.upperBorderSize - vh;
-	else
-		lowBorderSize = videl.lowerBorderSize;
+}
 
-	/* Center screen */
-	hvram += ((scrheight-vh_clip)>>1)*scrpitch;
-	hvram += ((scrwidth-vw_clip)>>1)*HostScreen_getBpp();
+/**
+ * Scale converted line horizontally to host screen with zoom table
+ */
+static void VIDEL_zoomLine(const Uint8 *src, Uint8 *dst, const int *xtable, int count, int hostbpp)
+{
+	int i;
+
+	switch (hostbpp) {
+	case 1:
+		for (i = 0; i < count; i++)
+			dst[i] = src[xtable[i]];
+		break;
+	case 2:
+		for (i = 0; i < count; i++)
+			((Uint16 *)dst)[i] = ((const Uint16 *)src)[xtable[i]];
+		break;
+	case 4:
+		for (i = 0; i < count; i++)
+			((Uint32 *)dst)[i] = ((const Uint32 *)src)[xtable[i]];
+		break;
+	}
+}
 
-	fvram_line = fvram;
-	scrwidth = videl.leftBorderSize + vw + videl.rightBorderSize;
+/**
+ * TT "sample & hold" mode: color 0 pixels repeat the previous color
+ */
+static void VIDEL_sampleHold(Uint8 *hvram, int count)
+{
+	Uint8 TMPPixel = 0;
+	int i;
 
-	/* render the graphic area */
-	if (vbpp < 16) {
-		/* Bitplanes modes */
-
-		/* The SDL colors blitting... */
-		Uint8 color[16];
-
-		/* FIXME: The byte swap could be done here by enrolling the loop into 2 each by 8 pixels */
-		switch ( HostScreen_getBpp() ) {
-			case 1:
-			{
-				Uint8 *hvram_line = hvram;
-
-				/* Render the upper border */
-				for (h = 0; h < videl.upperBorderSize; h++) {
-					VIDEL_memset_uint8 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch;
-				}
-
-				/* Render the graphical area */
-				for (h = 0; h < vh; h++) {
-					Uint16 *fvram_column = fvram_line;
-					Uint8 *hvram_column = hvram_line;
-
-					/* Left border first */
-					VIDEL_memset_uint8 (hvram_column, HostScreen_getPaletteColor(0), videl.leftBorderSize);
-					hvram_column += videl.leftBorderSize;
-				
-					/* First 16 pixels */
-					VIDEL_bitplaneToChunky(fvram_column, vbpp, color);
-					memcpy(hvram_column, color+hscrolloffset, 16-hscrolloffset);
-					hvram_column += 16-hscrolloffset;
-					fvram_column += vbpp;
-					/* Now the main part of the line */
-					for (w = 1; w < (vw+15)>>4; w++) {
-						VIDEL_bitplaneToChunky( fvram_column, vbpp, color );
-						memcpy(hvram_column, color, 16);
-						hvram_column += 16;
-						fvram_column += vbpp;
-					}
-					/* Last pixels of the line for fine scrolling */
-					if (hscrolloffset) {
-						VIDEL_bitplaneToChunky(fvram_column, vbpp, color);
-						memcpy(hvram_column, color, hscrolloffset);
-					}
-					/* Right border */
-					VIDEL_memset_uint8 (hvram_column, HostScreen_getPaletteColor(0), rightBorderSize);
-
-					if (bTTSampleHold) {
-						Uint8 TMPPixel = 0;
-						for (w=0; w < (vw); w++) {
-							if (hvram_line[w] == 0) {
-								hvram_line[w] = TMPPixel;
-							} else {
-								TMPPixel = hvram_line[w];
-							}
-						}
-					}
-
-					fvram_line += nextline;
-					hvram_line += scrpitch;
-				}
-
-				/* Render the lower border */
-				for (h = 0; h < lowBorderSize; h++) {
-					VIDEL_memset_uint8 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch;
-				}
-			}
-			break;
-			case 2:
-			{
-				Uint16 *hvram_line = (Uint16 *)hvram;
-
-				/* Render the upper border */
-				for (h = 0; h < videl.upperBorderSize; h++) {
-					VIDEL_memset_uint16 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch>>1;
-				}
-
-				/* Render the graphical area */
-				for (h = 0; h < vh; h++) {
-					Uint16 *fvram_column = fvram_line;
-					Uint16 *hvram_column = hvram_line;
-
-					/* Left border first */
-					VIDEL_memset_uint16 (hvram_column, HostScreen_getPaletteColor(0), videl.leftBorderSize);
-					hvram_column += videl.leftBorderSize;
-				
-					/* First 16 pixels */
-					VIDEL_bitplaneToChunky(fvram_column, vbpp, color);
-					for (j = 0; j < 16 - hscrolloffset; j++) {
-						*hvram_column++ = HostScreen_getPaletteColor(color[j+hscrolloffset]);
-					}
-					fvram_column += vbpp;
-					/* Now the main part of the line */
-					for (w = 1; w < (vw+15)>>4; w++) {
-						VIDEL_bitplaneToChunky( fvram_column, vbpp, color );
-						for (j=0; j<16; j++) {
-							*hvram_column++ = HostScreen_getPaletteColor( color[j] );
-						}
-						fvram_column += vbpp;
-					}
-					/* Last pixels of the line for fine scrolling */
-					if (hscrolloffset) {
-						VIDEL_bitplaneToChunky(fvram_column, vbpp, color);
-						for (j = 0; j < hscrolloffset; j++) {
-							*hvram_column++ = HostScreen_getPaletteColor(color[j]);
-						}
-					}
-					/* Right border */
-					VIDEL_memset_uint16 (hvram_column, HostScreen_getPaletteColor(0), rightBorderSize);
-
-					fvram_line += nextline;
-					hvram_line += scrpitch>>1;
-				}
-
-				/* Render the lower border */
-				for (h = 0; h < lowBorderSize; h++) {
-					VIDEL_memset_uint16 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch>>1;
-				}
-			}
-			break;
-			case 4:
-			{
-				Uint32 *hvram_line = (Uint32 *)hvram;
-
-				/* Render the upper border */
-				for (h = 0; h < videl.upperBorderSize; h++) {
-					VIDEL_memset_uint32 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch>>2;
-				}
-
-				/* Render the graphical area */
-				for (h = 0; h < vh; h++) {
-					Uint16 *fvram_column = fvram_line;
-					Uint32 *hvram_column = hvram_line;
-
-					/* Left border first */
-					VIDEL_memset_uint32 (hvram_column, HostScreen_getPaletteColor(0), videl.leftBorderSize);
-					hvram_column += videl.leftBorderSize;
-				
-					/* First 16 pixels */
-					VIDEL_bitplaneToChunky(fvram_column, vbpp, color);
-					for (j = 0; j < 16 - hscrolloffset; j++) {
-						*hvram_column++ = HostScreen_getPaletteColor(color[j+hscrolloffset]);
-					}
-					fvram_column += vbpp;
-					/* Now the main part of the line */
-					for (w = 1; w < (vw+15)>>4; w++) {
-						VIDEL_bitplaneToChunky( fvram_column, vbpp, color );
-						for (j=0; j<16; j++) {
-							*hvram_column++ = HostScreen_getPaletteColor( color[j] );
-						}
-						fvram_column += vbpp;
-					}
-					/* Last pixels of the line for fine scrolling */
-					if (hscrolloffset) {
-						VIDEL_bitplaneToChunky(fvram_column, vbpp, color);
-						for (j = 0; j < hscrolloffset; j++) {
-							*hvram_column++ = HostScreen_getPaletteColor(color[j]);
-						}
-					}
-					/* Right border */
-					VIDEL_memset_uint32 (hvram_column, HostScreen_getPaletteColor(0), rightBorderSize);
-
-					fvram_line += nextline;
-					hvram_line += scrpitch>>2;
-				}
-
-				/* Render the lower border */
-				for (h = 0; h < lowBorderSize; h++) {
-					VIDEL_memset_uint32 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch>>2;
-				}
-			}
-			break;
+	for (i = 0; i < count; i++) {
+		if (hvram[i] == 0) {
+			hvram[i] = TMPPixel;
+		} else {
+			TMPPixel = hvram[i];
 		}
+	}
+}
 
-	} else {
 
-		/* Falcon TC (High Color) */
-		switch ( HostScreen_getBpp() )  {
-			case 1:
-			{
-				/* FIXME: when Videl switches to 16bpp, set the palette to 3:3:2 */
-				Uint8 *hvram_line = hvram;
-
-				/* Render the upper border */
-				for (h = 0; h < videl.upperBorderSize; h++) {
-					VIDEL_memset_uint8 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch;
-				}
-
-				/* Render the graphical area */
-				for (h = 0; h < vh; h++) {
-					Uint16 *fvram_column = fvram_line;
-					Uint8 *hvram_column = hvram_line;
-					int tmp;
-
-					/* Left border first */
-					VIDEL_memset_uint8 (hvram_column, HostScreen_getPaletteColor(0), videl.leftBorderSize);
-					hvram_column += videl.leftBorderSize;
-
-					/* Graphical area */
-					for (w = 0; w < vw; w++) {
-						tmp = SDL_SwapBE16(*fvram_column++);
-						*hvram_column++ = (((tmp>>13) & 7) << 5) + (((tmp>>8) & 7) << 2) + (((tmp>>2) & 3));
-					}
-
-					/* Right border */
-					VIDEL_memset_uint8 (hvram_column, HostScreen_getPaletteColor(0), rightBorderSize);
-
-					fvram_line += nextline;
-					hvram_line += scrpitch;
-				}
-				/* Render the bottom border */
-				for (h = 0; h < lowBorderSize; h++) {
-					VIDEL_memset_uint8 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch;
-				}
-			}
-			break;
-			case 2:
-			{
-				Uint16 *hvram_line = (Uint16 *)hvram;
-
-				/* Render the upper border */
-				for (h = 0; h < videl.upperBorderSize; h++) {
-					VIDEL_memset_uint16 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch>>1;
-				}
-
-				/* Render the graphical area */
-				for (h = 0; h < vh; h++) {
-					Uint16 *hvram_column = hvram_line;
-#if SDL_BYTEORDER != SDL_BIG_ENDIAN
-					Uint16 *fvram_column;
-#endif
-					/* Left border first */
-					VIDEL_memset_uint16 (hvram_column, HostScreen_getPaletteColor(0), videl.leftBorderSize);
-					hvram_column += videl.leftBorderSize;
+/**
+ * Update host pixel values for Falcon true color high and low bytes.
+ * Color components don't overlap, so a pixel is just the two OR'ed.
+ */
+static void VIDEL_updateTrueColorTables(void)
+{
+	SDL_PixelFormat *fmt = HostScreen_getFormat();
+	int i, r, g, b;
+
+	for (i = 0; i < 256; i++) {
+		/* high byte RRRRRGGG */
+		r = i & 0xf8;
+		g = (i & 7) << 5;
+		videl_render.tcHigh[i] = SDL_MapRGB(fmt, r, g, 0);
+		/* low byte GGGBBBBB */
+		g = (i >> 5) << 2;
+		b = (i & 0x1f) << 3;
+		videl_render.tcLow[i] = SDL_MapRGB(fmt, 0, g, b);
+	}
+	videl_render.bHost565 = (fmt->BytesPerPixel == 2 && fmt->Rmask == 0xf800 &&
+	                         fmt->Gmask == 0x07e0 && fmt->Bmask == 0x001f);
+}
 
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-					/* FIXME: here might be a runtime little/big video endian switch like:
-						if ( " videocard memory in Motorola endian format " false)
-					*/
-					memcpy(hvram_column, fvram_line, vw<<1);
-					hvram_column += vw<<1;
-#else
-					fvram_column = fvram_line;
-					/* Graphical area */
-					for (w = 0; w < vw; w++)
-						*hvram_column ++ = SDL_SwapBE16(*fvram_column++);
-#endif /* SDL_BYTEORDER == SDL_BIG_ENDIAN */
-
-					/* Right border */
-					VIDEL_memset_uint16 (hvram_column, HostScreen_getPaletteColor(0), rightBorderSize);
-
-					fvram_line += nextline;
-					hvram_line += scrpitch>>1;
-				}
-
-				/* Render the bottom border */
-				for (h = 0; h < lowBorderSize; h++) {
-					VIDEL_memset_uint16 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch>>1;
-				}
-			}
-			break;
-			case 4:
-			{
-				Uint32 *hvram_line = (Uint32 *)hvram;
-
-				/* Render the upper border */
-				for (h = 0; h < videl.upperBorderSize; h++) {
-					VIDEL_memset_uint32 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch>>2;
-				}
-
-				/* Render the graphical area */
-				for (h = 0; h < vh; h++) {
-					Uint16 *fvram_column = fvram_line;
-					Uint32 *hvram_column = hvram_line;
-
-					/* Left border first */
-					VIDEL_memset_uint32 (hvram_column, HostScreen_getPaletteColor(0), videl.leftBorderSize);
-					hvram_column += videl.leftBorderSize;
-
-					/* Graphical area */
-					for (w = 0; w < vw; w++) {
-						Uint16 srcword = *fvram_column++;
-						*hvram_column ++ = SDL_MapRGB(scrfmt, (srcword & 0xf8), (((srcword & 0x07) << 5) | ((srcword >> 11) & 0x3c)), ((srcword >> 5) & 0xf8));
-					}
-
-					/* Right border */
-					VIDEL_memset_uint32 (hvram_column, HostScreen_getPaletteColor(0), rightBorderSize);
-				}
-
-				fvram_line += nextline;
-				hvram_line += scrpitch>>2;
-
-				/* Render the bottom border */
-				for (h = 0; h < lowBorderSize; h++) {
-					VIDEL_memset_uint32 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch>>2;
-				}
-			}
-			break;
-		}
+
+/**
+ * Set up table for converting monochrome bitplane bytes to chunky pixels
+ */
+static void VIDEL_initMonoChunky(void)
+{
+	int i, bit;
+
+	for (i = 0; i < 256; i++) {
+		for (bit = 0; bit < 8; bit++)
+			videl_render.monoChunky[i][bit] = (i >> (7 - bit)) & 1;
 	}
+	videl_render.bMonoChunky = true;
 }
 
 
-void VIDEL_ConvertScreenZoom(int vw, int vh, int vbpp, int nextline)
+/**
+ * Make sure that given conversion buffer is at least 'size' bytes,
+ * return false if it had to be (re-)allocated.
+ */
+static bool VIDEL_reserveBuffer(Uint8 **buf, int *bufsize, int size)
 {
-	int i, j, w, h, cursrcline;
+	if (*bufsize >= size && *buf)
+		return true;
+	free(*buf);
+	*buf = malloc(size > 0 ? size : 1);
+	if (!*buf) {
+		perror("VIDEL_reserveBuffer");
+		exit(1);
+	}
+	*bufsize = size;
+	return false;
+}
+
+/**
+ * Update zoom table of 'dsize' entries, mapping host pixels
+ * to 'size' Atari pixels, return the table.
+ */
+static int *VIDEL_updateZoomTable(int **table, Uint16 *prevsize, Uint16 *prevdsize,
+                                  int size, int dsize)
+{
+	int i;
+
+	if (*table && *prevsize == size && *prevdsize == dsize)
+		return *table;
+	free(*table);
+	*table = malloc(sizeof(int) * dsize);
+	if (!*table) {
+		perror("VIDEL_updateZoomTable");
+		exit(1);
+	}
+	for (i = 0; i < dsize; i++)
+		(*table)[i] = (size * i) / dsize;
+	*prevsize = size;
+	*prevdsize = dsize;
+	return *table;
+}
 
-	Uint16 *fvram = (Uint16 *) Atari2HostAddr(videl.videoBaseAddr);
-	Uint16 *fvram_line;
-	Uint16 scrIdx = 0;
 
-	int coefx = 1;
-	int coefy = 1;
-	int scrpitch, scrwidth, scrheight, scrbpp, hscrolloffset;
-	Uint8 *hvram;
-	SDL_PixelFormat *scrfmt;
+/**
+ * Convert Videl (or TT) screen to host screen, with the borders.
+ * Without zooming, the screen is clipped to the host screen size.
+ * With zooming, it's scaled to the host screen size, with integer
+ * factors when it's large enough.
+ *
+ * Only the video RAM lines which changed since previous frame are
+ * converted, and changed host screen lines are given to
+ * HostScreen_update1().
+ */
+static void VIDEL_convertScreen(int vw, int vh, int vbpp, int nextline, bool bZoom)
+{
+	Uint16 *fvram = (Uint16 *) Atari2HostAddr(videl.videoBaseAddr);
+	Uint8 *hvram = HostScreen_getVideoramAddress();
+	int scrpitch = HostScreen_getPitch();
+	int scrwidth = HostScreen_getWidth();
+	int scrheight = HostScreen_getHeight();
+	int hostbpp = HostScreen_getBpp();
+	int hscrolloffset = IoMem_ReadByte(0xff8265) & 0x0f;
+	int key[VIDEL_RENDER_KEYS];
+	videl_line_converter_t convertLine;
+	const int *xtable = NULL, *ytable = NULL;
+	int gw, gh, tw, th, dw, dh;
+	int linebytes, colors, y, sy, gy, prev_sy, top, bottom;
+	Uint32 color0;
+	bool bFull;
+	Uint8 *row, *dst;
 
 	/* If emulated computer is the TT, we use the same rendering for display, but without the borders */
 	if (ConfigureParams.System.nMachineType == MACHINE_TT) {
@@ -1535,15 +1509,11 @@ void VIDEL_ConvertScreenZoom(int vw, int vh, int vbpp, int nextline)
 		bTTSampleHold = false;
 	}
 
-	/* Host screen infos */
-	scrpitch = HostScreen_getPitch();
-	scrwidth = HostScreen_getWidth();
-	scrheight = HostScreen_getHeight();
-	scrbpp = HostScreen_getBpp();
-	scrfmt = HostScreen_getFormat();
-	hvram = (Uint8 *) HostScreen_getVideoramAddress();
-
-	hscrolloffset = IoMem_ReadByte(0xff8265) & 0x0f;
+	convertLine = VIDEL_getLineConverter(vbpp, hostbpp);
+	if (!convertLine)
+		return;
+	if (vbpp == 1 && !videl_render.bMonoChunky)
+		VIDEL_initMonoChunky();
 
 	/* Horizontal scroll register set? */
 	if (hscrolloffset) {
@@ -1551,484 +1521,155 @@ void VIDEL_ConvertScreenZoom(int vw, int vh, int vbpp, int nextline)
 		nextline += vbpp;
 	}
 
-	/* Integer zoom coef ? */
-	if (/*(bx_options.autozoom.integercoefs) &&*/ (scrwidth>=vw) && (scrheight>=vh)) {
-		coefx = scrwidth/vw;
-		coefy = scrheight/vh;
-
-		scrwidth = vw * coefx;
-		scrheight = vh * coefy;
+	/* Graphical area and total size with the borders */
+	gw = videl.XSize;
+	gh = videl.YSize;
+	tw = videl.leftBorderSize + gw + videl.rightBorderSize;
+	th = videl.upperBorderSize + gh + videl.lowerBorderSize;
+	if (tw <= 0 || th <= 0)
+		return;
 
-		/* Center screen */
-		hvram += ((HostScreen_getHeight()-scrheight)>>1)*scrpitch;
-		hvram += ((HostScreen_getWidth()-scrwidth)>>1)*scrbpp;
+	/* Host screen area size */
+	if (!bZoom) {
+		/* just clipped */
+		dw = tw < scrwidth ? tw : scrwidth;
+		dh = th < scrheight ? th : scrheight;
+	} else if (scrwidth >= tw && scrheight >= th) {
+		/* Integer zoom coefs */
+		dw = tw * (scrwidth / tw);
+		dh = th * (scrheight / th);
+	} else {
+		dw = scrwidth;
+		dh = scrheight;
 	}
+	if (bZoom && dw != tw)
+		xtable = VIDEL_updateZoomTable(&videl_zoom.zoomxtable, &videl_zoom.zoomwidth,
+		                               &videl_zoom.prev_scrwidth, tw, dw);
+	if (bZoom && dh != th)
+		ytable = VIDEL_updateZoomTable(&videl_zoom.zoomytable, &videl_zoom.zoomheight,
+		                               &videl_zoom.prev_scrheight, th, dh);
 
-	/* New zoom ? */
-	if ((videl_zoom.zoomwidth != vw) || (scrwidth != videl_zoom.prev_scrwidth)) {
-		if (videl_zoom.zoomxtable) {
-			free(videl_zoom.zoomxtable);
-		}
-		videl_zoom.zoomxtable = malloc(sizeof(int)*scrwidth);
-		for (i=0; i<scrwidth; i++) {
-			videl_zoom.zoomxtable[i] = (vw*i)/scrwidth;
-		}
-		videl_zoom.zoomwidth = vw;
-		videl_zoom.prev_scrwidth = scrwidth;
+	/* Center screen */
+	hvram += ((scrheight - dh) >> 1) * scrpitch;
+	hvram += ((scrwidth - dw) >> 1) * hostbpp;
+
+	/* Full update if mode, geometry or host screen changed */
+	bFull = videl_render.bFullUpdate;
+	videl_render.bFullUpdate = false;
+	key[0] = vbpp;
+	key[1] = nextline;
+	key[2] = hscrolloffset;
+	key[3] = gw;
+	key[4] = gh;
+	key[5] = videl.leftBorderSize;
+	key[6] = videl.upperBorderSize;
+	key[7] = tw;
+	key[8] = th;
+	key[9] = dw;
+	key[10] = dh;
+	key[11] = hvram - HostScreen_getVideoramAddress();
+	key[12] = scrpitch;
+	key[13] = hostbpp;
+	if (memcmp(key, videl_render.key, sizeof(key)) != 0) {
+		memcpy(videl_render.key, key, sizeof(key));
+		bFull = true;
 	}
-	if ((videl_zoom.zoomheight != vh) || (scrheight != videl_zoom.prev_scrheight)) {
-		if (videl_zoom.zoomytable) {
-			free(videl_zoom.zoomytable);
-		}
-		videl_zoom.zoomytable = malloc(sizeof(int)*scrheight);
-		for (i=0; i<scrheight; i++) {
-			videl_zoom.zoomytable[i] = (vh*i)/scrheight;
+
+	/* Host colors for the bitplane modes, color 0 is used also for borders */
+	colors = vbpp < 16 ? 1 << vbpp : 1;
+	for (y = 0; y < colors; y++) {
+		Uint32 color = HostScreen_getPaletteColor(y);
+		if (color != videl_render.palette[y]) {
+			videl_render.palette[y] = color;
+			bFull = true;
 		}
-		videl_zoom.zoomheight = vh;
-		videl_zoom.prev_scrheight = scrheight;
 	}
+	color0 = videl_render.palette[0];
+	if (vbpp == 16 && bFull)
+		VIDEL_updateTrueColorTables();
 
-	cursrcline = -1;
-
-	/* We reuse the following values to compute the display area size in zoom mode */
-	/* scrwidth must not change */
-	if (ConfigureParams.System.nMachineType == MACHINE_FALCON) {
-		vw = videl.XSize;
-		vh = videl.YSize;
-		scrheight = vh * coefy;
+	/* Compare video RAM lines to previous frame */
+	if (vbpp < 16)
+		linebytes = ((gw + hscrolloffset + 15) >> 4) * vbpp * 2;
+	else
+		linebytes = gw * 2;
+	if (!VIDEL_reserveBuffer(&videl_render.prevVram, &videl_render.prevVramSize, gh * linebytes))
+		bFull = true;
+	VIDEL_reserveBuffer(&videl_render.lineChanged, &videl_render.lineChangedSize, gh);
+	VIDEL_reserveBuffer(&videl_render.lineBuf, &videl_render.lineBufSize, tw * hostbpp);
+
+	for (y = 0; y < gh; y++) {
+		const Uint8 *src = (const Uint8 *)(fvram + y * nextline);
+		Uint8 *prev = videl_render.prevVram + y * linebytes;
+		if (bFull || memcmp(src, prev, linebytes) != 0) {
+			memcpy(prev, src, linebytes);
+			videl_render.lineChanged[y] = true;
+		} else {
+			videl_render.lineChanged[y] = false;
+		}
 	}
 
-	if (vbpp<16) {
-		Uint8 color[16];
-
-		/* Bitplanes modes */
-		switch(scrbpp) {
-			case 1:
-			{
-				/* One complete 16-pixel aligned planar 2 chunky line */
-				Uint8 *p2cline = malloc(sizeof(Uint8) * ((vw+15) & ~15));
-				Uint8 *hvram_line = hvram;
-				Uint8 *hvram_column = p2cline;
-
-				/* Render the upper border */
-				for (h = 0; h < videl.upperBorderSize * coefy; h++) {
-					VIDEL_memset_uint8 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch;
-				}
-
-				/* Render the graphical area */
-				for (h = 0; h < scrheight; h++) {
-
-					fvram_line = fvram + (videl_zoom.zoomytable[scrIdx] * nextline);
-					scrIdx ++;
-
-					/* Recopy the same line ? */
-					if (videl_zoom.zoomytable[h] == cursrcline) {
-						memcpy(hvram_line, hvram_line-scrpitch, scrwidth*scrbpp);
-					} else {
-						Uint16 *fvram_column = fvram_line;
-						hvram_column = p2cline;
-
-						/* First 16 pixels of a new line */
-						VIDEL_bitplaneToChunky(fvram_column, vbpp, color);
-						memcpy(hvram_column, color+hscrolloffset, 16-hscrolloffset);
-						hvram_column += 16-hscrolloffset;
-						fvram_column += vbpp;
-						/* Convert main part of the new line */
-						for (w=1; w < (vw+15)>>4; w++) {
-							VIDEL_bitplaneToChunky( fvram_column, vbpp, color );
-							memcpy(hvram_column, color, 16);
-							hvram_column += 16;
-							fvram_column += vbpp;
-						}
-						/* Last pixels of the line for fine scrolling */
-						if (hscrolloffset) {
-							VIDEL_bitplaneToChunky(fvram_column, vbpp, color);
-							memcpy(hvram_column, color, hscrolloffset);
-						}
-
-						hvram_column = hvram_line;
-
-						/* Display the Left border */
-						VIDEL_memset_uint8 (hvram_column, HostScreen_getPaletteColor(0), videl.leftBorderSize * coefx);
-						hvram_column += videl.leftBorderSize * coefx;
-
-						/* Display the Graphical area */
-						for (w=0; w<(vw*coefx); w++)
-							hvram_column[w] = p2cline[videl_zoom.zoomxtable[w - videl.leftBorderSize * coefx]];
-						hvram_column += vw * coefx;
-
-						/* Display the Right border */
-						VIDEL_memset_uint8 (hvram_column, HostScreen_getPaletteColor(0), videl.rightBorderSize * coefx);
-						hvram_column += videl.rightBorderSize * coefx;
-
-						if (bTTSampleHold) {
-							Uint8 TMPPixel = 0;
-							for (w=0; w < (vw*coefx); w++) {
-								if (hvram_line[w] == 0) {
-									hvram_line[w] = TMPPixel;
-								} else {
-									TMPPixel = hvram_line[w];
-								}
-							}
-						}
-
-					}
-
-					hvram_line += scrpitch;
-					cursrcline = videl_zoom.zoomytable[h];
-				}
-
-				/* Render the lower border */
-				for (h = 0; h < videl.lowerBorderSize * coefy; h++) {
-					VIDEL_memset_uint8 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch;
-				}
-
-				free(p2cline);
-			}
-			break;
-			case 2:
-			{
-				/* One complete 16-pixel aligned planar 2 chunky line */
-				Uint16 *p2cline = malloc(sizeof(Uint16) * ((vw+15) & ~15));
-				Uint16 *hvram_line = (Uint16 *)hvram;
-				Uint16 *hvram_column = p2cline;
-
-				/* Render the upper border */
-				for (h = 0; h < videl.upperBorderSize * coefy; h++) {
-					VIDEL_memset_uint16 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch>>1;
-				}
-
-				/* Render the graphical area */
-				for (h = 0; h < scrheight; h++) {
-					fvram_line = fvram + (videl_zoom.zoomytable[scrIdx] * nextline);
-					scrIdx ++;
-
-					/* Recopy the same line ? */
-					if (videl_zoom.zoomytable[h] == cursrcline) {
-						memcpy(hvram_line, hvram_line-(scrpitch>>1), scrwidth*scrbpp);
-					} else {
-						Uint16 *fvram_column = fvram_line;
-						hvram_column = p2cline;
-
-						/* First 16 pixels of a new line */
-						VIDEL_bitplaneToChunky(fvram_column, vbpp, color);
-						for (j = 0; j < 16 - hscrolloffset; j++) {
-							*hvram_column++ = HostScreen_getPaletteColor(color[j+hscrolloffset]);
-						}
-						fvram_column += vbpp;
-						/* Convert the main part of the new line */
-						for (w = 1; w < (vw+15)>>4; w++) {
-							VIDEL_bitplaneToChunky( fvram_column, vbpp, color );
-							for (j=0; j<16; j++) {
-								*hvram_column++ = HostScreen_getPaletteColor( color[j] );
-							}
-							fvram_column += vbpp;
-						}
-						/* Last pixels of the new line for fine scrolling */
-						if (hscrolloffset) {
-							VIDEL_bitplaneToChunky(fvram_column, vbpp, color);
-							for (j = 0; j < hscrolloffset; j++) {
-								*hvram_column++ = HostScreen_getPaletteColor(color[j]);
-							}
-						}
-
-						hvram_column = hvram_line;
-
-						/* Display the Left border */
-						VIDEL_memset_uint16 (hvram_column, HostScreen_getPaletteColor(0), videl.leftBorderSize * coefx);
-						hvram_column += videl.leftBorderSize * coefx;
-
-						/* Display the Graphical area */
-						for (w=0; w<(vw*coefx); w++)
-							hvram_column[w] = p2cline[videl_zoom.zoomxtable[w]];
-						hvram_column += vw * coefx;
-
-						/* Display the Right border */
-						VIDEL_memset_uint16 (hvram_column, HostScreen_getPaletteColor(0), videl.rightBorderSize * coefx);
-						hvram_column += videl.rightBorderSize * coefx;
-					}
-
-					hvram_line += scrpitch>>1;
-					cursrcline = videl_zoom.zoomytable[h];
-				}
-
-				/* Render the lower border */
-				for (h = 0; h < videl.lowerBorderSize * coefy; h++) {
-					VIDEL_memset_uint16 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch>>1;
-				}
-
-				free(p2cline);
-			}
-			break;
-			case 4:
-			{
-				/* One complete 16-pixel aligned planar 2 chunky line */
-				Uint32 *p2cline = malloc(sizeof(Uint32) * ((vw+15) & ~15));
-				Uint32 *hvram_line = (Uint32 *)hvram;
-				Uint32 *hvram_column = p2cline;
-
-				/* Render the upper border */
-				for (h = 0; h < videl.upperBorderSize * coefy; h++) {
-					VIDEL_memset_uint32 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch>>2;
-				}
-
-				/* Render the graphical area */
-				for (h = 0; h < scrheight; h++) {
-					fvram_line = fvram + (videl_zoom.zoomytable[scrIdx] * nextline);
-					scrIdx ++;
-					/* Recopy the same line ? */
-					if (videl_zoom.zoomytable[h] == cursrcline) {
-						memcpy(hvram_line, hvram_line-(scrpitch>>2), scrwidth*scrbpp);
-					} else {
-						Uint16 *fvram_column = fvram_line;
-						hvram_column = p2cline;
-
-						/* First 16 pixels of a new line */
-						VIDEL_bitplaneToChunky(fvram_column, vbpp, color);
-						for (j = 0; j < 16 - hscrolloffset; j++) {
-							*hvram_column++ = HostScreen_getPaletteColor(color[j+hscrolloffset]);
-						}
-						fvram_column += vbpp;
-						/* Convert the main part of the new line */
-						for (w = 1; w < (vw+15)>>4; w++) {
-							VIDEL_bitplaneToChunky( fvram_column, vbpp, color );
-							for (j=0; j<16; j++) {
-								*hvram_column++ = HostScreen_getPaletteColor( color[j] );
-							}
-							fvram_column += vbpp;
-						}
-						/* Last pixels of the new line for fine scrolling */
-						if (hscrolloffset) {
-							VIDEL_bitplaneToChunky(fvram_column, vbpp, color);
-							for (j = 0; j < hscrolloffset; j++) {
-								*hvram_column++ = HostScreen_getPaletteColor(color[j]);
-							}
-						}
-
-						hvram_column = hvram_line;
-						/* Display the Left border */
-						VIDEL_memset_uint32 (hvram_column, HostScreen_getPaletteColor(0), videl.leftBorderSize * coefx);
-						hvram_column += videl.leftBorderSize * coefx;
-
-						/* Display the Graphical area */
-						for (w=0; w<(vw*coefx); w++) {
-							hvram_column[w] = p2cline[videl_zoom.zoomxtable[w]];
-						}
-						hvram_column += vw * coefx;
-
-						/* Display the Right border */
-						VIDEL_memset_uint32 (hvram_column, HostScreen_getPaletteColor(0), videl.rightBorderSize * coefx);
-						hvram_column += videl.rightBorderSize * coefx;
-					}
-
-					hvram_line += scrpitch>>2;
-					cursrcline = videl_zoom.zoomytable[h];
-				}
-
-				/* Render the lower border */
-				for (h = 0; h < videl.lowerBorderSize * coefy; h++) {
-					VIDEL_memset_uint32 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch>>2;
-				}
-
-				free(p2cline);
-			}
-			break;
+	/* Convert host screen lines for the changed video RAM lines */
+	top = dh;
+	bottom = 0;
+	prev_sy = -1;
+	for (y = 0; y < dh; y++) {
+		row = hvram + y * scrpitch;
+		sy = ytable ? ytable[y] : y;
+		gy = sy - videl.upperBorderSize;
+		if (gy >= 0 && gy < gh) {
+			if (!videl_render.lineChanged[gy])
+				continue;
+		} else if (!bFull) {
+			continue;
 		}
-	} else {
-		/* Falcon high-color (16-bit) mode */
-
-		switch(scrbpp) {
-			case 1:
-			{
-				/* FIXME: when Videl switches to 16bpp, set the palette to 3:3:2 */
-				Uint8 *hvram_line = hvram;
-				Uint8 *hvram_column = hvram_line;
-
-				/* Render the upper border */
-				for (h = 0; h < videl.upperBorderSize * coefy; h++) {
-					VIDEL_memset_uint8 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch;
-				}
-
-				/* Render the graphical area */
-				for (h = 0; h < scrheight; h++) {
-					Uint16 *fvram_column;
-
-					fvram_line = fvram + (videl_zoom.zoomytable[scrIdx] * nextline);
-					scrIdx ++;
-
-					fvram_column = fvram_line;
-
-					/* Recopy the same line ? */
-					if (videl_zoom.zoomytable[h] == cursrcline) {
-						memcpy(hvram_line, hvram_line-scrpitch, scrwidth*scrbpp);
-					} else {
-
-						hvram_column = hvram_line;
-						/* Display the Left border */
-						VIDEL_memset_uint8 (hvram_column, HostScreen_getPaletteColor(0), videl.leftBorderSize * coefx);
-						hvram_column += videl.leftBorderSize * coefx;
-
-						/* Display the Graphical area */
-						for (w = 0; w<(vw*coefx); w++) {
-							Uint16 srcword;
-							Uint8 dstbyte;
-							
-							srcword = SDL_SwapBE16(fvram_column[videl_zoom.zoomxtable[w - videl.leftBorderSize * coefx]]);
-
-							dstbyte = ((srcword>>13) & 7) << 5;
-							dstbyte |= ((srcword>>8) & 7) << 2;
-							dstbyte |= ((srcword>>2) & 3);
-							*hvram_column++ = dstbyte;
-						}
-
-						/* Display the Right border */
-						VIDEL_memset_uint8 (hvram_column, HostScreen_getPaletteColor(0), videl.rightBorderSize * coefx);
-						hvram_column += videl.rightBorderSize * coefx;
-					}
-
-					hvram_line += scrpitch;
-					cursrcline = videl_zoom.zoomytable[h];
-				}
-
-				/* Render the lower border */
-				for (h = 0; h < videl.lowerBorderSize * coefy; h++) {
-					VIDEL_memset_uint8 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch;
-				}
-			}
-			break;
-			case 2:
-			{
-				Uint16 *hvram_line = (Uint16 *)hvram;
-				Uint16 *hvram_column = hvram_line;
-
-				/* Render the upper border */
-				for (h = 0; h < videl.upperBorderSize * coefy; h++) {
-					VIDEL_memset_uint16 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch>>1;
-				}
-
-				/* Render the graphical area */
-				for (h = 0; h < scrheight; h++) {
-					Uint16 *fvram_column;
-
-					fvram_line = fvram + (videl_zoom.zoomytable[scrIdx] * nextline);
-					scrIdx ++;
-
-					fvram_column = fvram_line;
-
-					/* Recopy the same line ? */
-					if (videl_zoom.zoomytable[h] == cursrcline) {
-						memcpy(hvram_line, hvram_line-(scrpitch>>1), scrwidth*scrbpp);
-					} else {
-
-						hvram_column = hvram_line;
-
-						/* Display the Left border */
-						VIDEL_memset_uint16 (hvram_column, HostScreen_getPaletteColor(0), videl.leftBorderSize * coefx);
-						hvram_column += videl.leftBorderSize * coefx;
-
-						/* Display the Graphical area */
-						for (w=0; w<(vw*coefx); w++)
-							*hvram_column++ = SDL_SwapBE16(fvram_column[videl_zoom.zoomxtable[w]]);
-
-
-						/* Display the Right border */
-						VIDEL_memset_uint16 (hvram_column, HostScreen_getPaletteColor(0), videl.rightBorderSize * coefx);
-						hvram_column += videl.rightBorderSize * coefx;
-					}
-
-					hvram_line += scrpitch>>1;
-					cursrcline = videl_zoom.zoomytable[h];
-				}
+		if (y < top)
+			top = y;
+		bottom = y + 1;
+
+		/* Recopy the same line ? */
+		if (sy == prev_sy) {
+			memcpy(row, row - scrpitch, dw * hostbpp);
+			continue;
+		}
+		prev_sy = sy;
 
-				/* Render the lower border */
-				for (h = 0; h < videl.lowerBorderSize * coefy; h++) {
-					VIDEL_memset_uint16 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch>>1;
-				}
-			}
-			break;
-			case 4:
-			{
-				Uint32 *hvram_line = (Uint32 *)hvram;
-				Uint32 *hvram_column = hvram_line;
-
-				/* Render the upper border */
-				for (h = 0; h < videl.upperBorderSize * coefy; h++) {
-					VIDEL_memset_uint32 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-				}
-
-				/* Render the graphical area */
-				for (h = 0; h < scrheight; h++) {
-					Uint16 *fvram_column;
-
-					fvram_line = fvram + (videl_zoom.zoomytable[scrIdx] * nextline);
-					scrIdx ++;
-					fvram_column = fvram_line;
-
-					/* Recopy the same line ? */
-					if (videl_zoom.zoomytable[h] == cursrcline) {
-						memcpy(hvram_line, hvram_line-(scrpitch>>2), scrwidth*scrbpp);
-						hvram_line += scrpitch>>2;
-					} else {
-
-						hvram_column = hvram_line;
-
-						/* Display the Left border */
-						VIDEL_memset_uint32 (hvram_column, HostScreen_getPaletteColor(0), videl.leftBorderSize * coefx);
-						hvram_column += videl.leftBorderSize * coefx;
-
-						/* Display the Graphical area */
-						for (w = 0; w<(vw*coefx); w++) {
-							Uint16 srcword;
-
-							srcword = fvram_column[videl_zoom.zoomxtable[w]];
-							*hvram_column++ = SDL_MapRGB(scrfmt, (srcword & 0xf8), (((srcword & 0x07) << 5) | ((srcword >> 11) & 0x3c)), ((srcword >> 5) & 0xf8));
-						}
-
-						/* Display the Right border */
-						VIDEL_memset_uint32 (hvram_column, HostScreen_getPaletteColor(0), videl.rightBorderSize * coefx);
-						hvram_column += videl.rightBorderSize * coefx;
-					}
-
-					hvram_line += scrpitch>>2;
-					cursrcline = videl_zoom.zoomytable[h];
-				}
-
-				/* Render the lower border */
-				for (h = 0; h < videl.lowerBorderSize * coefy; h++) {
-					VIDEL_memset_uint32 (hvram_line, HostScreen_getPaletteColor(0), scrwidth);
-					hvram_line += scrpitch>>2;
-				}
-			}
-			break;
+		/* Upper or lower border line */
+		if (gy < 0 || gy >= gh) {
+			VIDEL_fillPixels(row, color0, dw, hostbpp);
+			continue;
 		}
+
+		/* Graphical area line, with left & right border */
+		dst = (xtable || dw < tw) ? videl_render.lineBuf : row;
+		VIDEL_fillPixels(dst, color0, videl.leftBorderSize, hostbpp);
+		convertLine(fvram + gy * nextline, dst + videl.leftBorderSize * hostbpp,
+		            gw, hscrolloffset);
+		VIDEL_fillPixels(dst + (videl.leftBorderSize + gw) * hostbpp, color0,
+		                 videl.rightBorderSize, hostbpp);
+		if (bTTSampleHold && hostbpp == 1)
+			VIDEL_sampleHold(dst, tw);
+
+		if (xtable)
+			VIDEL_zoomLine(dst, row, xtable, dw, hostbpp);
+		else if (dst != row)
+			memcpy(row, dst, dw * hostbpp);
 	}
-}
 
-static void VIDEL_memset_uint32(Uint32 *addr, Uint32 color, int count)
-{
-	while (count-- > 0) {
-		*addr++ = color;
+	if (top < bottom) {
+		y = (hvram - HostScreen_getVideoramAddress()) / scrpitch;
+		HostScreen_addDirtyLines(y + top, bottom - top);
 	}
 }
 
-static void VIDEL_memset_uint16(Uint16 *addr, Uint16 color, int count)
+
+void VIDEL_ConvertScreenNoZoom(int vw, int vh, int vbpp, int nextline)
 {
-	while (count-- > 0) {
-		*addr++ = color;
-	}
+	VIDEL_convertScreen(vw, vh, vbpp, nextline, false);
 }
 
-static void VIDEL_memset_uint8(Uint8 *addr, Uint8 color, int count)
+
+void VIDEL_ConvertScreenZoom(int vw, int vh, int vbpp, int nextline)
 {
-	memset(addr, color, count);
+	VIDEL_convertScreen(vw, vh, vbpp, nextline, true);
 }
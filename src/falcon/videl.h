@@ -14,6 +14,8 @@ extern Uint16 vfc_counter;			/* counter for VFC register $ff82a0 */
 extern int nFrameSkips;
 
 extern bool VIDEL_renderScreen(void);
+extern Uint32 VIDEL_HashScreen(Uint32 hash);
+extern void VIDEL_SetFullUpdate(void);
 
 extern void VIDEL_reset(void);
 
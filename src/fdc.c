@@ -370,6 +370,7 @@ static int FDC_StepRate_ms[] = { 6 , 12 , 2 , 3 };		/* Controlled by bits 1 and
 
 
 #define	FDC_FAST_FDC_FACTOR			10		/* Divide all delays by this value when --fastfdc is used */
+#define	FDC_TURBO_FDC_CYCLES			FDC_DELAY_CYCLE_MFM_BYTE	/* Max delay between 2 states when --turbofdc is used */
 
 
 typedef struct {
@@ -396,6 +397,7 @@ typedef struct {
 	Uint64		IndexPulse_Time;			/* Clock value last time we had an index pulse with motor ON */
 	Uint64		CommandExpire_Time;			/* Clock value to abort a command if it didn't complete before */
 	Uint8		NextSector_ID_Field_SR;			/* Sector Register from the ID Field after a call to FDC_NextSectorID_NbBytes() */
+	bool		TurboSuspended;				/* true if turbo mode is disabled until the motor stops */
 } FDC_STRUCT;
 
 
@@ -629,12 +631,26 @@ static int	FDC_CpuCyclesToFdcCycles ( int CpuCycles )
  * Start an internal timer to handle the FDC's events.
  * If "fast floppy" mode is used, we speed up the timer by dividing
  * the number of cycles by a fixed number.
+ * If "turbo floppy" mode is used, the delay is reduced to FDC_TURBO_FDC_CYCLES
+ * and the skipped time is removed from the index pulse and command expire
+ * references : the disk spins faster, so the FDC still sees the same track
+ * positions and timeouts as with the normal delays.
  */
 static void	FDC_StartTimer_FdcCycles ( int FdcCycles , int InternalCycleOffset )
 {
+	Uint64	SkippedCycles;
+
 //fprintf ( stderr , "fdc start timer %d cycles\n" , FdcCycles );
 
-	if ( ( ConfigureParams.DiskImage.FastFloppy ) && ( FdcCycles > FDC_FAST_FDC_FACTOR ) )
+	if ( ( ConfigureParams.DiskImage.TurboFloppy ) && ( !FDC.TurboSuspended )
+	  && ( FdcCycles > FDC_TURBO_FDC_CYCLES ) )
+	{
+		SkippedCycles = FDC_FdcCyclesToCpuCycles ( FdcCycles - FDC_TURBO_FDC_CYCLES );
+		FDC.IndexPulse_Time -= SkippedCycles;
+		FDC.CommandExpire_Time -= SkippedCycles;
+		FdcCycles = FDC_TURBO_FDC_CYCLES;
+	}
+	else if ( ( ConfigureParams.DiskImage.FastFloppy ) && ( FdcCycles > FDC_FAST_FDC_FACTOR ) )
 		FdcCycles /= FDC_FAST_FDC_FACTOR;
 
 	CycInt_AddRelativeInterruptWithOffset ( FDC_FdcCyclesToCpuCycles ( FdcCycles ) , INT_CPU_CYCLE , INTERRUPT_FDC , InternalCycleOffset );
@@ -737,6 +753,7 @@ void FDC_Reset ( void )
 	FDC.Command = FDCEMU_CMD_NULL;			/* FDC emulation command currently being executed */
 	FDC.CommandState = FDCEMU_RUN_NULL;
 	FDC.CommandType = 0;
+	FDC.TurboSuspended = false;
 
 	FDC_DMA.Status = 1;				/* no DMA error and SectorCount=0 */
 	FDC_DMA.Mode = 0;
@@ -1431,6 +1448,7 @@ static int FDC_UpdateMotorStop ( void )
 						/* [NP] FIXME should we clear spin up here or only when the motor is started again ? */
 
 	FDC.Command = FDCEMU_CMD_NULL;					/* Motor stopped, this is the last state */
+	FDC.TurboSuspended = false;					/* Turbo mode can be used again for next commands */
 	return 0;
 }
 
@@ -2859,6 +2877,23 @@ void FDC_DiskController_WriteWord ( void )
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Programs reading the track or sector registers while a command is running
+ * are usually checking the FDC's progress (copy protections), so they
+ * need the real delays : disable turbo mode until the motor stops.
+ */
+static void FDC_CheckTurboSuspend ( void )
+{
+	if ( ( ConfigureParams.DiskImage.TurboFloppy ) && ( !FDC.TurboSuspended )
+	  && ( FDC.STR & FDC_STR_BIT_BUSY ) )
+	{
+		LOG_TRACE(TRACE_FDC, "fdc turbo mode suspended VBL=%d pc=%x\n" , nVBLs , M68000_GetPC() );
+		FDC.TurboSuspended = true;
+	}
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Return Status/FDC register when reading from $ff8604
@@ -2933,9 +2968,11 @@ void FDC_DiskControllerStatus_ReadWord ( void )
 			MFP_GPIP |= 0x20;
 			break;
 		 case 0x2:						/* 0 1 - Track register */
+			FDC_CheckTurboSuspend ();
 			DiskControllerByte = FDC.TR;
 			break;
 		 case 0x4:						/* 1 0 - Sector register */
+			FDC_CheckTurboSuspend ();
 			DiskControllerByte = FDC.SR;
 			break;
 		 case 0x6:						/* 1 1 - Data register */
@@ -49,6 +49,22 @@ EMULATION_DRIVE EmulationDrives[MAX_FLOPPYDRIVES];
 int nBootDrive = 0;
 
 
+/* Images of recently ejected disks, to avoid reading and uncompressing
+ * them again when they are inserted again (eg. for multi disk programs) */
+#define FLOPPY_CACHE_ENTRIES	8
+
+typedef struct
+{
+	EMULATION_DRIVE Image;			/* Image contents and file/zip path */
+	off_t nFileSize;			/* Image file size and modification time, */
+	time_t nFileTime;			/* to check whether the file was changed */
+	Uint32 nLastUse;
+} FLOPPY_CACHE_ENTRY;
+
+static FLOPPY_CACHE_ENTRY FloppyCache[FLOPPY_CACHE_ENTRIES];
+static Uint32 nFloppyCacheUse;
+
+
 /* Possible disk image file extensions to scan for */
 static const char * const pszDiskImageNameExts[] =
 {
@@ -64,6 +80,326 @@ static bool	Floppy_EjectBothDrives(void);
 static void	Floppy_DriveTransitionSetState ( int Drive , int State );
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Free image contents and track states of given drive / cache entry
+ */
+static void Floppy_FreeImage(EMULATION_DRIVE *pDrive)
+{
+	free(pDrive->pBuffer);
+	pDrive->pBuffer = NULL;
+	free(pDrive->pTrackState);
+	pDrive->pTrackState = NULL;
+	free(pDrive->pPackedImage);
+	pDrive->pPackedImage = NULL;
+	free(pDrive->pPackedTrackOffsets);
+	pDrive->pPackedTrackOffsets = NULL;
+	pDrive->nBytesPerTrack = pDrive->nTracks = 0;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Allocate track states for the image in given drive and set them all
+ * to 'State'. Return false if there's not enough memory.
+ */
+static bool Floppy_InitTrackStates(EMULATION_DRIVE *pDrive, int nBytesPerTrack, Uint8 State)
+{
+	if (nBytesPerTrack <= 0)
+		nBytesPerTrack = NUMBYTESPERSECTOR;
+	pDrive->nBytesPerTrack = nBytesPerTrack;
+	pDrive->nTracks = (pDrive->nImageBytes + nBytesPerTrack - 1) / nBytesPerTrack;
+
+	free(pDrive->pTrackState);
+	pDrive->pTrackState = malloc(pDrive->nTracks + 1);
+	if (!pDrive->pTrackState)
+	{
+		perror("Floppy_InitTrackStates");
+		return false;
+	}
+	memset(pDrive->pTrackState, State, pDrive->nTracks + 1);
+	return true;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Make sure that the tracks containing 'Size' bytes at 'Offset' in the image
+ * are available in pBuffer, uncompress them from the .MSA file if necessary.
+ */
+static void Floppy_LoadTracks(EMULATION_DRIVE *pDrive, long Offset, long Size)
+{
+	int Track, LastTrack;
+
+	if (!pDrive->pPackedImage || Size <= 0)
+		return;
+
+	Track = Offset / pDrive->nBytesPerTrack;
+	LastTrack = (Offset + Size - 1) / pDrive->nBytesPerTrack;
+	if (LastTrack >= pDrive->nTracks)
+		LastTrack = pDrive->nTracks - 1;
+
+	for ( ; Track <= LastTrack; Track++)
+	{
+		if (pDrive->pTrackState[Track] & FLOPPY_TRACK_LOADED)
+			continue;
+		MSA_UnCompressTrack(pDrive->pPackedImage + pDrive->pPackedTrackOffsets[Track],
+		                    pDrive->pBuffer + Track * pDrive->nBytesPerTrack,
+		                    pDrive->nBytesPerTrack);
+		pDrive->pTrackState[Track] |= FLOPPY_TRACK_LOADED;
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Flag the tracks containing 'Size' bytes at 'Offset' in the image as changed
+ */
+static void Floppy_SetTracksDirty(EMULATION_DRIVE *pDrive, long Offset, long Size)
+{
+	int Track, LastTrack;
+
+	if (!pDrive->pTrackState || Size <= 0)
+		return;
+
+	Track = Offset / pDrive->nBytesPerTrack;
+	LastTrack = (Offset + Size - 1) / pDrive->nBytesPerTrack;
+	if (LastTrack >= pDrive->nTracks)
+		LastTrack = pDrive->nTracks - 1;
+
+	for ( ; Track <= LastTrack; Track++)
+		pDrive->pTrackState[Track] |= FLOPPY_TRACK_DIRTY;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Flag all tracks as being the same as in the image file again,
+ * after the image has been saved
+ */
+static void Floppy_ClearTracksDirty(EMULATION_DRIVE *pDrive)
+{
+	int Track;
+
+	if (!pDrive->pTrackState)
+		return;
+	for (Track = 0; Track < pDrive->nTracks; Track++)
+		pDrive->pTrackState[Track] &= ~FLOPPY_TRACK_DIRTY;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Write the changed tracks of the image in given drive directly into the
+ * (uncompressed) image file, which has 'nHeaderBytes' before the disk
+ * contents. Return true if all OK, false if the whole image needs to be
+ * saved instead.
+ */
+static bool Floppy_WriteChangedTracks(int Drive, const char *pszFileName, long nHeaderBytes)
+{
+	EMULATION_DRIVE *pDrive = &EmulationDrives[Drive];
+	FILE *fp;
+	long Offset, Size;
+	bool bRet = true;
+	int Track;
+
+	/* File needs to be still the same as when the image was loaded */
+	if (!pDrive->pTrackState || File_DoesFileExtensionMatch(pszFileName, ".gz")
+	    || File_Length(pszFileName) != nHeaderBytes + pDrive->nImageBytes)
+		return false;
+
+	fp = fopen(pszFileName, "r+b");
+	if (!fp)
+		return false;
+
+	for (Track = 0; Track < pDrive->nTracks; Track++)
+	{
+		if (!(pDrive->pTrackState[Track] & FLOPPY_TRACK_DIRTY))
+			continue;
+
+		Offset = (long)Track * pDrive->nBytesPerTrack;
+		Size = pDrive->nImageBytes - Offset;
+		if (Size > pDrive->nBytesPerTrack)
+			Size = pDrive->nBytesPerTrack;
+		if (fseek(fp, nHeaderBytes + Offset, SEEK_SET) != 0
+		    || fwrite(pDrive->pBuffer + Offset, 1, Size, fp) != (size_t)Size)
+		{
+			bRet = false;
+			break;
+		}
+	}
+
+	if (fclose(fp) != 0)
+		bRet = false;
+	return bRet;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Get size and modification time of given file, return false on error.
+ */
+static bool Floppy_GetFileTime(const char *pszFileName, off_t *pnSize, time_t *pnTime)
+{
+	struct stat FileStat;
+
+	if (stat(pszFileName, &FileStat) != 0)
+		return false;
+	*pnSize = FileStat.st_size;
+	*pnTime = FileStat.st_mtime;
+	return true;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Move the image of given drive to the cache of ejected images.
+ * The least recently used entry is dropped if the cache is full.
+ */
+static void Floppy_CachePut(int Drive)
+{
+	EMULATION_DRIVE *pDrive = &EmulationDrives[Drive];
+	FLOPPY_CACHE_ENTRY *pEntry = &FloppyCache[0];
+	off_t nFileSize;
+	time_t nFileTime;
+	int i;
+
+	if (!pDrive->pBuffer || !pDrive->pTrackState || pDrive->bNoCache
+	    || !Floppy_GetFileTime(pDrive->sFileName, &nFileSize, &nFileTime))
+	{
+		Floppy_FreeImage(pDrive);
+		return;
+	}
+
+	for (i = 0; i < FLOPPY_CACHE_ENTRIES; i++)
+	{
+		if (!FloppyCache[i].Image.pBuffer)
+		{
+			pEntry = &FloppyCache[i];
+			break;
+		}
+		if (FloppyCache[i].nLastUse < pEntry->nLastUse)
+			pEntry = &FloppyCache[i];
+	}
+	Floppy_FreeImage(&pEntry->Image);
+
+	pEntry->Image = *pDrive;
+	pEntry->nFileSize = nFileSize;
+	pEntry->nFileTime = nFileTime;
+	pEntry->nLastUse = ++nFloppyCacheUse;
+
+	pDrive->pBuffer = NULL;
+	pDrive->pTrackState = NULL;
+	pDrive->pPackedImage = NULL;
+	pDrive->pPackedTrackOffsets = NULL;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Look for given image file in the cache of ejected images, and if it's
+ * there and the file didn't change since, move it to given drive.
+ * Return true if image was found.
+ */
+static bool Floppy_CacheGet(int Drive, const char *pszFileName, const char *pszZipPath)
+{
+	EMULATION_DRIVE *pDrive = &EmulationDrives[Drive];
+	FLOPPY_CACHE_ENTRY *pEntry;
+	off_t nFileSize;
+	time_t nFileTime;
+	int i;
+
+	for (i = 0; i < FLOPPY_CACHE_ENTRIES; i++)
+	{
+		pEntry = &FloppyCache[i];
+		if (!pEntry->Image.pBuffer || strcmp(pEntry->Image.sFileName, pszFileName) != 0
+		    || strcmp(pEntry->Image.sZipPath, pszZipPath) != 0)
+			continue;
+
+		if (!Floppy_GetFileTime(pszFileName, &nFileSize, &nFileTime)
+		    || nFileSize != pEntry->nFileSize || nFileTime != pEntry->nFileTime)
+		{
+			/* Image file was changed, cached contents are outdated */
+			Floppy_FreeImage(&pEntry->Image);
+			return false;
+		}
+
+		pDrive->pBuffer = pEntry->Image.pBuffer;
+		pDrive->nImageBytes = pEntry->Image.nImageBytes;
+		pDrive->nBytesPerTrack = pEntry->Image.nBytesPerTrack;
+		pDrive->nTracks = pEntry->Image.nTracks;
+		pDrive->pTrackState = pEntry->Image.pTrackState;
+		pDrive->pPackedImage = pEntry->Image.pPackedImage;
+		pDrive->pPackedTrackOffsets = pEntry->Image.pPackedTrackOffsets;
+		memset(&pEntry->Image, 0, sizeof(pEntry->Image));
+		return true;
+	}
+
+	return false;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Read disk image file to given drive. .MSA images are not uncompressed,
+ * only the first track is, the others will be when first accessed.
+ * Return true on success.
+ */
+static bool Floppy_ReadImage(int Drive, const char *pszFileName, const char *pszZipPath)
+{
+	EMULATION_DRIVE *pDrive = &EmulationDrives[Drive];
+	Uint16 nSectorsPerTrack, nSides;
+	long nImageBytes = 0;
+	int nTracks, nBytesPerTrack;
+
+	/* Check disk image type and read the file: */
+	if (MSA_FileNameIsMSA(pszFileName, true))
+	{
+		pDrive->pPackedImage = MSA_ReadDiskTracks(pszFileName, &nTracks, &nBytesPerTrack,
+		                                          &pDrive->pPackedTrackOffsets);
+		if (pDrive->pPackedImage)
+		{
+			pDrive->nImageBytes = nTracks * nBytesPerTrack;
+			pDrive->pBuffer = malloc(pDrive->nImageBytes);
+			if (!pDrive->pBuffer || !Floppy_InitTrackStates(pDrive, nBytesPerTrack, 0))
+			{
+				perror("Floppy_ReadImage");
+				Floppy_FreeImage(pDrive);
+				return false;
+			}
+			/* Boot sector is needed at once */
+			Floppy_LoadTracks(pDrive, 0, NUMBYTESPERSECTOR);
+			return true;
+		}
+		pDrive->pBuffer = MSA_ReadDisk(pszFileName, &nImageBytes);
+	}
+	else if (ST_FileNameIsST(pszFileName, true))
+		pDrive->pBuffer = ST_ReadDisk(pszFileName, &nImageBytes);
+	else if (DIM_FileNameIsDIM(pszFileName, true))
+		pDrive->pBuffer = DIM_ReadDisk(pszFileName, &nImageBytes);
+	else if (ZIP_FileNameIsZIP(pszFileName))
+		pDrive->pBuffer = ZIP_ReadDisk(pszFileName, pszZipPath, &nImageBytes);
+
+	if (pDrive->pBuffer == NULL)
+		return false;
+
+	/* Whole image is loaded, track size is only used to flag changed tracks */
+	pDrive->nImageBytes = nImageBytes;
+	nBytesPerTrack = NUMBYTESPERSECTOR;
+	if (nImageBytes >= NUMBYTESPERSECTOR)
+	{
+		Floppy_FindDiskDetails(pDrive->pBuffer, nImageBytes, &nSectorsPerTrack, &nSides);
+		nBytesPerTrack *= nSectorsPerTrack;
+	}
+	if (!Floppy_InitTrackStates(pDrive, nBytesPerTrack, FLOPPY_TRACK_LOADED))
+	{
+		Floppy_FreeImage(pDrive);
+		return false;
+	}
+	return true;
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Initialize emulation floppy drives
@@ -89,7 +425,12 @@ void Floppy_Init(void)
  */
 void Floppy_UnInit(void)
 {
+	int i;
+
 	Floppy_EjectBothDrives();
+
+	for (i = 0; i < FLOPPY_CACHE_ENTRIES; i++)
+		Floppy_FreeImage(&FloppyCache[i].Image);
 }
 
 
@@ -133,6 +474,8 @@ void Floppy_MemorySnapShot_Capture(bool bSave)
 			if (!EmulationDrives[i].pBuffer)
 				perror("Floppy_MemorySnapShot_Capture");
 		}
+		if (bSave)
+			Floppy_LoadTracks(&EmulationDrives[i], 0, EmulationDrives[i].nImageBytes);
 		if (EmulationDrives[i].pBuffer)
 			MemorySnapShot_Store(EmulationDrives[i].pBuffer, EmulationDrives[i].nImageBytes);
 		MemorySnapShot_Store(EmulationDrives[i].sFileName, sizeof(EmulationDrives[i].sFileName));
@@ -142,6 +485,15 @@ void Floppy_MemorySnapShot_Capture(bool bSave)
 		MemorySnapShot_Store(&EmulationDrives[i].TransitionState1_VBL,sizeof(EmulationDrives[i].TransitionState1_VBL));
 		MemorySnapShot_Store(&EmulationDrives[i].TransitionState2,sizeof(EmulationDrives[i].TransitionState2));
 		MemorySnapShot_Store(&EmulationDrives[i].TransitionState2_VBL,sizeof(EmulationDrives[i].TransitionState2_VBL));
+
+		/* Restored image is not related to the image file anymore */
+		if (!bSave && EmulationDrives[i].pBuffer)
+		{
+			EmulationDrives[i].sZipPath[0] = '\0';
+			EmulationDrives[i].bNoCache = true;
+			Floppy_InitTrackStates(&EmulationDrives[i], NUMBYTESPERSECTOR,
+			                       FLOPPY_TRACK_LOADED | FLOPPY_TRACK_DIRTY);
+		}
 	}
 }
 
@@ -481,13 +833,14 @@ int	Floppy_DriveTransitionUpdateState ( int Drive )
 /*-----------------------------------------------------------------------*/
 /**
  * Insert previously set disk file image into floppy drive.
- * The WHOLE image is copied into Hatari drive buffers, and
- * uncompressed if necessary.
+ * The image is copied into Hatari drive buffers (from the cache of
+ * ejected images if it's there). Tracks of .MSA images are uncompressed
+ * when first accessed.
  * Return TRUE on success, false otherwise.
  */
 bool Floppy_InsertDiskIntoDrive(int Drive)
 {
-	long nImageBytes = 0;
+	const char *zippath;
 	char *filename;
 
 	/* Eject disk, if one is inserted (doesn't inform user) */
@@ -505,31 +858,25 @@ bool Floppy_InsertDiskIntoDrive(int Drive)
 		return false;
 	}
 
-	/* Check disk image type and read the file: */
-	if (MSA_FileNameIsMSA(filename, true))
-		EmulationDrives[Drive].pBuffer = MSA_ReadDisk(filename, &nImageBytes);
-	else if (ST_FileNameIsST(filename, true))
-		EmulationDrives[Drive].pBuffer = ST_ReadDisk(filename, &nImageBytes);
-	else if (DIM_FileNameIsDIM(filename, true))
-		EmulationDrives[Drive].pBuffer = DIM_ReadDisk(filename, &nImageBytes);
-	else if (ZIP_FileNameIsZIP(filename))
-	{
-		const char *zippath = ConfigureParams.DiskImage.szDiskZipPath[Drive];
-		EmulationDrives[Drive].pBuffer = ZIP_ReadDisk(filename, zippath, &nImageBytes);
-	}
+	/* Zip path is used only for zip files */
+	zippath = ConfigureParams.DiskImage.szDiskZipPath[Drive];
+	if (!ZIP_FileNameIsZIP(filename))
+		zippath = "";
 
-	if (EmulationDrives[Drive].pBuffer == NULL)
+	if (!Floppy_CacheGet(Drive, filename, zippath)
+	    && !Floppy_ReadImage(Drive, filename, zippath))
 	{
 		return false;
 	}
 
 	/* Store image filename (required for ejecting the disk later!) */
 	strcpy(EmulationDrives[Drive].sFileName, filename);
+	strcpy(EmulationDrives[Drive].sZipPath, zippath);
 
-	/* Store size and set drive states */
-	EmulationDrives[Drive].nImageBytes = nImageBytes;
+	/* Set drive states */
 	EmulationDrives[Drive].bDiskInserted = true;
 	EmulationDrives[Drive].bContentsChanged = false;
+	EmulationDrives[Drive].bNoCache = false;
 	EmulationDrives[Drive].bOKToSave = Floppy_IsBootSectorOK(Drive);
 	Floppy_DriveTransitionSetState ( Drive , FLOPPY_DRIVE_TRANSITION_STATE_INSERT );
 	Log_Printf(LOG_INFO, "Inserted disk '%s' to drive %c:.",
@@ -560,17 +907,24 @@ bool Floppy_EjectDiskFromDrive(int Drive)
 			/* Is OK to save image (if boot-sector is bad, don't allow a save) */
 			if (EmulationDrives[Drive].bOKToSave && !Floppy_IsWriteProtected(Drive))
 			{
-				/* Save as .MSA or .ST image? */
+				/* Save as .MSA or .ST image? Only changed tracks need to be
+				 * compressed again / written to the file */
 				if (MSA_FileNameIsMSA(psFileName, true))
-					bSaved = MSA_WriteDisk(psFileName, EmulationDrives[Drive].pBuffer, EmulationDrives[Drive].nImageBytes);
+					bSaved = MSA_WriteDiskTracks(psFileName, EmulationDrives[Drive].pBuffer, EmulationDrives[Drive].nImageBytes,
+					                             EmulationDrives[Drive].pPackedImage, EmulationDrives[Drive].pPackedTrackOffsets,
+					                             EmulationDrives[Drive].pTrackState);
 				else if (ST_FileNameIsST(psFileName, true))
-					bSaved = ST_WriteDisk(psFileName, EmulationDrives[Drive].pBuffer, EmulationDrives[Drive].nImageBytes);
+					bSaved = Floppy_WriteChangedTracks(Drive, psFileName, 0)
+					         || ST_WriteDisk(psFileName, EmulationDrives[Drive].pBuffer, EmulationDrives[Drive].nImageBytes);
 				else if (DIM_FileNameIsDIM(psFileName, true))
 					bSaved = DIM_WriteDisk(psFileName, EmulationDrives[Drive].pBuffer, EmulationDrives[Drive].nImageBytes);
 				else if (ZIP_FileNameIsZIP(psFileName))
 					bSaved = ZIP_WriteDisk(psFileName, EmulationDrives[Drive].pBuffer, EmulationDrives[Drive].nImageBytes);
 				if (bSaved)
+				{
+					Floppy_ClearTracksDirty(&EmulationDrives[Drive]);
 					Log_Printf(LOG_INFO, "Updated the contents of floppy image '%s'.", psFileName);
+				}
 				else
 					Log_Printf(LOG_INFO, "Writing of this format failed or not supported, discarded the contents\n of floppy image '%s'.", psFileName);
 			} else
@@ -583,20 +937,23 @@ bool Floppy_EjectDiskFromDrive(int Drive)
 
 		Floppy_DriveTransitionSetState ( Drive , FLOPPY_DRIVE_TRANSITION_STATE_EJECT );
 		bEjected = true;
+
+		/* Keep the image for the case it's inserted again, unless
+		 * its contents differ from the file */
+		if (!EmulationDrives[Drive].bContentsChanged || bSaved)
+			Floppy_CachePut(Drive);
 	}
 
 	/* Drive is now empty */
-	if (EmulationDrives[Drive].pBuffer != NULL)
-	{
-		free(EmulationDrives[Drive].pBuffer);
-		EmulationDrives[Drive].pBuffer = NULL;
-	}
+	Floppy_FreeImage(&EmulationDrives[Drive]);
 
 	EmulationDrives[Drive].sFileName[0] = '\0';
+	EmulationDrives[Drive].sZipPath[0] = '\0';
 	EmulationDrives[Drive].nImageBytes = 0;
 	EmulationDrives[Drive].bDiskInserted = false;
 	EmulationDrives[Drive].bContentsChanged = false;
 	EmulationDrives[Drive].bOKToSave = false;
+	EmulationDrives[Drive].bNoCache = false;
 
 	return bEjected;
 }
@@ -785,6 +1142,7 @@ bool Floppy_ReadSectors(int Drive, Uint8 *pBuffer, Uint16 Sector,
 		Offset += (NUMBYTESPERSECTOR*(Sector-1));     /* And finally to sector */
 
 		/* Read sectors (usually 512 bytes per sector) */
+		Floppy_LoadTracks(&EmulationDrives[Drive], Offset, (int)Count*NUMBYTESPERSECTOR);
 		memcpy(pBuffer, pDiskBuffer+Offset, (int)Count*NUMBYTESPERSECTOR);
 
 		return true;
@@ -865,8 +1223,10 @@ bool Floppy_WriteSectors(int Drive, Uint8 *pBuffer, Uint16 Sector,
 		Offset += (NUMBYTESPERSECTOR*(Sector-1));   /* And finally to sector */
 
 		/* Write sectors (usually 512 bytes per sector) */
+		Floppy_LoadTracks(&EmulationDrives[Drive], Offset, (int)Count*NUMBYTESPERSECTOR);
 		memcpy(pDiskBuffer+Offset, pBuffer, (int)Count*NUMBYTESPERSECTOR);
-		/* And set 'changed' flag */
+		/* And set 'changed' flags */
+		Floppy_SetTracksDirty(&EmulationDrives[Drive], Offset, (int)Count*NUMBYTESPERSECTOR);
 		EmulationDrives[Drive].bContentsChanged = true;
 
 		return true;
@@ -37,12 +37,14 @@ const char Gemdos_fileid[] = "Hatari gemdos.c : " __DATE__ " " __TIME__;
 #include <errno.h>
 
 #include "main.h"
+#include "benchmark.h"
 #include "cart.h"
 #include "tos.h"
 #include "configuration.h"
 #include "file.h"
 #include "floppy.h"
 #include "hdc.h"
+#include "inputRecord.h"
 #include "gemdos.h"
 #include "gemdos_defines.h"
 #include "log.h"
@@ -161,6 +163,7 @@ static char *LastProgramPath;
 static void GemDOS_DateTime2Tos(time_t t, DATETIME *DateTime, const char *fname)
 {
 	struct tm *x;
+	Uint32 value;
 
 	/* localtime takes DST into account */
 	x = localtime(&t);
@@ -170,14 +173,21 @@ static void GemDOS_DateTime2Tos(time_t t, DATETIME *DateTime, const char *fname)
 		Log_Printf(LOG_WARN, "WARNING: '%s' timestamp is invalid for (Windows?) localtime(), defaulting to TOS epoch!",  fname);
 		DateTime->dateword = 1|(1<<5);	/* 1980-01-01 */
 		DateTime->timeword = 0;
-		return;
 	}
-	/* Bits: 0-4 = secs/2, 5-10 = mins, 11-15 = hours (24-hour format) */
-	DateTime->timeword = (x->tm_sec>>1)|(x->tm_min<<5)|(x->tm_hour<<11);
-	
-	/* Bits: 0-4 = day (1-31), 5-8 = month (1-12), 9-15 = years (since 1980) */
-	DateTime->dateword = x->tm_mday | ((x->tm_mon+1)<<5)
-		| (((x->tm_year-80 > 0) ? x->tm_year-80 : 0) << 9);
+	else
+	{
+		/* Bits: 0-4 = secs/2, 5-10 = mins, 11-15 = hours (24-hour format) */
+		DateTime->timeword = (x->tm_sec>>1)|(x->tm_min<<5)|(x->tm_hour<<11);
+
+		/* Bits: 0-4 = day (1-31), 5-8 = month (1-12), 9-15 = years (since 1980) */
+		DateTime->dateword = x->tm_mday | ((x->tm_mon+1)<<5)
+			| (((x->tm_year-80 > 0) ? x->tm_year-80 : 0) << 9);
+	}
+
+	/* host file timestamps are input for input recording & replay */
+	value = InputRecord_HostTime(DateTime->dateword << 16 | DateTime->timeword);
+	DateTime->dateword = value >> 16;
+	DateTime->timeword = value;
 }
 
 /*-----------------------------------------------------------------------*/
@@ -2032,6 +2042,15 @@ static bool GemDOS_Read(Uint32 Params)
 		Regs[REG_D0] = -1;
 		return true;
 	}
+
+	/* Replayed input recording gives the file contents */
+	nBytesRead = InputRecord_ReplayHostFile(Addr, Size);
+	if (nBytesRead >= 0)
+	{
+		fseek(FileHandles[Handle].FileHandle, nBytesRead, SEEK_CUR);
+		Regs[REG_D0] = nBytesRead;
+		return true;
+	}
 	
 	/* To quick check to see where our file pointer is and how large the file is */
 	CurrentPos = ftell(FileHandles[Handle].FileHandle);
@@ -2045,6 +2064,7 @@ static bool GemDOS_Read(Uint32 Params)
 	if (Size <= 0 || nBytesLeft <= 0)
 	{
 		/* return zero (bytes read) as original GEMDOS/EmuTOS */
+		InputRecord_RecordHostFile(NULL, 0);
 		Regs[REG_D0] = 0;
 		return true;
 	}
@@ -2062,6 +2082,7 @@ static bool GemDOS_Read(Uint32 Params)
 	}
 	/* And read data in */
 	nBytesRead = fread(pBuffer, 1, Size, FileHandles[Handle].FileHandle);
+	InputRecord_RecordHostFile((Uint8 *)pBuffer, nBytesRead > 0 ? nBytesRead : 0);
 	
 	/* Return number of bytes read */
 	Regs[REG_D0] = nBytesRead;
@@ -3118,6 +3139,7 @@ void GemDOS_OpCode(void)
 	Uint32 Params;
 	int Finished;
 	Uint16 SR;
+	int nBenchPrev = Benchmark_Enter(BENCH_GEMDOS);
 
 	SR = M68000_GetSR();
 
@@ -3324,6 +3346,7 @@ void GemDOS_OpCode(void)
 	}
 
 	M68000_SetSR(SR);   /* update the flags in the SR register */
+	Benchmark_Leave(nBenchPrev);
 }
 
 
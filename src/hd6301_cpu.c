@@ -17,14 +17,58 @@
 #include <stdlib.h>
 #include <SDL.h>
 
+#include "main.h"
 #include "hd6301_cpu.h"
+#include "log.h"
+#include "memorySnapShot.h"
 
 
 /**********************************
  *	Defines
  **********************************/
-#define HD6301_DISASM 		1
-#define HD6301_DISPLAY_REGS	1
+/* Internal registers */
+#define HD6301_REG_P1DDR	0x00
+#define HD6301_REG_P2DDR	0x01
+#define HD6301_REG_P1DATA	0x02
+#define HD6301_REG_P2DATA	0x03
+#define HD6301_REG_P3DDR	0x04
+#define HD6301_REG_P4DDR	0x05
+#define HD6301_REG_P3DATA	0x06
+#define HD6301_REG_P4DATA	0x07
+#define HD6301_REG_TCSR		0x08
+#define HD6301_REG_FRC_HIGH	0x09
+#define HD6301_REG_FRC_LOW	0x0a
+#define HD6301_REG_OCR_HIGH	0x0b
+#define HD6301_REG_OCR_LOW	0x0c
+#define HD6301_REG_RMCR		0x10
+#define HD6301_REG_TRCSR	0x11
+#define HD6301_REG_RDR		0x12
+#define HD6301_REG_TDR		0x13
+
+/* Timer control and status register bits */
+#define HD6301_TCSR_ICF		0x80
+#define HD6301_TCSR_OCF		0x40
+#define HD6301_TCSR_TOF		0x20
+#define HD6301_TCSR_EOCI	0x08
+#define HD6301_TCSR_ETOI	0x04
+
+/* Transmit/receive control and status register bits */
+#define HD6301_TRCSR_RDRF	0x80
+#define HD6301_TRCSR_ORFE	0x40
+#define HD6301_TRCSR_TDRE	0x20
+#define HD6301_TRCSR_RIE	0x10
+#define HD6301_TRCSR_RE		0x08
+#define HD6301_TRCSR_TIE	0x04
+#define HD6301_TRCSR_TE		0x02
+
+/* Interrupt vectors */
+#define HD6301_VECTOR_TRAP	0xffee
+#define HD6301_VECTOR_SCI	0xfff0
+#define HD6301_VECTOR_TOF	0xfff2
+#define HD6301_VECTOR_OCF	0xfff4
+#define HD6301_VECTOR_RESET	0xfffe
+
+#define HD6301_IRQ_CYCLES	12
 
 /* HD6301 Disasm and debug code */
 #define HD6301_DISASM_UNDEFINED		0
@@ -76,6 +120,15 @@
 static Uint8 hd6301_read_memory(Uint16 addr);
 static void hd6301_write_memory (Uint16 addr, Uint8 value);
 static Uint16 hd6301_get_memory_ext(void);
+static Uint8 hd6301_read_register(Uint8 reg);
+static void hd6301_write_register(Uint8 reg, Uint8 value);
+static Uint8 hd6301_read_port_lines(int port, Uint8 ddr_reg, Uint8 data_reg);
+static void hd6301_update_timer(int cycles);
+static int hd6301_get_cycles_to_timer_event(void);
+static Uint16 hd6301_get_pending_interrupt(void);
+static void hd6301_check_interrupts(void);
+static void hd6301_push_registers(void);
+static void hd6301_jump_vector(Uint16 vector);
 
 /* HD6301 opcodes functions */
 static void hd6301_undefined(void);
@@ -598,9 +651,9 @@ static struct hd6301_opcode_t hd6301_opcode_table[256] = {
 static Uint8	hd6301_cycles;
 static Uint8	hd6301_cur_inst;
 
-static Sint8	hd6301_reg_A; 
-static Sint8	hd6301_reg_B;
-static Sint16	hd6301_reg_X;
+static Uint8	hd6301_reg_A;
+static Uint8	hd6301_reg_B;
+static Uint16	hd6301_reg_X;
 static Uint16	hd6301_reg_SP;
 static Uint16	hd6301_reg_PC;
 static Uint8	hd6301_reg_CCR;
@@ -611,6 +664,17 @@ static Uint8	hd6301_intREG[32];
 static Uint8	hd6301_intRAM[128];
 static Uint8	hd6301_intROM[4096];
 
+static Uint16	hd6301_reg_FRC;			/* Free running counter */
+static Uint16	hd6301_reg_OCR;			/* Output compare register */
+static Uint8	hd6301_frc_low_latch;		/* FRC low byte, latched when reading the high byte */
+static Uint8	hd6301_tcsr_read;		/* TCSR flags seen by the last read of TCSR */
+static Uint8	hd6301_trcsr_read;		/* TRCSR flags seen by the last read of TRCSR */
+static bool	hd6301_waiting;			/* WAI was executed, registers are already stacked */
+static bool	hd6301_sleeping;		/* SLP was executed */
+static int	hd6301_cycles_credit;		/* Cycles left to run (negative if we ran too many) */
+
+Uint8	(*hd6301_read_port)(int port);
+
 
 /**********************************
  *	Emulator kernel
@@ -624,26 +688,65 @@ void hd6301_init_cpu(void)
 	hd6301_reg_CCR = 0xc0;
 }
 
+/**
+ * Reset hd6301 cpu : set internal registers to their default values
+ * and start executing the code pointed to by the reset vector
+ */
+void hd6301_reset_cpu(void)
+{
+	memset(hd6301_intREG, 0, sizeof(hd6301_intREG));
+	hd6301_intREG[HD6301_REG_TRCSR] = HD6301_TRCSR_TDRE;
+
+	hd6301_reg_FRC = 0;
+	hd6301_reg_OCR = 0xffff;
+	hd6301_frc_low_latch = 0;
+	hd6301_tcsr_read = 0;
+	hd6301_trcsr_read = 0;
+
+	hd6301_waiting = false;
+	hd6301_sleeping = false;
+	hd6301_cycles_credit = 0;
+
+	hd6301_reg_CCR = 0xc0 | (1 << hd6301_REG_CCR_I);
+	hd6301_jump_vector(HD6301_VECTOR_RESET);
+}
+
+/**
+ * Copy the 4 KB of the mask ROM mapped at $F000-$FFFF
+ */
+void hd6301_load_rom(const Uint8 *pRom)
+{
+	memcpy(hd6301_intROM, pRom, sizeof(hd6301_intROM));
+}
+
 /**
  * Execute 1 hd6301 instruction
+ * When the cpu is stopped by WAI or SLP, only the timer is updated.
  */
 void hd6301_execute_one_instruction(void)
 {
+	if (hd6301_waiting || hd6301_sleeping) {
+		hd6301_cycles = 1;
+		hd6301_update_timer(hd6301_cycles);
+		hd6301_check_interrupts();
+		return;
+	}
+
+	hd6301_cycles = 0;
 	hd6301_cur_inst = hd6301_read_memory(hd6301_reg_PC);
 
 	/* Get opcode to execute */
 	hd6301_opcode = hd6301_opcode_table[hd6301_cur_inst];
 
 	/* disasm opcode ? */
-#ifdef HD6301_DISASM
-	hd6301_disasm();
-#endif
+	if (LOG_TRACE_LEVEL(TRACE_IKBD_EXEC))
+		hd6301_disasm();
+
 	/* execute opcode  */
 	hd6301_opcode.op_func();
 
-#ifdef HD6301_DISPLAY_REGS
-	hd6301_display_registers();
-#endif
+	if (LOG_TRACE_LEVEL(TRACE_IKBD_EXEC))
+		hd6301_display_registers();
 
 	/* Increment instruction cycles */
 	hd6301_cycles += hd6301_opcode.op_n_cycles;
@@ -651,11 +754,228 @@ void hd6301_execute_one_instruction(void)
 	/* Increment PC register */
 	hd6301_reg_PC += hd6301_opcode.op_bytes;
 
+	/* post process timers */
+	hd6301_update_timer(hd6301_cycles);
+
 	/* post process interrupts */
+	hd6301_check_interrupts();
+}
 
-	/* post process timers */
+/**
+ * Run the hd6301 for some cycles. As instructions can't be split, we may
+ * run a few cycles too many ; they will be deducted from the next call.
+ */
+void hd6301_run_cycles(int cycles)
+{
+	int	idle;
+
+	hd6301_cycles_credit += cycles;
+
+	while (hd6301_cycles_credit > 0) {
+		/* When stopped, jump directly to the next timer event */
+		if (hd6301_waiting || hd6301_sleeping) {
+			idle = hd6301_get_cycles_to_timer_event();
+			if (idle > hd6301_cycles_credit)
+				idle = hd6301_cycles_credit;
+			hd6301_update_timer(idle);
+			hd6301_cycles = 0;
+			hd6301_check_interrupts();
+			hd6301_cycles_credit -= idle + hd6301_cycles;
+			continue;
+		}
+
+		hd6301_execute_one_instruction();
+		hd6301_cycles_credit -= hd6301_cycles;
+	}
+}
+
+/**
+ * Return the number of cycles before the timer raises an enabled
+ * interrupt, or -1 if no timer interrupt is enabled.
+ */
+int hd6301_get_cycles_to_interrupt(void)
+{
+	Uint8	tcsr = hd6301_intREG[HD6301_REG_TCSR];
+	int	cycles = -1;
+	int	to_ocr, to_overflow;
+
+	to_ocr = (Uint16)(hd6301_reg_OCR - hd6301_reg_FRC);
+	if (to_ocr == 0)
+		to_ocr = 0x10000;
+	to_overflow = 0x10000 - hd6301_reg_FRC;
+
+	if (tcsr & HD6301_TCSR_EOCI)
+		cycles = to_ocr;
+	if ((tcsr & HD6301_TCSR_ETOI) && (cycles < 0 || to_overflow < cycles))
+		cycles = to_overflow;
+	if (cycles < 0)
+		return -1;
+
+	/* Take into account the cycles we already ran ahead */
+	return cycles - hd6301_cycles_credit;
+}
+
+/**
+ * Return the number of cycles before the next compare match or overflow
+ */
+static int hd6301_get_cycles_to_timer_event(void)
+{
+	int	to_ocr, to_overflow;
+
+	to_ocr = (Uint16)(hd6301_reg_OCR - hd6301_reg_FRC);
+	if (to_ocr == 0)
+		to_ocr = 0x10000;
+	to_overflow = 0x10000 - hd6301_reg_FRC;
+
+	return to_ocr < to_overflow ? to_ocr : to_overflow;
+}
+
+/**
+ * Update the free running counter and set the OCF/TOF flags
+ */
+static void hd6301_update_timer(int cycles)
+{
+	int	to_ocr;
+
+	to_ocr = (Uint16)(hd6301_reg_OCR - hd6301_reg_FRC);
+	if (to_ocr == 0)
+		to_ocr = 0x10000;
+
+	if (cycles >= to_ocr)
+		hd6301_intREG[HD6301_REG_TCSR] |= HD6301_TCSR_OCF;
+	if (hd6301_reg_FRC + cycles > 0xffff)
+		hd6301_intREG[HD6301_REG_TCSR] |= HD6301_TCSR_TOF;
+
+	hd6301_reg_FRC += cycles;
+}
+
+/**
+ * Return the vector of the highest priority pending interrupt, or 0
+ */
+static Uint16 hd6301_get_pending_interrupt(void)
+{
+	Uint8	tcsr = hd6301_intREG[HD6301_REG_TCSR];
+	Uint8	trcsr = hd6301_intREG[HD6301_REG_TRCSR];
+
+	if ((tcsr & HD6301_TCSR_OCF) && (tcsr & HD6301_TCSR_EOCI))
+		return HD6301_VECTOR_OCF;
+	if ((tcsr & HD6301_TCSR_TOF) && (tcsr & HD6301_TCSR_ETOI))
+		return HD6301_VECTOR_TOF;
+	if ((trcsr & (HD6301_TRCSR_RDRF | HD6301_TRCSR_ORFE)) && (trcsr & HD6301_TRCSR_RIE))
+		return HD6301_VECTOR_SCI;
+	if ((trcsr & HD6301_TRCSR_TDRE) && (trcsr & HD6301_TRCSR_TIE))
+		return HD6301_VECTOR_SCI;
+	return 0;
+}
+
+/**
+ * Process pending interrupts if they're not masked. A pending interrupt
+ * always ends SLP, even when masked.
+ */
+static void hd6301_check_interrupts(void)
+{
+	Uint16	vector;
+
+	vector = hd6301_get_pending_interrupt();
+	if (vector == 0)
+		return;
+
+	hd6301_sleeping = false;
+	if (hd6301_reg_CCR & (1 << hd6301_REG_CCR_I))
+		return;
+
+	LOG_TRACE(TRACE_IKBD_EXEC, "hd6301 interrupt vector=0x%04x pc=0x%04x\n", vector, hd6301_reg_PC);
+
+	if (!hd6301_waiting)
+		hd6301_push_registers();
+	hd6301_waiting = false;
+
+	hd6301_reg_CCR |= 1 << hd6301_REG_CCR_I;
+	hd6301_jump_vector(vector);
+
+	hd6301_update_timer(HD6301_IRQ_CYCLES);
+	hd6301_cycles += HD6301_IRQ_CYCLES;
+}
+
+/**
+ * Push PC, X, A, B and CCR on the stack
+ */
+static void hd6301_push_registers(void)
+{
+	hd6301_write_memory(hd6301_reg_SP--, hd6301_reg_PC & 0xff);
+	hd6301_write_memory(hd6301_reg_SP--, hd6301_reg_PC >> 8);
+	hd6301_write_memory(hd6301_reg_SP--, hd6301_reg_X & 0xff);
+	hd6301_write_memory(hd6301_reg_SP--, hd6301_reg_X >> 8);
+	hd6301_write_memory(hd6301_reg_SP--, hd6301_reg_A);
+	hd6301_write_memory(hd6301_reg_SP--, hd6301_reg_B);
+	hd6301_write_memory(hd6301_reg_SP--, hd6301_reg_CCR);
+}
+
+/**
+ * Load PC from an interrupt vector
+ */
+static void hd6301_jump_vector(Uint16 vector)
+{
+	hd6301_reg_PC = hd6301_read_memory(vector) << 8;
+	hd6301_reg_PC += hd6301_read_memory(vector+1);
+}
+
+/**
+ * Receive a byte from the serial line into RDR
+ */
+void hd6301_sci_receive(Uint8 value)
+{
+	Uint8	*trcsr = &hd6301_intREG[HD6301_REG_TRCSR];
+
+	if ((*trcsr & HD6301_TRCSR_RE) == 0)
+		return;
+
+	if (*trcsr & HD6301_TRCSR_RDRF) {
+		*trcsr |= HD6301_TRCSR_ORFE;		/* Overrun, value is lost */
+		return;
+	}
+	hd6301_intREG[HD6301_REG_RDR] = value;
+	*trcsr |= HD6301_TRCSR_RDRF;
+}
+
+/**
+ * Get the byte written to TDR to send it on the serial line.
+ * Return false if TDR is empty.
+ */
+bool hd6301_sci_transmit(Uint8 *pValue)
+{
+	Uint8	*trcsr = &hd6301_intREG[HD6301_REG_TRCSR];
+
+	if ((*trcsr & HD6301_TRCSR_TE) == 0 || (*trcsr & HD6301_TRCSR_TDRE))
+		return false;
 
-	/* post process SCI */
+	*pValue = hd6301_intREG[HD6301_REG_TDR];
+	*trcsr |= HD6301_TRCSR_TDRE;
+	return true;
+}
+
+/**
+ * Save/restore snapshot of hd6301 variables
+ */
+void hd6301_MemorySnapShot_Capture(bool bSave)
+{
+	MemorySnapShot_Store(&hd6301_reg_A, sizeof(hd6301_reg_A));
+	MemorySnapShot_Store(&hd6301_reg_B, sizeof(hd6301_reg_B));
+	MemorySnapShot_Store(&hd6301_reg_X, sizeof(hd6301_reg_X));
+	MemorySnapShot_Store(&hd6301_reg_SP, sizeof(hd6301_reg_SP));
+	MemorySnapShot_Store(&hd6301_reg_PC, sizeof(hd6301_reg_PC));
+	MemorySnapShot_Store(&hd6301_reg_CCR, sizeof(hd6301_reg_CCR));
+	MemorySnapShot_Store(hd6301_intREG, sizeof(hd6301_intREG));
+	MemorySnapShot_Store(hd6301_intRAM, sizeof(hd6301_intRAM));
+	MemorySnapShot_Store(hd6301_intROM, sizeof(hd6301_intROM));
+	MemorySnapShot_Store(&hd6301_reg_FRC, sizeof(hd6301_reg_FRC));
+	MemorySnapShot_Store(&hd6301_reg_OCR, sizeof(hd6301_reg_OCR));
+	MemorySnapShot_Store(&hd6301_frc_low_latch, sizeof(hd6301_frc_low_latch));
+	MemorySnapShot_Store(&hd6301_tcsr_read, sizeof(hd6301_tcsr_read));
+	MemorySnapShot_Store(&hd6301_trcsr_read, sizeof(hd6301_trcsr_read));
+	MemorySnapShot_Store(&hd6301_waiting, sizeof(hd6301_waiting));
+	MemorySnapShot_Store(&hd6301_sleeping, sizeof(hd6301_sleeping));
+	MemorySnapShot_Store(&hd6301_cycles_credit, sizeof(hd6301_cycles_credit));
 }
 
 /**
@@ -665,7 +985,7 @@ static Uint8 hd6301_read_memory(Uint16 addr)
 {
 	/* Internal registers */
 	if (addr <= 0x1f) {
-		return hd6301_intREG[addr];
+		return hd6301_read_register(addr);
 	}
 
 	/* Internal RAM */
@@ -678,8 +998,9 @@ static Uint8 hd6301_read_memory(Uint16 addr)
 		return hd6301_intROM[addr-0xf000];
 	}
 
-	fprintf(stderr, "hd6301: 0x%04x: 0x%04x illegal memory address\n", hd6301_reg_PC, addr);
-	exit(-1);
+	/* No external memory in single chip mode */
+	LOG_TRACE(TRACE_IKBD_EXEC, "hd6301: 0x%04x: 0x%04x illegal memory address\n", hd6301_reg_PC, addr);
+	return 0xff;
 }
 
 /**
@@ -689,7 +1010,7 @@ static void hd6301_write_memory (Uint16 addr, Uint8 value)
 {
 	/* Internal registers */
 	if (addr <= 0x1f) {
-		hd6301_intREG[addr] = value;
+		hd6301_write_register(addr, value);
 	}
 
 	/* Internal RAM */
@@ -699,14 +1020,137 @@ static void hd6301_write_memory (Uint16 addr, Uint8 value)
 
 	/* Internal ROM */
 	else if (addr >= 0xf000) {
-		fprintf(stderr, "hd6301: 0x%04x: attempt to write to rom\n", addr);
+		LOG_TRACE(TRACE_IKBD_EXEC, "hd6301: 0x%04x: attempt to write to rom\n", addr);
 	}
 
 	/* Illegal address */
 	else {
-		fprintf(stderr, "hd6301: 0x%04x: write to illegal address\n", addr);
-		exit(-1);
+		LOG_TRACE(TRACE_IKBD_EXEC, "hd6301: 0x%04x: write to illegal address\n", addr);
+	}
+}
+
+/**
+ * Read internal register
+ */
+static Uint8 hd6301_read_register(Uint8 reg)
+{
+	Uint8 value;
+
+	switch (reg) {
+		case HD6301_REG_P1DATA:
+			return hd6301_read_port_lines(1, HD6301_REG_P1DDR, reg);
+		case HD6301_REG_P2DATA:
+			return hd6301_read_port_lines(2, HD6301_REG_P2DDR, reg);
+		case HD6301_REG_P3DATA:
+			return hd6301_read_port_lines(3, HD6301_REG_P3DDR, reg);
+		case HD6301_REG_P4DATA:
+			return hd6301_read_port_lines(4, HD6301_REG_P4DDR, reg);
+
+		case HD6301_REG_TCSR:
+			hd6301_tcsr_read = hd6301_intREG[reg];
+			return hd6301_intREG[reg];
+		case HD6301_REG_FRC_HIGH:
+			/* Reading FRC after TCSR clears TOF */
+			hd6301_intREG[HD6301_REG_TCSR] &= ~(hd6301_tcsr_read & HD6301_TCSR_TOF);
+			hd6301_tcsr_read &= ~HD6301_TCSR_TOF;
+			hd6301_frc_low_latch = hd6301_reg_FRC & 0xff;
+			return hd6301_reg_FRC >> 8;
+		case HD6301_REG_FRC_LOW:
+			return hd6301_frc_low_latch;
+		case HD6301_REG_OCR_HIGH:
+			return hd6301_reg_OCR >> 8;
+		case HD6301_REG_OCR_LOW:
+			return hd6301_reg_OCR & 0xff;
+
+		case HD6301_REG_TRCSR:
+			hd6301_trcsr_read = hd6301_intREG[reg];
+			return hd6301_intREG[reg];
+		case HD6301_REG_RDR:
+			/* Reading RDR after TRCSR clears RDRF and ORFE */
+			value = hd6301_trcsr_read & (HD6301_TRCSR_RDRF | HD6301_TRCSR_ORFE);
+			hd6301_intREG[HD6301_REG_TRCSR] &= ~value;
+			hd6301_trcsr_read &= ~value;
+			return hd6301_intREG[reg];
+	}
+
+	return hd6301_intREG[reg];
+}
+
+/**
+ * Write internal register
+ */
+static void hd6301_write_register(Uint8 reg, Uint8 value)
+{
+	switch (reg) {
+		case HD6301_REG_TCSR:
+			/* Flags are read only */
+			hd6301_intREG[reg] = (hd6301_intREG[reg] & 0xe0) | (value & 0x1f);
+			return;
+		case HD6301_REG_FRC_HIGH:
+			/* Writing to FRC presets it to $FFF8 */
+			hd6301_reg_FRC = 0xfff8;
+			return;
+		case HD6301_REG_FRC_LOW:
+			return;
+		case HD6301_REG_OCR_HIGH:
+		case HD6301_REG_OCR_LOW:
+			if (reg == HD6301_REG_OCR_HIGH)
+				hd6301_reg_OCR = (hd6301_reg_OCR & 0xff) | (value << 8);
+			else
+				hd6301_reg_OCR = (hd6301_reg_OCR & 0xff00) | value;
+			/* Writing OCR after TCSR clears OCF */
+			hd6301_intREG[HD6301_REG_TCSR] &= ~(hd6301_tcsr_read & HD6301_TCSR_OCF);
+			hd6301_tcsr_read &= ~HD6301_TCSR_OCF;
+			return;
+
+		case HD6301_REG_TRCSR:
+			/* Flags are read only */
+			hd6301_intREG[reg] = (hd6301_intREG[reg] & 0xe0) | (value & 0x1f);
+			return;
+		case HD6301_REG_RDR:
+			return;
+		case HD6301_REG_TDR:
+			hd6301_intREG[reg] = value;
+			hd6301_intREG[HD6301_REG_TRCSR] &= ~HD6301_TRCSR_TDRE;
+			return;
 	}
+
+	hd6301_intREG[reg] = value;
+}
+
+/**
+ * Read a port : bits set as outputs in the data direction register
+ * return the data register, other bits return the external lines
+ */
+static Uint8 hd6301_read_port_lines(int port, Uint8 ddr_reg, Uint8 data_reg)
+{
+	Uint8 ddr = hd6301_intREG[ddr_reg];
+	Uint8 lines = 0xff;
+
+	if (hd6301_read_port)
+		lines = hd6301_read_port(port);
+
+	return (hd6301_intREG[data_reg] & ddr) | (lines & ~ddr);
+}
+
+/**
+ * Return the levels the 6301 drives on given port (1-4) : data register
+ * bits for the lines set as outputs, 1 for the input lines (pulled up)
+ */
+Uint8 hd6301_get_port_outputs(int port)
+{
+	static const Uint8 port_regs[4][2] = {
+		{ HD6301_REG_P1DDR, HD6301_REG_P1DATA },
+		{ HD6301_REG_P2DDR, HD6301_REG_P2DATA },
+		{ HD6301_REG_P3DDR, HD6301_REG_P3DATA },
+		{ HD6301_REG_P4DDR, HD6301_REG_P4DATA }
+	};
+	Uint8 ddr;
+
+	if (port < 1 || port > 4)
+		return 0xff;
+	ddr = hd6301_intREG[port_regs[port-1][0]];
+	return (hd6301_intREG[port_regs[port-1][1]] & ddr) | ~ddr;
 }
 
 /**
@@ -726,8 +1170,13 @@ static Uint16 hd6301_get_memory_ext(void)
  */
 static void hd6301_undefined(void)
 {
-	fprintf(stderr, "hd6301: 0x%04x: 0x%02x unknown instruction\n", hd6301_reg_PC, hd6301_cur_inst);
-	exit(-1);  /* TODO: Trap the error correctly */
+	LOG_TRACE(TRACE_IKBD_EXEC, "hd6301: 0x%04x: 0x%02x unknown instruction\n", hd6301_reg_PC, hd6301_cur_inst);
+
+	/* Illegal opcodes are trapped with the address of the opcode on the stack */
+	hd6301_push_registers();
+	hd6301_reg_CCR |= 1 << hd6301_REG_CCR_I;
+	hd6301_jump_vector(HD6301_VECTOR_TRAP);
+	hd6301_cycles += HD6301_IRQ_CYCLES;
 }
 
 /**
@@ -993,7 +1442,25 @@ static void hd6301_xgdx(void)
  */
 static void hd6301_daa(void)
 {
-	/* Todo */
+	Uint8  msn, lsn;
+	Uint16 correction, result;
+
+	msn = hd6301_reg_A & 0xf0;
+	lsn = hd6301_reg_A & 0x0f;
+	correction = 0;
+	if ((lsn > 0x09) || (hd6301_reg_CCR & (1 << hd6301_REG_CCR_H)))
+		correction |= 0x06;
+	if ((msn > 0x80) && (lsn > 0x09))
+		correction |= 0x60;
+	if ((msn > 0x90) || (hd6301_reg_CCR & 1))
+		correction |= 0x60;
+	result = hd6301_reg_A + correction;
+
+	/* Carry is kept from the previous addition */
+	HD6301_CLR_NZV;
+	HD6301_SET_NZ8((Uint8)result);
+	HD6301_SET_C8(result);
+	hd6301_reg_A = result;
 }
 
 /**
@@ -1004,7 +1471,7 @@ static void hd6301_daa(void)
  */
 static void hd6301_slp(void)
 {
-	/* Todo */
+	hd6301_sleeping = true;
 }
 
 /**
@@ -1507,7 +1974,10 @@ static void hd6301_mul(void)
  */
 static void hd6301_wai(void)
 {
-	/* Todo */
+	/* Registers are stacked now, the interrupt will only load the vector */
+	hd6301_reg_PC += 1;
+	hd6301_push_registers();
+	hd6301_waiting = true;
 }
 
 /**
@@ -1680,7 +2150,7 @@ static void hd6301_deca(void)
 {
 	Uint8 overflow;
 
-	overflow = (hd6301_reg_A == (Sint8)0x80) << hd6301_REG_CCR_V;
+	overflow = (hd6301_reg_A == 0x80) << hd6301_REG_CCR_V;
 	-- hd6301_reg_A;
 
 	HD6301_CLR_NZV;
@@ -1878,7 +2348,7 @@ static void hd6301_decb(void)
 {
 	Uint8 overflow;
 
-	overflow = (hd6301_reg_B == (Sint8)0x80) << hd6301_REG_CCR_V;
+	overflow = (hd6301_reg_B == 0x80) << hd6301_REG_CCR_V;
 	-- hd6301_reg_B;
 
 	HD6301_CLR_NZV;
@@ -2249,12 +2719,10 @@ static void hd6301_tst_ind(void)
  */
 static void hd6301_jmp_ind(void)
 {
-	Uint8  value;
 	Uint16 addr;
 
 	addr = hd6301_reg_X + hd6301_read_memory(hd6301_reg_PC+1);
-	value = hd6301_read_memory(addr);
-	hd6301_reg_PC = value;
+	hd6301_reg_PC = addr;
 }
 
 /**
@@ -2594,13 +3062,10 @@ static void hd6301_tst_ext(void)
  */
 static void hd6301_jmp_ext(void)
 {
-	Uint8  value;
 	Uint16 addr;
 
 	addr = hd6301_get_memory_ext();
-	value = hd6301_read_memory(addr);
-
-	hd6301_reg_PC = value;
+	hd6301_reg_PC = addr;
 }
 
 /**
@@ -3139,7 +3604,7 @@ static void hd6301_jsr_dir(void)
 	hd6301_write_memory(hd6301_reg_SP--, (hd6301_reg_PC + 2) >> 8);
 
 	addr = hd6301_read_memory(hd6301_reg_PC + 1);
-	hd6301_reg_PC += addr + 2;
+	hd6301_reg_PC = addr;
 }
 
 /**
@@ -3446,7 +3911,7 @@ static void hd6301_jsr_ind(void)
 	hd6301_write_memory(hd6301_reg_SP--, (hd6301_reg_PC + 2) >> 8);
 
 	addr = hd6301_reg_X + hd6301_read_memory(hd6301_reg_PC+1);
-	hd6301_reg_PC += addr + 2;
+	hd6301_reg_PC = addr;
 }
 
 /**
@@ -3749,11 +4214,11 @@ static void hd6301_jsr_ext(void)
 {
 	Uint16 addr;
 
-	hd6301_write_memory(hd6301_reg_SP--, (hd6301_reg_PC + 2) & 0xff);
-	hd6301_write_memory(hd6301_reg_SP--, (hd6301_reg_PC + 2) >> 8);
+	hd6301_write_memory(hd6301_reg_SP--, (hd6301_reg_PC + 3) & 0xff);
+	hd6301_write_memory(hd6301_reg_SP--, (hd6301_reg_PC + 3) >> 8);
 
 	addr = hd6301_get_memory_ext();
-	hd6301_reg_PC += addr + 2;
+	hd6301_reg_PC = addr;
 }
 
 /**
@@ -4986,7 +5451,7 @@ void hd6301_disasm(void)
 			break;
 	}
 
-	fprintf(stderr, "%02x: %s\n", hd6301_reg_PC, hd6301_str_instr);
+	LOG_TRACE_PRINT("hd6301: %04x: %s\n", hd6301_reg_PC, hd6301_str_instr);
 
 }
 
@@ -4995,7 +5460,7 @@ void hd6301_disasm(void)
  */
 void hd6301_display_registers(void)
 {
-	fprintf(stderr, "A:  %02x       B: %02x\n", hd6301_reg_A, hd6301_reg_B);
-	fprintf(stderr, "X:  %04x   CCR: %02x\n", hd6301_reg_X, hd6301_reg_CCR);
-	fprintf(stderr, "SP: %04x    PC:  %04x\n", hd6301_reg_SP, hd6301_reg_PC);
+	LOG_TRACE_PRINT("A:  %02x       B: %02x\n", hd6301_reg_A, hd6301_reg_B);
+	LOG_TRACE_PRINT("X:  %04x   CCR: %02x\n", hd6301_reg_X, hd6301_reg_CCR);
+	LOG_TRACE_PRINT("SP: %04x    PC:  %04x\n", hd6301_reg_SP, hd6301_reg_PC);
 }
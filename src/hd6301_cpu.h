@@ -32,9 +32,23 @@ struct hd6301_opcode_t {
 	Uint8	op_disasm;		/* For instructions disasm */
 };
 
+/* Callback reading the input lines of port 1-4 (bits set to 1 when idle) */
+extern Uint8 (*hd6301_read_port)(int port);
+extern Uint8 hd6301_get_port_outputs(int port);
+
 /* Functions */
 extern void hd6301_init_cpu(void);
+extern void hd6301_reset_cpu(void);
+extern void hd6301_load_rom(const Uint8 *pRom);
 extern void hd6301_execute_one_instruction(void);
+extern void hd6301_run_cycles(int cycles);
+extern int hd6301_get_cycles_to_interrupt(void);
+
+/* Serial communication interface */
+extern void hd6301_sci_receive(Uint8 value);
+extern bool hd6301_sci_transmit(Uint8 *pValue);
+
+extern void hd6301_MemorySnapShot_Capture(bool bSave);
 
 /* HF6301 Disasm and debug code */
 extern void hd6301_disasm(void);
@@ -0,0 +1,522 @@
+/*
+  Hatari - hostStream.c
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  Byte streams between emulated serial interfaces and the host.
+
+  A stream can be a normal file or device, or one of these endpoints:
+  - "tcp:<host>:<port>" connects to given TCP server
+  - "tcp::<port>" waits for a TCP connection on given local port
+  - "unix:<path>" connects to given Unix socket, or if there's nobody
+    listening on it, creates the socket and waits for a connection
+  - "pty" creates a pseudo terminal (its name is shown on the console)
+
+  Reading never blocks: it returns only the bytes which are already
+  available, checked with select(), so streams can be polled from the
+  emulation thread without a separate reader thread.  HostStream_TryWrite()
+  similarly writes only what the stream accepts without blocking.  Listening sockets
+  accept a new connection when the previous one is closed.
+*/
+const char HostStream_fileid[] = "Hatari hostStream.c : " __DATE__ " " __TIME__;
+
+#define _XOPEN_SOURCE 600	/* for posix_openpt() */
+
+#include <config.h>
+
+#include <sys/types.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#if HAVE_TERMIOS_H
+# include <termios.h>
+#endif
+#if HAVE_UNIX_DOMAIN_SOCKETS
+# include <sys/socket.h>
+# include <sys/un.h>
+# include <netinet/in.h>
+# include <netdb.h>
+#endif
+
+#include "main.h"
+#include "hostStream.h"
+#include "log.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#ifndef MSG_DONTWAIT
+#define MSG_DONTWAIT 0
+#endif
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if given name is a socket or pseudo terminal endpoint
+ * instead of a file name.
+ */
+bool HostStream_IsEndpoint(const char *name)
+{
+	return strncmp(name, "tcp:", 4) == 0 ||
+	       strncmp(name, "unix:", 5) == 0 ||
+	       strcmp(name, "pty") == 0;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if data can be read from given file descriptor without
+ * blocking.  Without select(), only regular files can be read, so
+ * we assume reads don't block.
+ */
+static bool HostStream_Ready(int fd)
+{
+#if HAVE_SELECT
+	fd_set rfds;
+	struct timeval tv;
+
+	FD_ZERO(&rfds);
+	FD_SET(fd, &rfds);
+
+	/* Return immediately */
+	tv.tv_sec = 0;
+	tv.tv_usec = 0;
+
+	return select(fd+1, &rfds, NULL, NULL, &tv) > 0;
+#else
+	return true;
+#endif
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if data can be written to given file descriptor without
+ * blocking.  Without select(), we assume that writes don't block.
+ */
+static bool HostStream_WriteReady(int fd)
+{
+#if HAVE_SELECT
+	fd_set wfds;
+	struct timeval tv;
+
+	FD_ZERO(&wfds);
+	FD_SET(fd, &wfds);
+
+	/* Return immediately */
+	tv.tv_sec = 0;
+	tv.tv_usec = 0;
+
+	return select(fd+1, NULL, &wfds, NULL, &tv) > 0;
+#else
+	return true;
+#endif
+}
+
+
+#if HAVE_UNIX_DOMAIN_SOCKETS
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Connect to TCP server at given host and port.
+ * Return socket or -1 on error.
+ */
+static int HostStream_ConnectTCP(const char *host, const char *port)
+{
+	struct addrinfo hints, *result, *ai;
+	int sock = -1;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if (getaddrinfo(host, port, &hints, &result) != 0)
+	{
+		Log_Printf(LOG_WARN, "Can't resolve TCP address '%s:%s'\n", host, port);
+		return -1;
+	}
+	for (ai = result; ai; ai = ai->ai_next)
+	{
+		sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+		if (sock < 0)
+			continue;
+		if (connect(sock, ai->ai_addr, ai->ai_addrlen) == 0)
+			break;
+		close(sock);
+		sock = -1;
+	}
+	freeaddrinfo(result);
+
+	if (sock < 0)
+		Log_Printf(LOG_WARN, "Can't connect to TCP address '%s:%s'\n", host, port);
+	return sock;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Create socket listening for connections on given local TCP port.
+ * Return socket or -1 on error.
+ */
+static int HostStream_ListenTCP(const char *port)
+{
+	struct sockaddr_in address;
+	int sock, on = 1;
+
+	sock = socket(AF_INET, SOCK_STREAM, 0);
+	if (sock < 0)
+		return -1;
+	setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+	/* only local connections, others can use e.g. SSH tunneling */
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(atoi(port));
+	if (bind(sock, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+	    listen(sock, 1) < 0)
+	{
+		Log_Printf(LOG_WARN, "Can't listen on TCP port %s: %s\n", port, strerror(errno));
+		close(sock);
+		return -1;
+	}
+	Log_Printf(LOG_INFO, "Waiting for connection on TCP port %s.\n", port);
+	return sock;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Open TCP endpoint, given without the "tcp:" prefix.
+ */
+static bool HostStream_OpenTCP(HOSTSTREAM *stream, const char *address)
+{
+	char host[256];
+	const char *port;
+	int len;
+
+	port = strrchr(address, ':');
+	if (!port || !port[1])
+	{
+		Log_Printf(LOG_WARN, "TCP address 'tcp:%s' is missing the port\n", address);
+		return false;
+	}
+	len = port - address;
+	port++;
+
+	if (len == 0)
+	{
+		stream->listenfd = HostStream_ListenTCP(port);
+		return stream->listenfd >= 0;
+	}
+	if (len >= (int)sizeof(host))
+		return false;
+	memcpy(host, address, len);
+	host[len] = '\0';
+
+	stream->fd = HostStream_ConnectTCP(host, port);
+	stream->bSocket = true;
+	return stream->fd >= 0;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Open Unix socket endpoint, given without the "unix:" prefix.
+ * Connect to the socket if somebody listens on it, otherwise create
+ * the socket and wait for connections on it.  This way two Hatari
+ * instances can be linked with the same endpoint name.
+ */
+static bool HostStream_OpenUnix(HOSTSTREAM *stream, const char *path)
+{
+	struct sockaddr_un address;
+	int sock;
+
+	if (strlen(path) >= sizeof(address.sun_path))
+	{
+		Log_Printf(LOG_WARN, "Unix socket path '%s' is too long\n", path);
+		return false;
+	}
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path, path);
+
+	sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (sock < 0)
+		return false;
+	if (connect(sock, (struct sockaddr *)&address, sizeof(address)) == 0)
+	{
+		Log_Printf(LOG_INFO, "Connected to Unix socket '%s'.\n", path);
+		stream->fd = sock;
+		stream->bSocket = true;
+		return true;
+	}
+	if (errno == ECONNREFUSED)
+		unlink(path);	/* nobody listens to it, remove stale socket */
+	else if (errno != ENOENT)
+	{
+		Log_Printf(LOG_WARN, "Can't connect to Unix socket '%s': %s\n", path, strerror(errno));
+		close(sock);
+		return false;
+	}
+
+	if (bind(sock, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+	    listen(sock, 1) < 0)
+	{
+		Log_Printf(LOG_WARN, "Can't create Unix socket '%s': %s\n", path, strerror(errno));
+		close(sock);
+		return false;
+	}
+	Log_Printf(LOG_INFO, "Waiting for connection on Unix socket '%s'.\n", path);
+	stream->listenfd = sock;
+	stream->pUnlinkPath = strdup(path);
+	return true;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Accept a pending connection on listening socket.
+ * Return true if stream has a connection.
+ */
+static bool HostStream_Accept(HOSTSTREAM *stream)
+{
+	if (stream->fd >= 0)
+		return true;
+	if (stream->listenfd < 0 || !HostStream_Ready(stream->listenfd))
+		return false;
+
+	stream->fd = accept(stream->listenfd, NULL, NULL);
+	if (stream->fd < 0)
+		return false;
+	stream->bSocket = true;
+	Log_Printf(LOG_INFO, "Accepted new serial stream connection.\n");
+	return true;
+}
+
+#else	/* !HAVE_UNIX_DOMAIN_SOCKETS */
+
+static bool HostStream_OpenTCP(HOSTSTREAM *stream, const char *address)
+{
+	Log_Printf(LOG_WARN, "TCP streams are not supported on this system\n");
+	return false;
+}
+
+static bool HostStream_OpenUnix(HOSTSTREAM *stream, const char *path)
+{
+	Log_Printf(LOG_WARN, "Unix socket streams are not supported on this system\n");
+	return false;
+}
+
+static bool HostStream_Accept(HOSTSTREAM *stream)
+{
+	return stream->fd >= 0;
+}
+
+#endif	/* !HAVE_UNIX_DOMAIN_SOCKETS */
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Create a pseudo terminal in raw mode and show the name of its
+ * slave side, which programs on the host can then open.
+ */
+static bool HostStream_OpenPty(HOSTSTREAM *stream)
+{
+#if HAVE_POSIX_OPENPT && HAVE_TERMIOS_H
+	struct termios termmode;
+	int fd;
+
+	fd = posix_openpt(O_RDWR | O_NOCTTY);
+	if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0)
+	{
+		Log_Printf(LOG_WARN, "Can't create a pseudo terminal: %s\n", strerror(errno));
+		if (fd >= 0)
+			close(fd);
+		return false;
+	}
+	if (tcgetattr(fd, &termmode) == 0)
+	{
+		termmode.c_iflag &= ~(IGNBRK|BRKINT|PARMRK|ISTRIP|INLCR|IGNCR|ICRNL|IXON);
+		termmode.c_oflag &= ~OPOST;
+		termmode.c_lflag &= ~(ECHO|ECHONL|ICANON|ISIG|IEXTEN);
+		termmode.c_cflag &= ~(CSIZE|PARENB);
+		termmode.c_cflag |= CS8;
+		tcsetattr(fd, TCSANOW, &termmode);
+	}
+	/* writes are dropped instead of blocking when nobody reads the slave side */
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+	Log_Printf(LOG_INFO, "Serial stream pseudo terminal is '%s'.\n", ptsname(fd));
+	stream->fd = fd;
+	return true;
+#else
+	Log_Printf(LOG_WARN, "Pseudo terminals are not supported on this system\n");
+	return false;
+#endif
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Open given file or endpoint for reading and/or writing.
+ * Return false on error.
+ */
+bool HostStream_Open(HOSTSTREAM *stream, const char *name, int mode)
+{
+	int flags;
+
+	stream->fd = stream->listenfd = -1;
+	stream->bSocket = false;
+	stream->pUnlinkPath = NULL;
+
+	if (strncmp(name, "tcp:", 4) == 0)
+		return HostStream_OpenTCP(stream, name + 4);
+	if (strncmp(name, "unix:", 5) == 0)
+		return HostStream_OpenUnix(stream, name + 5);
+	if (strcmp(name, "pty") == 0)
+		return HostStream_OpenPty(stream);
+
+	if (mode == HOSTSTREAM_READWRITE)
+		flags = O_RDWR;
+	else if (mode == HOSTSTREAM_WRITE)
+		flags = O_WRONLY | O_CREAT | O_TRUNC;
+	else
+		flags = O_RDONLY;
+	stream->fd = open(name, flags | O_BINARY, 0666);
+	return stream->fd >= 0;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Close current connection, listening socket continues to wait
+ * for a new one.
+ */
+static void HostStream_Disconnect(HOSTSTREAM *stream)
+{
+	close(stream->fd);
+	stream->fd = -1;
+	Log_Printf(LOG_INFO, "Serial stream connection closed.\n");
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Close stream and remove Unix socket created for it.
+ */
+void HostStream_Close(HOSTSTREAM *stream)
+{
+	if (stream->fd >= 0)
+		close(stream->fd);
+	if (stream->listenfd >= 0)
+		close(stream->listenfd);
+	if (stream->pUnlinkPath)
+	{
+		unlink(stream->pUnlinkPath);
+		free(stream->pUnlinkPath);
+	}
+	stream->fd = stream->listenfd = -1;
+	stream->bSocket = false;
+	stream->pUnlinkPath = NULL;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if stream is open (even if it doesn't have a connection yet).
+ */
+bool HostStream_IsOpen(HOSTSTREAM *stream)
+{
+	return stream->fd >= 0 || stream->listenfd >= 0;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Read up to 'size' bytes which are already available from the stream.
+ * Return number of bytes read, zero if there were none.
+ */
+int HostStream_Read(HOSTSTREAM *stream, Uint8 *buf, int size)
+{
+	int count;
+
+	if (size <= 0 || !HostStream_Accept(stream) || !HostStream_Ready(stream->fd))
+		return 0;
+
+	count = read(stream->fd, buf, size);
+	if (count > 0)
+		return count;
+
+	/* end of file is not an error for files, FIFOs and pseudo terminals,
+	 * more data can come later, but closed connections are dropped */
+	if (stream->bSocket && (count == 0 || (errno != EAGAIN && errno != EINTR)))
+		HostStream_Disconnect(stream);
+	return 0;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Write given bytes to the stream.  Return false if they couldn't be
+ * written, e.g. because there's no connection.
+ */
+bool HostStream_Write(HOSTSTREAM *stream, const Uint8 *buf, int size)
+{
+	int count;
+
+	if (!HostStream_Accept(stream))
+		return false;
+
+	while (size > 0)
+	{
+#if HAVE_UNIX_DOMAIN_SOCKETS
+		if (stream->bSocket)
+			count = send(stream->fd, buf, size, MSG_NOSIGNAL);
+		else
+#endif
+			count = write(stream->fd, buf, size);
+		if (count < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			if (stream->bSocket)
+				HostStream_Disconnect(stream);
+			return false;
+		}
+		buf += count;
+		size -= count;
+	}
+	return true;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Write as many of given bytes as the stream accepts without blocking.
+ * Return number of bytes written (zero if stream is busy), or -1 if
+ * there's no connection or writing failed.
+ */
+int HostStream_TryWrite(HOSTSTREAM *stream, const Uint8 *buf, int size)
+{
+	int count;
+
+	if (!HostStream_Accept(stream))
+		return -1;
+	if (size <= 0 || !HostStream_WriteReady(stream->fd))
+		return 0;
+
+	/* Writable FIFO or terminal accepts at least PIPE_BUF (>= 512)
+	 * bytes without blocking, socket sends are done non-blocking */
+#if HAVE_UNIX_DOMAIN_SOCKETS
+	if (stream->bSocket)
+		count = send(stream->fd, buf, size, MSG_NOSIGNAL|MSG_DONTWAIT);
+	else
+#endif
+		count = write(stream->fd, buf, size < 512 ? size : 512);
+	if (count >= 0)
+		return count;
+	if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+		return 0;
+	if (stream->bSocket)
+		HostStream_Disconnect(stream);
+	return -1;
+}
@@ -18,6 +18,7 @@
 #include "configuration.h"
 #include "file.h"
 #include "ide.h"
+#include "ioMem.h"
 #include "m68000.h"
 #include "mfp.h"
 #include "stMemory.h"
@@ -93,6 +94,8 @@ uae_u32 Ide_Mem_bget(uaecptr addr)
 
 	Dprintf(("IdeMem_bget($%x)\n", addr));
 
+	IoAccessReadCount++;
+
 	addr &= 0x00ffffff;                           /* Use a 24 bit address */
 
 	if (addr >= 0xf00040 || !ConfigureParams.HardDisk.bUseIdeMasterHardDiskImage)
@@ -128,6 +131,8 @@ uae_u32 Ide_Mem_wget(uaecptr addr)
 {
 	uint16_t retval;
 
+	IoAccessReadCount++;
+
 	addr &= 0x00ffffff;                           /* Use a 24 bit address */
 
 	if (addr >= 0xf00040 || !ConfigureParams.HardDisk.bUseIdeMasterHardDiskImage)
@@ -162,6 +167,8 @@ uae_u32 Ide_Mem_lget(uaecptr addr)
 {
 	uint32_t retval;
 
+	IoAccessReadCount++;
+
 	addr &= 0x00ffffff;                           /* Use a 24 bit address */
 
 	if (addr >= 0xf00040 || !ConfigureParams.HardDisk.bUseIdeMasterHardDiskImage)
@@ -79,6 +79,9 @@ const char IKBD_fileid[] = "Hatari ikbd.c : " __DATE__ " " __TIME__;
 #include "acia.h"
 #include "configuration.h"
 #include "clocks_timings.h"
+#include "file.h"
+#include "hd6301_cpu.h"
+#include "inputRecord.h"
 
 
 #define DBL_CLICK_HISTORY  0x07     /* Number of frames since last click to see if need to send one or two clicks */
@@ -93,6 +96,9 @@ const char IKBD_fileid[] = "Hatari ikbd.c : " __DATE__ " " __TIME__;
 
 #define IKBD_RESET_CYCLES  502000	/* Number of cycles (for a 68000 at 8 MHz) between sending the reset command and receiving $F1 */
 
+#define	IKBD_HD6301_CYCLE_DIVIDER	8	/* The 6301 runs at 1 MHz, 8 times slower than a 68000 at 8 MHz */
+#define	IKBD_HD6301_ROM_SIZE		4096
+
 #define	IKBD_ROM_VERSION	0xF1	/* On reset, the IKBD will return either 0xF0 or 0xF1, depending on the IKBD's ROM */
 					/* version. Only very early ST returned 0xF0, so we use 0xF1 which is the most common case.*/
 					/* Beside, some programs explicitly wait for 0xF1 after a reset (Dragonnels demo) */
@@ -321,6 +327,7 @@ static void	IKBD_Boot_ROM ( bool ClearAllRAM );
 
 static void	IKBD_SCI_Get_Line_RX ( int rx_bit );
 static Uint8	IKBD_SCI_Set_Line_TX ( void );
+static Uint8	IKBD_SCI_Get_Line_Idle ( void );
 
 static void	IKBD_Process_RDR ( Uint8 RDR );
 static void	IKBD_Check_New_TDR ( void );
@@ -367,6 +374,36 @@ static bool	IKBD_ExeMode = false;
 
 static Uint8	ScanCodeState[ 128 ];			/* state of each key : 0=released 1=pressed */
 
+
+/* Low level mode : run the real IKBD ROM on the HD6301 cpu core.
+ * The 6301 is not run in lockstep with the 68000 ; it's only run to catch up
+ * with the 68000's clock when its state can be observed or changed : when
+ * a bit is exchanged with the ACIA, when a key/mouse event is received or
+ * when the 6301's own timer raises an interrupt. */
+static bool	IKBD_LowLevel = false;
+static Uint64	IKBD_LowLevel_Clock;			/* 68000 clock up to which the 6301 was run */
+static int	IKBD_LowLevel_MouseX;			/* quadrature counters for the mouse's X/Y axis */
+static int	IKBD_LowLevel_MouseY;
+
+/* Keyboard matrix : the ROM drives one of the 15 column lines P31-P37/P40-P47
+ * low and reads the 8 row lines on port 1. The ROM converts the position
+ * of a key (column * 8 + row) to its scancode with a table, which is also
+ * used to know where each scancode is in the matrix. */
+#define	IKBD_MATRIX_COLUMNS		15
+#define	IKBD_MATRIX_KEYS		( IKBD_MATRIX_COLUMNS * 8 )
+#define	IKBD_MATRIX_NONE		0xff
+#define	IKBD_MATRIX_MIN_KEYS		90		/* ST keyboards have 94 or 95 keys */
+static Uint8	IKBD_LowLevel_KeyPos[ 128 ];		/* matrix position of each scancode, or IKBD_MATRIX_NONE */
+static Uint8	IKBD_LowLevel_Matrix[ IKBD_MATRIX_COLUMNS ];	/* row lines of the pressed keys in each column */
+
+static bool	IKBD_LowLevel_LoadRom ( void );
+static void	IKBD_LowLevel_FindKeyTable ( const Uint8 *pRom );
+static void	IKBD_LowLevel_SetKey ( Uint8 ScanCode , bool bPress );
+static void	IKBD_LowLevel_Reset ( void );
+static void	IKBD_LowLevel_CatchUp ( void );
+static void	IKBD_LowLevel_StartTimer ( void );
+static Uint8	IKBD_LowLevel_ReadPort ( int port );
+
 /* This array contains all known custom 6301 programs, with their CRC */
 static const struct
 {
@@ -447,6 +484,9 @@ static void	IKBD_Init_Pointers ( ACIA_STRUCT *pACIA_IKBD )
 {
 	pACIA_IKBD->Get_Line_RX = IKBD_SCI_Set_Line_TX;			/* Connect ACIA's RX to IKBD SCI's TX */
 	pACIA_IKBD->Set_Line_TX = IKBD_SCI_Get_Line_RX;			/* Connect ACIA's TX to IKBD SCI's RX */
+	pACIA_IKBD->Get_Peer_Idle = IKBD_SCI_Get_Line_Idle;		/* Tell the ACIA when the IKBD's SCI is idle */
+
+	hd6301_read_port = IKBD_LowLevel_ReadPort;			/* Connect the 6301's ports to mouse/joysticks */
 }
 
 
@@ -479,6 +519,16 @@ void	IKBD_Reset ( bool bCold )
 	pIKBD->RSR = 0;
 	pIKBD->SCI_RX_Size = 0;
 
+	/* On cold reset, check if we should run the real IKBD ROM */
+	if ( bCold )
+		IKBD_LowLevel = IKBD_LowLevel_LoadRom ();
+
+	if ( IKBD_LowLevel )
+	{
+		IKBD_LowLevel_Reset ();
+		ACIA_IKBD_Wakeup ();					/* The 6301 can write to TDR at any time */
+		return;
+	}
 
 	/* On cold reset, clear the whole RAM (including clock data) */
 	/* On warm reset, the clock data should be kept */
@@ -655,6 +705,271 @@ void IKBD_MemorySnapShot_Capture(bool bSave)
 	{
 		IKBD_Init_Pointers ( pACIA_IKBD );
 	}
+
+	/* Save the 6301 cpu when running the real IKBD ROM */
+	MemorySnapShot_Store(&IKBD_LowLevel, sizeof(IKBD_LowLevel));
+	MemorySnapShot_Store(&IKBD_LowLevel_Clock, sizeof(IKBD_LowLevel_Clock));
+	MemorySnapShot_Store(&IKBD_LowLevel_MouseX, sizeof(IKBD_LowLevel_MouseX));
+	MemorySnapShot_Store(&IKBD_LowLevel_MouseY, sizeof(IKBD_LowLevel_MouseY));
+	MemorySnapShot_Store(IKBD_LowLevel_KeyPos, sizeof(IKBD_LowLevel_KeyPos));
+	MemorySnapShot_Store(IKBD_LowLevel_Matrix, sizeof(IKBD_LowLevel_Matrix));
+	hd6301_MemorySnapShot_Capture(bSave);
+}
+
+
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Load the IKBD ROM image given in the configuration.
+ * Return true if the low level mode can be used.
+ */
+static bool	IKBD_LowLevel_LoadRom ( void )
+{
+	Uint8	*pRom;
+	long	RomSize;
+
+	if ( strlen ( ConfigureParams.Rom.szIkbdRomFileName ) == 0 )
+		return false;
+
+	pRom = File_Read ( ConfigureParams.Rom.szIkbdRomFileName, &RomSize, NULL );
+	if ( pRom == NULL )
+	{
+		Log_Printf ( LOG_WARN, "Can not load IKBD ROM '%s', using high level IKBD emulation\n",
+			ConfigureParams.Rom.szIkbdRomFileName );
+		return false;
+	}
+	if ( RomSize != IKBD_HD6301_ROM_SIZE )
+	{
+		Log_Printf ( LOG_WARN, "IKBD ROM '%s' should be %d bytes, using high level IKBD emulation\n",
+			ConfigureParams.Rom.szIkbdRomFileName , IKBD_HD6301_ROM_SIZE );
+		free ( pRom );
+		return false;
+	}
+
+	hd6301_load_rom ( pRom );
+	IKBD_LowLevel_FindKeyTable ( pRom );
+	free ( pRom );
+	LOG_TRACE ( TRACE_IKBD_ALL , "ikbd low level mode using rom %s\n" , ConfigureParams.Rom.szIkbdRomFileName );
+	return true;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Find the ROM's table converting keyboard matrix positions to scancodes :
+ * the 120 bytes containing the most different scancodes, without any
+ * scancode twice. Set the matrix position of each scancode from it.
+ */
+static void	IKBD_LowLevel_FindKeyTable ( const Uint8 *pRom )
+{
+	Uint8	Seen[ 128 ];
+	int	Offset , BestOffset = -1 , BestCount = 0;
+	int	Count , i;
+
+	for ( Offset = 0 ; Offset <= IKBD_HD6301_ROM_SIZE - IKBD_MATRIX_KEYS ; Offset++ )
+	{
+		memset ( Seen , 0 , sizeof ( Seen ) );
+		Count = 0;
+		for ( i = 0 ; i < IKBD_MATRIX_KEYS ; i++ )
+		{
+			Uint8 ScanCode = pRom[ Offset + i ];
+			if ( ScanCode == 0 || ScanCode > 0x72 )	/* unused position */
+				continue;
+			if ( Seen[ ScanCode ] )
+				break;
+			Seen[ ScanCode ] = 1;
+			Count++;
+		}
+		if ( i == IKBD_MATRIX_KEYS && Count > BestCount )
+		{
+			BestCount = Count;
+			BestOffset = Offset;
+		}
+	}
+
+	memset ( IKBD_LowLevel_KeyPos , IKBD_MATRIX_NONE , sizeof ( IKBD_LowLevel_KeyPos ) );
+	if ( BestCount < IKBD_MATRIX_MIN_KEYS )
+	{
+		Log_Printf ( LOG_WARN, "No scancode table found in IKBD ROM, keyboard is not connected\n" );
+		return;
+	}
+	for ( i = 0 ; i < IKBD_MATRIX_KEYS ; i++ )
+	{
+		Uint8 ScanCode = pRom[ BestOffset + i ];
+		if ( ScanCode != 0 && ScanCode <= 0x72 )
+			IKBD_LowLevel_KeyPos[ ScanCode ] = i;
+	}
+	LOG_TRACE ( TRACE_IKBD_ALL , "ikbd low level mode scancode table at $%x, %d keys\n" ,
+		0xf000 + BestOffset , BestCount );
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Press or release a key in the keyboard matrix
+ */
+static void	IKBD_LowLevel_SetKey ( Uint8 ScanCode , bool bPress )
+{
+	Uint8	Pos = IKBD_LowLevel_KeyPos[ ScanCode & 0x7f ];
+
+	if ( Pos == IKBD_MATRIX_NONE )
+		return;
+	if ( bPress )
+		IKBD_LowLevel_Matrix[ Pos >> 3 ] |= 1 << ( Pos & 7 );
+	else
+		IKBD_LowLevel_Matrix[ Pos >> 3 ] &= ~( 1 << ( Pos & 7 ) );
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Reset the 6301 in low level mode. The ROM will do the rest.
+ */
+static void	IKBD_LowLevel_Reset ( void )
+{
+	int	i;
+
+	for ( i=0 ; i<128 ; i++ )
+		ScanCodeState[ i ] = 0;				/* key is released */
+	memset ( IKBD_LowLevel_Matrix , 0 , sizeof ( IKBD_LowLevel_Matrix ) );
+
+	Keyboard.BufferHead = Keyboard.BufferTail = 0;
+	Keyboard.NbBytesInOutputBuffer = 0;
+	Keyboard.bLButtonDown = Keyboard.bRButtonDown = BUTTON_NULL;
+	KeyboardProcessor.Mouse.dx = KeyboardProcessor.Mouse.dy = 0;
+	IKBD_LowLevel_MouseX = IKBD_LowLevel_MouseY = 0;
+
+	hd6301_reset_cpu ();
+	IKBD_LowLevel_Clock = CyclesGlobalClockCounter;
+	IKBD_LowLevel_StartTimer ();
+
+	/* User events are still processed from the auto-send interrupt */
+	CycInt_AddRelativeInterrupt ( 150000, INT_CPU_CYCLE, INTERRUPT_IKBD_AUTOSEND );
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Run the 6301 until it reaches the 68000's current clock.
+ */
+static void	IKBD_LowLevel_CatchUp ( void )
+{
+	Uint64	Cycles;
+
+	Cycles = ( CyclesGlobalClockCounter - IKBD_LowLevel_Clock ) / IKBD_HD6301_CYCLE_DIVIDER;
+	if ( Cycles == 0 )
+		return;
+
+	IKBD_LowLevel_Clock += Cycles * IKBD_HD6301_CYCLE_DIVIDER;
+	hd6301_run_cycles ( Cycles );
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Start a timer to wake up the 6301 when its own timer raises an interrupt.
+ * If no timer interrupt is enabled, the 6301 will only be run on the next
+ * exchange with the ACIA or on the next user event.
+ */
+static void	IKBD_LowLevel_StartTimer ( void )
+{
+	int	Cycles;
+
+	CycInt_RemovePendingInterrupt ( INTERRUPT_IKBD_CPU );
+
+	Cycles = hd6301_get_cycles_to_interrupt ();
+	if ( Cycles < 0 )
+		return;
+
+	CycInt_AddRelativeInterrupt ( ( Cycles + 1 ) * IKBD_HD6301_CYCLE_DIVIDER , INT_CPU_CYCLE , INTERRUPT_IKBD_CPU );
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Interrupt handler called when the 6301's timer raises an interrupt
+ */
+void	IKBD_InterruptHandler_CPU ( void )
+{
+	CycInt_AcknowledgeInterrupt ();
+
+	IKBD_LowLevel_CatchUp ();
+	IKBD_LowLevel_StartTimer ();
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return the lines connected to the 6301's ports. Lines are active low.
+ * Port 1 : keyboard matrix rows of the pressed keys in the columns
+ * selected by driving P31-P37 and P40-P47 low.
+ * Port 2 : fire buttons for joystick 0 (bit 1) and joystick 1 (bit 2),
+ * which are also the left and right mouse buttons.
+ * Port 4 : mouse's XB/XA/YA/YB signals (bits 0-3), which are also the
+ * directions for joystick 0, and directions for joystick 1 (bits 4-7).
+ */
+static Uint8	IKBD_LowLevel_ReadPort ( int port )
+{
+	static const Uint8 QuadraturePhase[ 4 ] = { 0 , 1 , 3 , 2 };
+	Uint8	Lines = 0;
+	Uint16	Columns;
+	int	i;
+
+	switch ( port )
+	{
+	  case 1 :
+		/* Column lines selected by the ROM are driven low */
+		Columns = ~( ( hd6301_get_port_outputs ( 3 ) >> 1 ) | ( hd6301_get_port_outputs ( 4 ) << 7 ) );
+		for ( i = 0 ; i < IKBD_MATRIX_COLUMNS ; i++ )
+			if ( Columns & ( 1 << i ) )
+				Lines |= IKBD_LowLevel_Matrix[ i ];
+		break;
+
+	  case 2 :
+		if ( ( Joy_GetStickData ( 0 ) & ATARIJOY_BITMASK_FIRE ) || ( Keyboard.bLButtonDown & BUTTON_MOUSE ) )
+			Lines |= 0x02;
+		if ( ( Joy_GetStickData ( 1 ) & ATARIJOY_BITMASK_FIRE ) || ( Keyboard.bRButtonDown & BUTTON_MOUSE ) )
+			Lines |= 0x04;
+		break;
+
+	  case 4 :
+		/* Move the mouse by one step each time the ROM samples the port */
+		if ( KeyboardProcessor.Mouse.dx > 0 )
+		{
+			IKBD_LowLevel_MouseX++;
+			KeyboardProcessor.Mouse.dx--;
+		}
+		else if ( KeyboardProcessor.Mouse.dx < 0 )
+		{
+			IKBD_LowLevel_MouseX--;
+			KeyboardProcessor.Mouse.dx++;
+		}
+		if ( KeyboardProcessor.Mouse.dy > 0 )
+		{
+			IKBD_LowLevel_MouseY++;
+			KeyboardProcessor.Mouse.dy--;
+		}
+		else if ( KeyboardProcessor.Mouse.dy < 0 )
+		{
+			IKBD_LowLevel_MouseY--;
+			KeyboardProcessor.Mouse.dy++;
+		}
+
+		Lines = QuadraturePhase[ IKBD_LowLevel_MouseX & 3 ] | ( QuadraturePhase[ IKBD_LowLevel_MouseY & 3 ] << 2 );
+		Lines |= Joy_GetStickData ( 0 ) & 0x0f;
+		Lines |= ( Joy_GetStickData ( 1 ) & 0x0f ) << 4;
+		break;
+	}
+
+	return ~Lines;
 }
 
 
@@ -742,7 +1057,14 @@ static void	IKBD_SCI_Get_Line_RX ( int rx_bit )
 		break;
 
 	  case IKBD_SCI_STATE_STOP_BIT :
-		if ( rx_bit == 1 )					/* Wait for one "1" stop bit */
+		if ( ( rx_bit == 1 ) && IKBD_LowLevel )			/* The 6301 reads RDR itself */
+		{
+			IKBD_LowLevel_CatchUp ();
+			hd6301_sci_receive ( pIKBD->RSR );
+			IKBD_LowLevel_StartTimer ();
+			StateNext = IKBD_SCI_STATE_IDLE;
+		}
+		else if ( rx_bit == 1 )					/* Wait for one "1" stop bit */
 		{
 			pIKBD->TRCSR &= ~IKBD_TRCSR_BIT_ORFE;
 			
@@ -807,7 +1129,15 @@ static Uint8	IKBD_SCI_Set_Line_TX ( void )
 			break;
 		}
 
-		IKBD_Check_New_TDR ();					/* Do we have a byte to load in TDR ? */
+		if ( IKBD_LowLevel )					/* Did the 6301 write a byte in TDR ? */
+		{
+			IKBD_LowLevel_CatchUp ();
+			if ( hd6301_sci_transmit ( &pIKBD->TDR ) )
+				pIKBD->TRCSR &= ~IKBD_TRCSR_BIT_TDRE;
+			IKBD_LowLevel_StartTimer ();
+		}
+		else
+			IKBD_Check_New_TDR ();				/* Do we have a byte to load in TDR ? */
 
 		if ( ( pIKBD->TRCSR & IKBD_TRCSR_BIT_TDRE ) == 0 )	/* We have a new byte in TDR */
 		{
@@ -842,6 +1172,33 @@ static Uint8	IKBD_SCI_Set_Line_TX ( void )
 
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Return 1 if the IKBD's SCI is not sending or receiving a byte and has no
+ * byte waiting to be sent : in that case the ACIA doesn't need to clock
+ * each bit and ACIA_IKBD_Wakeup() will be called when a new byte is added
+ * by IKBD_Send_Byte_Delay.
+ * When running the 6301 ROM or some custom code, TDR can be written at any
+ * time, so we never return 1 to keep the same timings as for every bit.
+ */
+static Uint8	IKBD_SCI_Get_Line_Idle ( void )
+{
+	if ( IKBD_LowLevel || IKBD_ExeMode )
+		return 0;
+
+	if ( ( pIKBD->SCI_TX_State != IKBD_SCI_STATE_IDLE ) || ( pIKBD->SCI_RX_State != IKBD_SCI_STATE_IDLE ) )
+		return 0;
+
+	if ( ( pIKBD->SCI_TX_Delay > 0 ) || ( ( pIKBD->TRCSR & IKBD_TRCSR_BIT_TDRE ) == 0 )
+	  || ( Keyboard.NbBytesInOutputBuffer > 0 ) )
+		return 0;
+
+	return 1;
+}
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Handle the byte that was received in the RDR from the ACIA.
@@ -1006,6 +1363,8 @@ static void	IKBD_Send_Byte_Delay ( Uint8 Data , int Delay_Cycles )
 	{
 		Log_Printf(LOG_ERROR, "IKBD buffer is full, can't send 0x%02x!\n" , Data );
 	}
+
+	ACIA_IKBD_Wakeup ();						/* Restart the ACIA's bit clock if it was idle */
 }
 
 
@@ -1655,10 +2014,25 @@ static void IKBD_SendAutoKeyboardCommands(void)
  */
 void IKBD_PressSTKey(Uint8 ScanCode, bool bPress)
 {
+	/* Record the key, or ignore it while replaying recorded input */
+	if ( !InputRecord_Key ( ScanCode , bPress ) )
+		return;
+
+	/* Run the 6301 up to the time of the event before changing its inputs */
+	if ( IKBD_LowLevel )
+		IKBD_LowLevel_CatchUp ();
+
 	/* Store the state of each ST scancode : 1=pressed 0=released */
 	if ( bPress )		ScanCodeState[ ScanCode & 0x7f ] = 1;
 	else			ScanCodeState[ ScanCode & 0x7f ] = 0;
 
+	/* The ROM scans the keyboard matrix by itself */
+	if ( IKBD_LowLevel )
+	{
+		IKBD_LowLevel_SetKey ( ScanCode , bPress );
+		return;
+	}
+
 	if (!bPress)
 		ScanCode |= 0x80;				/* Set top bit if released key */
 
@@ -1680,8 +2054,14 @@ void IKBD_PressSTKey(Uint8 ScanCode, bool bPress)
  */
 void IKBD_InterruptHandler_AutoSend(void)
 {
+	/* Run the 6301 up to the time of the new user events */
+	if (IKBD_LowLevel)
+		IKBD_LowLevel_CatchUp();
+
 	/* Handle user events and other messages, (like quit message) */
+	InputRecord_BeginEvents();
 	Main_EventHandler();
+	InputRecord_EndEvents();
 
 	/* Remove this interrupt from list and re-order.
 	 * (needs to be done after UI event handling so
@@ -1703,6 +2083,10 @@ void IKBD_InterruptHandler_AutoSend(void)
 	/* Trigger this auto-update function again after a while */
 	CycInt_AddRelativeInterrupt(150000, INT_CPU_CYCLE, INTERRUPT_IKBD_AUTOSEND);
 
+	/* In low level mode, the 6301 reads mouse/joysticks by itself */
+	if (IKBD_LowLevel)
+		return;
+
 	/* We don't send keyboard data automatically within the first few
 	 * VBLs to avoid that TOS gets confused during its boot time */
 	if (nVBLs > 20)
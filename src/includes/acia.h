@@ -38,6 +38,8 @@ typedef struct {
 	Uint8		RX_StopBits;				/* How many stop bits left to receive (1 or 2) */
 	Uint8		RX_Overrun;				/* Set to 1 if previous RDR was not read when RSR is full */ 
 
+	Uint8		Timer_Idle;				/* Set to 1 when the bit timer runs at the slower idle rate */
+
 	/* Callback functions */
 	Uint8		(*Get_Line_RX) ( void );		/* Input  : RX */
 	void		(*Set_Line_TX) ( int val );		/* Output : TX */
@@ -49,6 +51,8 @@ typedef struct {
 	Uint8		(*Get_Line_DCD) ( void );		/* Input  : Data Carrier Detect (not connected in ST) */
 	void		(*Set_Line_RTS) ( int val );		/* Output : Request To Send (not connected in ST) */
 
+	Uint8		(*Get_Peer_Idle) ( void );		/* Return 1 if the device on RX/TX has nothing to send/receive */
+
 	/* Other variables */
 	char		ACIA_Name[ 10 ];			/* IKBD or MIDI */
 
@@ -76,6 +80,7 @@ void	ACIA_IKBD_Read_SR ( void );
 void	ACIA_IKBD_Read_RDR ( void );
 void	ACIA_IKBD_Write_CR ( void );
 void	ACIA_IKBD_Write_TDR ( void );
+void	ACIA_IKBD_Wakeup ( void );
 
 
 
@@ -0,0 +1,49 @@
+/*
+  Hatari - benchmark.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef HATARI_BENCHMARK_H
+#define HATARI_BENCHMARK_H
+
+#include <signal.h>
+
+/* subsystems to which host CPU time is attributed */
+enum
+{
+	BENCH_CPU,       /* CPU core & everything not listed below */
+	BENCH_SCREEN,    /* screen conversion & update */
+	BENCH_SOUND,     /* YM & DMA sound sample generation */
+	BENCH_BLITTER,
+	BENCH_DSP,
+	BENCH_GEMDOS,    /* GEMDOS HD emulation, i.e. host file I/O */
+	BENCH_SUBSYSTEMS
+};
+
+extern volatile sig_atomic_t Benchmark_Subsystem;
+
+/**
+ * Mark given subsystem as active, return previously active one
+ * for Benchmark_Leave().  These only set a variable, so they can
+ * be used also in frequently called functions.
+ */
+static inline int Benchmark_Enter(int subsystem)
+{
+	int previous = Benchmark_Subsystem;
+	Benchmark_Subsystem = subsystem;
+	return previous;
+}
+
+static inline void Benchmark_Leave(int previous)
+{
+	Benchmark_Subsystem = previous;
+}
+
+extern bool Benchmark_SetOutputFile(const char *filename);
+extern void Benchmark_Init(void);
+extern void Benchmark_VBL(void);
+extern void Benchmark_UnInit(void);
+
+#endif  /* HATARI_BENCHMARK_H */
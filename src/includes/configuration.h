@@ -38,6 +38,7 @@ typedef struct
   char szTosImageFileName[FILENAME_MAX];
   bool bPatchTos;
   char szCartridgeImageFileName[FILENAME_MAX];
+  char szIkbdRomFileName[FILENAME_MAX];
 } CNF_ROM;
 
 
@@ -59,6 +60,7 @@ typedef struct
 typedef struct
 {
   bool bEnableRS232;
+  bool bTurbo;                     /* receive bytes as fast as they're read, ignoring baud rate */
   char szOutFileName[FILENAME_MAX];
   char szInFileName[FILENAME_MAX];
 } CNF_RS232;
@@ -159,6 +161,7 @@ typedef struct
 {
   bool bAutoInsertDiskB;
   bool FastFloppy;			/* true to speed up FDC emulation */
+  bool TurboFloppy;			/* true to reduce all FDC delays to a minimum */
   WRITEPROTECTION nWriteProtection;
   char szDiskZipPath[MAX_FLOPPYDRIVES][FILENAME_MAX];
   char szDiskFileName[MAX_FLOPPYDRIVES][FILENAME_MAX];
@@ -228,6 +231,7 @@ typedef struct
   int nVdiColors;
   int nVdiWidth;
   int nVdiHeight;
+  bool bVdiNativeDraw;
   bool bShowStatusbar;
   bool bShowDriveLed;
   bool bCrop;
@@ -288,10 +292,12 @@ typedef struct
   bool bCompatibleCpu;            /* Prefetch mode */
   MACHINETYPE nMachineType;
   bool bBlitter;                  /* TRUE if Blitter is enabled */
+  bool bFastBlitter;              /* Use line kernels instead of word steps */
   DSPTYPE nDSPType;               /* how to "emulate" DSP */
   bool bRealTimeClock;
   bool bPatchTimerD;
   bool bFastBoot;                 /* Enable to patch TOS for fast boot */
+  bool bSpinLoopSkip;             /* Skip idle polling loops to the next interrupt */
   bool bFastForward;
 
 #if ENABLE_WINUAE_CPU
@@ -305,6 +311,7 @@ typedef struct
 
 typedef struct
 {
+  int ScreenShotFormat;           /* SCREENSHOT_FORMAT_* */
   int AviRecordVcodec;
   int AviRecordFps;
   char AviRecordFile[FILENAME_MAX];
@@ -16,10 +16,16 @@ extern void Control_ProcessBuffer(char *buffer);
 extern bool Control_CheckUpdates(void);
 extern const char* Control_SetSocket(const char *socketpath);
 extern void Control_ReparentWindow(int width, int height, bool noembed);
+extern bool Control_BinaryBreak(int reason);
+extern bool Control_BinaryCycleRun(void);
+extern void Control_BinaryCheckCycles(void);
 #else
 #define Control_CheckUpdates() false
 #define Control_SetSocket(path) "Control socket is not supported on this platform."
 #define Control_ReparentWindow(width, height, noembed);
+#define Control_BinaryBreak(reason) false
+#define Control_BinaryCycleRun() false
+#define Control_BinaryCheckCycles()
 #endif /* HAVE_UNIX_DOMAIN_SOCKETS */
 
 #endif /* HATARI_CONTROL_H */
@@ -22,12 +22,14 @@ typedef enum
   INTERRUPT_ACIA_IKBD,
   INTERRUPT_IKBD_RESETTIMER,
   INTERRUPT_IKBD_AUTOSEND,
+  INTERRUPT_IKBD_CPU,
   INTERRUPT_DMASOUND_MICROWIRE, /* Used for both STE and Falcon Microwire emulation */
   INTERRUPT_CROSSBAR_25MHZ,
   INTERRUPT_CROSSBAR_32MHZ,
   INTERRUPT_FDC,
   INTERRUPT_BLITTER,
   INTERRUPT_MIDI,
+  INTERRUPT_RS232,
 
   MAX_INTERRUPTS
 } interrupt_id;
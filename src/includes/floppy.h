@@ -19,15 +19,29 @@
 #define	FLOPPY_DRIVE_TRANSITION_STATE_EJECT		2
 #define	FLOPPY_DRIVE_TRANSITION_DELAY_VBL		18	/* min of 16 VBLs */
 
+/* Per track state of a disk image (see EMULATION_DRIVE.pTrackState) */
+#define	FLOPPY_TRACK_LOADED		0x01	/* Track contents are available in pBuffer */
+#define	FLOPPY_TRACK_DIRTY		0x02	/* Track contents differ from the image file */
+
 /* Structure for each drive connected as emulation */
 typedef struct
 {
 	Uint8 *pBuffer;
 	char sFileName[FILENAME_MAX];
+	char sZipPath[FILENAME_MAX];
 	int nImageBytes;
 	bool bDiskInserted;
 	bool bContentsChanged;
 	bool bOKToSave;
+	bool bNoCache;				/* Contents didn't come from the file (snapshot), don't cache */
+
+	/* Tracks of .MSA images are uncompressed on first access, and only
+	 * changed tracks are written back when the disk is ejected */
+	int nBytesPerTrack;
+	int nTracks;
+	Uint8 *pTrackState;			/* FLOPPY_TRACK_* flags for each track */
+	Uint8 *pPackedImage;			/* .MSA file to uncompress tracks from, or NULL */
+	Uint32 *pPackedTrackOffsets;		/* Offset of each track in pPackedImage */
 
 	/* For the emulation of the WPRT bit when a disk is changed */
 	int TransitionState1;
@@ -0,0 +1,35 @@
+/*
+  Hatari - hostStream.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef HATARI_HOSTSTREAM_H
+#define HATARI_HOSTSTREAM_H
+
+/* open modes */
+#define HOSTSTREAM_READ       1
+#define HOSTSTREAM_WRITE      2
+#define HOSTSTREAM_READWRITE  (HOSTSTREAM_READ|HOSTSTREAM_WRITE)
+
+typedef struct
+{
+	int fd;              /* file, device or connected socket, -1 if none */
+	int listenfd;        /* socket waiting for a connection, -1 if none */
+	bool bSocket;        /* fd is a socket */
+	char *pUnlinkPath;   /* Unix socket created by us, removed on close */
+} HOSTSTREAM;
+
+/* initializer for a closed stream */
+#define HOSTSTREAM_INIT { -1, -1, false, NULL }
+
+extern bool HostStream_IsEndpoint(const char *name);
+extern bool HostStream_Open(HOSTSTREAM *stream, const char *name, int mode);
+extern void HostStream_Close(HOSTSTREAM *stream);
+extern bool HostStream_IsOpen(HOSTSTREAM *stream);
+extern int HostStream_Read(HOSTSTREAM *stream, Uint8 *buf, int size);
+extern bool HostStream_Write(HOSTSTREAM *stream, const Uint8 *buf, int size);
+extern int HostStream_TryWrite(HOSTSTREAM *stream, const Uint8 *buf, int size);
+
+#endif  /* HATARI_HOSTSTREAM_H */
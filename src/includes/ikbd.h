@@ -89,6 +89,7 @@ extern void IKBD_MemorySnapShot_Capture(bool bSave);
 
 extern void IKBD_InterruptHandler_ResetTimer(void);
 extern void IKBD_InterruptHandler_AutoSend(void);
+extern void IKBD_InterruptHandler_CPU(void);
 
 extern void IKBD_UpdateClockOnVBL ( void );
 
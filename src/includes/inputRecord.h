@@ -0,0 +1,31 @@
+/*
+  Hatari - inputRecord.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef HATARI_INPUTRECORD_H
+#define HATARI_INPUTRECORD_H
+
+extern bool InputRecord_SetRecordFile(const char *filename);
+extern bool InputRecord_SetReplayFile(const char *filename);
+extern bool InputRecord_SetAnchorInterval(int secs);
+extern bool InputRecord_SetSeek(int secs);
+extern bool InputRecord_IsActive(void);
+extern bool InputRecord_IsReplaying(void);
+
+extern void InputRecord_BeginEvents(void);
+extern void InputRecord_EndEvents(void);
+extern bool InputRecord_Key(Uint8 scancode, bool press);
+extern Uint8 InputRecord_Joystick(int port, Uint8 value);
+extern int InputRecord_Midi(int byte);
+extern bool InputRecord_RS232Status(bool status);
+extern bool InputRecord_RS232Data(Uint8 *bytes, int count, bool ok);
+extern void InputRecord_RecordHostFile(const Uint8 *buffer, int bytes);
+extern int InputRecord_ReplayHostFile(Uint32 addr, Uint32 size);
+extern Uint32 InputRecord_HostTime(Uint32 value);
+
+extern void InputRecord_UnInit(void);
+
+#endif  /* HATARI_INPUTRECORD_H */
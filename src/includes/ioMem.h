@@ -25,6 +25,7 @@ extern uae_u8 *IOmemory;
 extern Uint32 IoAccessBaseAddress;
 extern Uint32 IoAccessCurrentAddress;
 extern int nIoMemAccessSize;
+extern Uint32 IoAccessReadCount;
 
 
 /**
@@ -94,6 +95,7 @@ static inline void IoMem_WriteByte(Uint32 Address, Uint8 Var)
 extern void IoMem_Init(void);
 extern void IoMem_UnInit(void);
 extern void IoMem_Init_FalconInSTeBuscompatibilityMode(Uint8 value);
+extern bool IoMem_IsBusErrorRange(Uint32 addr, Uint32 len, bool bWrite);
 
 
 extern uae_u32 IoMem_bget(uaecptr addr);
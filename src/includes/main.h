@@ -22,9 +22,11 @@
 #if __GNUC__ >= 3
 # define likely(x)      __builtin_expect (!!(x), 1)
 # define unlikely(x)    __builtin_expect (!!(x), 0)
+# define ALWAYS_INLINE  inline __attribute__((always_inline))
 #else
 # define likely(x)      (x)
 # define unlikely(x)    (x)
+# define ALWAYS_INLINE  inline
 #endif
 
 #ifdef WIN32
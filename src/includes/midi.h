@@ -11,6 +11,7 @@
 extern void Midi_Init(void);
 extern void Midi_UnInit(void);
 extern void Midi_Reset(void);
+extern void Midi_VBL(void);
 extern void Midi_Control_ReadByte(void);
 extern void Midi_Data_ReadByte(void);
 extern void Midi_Control_WriteByte(void);
@@ -6,6 +6,11 @@
 */
 
 extern bool MSA_FileNameIsMSA(const char *pszFileName, bool bAllowGZ);
+extern Uint8 *MSA_UnCompressTrack(Uint8 *pMSAImageBuffer, Uint8 *pImageBuffer, int nBytesPerTrack);
 extern Uint8 *MSA_UnCompress(Uint8 *pMSAFile, long *pImageSize);
 extern Uint8 *MSA_ReadDisk(const char *pszFileName, long *pImageSize);
+extern Uint8 *MSA_ReadDiskTracks(const char *pszFileName, int *pnTracks, int *pnBytesPerTrack, Uint32 **ppTrackOffsets);
 extern bool MSA_WriteDisk(const char *pszFileName, Uint8 *pBuffer, int ImageSize);
+extern bool MSA_WriteDiskTracks(const char *pszFileName, Uint8 *pBuffer, int ImageSize,
+                                const Uint8 *pMSAFile, const Uint32 *pTrackOffsets,
+                                const Uint8 *pTrackState);
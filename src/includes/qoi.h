@@ -0,0 +1,26 @@
+/*
+  Hatari - qoi.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef HATARI_QOI_H
+#define HATARI_QOI_H
+
+/* worst case encoded size of a line: every pixel as QOI_OP_RGB,
+ * plus a run ending at its start */
+#define QOI_LINE_BYTES(width)	(4 * (width) + 1)
+
+typedef struct {
+	Uint8 index[64][4];	/* RGBA of previously seen colors, by hash */
+	Uint8 prev[3];		/* previous pixel */
+	int run;		/* pending run length of the previous pixel */
+} QOI_ENCODER;
+
+extern bool Qoi_WriteHeader(FILE *fp, int width, int height);
+extern void Qoi_InitEncoder(QOI_ENCODER *enc);
+extern int Qoi_EncodeLine(QOI_ENCODER *enc, const Uint8 *px, int width, Uint8 *out);
+extern bool Qoi_WriteEnd(QOI_ENCODER *enc, FILE *fp);
+
+#endif
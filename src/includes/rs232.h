@@ -10,9 +10,12 @@
 
 
 #define  MAX_RS232INPUT_BUFFER    2048  /* Must be ^2 */
+#define  MAX_RS232OUTPUT_BUFFER   1024
 
 extern void RS232_Init(void);
+extern void RS232_Reset(void);
 extern void RS232_UnInit(void);
+extern void RS232_InterruptHandler(void);
 extern void RS232_HandleUCR(Sint16 ucr);
 extern bool RS232_SetBaudRate(int nBaud);
 extern void RS232_SetBaudRateFromTimerD(void);
@@ -9,6 +9,7 @@
 #define HATARI_SCREEN_H
 
 #include <SDL_video.h>    /* for SDL_Surface */
+#include "vdi.h"           /* for MAX_VDI_HEIGHT */
 
 
 /* The 'screen' is a representation of the ST video memory	*/
@@ -39,6 +40,9 @@
 #define HBL_PALETTE_MASKS (NUM_VISIBLE_LINES+1 +3 )		/* [NP] FIXME we need to handle 313 hbl, not 310 ; palette code is a mess it should be removed */
 
 
+/* Max. number of lines in ST screen buffer, VDI mode has most */
+#define STSCREEN_MAX_LINES  MAX_VDI_HEIGHT
+
 /* Frame buffer, used to store details in screen conversion */
 typedef struct
 {
@@ -91,6 +95,7 @@ extern int STScreenStartHorizLine;
 extern int STScreenLeftSkipBytes;
 extern FRAMEBUFFER *pFrameBuffer;
 extern Uint8 *pSTScreen;
+extern Uint8 STScreenLineChanged[STSCREEN_MAX_LINES];
 extern SDL_Surface *sdlscrn;
 extern Uint32 STRGBPalette[16];
 extern Uint32 ST2RGB[4096];
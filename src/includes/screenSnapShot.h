@@ -11,9 +11,20 @@
 #include <stdio.h>
 #include <SDL.h>
 
+/* screenshot file formats */
+enum {
+	SCREENSHOT_FORMAT_PNG,
+	SCREENSHOT_FORMAT_BMP,
+	SCREENSHOT_FORMAT_PPM,
+	SCREENSHOT_FORMAT_QOI
+};
+
 extern int ScreenSnapShot_SavePNG_ToFile(SDL_Surface *surface, FILE *fp, int png_compression_level, int png_filter ,
 		int CropLeft , int CropRight , int CropTop , int CropBottom );
 extern void ScreenSnapShot_SaveScreen(void);
+extern bool ScreenSnapShot_SetFrameDump(const char *dirname, bool bChangedOnly);
+extern void ScreenSnapShot_FrameDump(void);
+extern void ScreenSnapShot_UnInit(void);
 
 #endif /* ifndef HATARI_SCREENSNAPSHOT_H */
 
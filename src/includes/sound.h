@@ -55,6 +55,7 @@ extern void Sound_MemorySnapShot_Capture(bool bSave);
 extern void Sound_Update(bool FillFrame);
 extern void Sound_Update_VBL(void);
 extern void Sound_WriteReg( int reg , Uint8 data );
+extern void Sound_WriteRegLater( int reg , Uint8 data );
 extern bool Sound_BeginRecording(char *pszCaptureFileName);
 extern void Sound_EndRecording(void);
 extern bool Sound_AreWeRecording(void);
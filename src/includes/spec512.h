@@ -16,5 +16,6 @@ extern void Spec512_ScanWholeLine(void);
 extern void Spec512_StartScanLine(void);
 extern void Spec512_EndScanLine(void);
 extern void Spec512_UpdatePaletteSpan(void);
+extern Uint32 Spec512_HashPalettes(Uint32 hash);
 
 #endif  /* HATARI_SPEC512_H */
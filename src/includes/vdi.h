@@ -41,6 +41,14 @@ enum
   GEMCOLOR_16
 };
 
+/* VDI_AES_Entry() return values */
+enum
+{
+  VDI_ENTRY_PASS,      /* let TOS handle the call */
+  VDI_ENTRY_COMPLETE,  /* call VDI_Complete() on trap exit */
+  VDI_ENTRY_DONE       /* call was handled, skip the trap */
+};
+
 extern Uint32 VDI_OldPC;
 extern bool bUseVDIRes, bVdiAesIntercept;
 extern int VDIWidth,VDIHeight;
@@ -50,7 +58,7 @@ extern int VDI_Limit(int value, int align, int min, int max);
 extern void VDI_SetResolution(int GEMColor, int WidthRequest, int HeightRequest);
 extern void AES_Info(Uint32 bShowOpcodes);
 extern void VDI_Info(Uint32 bShowOpcodes);
-extern bool VDI_AES_Entry(void);
+extern int VDI_AES_Entry(void);
 extern void VDI_LineA(Uint32 LineABase, Uint32 FontBase);
 extern void VDI_Complete(void);
 extern void VDI_Reset(void);
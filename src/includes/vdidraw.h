@@ -0,0 +1,33 @@
+/*
+  Hatari - vdidraw.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef HATARI_VDIDRAW_H
+#define HATARI_VDIDRAW_H
+
+/* VDIDraw_RecordFile stream record types */
+enum
+{
+	VDIDRAW_REC_OPEN = 1,     /* workstation open completed */
+	VDIDRAW_REC_ATTRIB,       /* attribute call completed */
+	VDIDRAW_REC_DRAW,         /* drawing call entry */
+	VDIDRAW_REC_FONTS         /* system font table */
+};
+#define VDIDRAW_REC_MAGIC    "VDIR"
+#define VDIDRAW_REC_VERSION  1
+
+extern int VDIDraw_Entry(Uint32 control, Uint32 intin, Uint32 ptsin, bool bNative);
+extern void VDIDraw_Complete(Uint32 control, Uint32 intin, Uint32 ptsin,
+                             Uint32 intout, Uint32 ptsout);
+extern void VDIDraw_SetFonts(Uint32 fontbase);
+extern void VDIDraw_Reset(void);
+extern void VDIDraw_MemorySnapShot_Capture(bool bSave);
+
+extern bool VDIDraw_SetRecordFile(const char *pszFileName);
+extern bool VDIDraw_IsRecording(void);
+extern void VDIDraw_UnInit(void);
+
+#endif  /* HATARI_VDIDRAW_H */
@@ -167,6 +167,19 @@ extern void	Video_SetScreenRasters(void);
 extern void	Video_GetTTRes(int *width, int *height, int *bpp);
 extern bool	Video_RenderTTScreen(void);
 
+/* Screen contents hash (FNV-1a), see Video_HashData() */
+#define VIDEO_HASH_INIT   0x811c9dc5
+#define VIDEO_HASH_PRIME  0x01000193
+
+static inline Uint32 Video_HashValue(Uint32 hash, Uint32 value)
+{
+	return (hash ^ value) * VIDEO_HASH_PRIME;
+}
+
+extern Uint32	Video_HashData(Uint32 hash, const Uint8 *data, int len);
+extern Uint32	Video_GetScreenHash(void);
+extern Uint32	Video_GetScreenHashVBL(void);
+
 extern void	Video_AddInterruptTimerB ( int Pos );
 
 extern void	Video_StartInterrupts ( int PendingCyclesOver );
@@ -0,0 +1,784 @@
+/*
+  Hatari - inputRecord.c
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  Deterministic recording and replaying of external emulation input.
+
+  All input which doesn't come from the emulation itself is logged with
+  its CyclesGlobalClockCounter timestamp: IKBD key presses, mouse motion
+  and buttons (as changed by host events during the IKBD auto-send
+  interrupt), joystick readings, MIDI and RS232 input bytes, and host
+  file contents read through GEMDOS Fread().
+
+  Emulation state is saved with MemorySnapShot at the start of recording
+  and then periodically as "anchors".  Replay restores the last anchor
+  before the requested seek position, skips the recorded input before it
+  and then feeds the rest of the recorded input to emulation instead of
+  the host input (fast forwarding until the seek position is reached).
+
+  Recording file is big endian.  It starts with "HREC" magic, version and
+  emulated cycles per second (longs), followed by records, each of which
+  has a 16 byte header: 64-bit timestamp, type byte, argument byte,
+  unused word and payload length long.
+*/
+const char InputRecord_fileid[] = "Hatari inputRecord.c : " __DATE__ " " __TIME__;
+
+#include <inttypes.h>
+
+#include "main.h"
+#include "configuration.h"
+#include "clocks_timings.h"
+#include "cycles.h"
+#include "file.h"
+#include "ikbd.h"
+#include "inputRecord.h"
+#include "log.h"
+#include "memorySnapShot.h"
+#include "mfp.h"
+#include "rs232.h"
+#include "screen.h"
+#include "stMemory.h"
+#include "video.h"
+
+
+#define INPUTREC_MAGIC      "HREC"
+#define INPUTREC_VERSION    1
+#define INPUTREC_HEADER     16
+#define INPUTREC_MAX_PORTS  6           /* Joy_GetStickData() IDs */
+
+enum
+{
+	INPUTREC_ANCHOR = 1,     /* snapshot file name */
+	INPUTREC_KEY,            /* arg = pressed, scancode byte */
+	INPUTREC_MOUSE,          /* dx & dy words, button flags byte */
+	INPUTREC_JOY,            /* arg = port, new reading byte */
+	INPUTREC_MIDI,           /* received byte */
+	INPUTREC_RS232_STATUS,   /* arg = new input status */
+	INPUTREC_RS232_DATA,     /* received bytes */
+	INPUTREC_HOSTFILE,       /* bytes read from host file */
+	INPUTREC_HOSTTIME,       /* value derived from host time, long */
+	INPUTREC_TYPES
+};
+
+/* INPUTREC_MOUSE button flags */
+#define INPUTREC_MOUSE_LEFT   1
+#define INPUTREC_MOUSE_RIGHT  2
+#define INPUTREC_MOUSE_DBLCLK 4
+
+typedef struct
+{
+	Uint64 time;
+	Uint8 type;
+	Uint8 arg;
+	Uint32 len;
+	Uint8 *data;
+} INPUTREC_EVENT;
+
+static enum { INPUTREC_OFF, INPUTREC_RECORD, INPUTREC_REPLAY } Mode;
+static bool bStarted;
+static char *FileName;
+static int AnchorSecs = 30;
+static int SeekSecs;
+
+/* recording */
+static FILE *RecordFile;
+static Uint64 NextAnchor;
+static int nAnchors;
+
+/* replaying */
+static Uint8 *ReplayData;
+static INPUTREC_EVENT *Events;
+static int nEvents;
+static int Cursor[INPUTREC_TYPES];
+static int JoyCursor[INPUTREC_MAX_PORTS];
+static Uint8 JoyValue[INPUTREC_MAX_PORTS];
+static bool RS232Status;
+static Uint64 SeekTarget;
+static bool bSeeking, bOldFastForward;
+static bool bInjecting, bDesyncWarned;
+
+/* RS232 receive interrupt raised for waiting input */
+static bool bRS232Raised;
+
+/* recorded or replayed values, to detect changes */
+static Uint8 LastJoy[INPUTREC_MAX_PORTS];
+static bool LastRS232Status;
+
+/* input state before host events are handled */
+static int OldMouseDx, OldMouseDy;
+static int OldLButton, OldRButton, OldDblClk;
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Set file to record input to.  Return false for invalid name.
+ */
+bool InputRecord_SetRecordFile(const char *filename)
+{
+	if (!filename || !*filename || Mode == INPUTREC_REPLAY)
+		return false;
+	free(FileName);
+	FileName = strdup(filename);
+	Mode = INPUTREC_RECORD;
+	return true;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Set file to replay input from.  Return false if it doesn't exist.
+ */
+bool InputRecord_SetReplayFile(const char *filename)
+{
+	if (!filename || !File_Exists(filename) || Mode == INPUTREC_RECORD)
+		return false;
+	free(FileName);
+	FileName = strdup(filename);
+	Mode = INPUTREC_REPLAY;
+	return true;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Set interval for snapshot anchors in seconds, zero = only at start
+ */
+bool InputRecord_SetAnchorInterval(int secs)
+{
+	if (secs < 0)
+		return false;
+	AnchorSecs = secs;
+	return true;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Set replay seek position in seconds from the start of recording
+ */
+bool InputRecord_SetSeek(int secs)
+{
+	if (secs < 0)
+		return false;
+	SeekSecs = secs;
+	return true;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if input is being recorded or replayed
+ */
+bool InputRecord_IsActive(void)
+{
+	return bStarted;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if input is being replayed
+ */
+bool InputRecord_IsReplaying(void)
+{
+	return bStarted && Mode == INPUTREC_REPLAY;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Big endian value helpers
+ */
+static void InputRecord_PutValue(Uint8 *p, Uint64 value, int bytes)
+{
+	while (bytes--)
+	{
+		p[bytes] = value;
+		value >>= 8;
+	}
+}
+
+static Uint64 InputRecord_GetValue(const Uint8 *p, int bytes)
+{
+	Uint64 value = 0;
+	while (bytes--)
+		value = (value << 8) | *p++;
+	return value;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Write a record with the current timestamp
+ */
+static void InputRecord_Write(int type, int arg, const void *data, Uint32 len)
+{
+	Uint8 header[INPUTREC_HEADER];
+
+	InputRecord_PutValue(header, CyclesGlobalClockCounter, 8);
+	header[8] = type;
+	header[9] = arg;
+	InputRecord_PutValue(header + 10, 0, 2);
+	InputRecord_PutValue(header + 12, len, 4);
+	if (fwrite(header, sizeof(header), 1, RecordFile) != 1 ||
+	    (len && fwrite(data, len, 1, RecordFile) != 1))
+	{
+		Log_AlertDlg(LOG_ERROR, "Input recording write failed, recording stopped!");
+		InputRecord_UnInit();
+	}
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Seed the random numbers used by emulation (e.g. IKBD command delays)
+ * from the anchor time, so that replay from the anchor gets the same ones
+ */
+static void InputRecord_SeedRandom(Uint64 time)
+{
+	srand((unsigned)time ^ (unsigned)(time >> 32));
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Save emulation state to next anchor snapshot file
+ */
+static void InputRecord_SaveAnchor(void)
+{
+	char *name;
+
+	name = malloc(strlen(FileName) + 16);
+	if (!name)
+		return;
+	sprintf(name, "%s.%03d.sav", FileName, nAnchors++);
+	MemorySnapShot_Capture(name, false);
+	InputRecord_Write(INPUTREC_ANCHOR, 0, name, strlen(name));
+	free(name);
+	InputRecord_SeedRandom(CyclesGlobalClockCounter);
+
+	if (AnchorSecs)
+		NextAnchor = CyclesGlobalClockCounter + (Uint64)AnchorSecs * MachineClocks.CPU_Freq;
+	else
+		NextAnchor = UINT64_MAX;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Start recording: write file header.  The first anchor is saved
+ * after this tick's host events, like all the other anchors, so that
+ * replay can skip the events recorded before it.
+ */
+static bool InputRecord_StartRecording(void)
+{
+	Uint8 header[12];
+
+	RecordFile = File_Open(FileName, "wb");
+	if (!RecordFile)
+		return false;
+	memcpy(header, INPUTREC_MAGIC, 4);
+	InputRecord_PutValue(header + 4, INPUTREC_VERSION, 4);
+	InputRecord_PutValue(header + 8, MachineClocks.CPU_Freq, 4);
+	if (fwrite(header, sizeof(header), 1, RecordFile) != 1)
+		return false;
+
+	bStarted = true;
+	NextAnchor = 0;
+	Log_Printf(LOG_INFO, "Recording input to '%s'.\n", FileName);
+	return true;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Set replay cursors to the first events after given time,
+ * and the input state values to the ones valid at that time.
+ */
+static void InputRecord_Position(Uint64 time)
+{
+	int i, type;
+
+	memset(JoyValue, 0, sizeof(JoyValue));
+	RS232Status = false;
+	for (i = 0; i < nEvents && Events[i].time <= time; i++)
+	{
+		if (Events[i].type == INPUTREC_JOY && Events[i].arg < INPUTREC_MAX_PORTS)
+			JoyValue[Events[i].arg] = Events[i].data[0];
+		else if (Events[i].type == INPUTREC_RS232_STATUS)
+			RS232Status = Events[i].arg;
+	}
+	for (type = 0; type < INPUTREC_TYPES; type++)
+		Cursor[type] = i;
+	for (type = 0; type < INPUTREC_MAX_PORTS; type++)
+		JoyCursor[type] = i;
+	memcpy(LastJoy, JoyValue, sizeof(LastJoy));
+	LastRS232Status = RS232Status;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return index of next event of given type from its cursor
+ * (without advancing it), or -1 if there are no more such events
+ */
+static int InputRecord_Peek(int type)
+{
+	int i;
+
+	for (i = Cursor[type]; i < nEvents; i++)
+	{
+		if (Events[i].type == type)
+			break;
+	}
+	Cursor[type] = i;
+	return i < nEvents ? i : -1;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return next event of given type if it's due, advance its cursor
+ */
+static INPUTREC_EVENT *InputRecord_Next(int type)
+{
+	int i = InputRecord_Peek(type);
+
+	if (i < 0 || Events[i].time > CyclesGlobalClockCounter)
+		return NULL;
+	if (Events[i].time < CyclesGlobalClockCounter && !bDesyncWarned)
+	{
+		Log_Printf(LOG_WARN, "Input replay out of sync (event type %d at %"PRIu64", now %"PRIu64")!\n",
+		           type, Events[i].time, CyclesGlobalClockCounter);
+		bDesyncWarned = true;
+	}
+	Cursor[type] = i + 1;
+	return &Events[i];
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Load and parse the whole recording.  Return false for errors.
+ */
+static bool InputRecord_Load(void)
+{
+	long size;
+	Uint8 *p, *end;
+	int count;
+
+	ReplayData = File_Read(FileName, &size, NULL);
+	if (!ReplayData || size < 12 || memcmp(ReplayData, INPUTREC_MAGIC, 4) != 0
+	    || InputRecord_GetValue(ReplayData + 4, 4) != INPUTREC_VERSION)
+	{
+		Log_AlertDlg(LOG_ERROR, "'%s' isn't a valid Hatari input recording!", FileName);
+		return false;
+	}
+	end = ReplayData + size;
+
+	/* count & index events */
+	count = 0;
+	for (p = ReplayData + 12; p + INPUTREC_HEADER <= end; count++)
+		p += INPUTREC_HEADER + InputRecord_GetValue(p + 12, 4);
+	Events = calloc(count, sizeof(*Events));
+	if (count && !Events)
+		return false;
+	for (p = ReplayData + 12; p + INPUTREC_HEADER <= end; nEvents++)
+	{
+		INPUTREC_EVENT *ev = &Events[nEvents];
+		ev->time = InputRecord_GetValue(p, 8);
+		ev->type = p[8];
+		ev->arg = p[9];
+		ev->len = InputRecord_GetValue(p + 12, 4);
+		ev->data = p + INPUTREC_HEADER;
+		if (ev->data + ev->len > end)
+			break;	/* truncated at end */
+		p = ev->data + ev->len;
+	}
+	return true;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Start replay: restore the last anchor before seek position
+ */
+static bool InputRecord_StartReplay(void)
+{
+	INPUTREC_EVENT *anchor = NULL;
+	Uint64 cps;
+	char *name;
+	int i;
+
+	if (!InputRecord_Load())
+		return false;
+
+	cps = InputRecord_GetValue(ReplayData + 8, 4);
+	for (i = 0; i < nEvents; i++)
+	{
+		if (Events[i].type != INPUTREC_ANCHOR)
+			continue;
+		if (!anchor)
+			SeekTarget = Events[i].time + SeekSecs * cps;
+		else if (Events[i].time > SeekTarget)
+			break;
+		anchor = &Events[i];
+	}
+	if (!anchor)
+	{
+		Log_AlertDlg(LOG_ERROR, "No snapshot anchors in input recording '%s'!", FileName);
+		return false;
+	}
+
+	name = malloc(anchor->len + 1);
+	if (!name)
+		return false;
+	memcpy(name, anchor->data, anchor->len);
+	name[anchor->len] = '\0';
+	Log_Printf(LOG_INFO, "Replaying input from '%s', starting from '%s'.\n", FileName, name);
+	MemorySnapShot_Restore(name, false);
+	free(name);
+
+	bStarted = true;
+	InputRecord_SeedRandom(anchor->time);
+	InputRecord_Position(anchor->time);
+	if (SeekTarget > CyclesGlobalClockCounter)
+	{
+		bOldFastForward = ConfigureParams.System.bFastForward;
+		ConfigureParams.System.bFastForward = true;
+		bSeeking = true;
+	}
+	return true;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Replay is done, continue with host input
+ */
+static void InputRecord_EndReplay(void)
+{
+	Log_Printf(LOG_INFO, "Input replay finished at VBL %d.\n", nVBLs);
+	InputRecord_UnInit();
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Called at IKBD auto-send interrupt, before host events are processed.
+ * Starts recording / replaying on first call and stores input state
+ * so that changes done to it by host events can be recorded or undone.
+ */
+void InputRecord_BeginEvents(void)
+{
+	if (!bStarted)
+	{
+		if (Mode == INPUTREC_OFF)
+			return;
+		if (!(Mode == INPUTREC_RECORD ? InputRecord_StartRecording() : InputRecord_StartReplay()))
+		{
+			Log_AlertDlg(LOG_ERROR, "Input %s with '%s' failed!",
+			             Mode == INPUTREC_RECORD ? "recording" : "replay", FileName);
+			InputRecord_UnInit();
+			return;
+		}
+	}
+	OldMouseDx = KeyboardProcessor.Mouse.dx;
+	OldMouseDy = KeyboardProcessor.Mouse.dy;
+	OldLButton = Keyboard.bLButtonDown & BUTTON_MOUSE;
+	OldRButton = Keyboard.bRButtonDown & BUTTON_MOUSE;
+	OldDblClk = Keyboard.LButtonDblClk;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Record mouse changes done by host events, and save anchor when it's due
+ */
+static void InputRecord_RecordEvents(void)
+{
+	Uint8 data[5];
+	int flags = 0;
+
+	if (Keyboard.bLButtonDown & BUTTON_MOUSE)
+		flags |= INPUTREC_MOUSE_LEFT;
+	if (Keyboard.bRButtonDown & BUTTON_MOUSE)
+		flags |= INPUTREC_MOUSE_RIGHT;
+	if (Keyboard.LButtonDblClk && !OldDblClk)
+		flags |= INPUTREC_MOUSE_DBLCLK;
+	if (KeyboardProcessor.Mouse.dx != OldMouseDx || KeyboardProcessor.Mouse.dy != OldMouseDy
+	    || (Keyboard.bLButtonDown & BUTTON_MOUSE) != OldLButton
+	    || (Keyboard.bRButtonDown & BUTTON_MOUSE) != OldRButton
+	    || (flags & INPUTREC_MOUSE_DBLCLK))
+	{
+		InputRecord_PutValue(data, KeyboardProcessor.Mouse.dx - OldMouseDx, 2);
+		InputRecord_PutValue(data + 2, KeyboardProcessor.Mouse.dy - OldMouseDy, 2);
+		data[4] = flags;
+		InputRecord_Write(INPUTREC_MOUSE, 0, data, sizeof(data));
+	}
+	if (RecordFile && CyclesGlobalClockCounter >= NextAnchor)
+		InputRecord_SaveAnchor();
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Undo input changes done by host events and apply recorded ones instead
+ */
+static void InputRecord_ReplayEvents(void)
+{
+	INPUTREC_EVENT *ev;
+
+	/* undo host changes */
+	KeyboardProcessor.Mouse.dx = OldMouseDx;
+	KeyboardProcessor.Mouse.dy = OldMouseDy;
+	Keyboard.bLButtonDown = (Keyboard.bLButtonDown & ~BUTTON_MOUSE) | OldLButton;
+	Keyboard.bRButtonDown = (Keyboard.bRButtonDown & ~BUTTON_MOUSE) | OldRButton;
+	Keyboard.LButtonDblClk = OldDblClk;
+
+	/* and apply recorded ones */
+	bInjecting = true;
+	while ((ev = InputRecord_Next(INPUTREC_KEY)))
+		IKBD_PressSTKey(ev->data[0], ev->arg);
+	bInjecting = false;
+	while ((ev = InputRecord_Next(INPUTREC_MOUSE)))
+	{
+		KeyboardProcessor.Mouse.dx += (Sint16)InputRecord_GetValue(ev->data, 2);
+		KeyboardProcessor.Mouse.dy += (Sint16)InputRecord_GetValue(ev->data + 2, 2);
+		Keyboard.bLButtonDown &= ~BUTTON_MOUSE;
+		if (ev->data[4] & INPUTREC_MOUSE_LEFT)
+			Keyboard.bLButtonDown |= BUTTON_MOUSE;
+		Keyboard.bRButtonDown &= ~BUTTON_MOUSE;
+		if (ev->data[4] & INPUTREC_MOUSE_RIGHT)
+			Keyboard.bRButtonDown |= BUTTON_MOUSE;
+		if (ev->data[4] & INPUTREC_MOUSE_DBLCLK)
+			Keyboard.LButtonDblClk = 1;
+	}
+
+	if (bSeeking && CyclesGlobalClockCounter >= SeekTarget)
+	{
+		ConfigureParams.System.bFastForward = bOldFastForward;
+		bSeeking = false;
+		Log_Printf(LOG_INFO, "Input replay seek done at VBL %d.\n", nVBLs);
+	}
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Called at IKBD auto-send interrupt, after host events are processed.
+ * Records the input changes done by them, or replaces them with recorded
+ * ones.  Because RS232 host input isn't deterministic, RS232 receive
+ * interrupt is also raised from here while input is recorded / replayed.
+ */
+void InputRecord_EndEvents(void)
+{
+	bool bRS232Waiting;
+
+	if (!bStarted)
+		return;
+
+	if (Mode == INPUTREC_RECORD)
+		InputRecord_RecordEvents();
+	else
+		InputRecord_ReplayEvents();
+	if (!bStarted)
+		return;
+
+	bRS232Waiting = RS232_GetStatus();
+	if (bRS232Waiting && !bRS232Raised)
+		MFP_InputOnChannel ( MFP_INT_RCV_BUF_FULL , 0 );
+	bRS232Raised = bRS232Waiting;
+
+	if (Mode == INPUTREC_REPLAY && nEvents
+	    && CyclesGlobalClockCounter > Events[nEvents-1].time)
+		InputRecord_EndReplay();
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Record a host key press/release.
+ * Return false if it should be ignored because input is replayed.
+ */
+bool InputRecord_Key(Uint8 scancode, bool press)
+{
+	if (!bStarted || bInjecting)
+		return true;
+	if (Mode == INPUTREC_REPLAY)
+		return false;
+	InputRecord_Write(INPUTREC_KEY, press, &scancode, 1);
+	return true;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Record joystick reading for given port if it changed,
+ * or return replayed reading instead of it
+ */
+Uint8 InputRecord_Joystick(int port, Uint8 value)
+{
+	int i;
+
+	if (!bStarted || port < 0 || port >= INPUTREC_MAX_PORTS)
+		return value;
+	if (Mode == INPUTREC_RECORD)
+	{
+		if (value != LastJoy[port])
+		{
+			InputRecord_Write(INPUTREC_JOY, port, &value, 1);
+			LastJoy[port] = value;
+		}
+		return value;
+	}
+	for (i = JoyCursor[port]; i < nEvents && Events[i].time <= CyclesGlobalClockCounter; i++)
+	{
+		if (Events[i].type == INPUTREC_JOY && Events[i].arg == port)
+			JoyValue[port] = Events[i].data[0];
+	}
+	JoyCursor[port] = i;
+	return JoyValue[port];
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Record received MIDI byte (EOF = none),
+ * or return replayed one instead of it
+ */
+int InputRecord_Midi(int byte)
+{
+	INPUTREC_EVENT *ev;
+	Uint8 value = byte;
+
+	if (!bStarted)
+		return byte;
+	if (Mode == INPUTREC_RECORD)
+	{
+		if (byte != EOF)
+			InputRecord_Write(INPUTREC_MIDI, 0, &value, 1);
+		return byte;
+	}
+	ev = InputRecord_Next(INPUTREC_MIDI);
+	return ev ? ev->data[0] : EOF;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Record RS232 input status if it changed,
+ * or return replayed status instead of it
+ */
+bool InputRecord_RS232Status(bool status)
+{
+	int i;
+
+	if (!bStarted)
+		return status;
+	if (Mode == INPUTREC_RECORD)
+	{
+		if (status != LastRS232Status)
+		{
+			InputRecord_Write(INPUTREC_RS232_STATUS, status, NULL, 0);
+			LastRS232Status = status;
+		}
+		return status;
+	}
+	for (i = Cursor[INPUTREC_RS232_STATUS]; i < nEvents && Events[i].time <= CyclesGlobalClockCounter; i++)
+	{
+		if (Events[i].type == INPUTREC_RS232_STATUS)
+			RS232Status = Events[i].arg;
+	}
+	Cursor[INPUTREC_RS232_STATUS] = i;
+	return RS232Status;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Record received RS232 bytes (if 'ok'), or replace them with
+ * replayed ones.  Return whether there were bytes.
+ */
+bool InputRecord_RS232Data(Uint8 *bytes, int count, bool ok)
+{
+	INPUTREC_EVENT *ev;
+
+	if (!bStarted)
+		return ok;
+	/* raise interrupt again for the next received byte */
+	bRS232Raised = false;
+	if (Mode == INPUTREC_RECORD)
+	{
+		if (ok)
+			InputRecord_Write(INPUTREC_RS232_DATA, 0, bytes, count);
+		return ok;
+	}
+	ev = InputRecord_Next(INPUTREC_RS232_DATA);
+	if (!ev)
+		return false;
+	memcpy(bytes, ev->data, ev->len < (Uint32)count ? ev->len : (Uint32)count);
+	return true;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Record contents read from a host file through GEMDOS
+ */
+void InputRecord_RecordHostFile(const Uint8 *buffer, int bytes)
+{
+	if (bStarted && Mode == INPUTREC_RECORD)
+		InputRecord_Write(INPUTREC_HOSTFILE, 0, buffer, bytes);
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Copy next replayed host file contents to given ST RAM address
+ * (at most given size).  Return their size, or -1 if input isn't replayed.
+ */
+int InputRecord_ReplayHostFile(Uint32 addr, Uint32 size)
+{
+	INPUTREC_EVENT *ev;
+
+	if (!bStarted || Mode != INPUTREC_REPLAY)
+		return -1;
+	ev = InputRecord_Next(INPUTREC_HOSTFILE);
+	if (!ev)
+		return 0;
+	if (ev->len < size)
+		size = ev->len;
+	if (!STMemory_ValidArea(addr, size))
+		return 0;
+	memcpy((void *)STRAM_ADDR(addr), ev->data, size);
+	return size;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Record a value derived from host time (clock chip register, GEMDOS
+ * file timestamp), or return replayed one instead of it.  Values are
+ * recorded after time zone conversion, so that replay doesn't depend
+ * on the host clock or its time zone.
+ */
+Uint32 InputRecord_HostTime(Uint32 value)
+{
+	INPUTREC_EVENT *ev;
+	Uint8 data[4];
+
+	if (!bStarted)
+		return value;
+	if (Mode == INPUTREC_RECORD)
+	{
+		InputRecord_PutValue(data, value, 4);
+		InputRecord_Write(INPUTREC_HOSTTIME, 0, data, sizeof(data));
+		return value;
+	}
+	ev = InputRecord_Next(INPUTREC_HOSTTIME);
+	if (!ev || ev->len != sizeof(data))
+		return value;
+	return InputRecord_GetValue(ev->data, sizeof(data));
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Stop recording / replaying and free resources
+ */
+void InputRecord_UnInit(void)
+{
+	if (bSeeking)
+	{
+		ConfigureParams.System.bFastForward = bOldFastForward;
+		bSeeking = false;
+	}
+	RecordFile = File_Close(RecordFile);
+	free(ReplayData);
+	ReplayData = NULL;
+	free(Events);
+	Events = NULL;
+	nEvents = 0;
+	bRS232Raised = false;
+	bStarted = false;
+	Mode = INPUTREC_OFF;
+}
@@ -45,6 +45,7 @@ static void (*pInterceptWriteTable[0x8000])(void);    /* Table with write access
 int nIoMemAccessSize;                                 /* Set to 1, 2 or 4 according to byte, word or long word access */
 Uint32 IoAccessBaseAddress;                           /* Stores the base address of the IO mem access */
 Uint32 IoAccessCurrentAddress;                        /* Current byte address while handling WORD and LONG accesses */
+Uint32 IoAccessReadCount;                             /* Number of read accesses, checked by spin-loop detection */
 static int nBusErrorAccesses;                         /* Needed to count bus error accesses */
 
 /* Falcon bus mode (Falcon STe compatible bus or Falcon only bus) */
@@ -254,6 +255,27 @@ void IoMem_UnInit(void)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if read (or write) access to any of the 'len' IO memory
+ * bytes at 'addr' goes to a bus error handler, i.e. if accessing them
+ * from outside of the CPU emulation could raise a bus error exception.
+ */
+bool IoMem_IsBusErrorRange(Uint32 addr, Uint32 len, bool bWrite)
+{
+	void (**table)(void) = bWrite ? pInterceptWriteTable : pInterceptReadTable;
+	Uint32 idx;
+
+	for (idx = addr - 0xff8000; len > 0; idx++, len--)
+	{
+		if (table[idx] == IoMem_BusErrorEvenReadAccess || table[idx] == IoMem_BusErrorOddReadAccess
+		    || table[idx] == IoMem_BusErrorEvenWriteAccess || table[idx] == IoMem_BusErrorOddWriteAccess)
+			return true;
+	}
+	return false;
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Handle byte read access from IO memory.
@@ -274,6 +296,7 @@ uae_u32 IoMem_bget(uaecptr addr)
 	IoAccessBaseAddress = addr;                   /* Store access location */
 	nIoMemAccessSize = SIZE_BYTE;
 	nBusErrorAccesses = 0;
+	IoAccessReadCount++;
 
 	IoAccessCurrentAddress = addr;
 	pInterceptReadTable[addr-0xff8000]();         /* Call handler */
@@ -319,6 +342,7 @@ uae_u32 IoMem_wget(uaecptr addr)
 	IoAccessBaseAddress = addr;                   /* Store for exception frame */
 	nIoMemAccessSize = SIZE_WORD;
 	nBusErrorAccesses = 0;
+	IoAccessReadCount++;
 	idx = addr - 0xff8000;
 
 	IoAccessCurrentAddress = addr;
@@ -371,6 +395,7 @@ uae_u32 IoMem_lget(uaecptr addr)
 	IoAccessBaseAddress = addr;                   /* Store for exception frame */
 	nIoMemAccessSize = SIZE_LONG;
 	nBusErrorAccesses = 0;
+	IoAccessReadCount++;
 	idx = addr - 0xff8000;
 
 	IoAccessCurrentAddress = addr;
@@ -14,6 +14,7 @@ const char Joy_fileid[] = "Hatari joy.c : " __DATE__ " " __TIME__;
 
 #include "main.h"
 #include "configuration.h"
+#include "inputRecord.h"
 #include "ioMem.h"
 #include "joy.h"
 #include "log.h"
@@ -164,10 +165,8 @@ static bool Joy_ReadJoystick(int nSdlJoyID, JOYREADING *pJoyReading)
 /**
  * Read PC joystick and return ST format byte, i.e. lower 4 bits direction
  * and top bit fire.
- * NOTE : ID 0 is Joystick 0/Mouse and ID 1 is Joystick 1 (default),
- *        ID 2 and 3 are STE joypads and ID 4 and 5 are parport joysticks.
  */
-Uint8 Joy_GetStickData(int nStJoyId)
+static Uint8 Joy_ReadStickData(int nStJoyId)
 {
 	Uint8 nData = 0;
 	JOYREADING JoyReading;
@@ -256,6 +255,18 @@ Uint8 Joy_GetStickData(int nStJoyId)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Return ST format joystick data, recorded or replayed when needed.
+ * NOTE : ID 0 is Joystick 0/Mouse and ID 1 is Joystick 1 (default),
+ *        ID 2 and 3 are STE joypads and ID 4 and 5 are parport joysticks.
+ */
+Uint8 Joy_GetStickData(int nStJoyId)
+{
+	return InputRecord_Joystick(nStJoyId, Joy_ReadStickData(nStJoyId));
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Get the fire button states.
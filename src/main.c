@@ -19,6 +19,7 @@ const char Main_fileid[] = "Hatari main.c : " __DATE__ " " __TIME__;
 #include "options.h"
 #include "dialog.h"
 #include "audio.h"
+#include "benchmark.h"
 #include "joy.h"
 #include "floppy.h"
 #include "gemdos.h"
@@ -27,6 +28,7 @@ const char Main_fileid[] = "Hatari main.c : " __DATE__ " " __TIME__;
 #include "ide.h"
 #include "acia.h"
 #include "ikbd.h"
+#include "inputRecord.h"
 #include "ioMem.h"
 #include "keymap.h"
 #include "log.h"
@@ -40,6 +42,7 @@ const char Main_fileid[] = "Hatari main.c : " __DATE__ " " __TIME__;
 #include "resolution.h"
 #include "rs232.h"
 #include "screen.h"
+#include "screenSnapShot.h"
 #include "sdlgui.h"
 #include "shortcut.h"
 #include "sound.h"
@@ -49,6 +52,7 @@ const char Main_fileid[] = "Hatari main.c : " __DATE__ " " __TIME__;
 #include "str.h"
 #include "tos.h"
 #include "video.h"
+#include "vdidraw.h"
 #include "avi_record.h"
 #include "debugui.h"
 #include "clocks_timings.h"
@@ -281,10 +285,12 @@ void Main_WaitOnVbl(void)
 	Sint64 nDelay;
 
 	nVBLCount++;
+	Benchmark_VBL();
 	if (nRunVBLs &&	nVBLCount >= nRunVBLs)
 	{
 		/* show VBLs/s */
 		Main_PauseEmulation(true);
+		Benchmark_UnInit();
 		exit(0);
 	}
 
@@ -655,6 +661,10 @@ static void Main_UnInit(void)
 	GemDOS_UnInitDrives();
 	Ide_UnInit();
 	Joy_UnInit();
+	VDIDraw_UnInit();
+	InputRecord_UnInit();
+	Benchmark_UnInit();
+	ScreenSnapShot_UnInit();
 	if (Sound_AreWeRecording())
 		Sound_EndRecording();
 	Audio_UnInit();
@@ -788,6 +798,7 @@ int main(int argc, char *argv[])
 
 	/* Run emulation */
 	Main_UnPauseEmulation();
+	Benchmark_Init();
 	M68000_Start();                 /* Start emulation */
 
 	if (bRecordingAvi)
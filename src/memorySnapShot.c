@@ -46,6 +46,7 @@ const char MemorySnapShot_fileid[] = "Hatari memorySnapShot.c : " __DATE__ " " _
 #include "stMemory.h"
 #include "tos.h"
 #include "screen.h"
+#include "vdidraw.h"
 #include "video.h"
 #include "falcon/dsp.h"
 #include "falcon/crossbar.h"
@@ -256,6 +257,7 @@ void MemorySnapShot_Capture(const char *pszFileName, bool bConfirm)
 		PSG_MemorySnapShot_Capture(true);
 		Sound_MemorySnapShot_Capture(true);
 		Video_MemorySnapShot_Capture(true);
+		VDIDraw_MemorySnapShot_Capture(true);
 		Blitter_MemorySnapShot_Capture(true);
 		DmaSnd_MemorySnapShot_Capture(true);
 		Crossbar_MemorySnapShot_Capture(true);
@@ -309,6 +311,7 @@ void MemorySnapShot_Restore(const char *pszFileName, bool bConfirm)
 		PSG_MemorySnapShot_Capture(false);
 		Sound_MemorySnapShot_Capture(false);
 		Video_MemorySnapShot_Capture(false);
+		VDIDraw_MemorySnapShot_Capture(false);
 		Blitter_MemorySnapShot_Capture(false);
 		DmaSnd_MemorySnapShot_Capture(false);
 		Crossbar_MemorySnapShot_Capture(false);
@@ -9,6 +9,23 @@
   enough to let some ST programs (e.g. the game Pirates!) use the host's midi
   system.
 
+  Host input and output go through hostStream.c, so besides files and
+  devices, MIDI can also use TCP or Unix sockets (e.g. to link several
+  local Hatari instances into a MIDI ring) or a pseudo terminal.
+
+  All I/O is done on the emulation thread and never blocks:
+  - Input is read from the host in bulk into a ring buffer when it's
+    polled, and received bytes are given to the ACIA one per MIDI byte
+    time (320us).
+  - Output bytes are collected into a batch, which is written to the host
+    when the program stops sending (no new byte during a byte time),
+    when the batch gets too old or when the buffer fills up.
+  - The byte time interrupt runs only while there's something to send or
+    receive.  When MIDI is idle, host input is polled once per VBL and,
+    at most once per byte time, when the ACIA status register is read.
+    While input is recorded or replayed, the interrupt runs all the time
+    so that received bytes are handled at deterministic points.
+
   TODO:
    - Most bits in the ACIA's status + control registers are currently ignored.
    - Check when we have to clear the ACIA_SR_INTERRUPT_REQUEST bit in the
@@ -22,11 +39,14 @@ const char Midi_fileid[] = "Hatari midi.c : " __DATE__ " " __TIME__;
 
 #include "main.h"
 #include "configuration.h"
+#include "cycInt.h"
+#include "cycles.h"
+#include "hostStream.h"
 #include "ioMem.h"
 #include "m68000.h"
 #include "mfp.h"
 #include "midi.h"
-#include "file.h"
+#include "inputRecord.h"
 #include "acia.h"
 
 
@@ -34,6 +54,16 @@ const char Midi_fileid[] = "Hatari midi.c : " __DATE__ " " __TIME__;
 #define ACIA_SR_TX_EMPTY           0x02
 #define ACIA_SR_RX_FULL            0x01
 
+/* One byte (start + 8 data + stop bits) at 31250 baud,
+ * in CPU cycles for a 8 MHz STF reference */
+#define MIDI_BYTE_CYCLES  (8021247 * 10 / 31250)
+
+/* Output batch is written to the host at latest when it's this old */
+#define MIDI_BATCH_CYCLES  (8 * MIDI_BYTE_CYCLES)
+
+#define MIDI_INPUT_BUFFER   1024	/* must be a power of 2 */
+#define MIDI_OUTPUT_BUFFER  256
+
 #define MIDI_DEBUG 0
 #if MIDI_DEBUG
 #define Dprintf(a) printf a
@@ -42,12 +72,142 @@ const char Midi_fileid[] = "Hatari midi.c : " __DATE__ " " __TIME__;
 #endif
 
 
-static FILE *pMidiFhIn  = NULL;        /* File handle used for Midi input */
-static FILE *pMidiFhOut = NULL;        /* File handle used for Midi output */
+static HOSTSTREAM MidiIn = HOSTSTREAM_INIT;     /* Stream used for MIDI input */
+static HOSTSTREAM MidiOut = HOSTSTREAM_INIT;    /* Stream used for MIDI output */
+static HOSTSTREAM *pMidiOut = &MidiOut;         /* &MidiIn if they're the same socket/pty */
 static Uint8 MidiControlRegister;
 static Uint8 MidiStatusRegister;
 static Uint8 nRxDataByte;
 
+static Uint8 InputBuffer[MIDI_INPUT_BUFFER];
+static int InputHead, InputTail;
+static Uint64 nLastPollTime;                    /* CyclesGlobalClockCounter at last host poll */
+
+static Uint8 OutputBuffer[MIDI_OUTPUT_BUFFER];
+static int nOutputBytes;
+static Uint64 nBatchStartTime;                  /* CyclesGlobalClockCounter at first byte of batch */
+
+
+/**
+ * Open MIDI input and output streams.  Return false on error.
+ */
+static bool Midi_OpenStreams(void)
+{
+	const char *sIn = ConfigureParams.Midi.sMidiInFileName;
+	const char *sOut = ConfigureParams.Midi.sMidiOutFileName;
+
+	/* Same socket or pseudo terminal for both directions? */
+	if (sIn[0] && HostStream_IsEndpoint(sIn) && strcmp(sIn, sOut) == 0)
+	{
+		if (!HostStream_Open(&MidiIn, sIn, HOSTSTREAM_READWRITE))
+			return false;
+		pMidiOut = &MidiIn;
+		Dprintf(("Opened '%s' for MIDI input and output.\n", sIn));
+		return true;
+	}
+
+	pMidiOut = &MidiOut;
+	if (sOut[0])
+	{
+		if (!HostStream_Open(&MidiOut, sOut, HOSTSTREAM_WRITE))
+			return false;
+		Dprintf(("Opened '%s' for MIDI output.\n", sOut));
+	}
+	if (sIn[0])
+	{
+		if (!HostStream_Open(&MidiIn, sIn, HOSTSTREAM_READ))
+			return false;
+		Dprintf(("Opened '%s' for MIDI input.\n", sIn));
+	}
+	return true;
+}
+
+
+/**
+ * Start the byte time interrupt, unless it's already running or
+ * there's nothing to do for it.
+ */
+static void Midi_StartTimer(void)
+{
+	if (CycInt_InterruptActive(INTERRUPT_MIDI))
+		return;
+
+	if (!InputRecord_IsActive() && InputHead == InputTail && nOutputBytes == 0
+	    && (MidiStatusRegister & ACIA_SR_TX_EMPTY))
+		return;
+
+	CycInt_AddRelativeInterrupt(MIDI_BYTE_CYCLES << nCpuFreqShift, INT_CPU_CYCLE, INTERRUPT_MIDI);
+}
+
+
+/**
+ * Read all the bytes which are available from the host into
+ * the free space of the input buffer.
+ */
+static void Midi_FillInputBuffer(void)
+{
+	int nFree, nRead;
+
+	nLastPollTime = CyclesGlobalClockCounter;
+
+	while (HostStream_IsOpen(&MidiIn))
+	{
+		/* Free contiguous space after the tail, one byte is kept
+		 * unused to tell a full buffer from an empty one */
+		if (InputTail >= InputHead)
+			nFree = MIDI_INPUT_BUFFER - InputTail - (InputHead == 0);
+		else
+			nFree = InputHead - InputTail - 1;
+		if (nFree <= 0)
+			break;
+
+		nRead = HostStream_Read(&MidiIn, &InputBuffer[InputTail], nFree);
+		if (nRead <= 0)
+			break;
+		Dprintf(("Midi: Read %d bytes\n", nRead));
+
+		InputTail = (InputTail + nRead) & (MIDI_INPUT_BUFFER-1);
+		if (nRead < nFree)
+			break;
+	}
+}
+
+
+/**
+ * Poll host for MIDI input and start the byte time interrupt
+ * if something was received.
+ */
+static void Midi_PollInput(void)
+{
+	Midi_FillInputBuffer();
+	Midi_StartTimer();
+}
+
+
+/**
+ * Write the output batch to the host.  What the host doesn't accept
+ * without blocking is kept for the next flush, unless the buffer is full.
+ */
+static void Midi_FlushOutput(void)
+{
+	int nWritten;
+
+	if (nOutputBytes == 0)
+		return;
+
+	nWritten = HostStream_TryWrite(pMidiOut, OutputBuffer, nOutputBytes);
+	if (nWritten < 0 || (nWritten == 0 && nOutputBytes == MIDI_OUTPUT_BUFFER))
+	{
+		/* no receiver, or it doesn't keep up, like with real MIDI */
+		Dprintf(("Midi: Dropped %d output bytes\n", nOutputBytes));
+		nWritten = nOutputBytes;
+	}
+	nOutputBytes -= nWritten;
+	if (nOutputBytes)
+		memmove(OutputBuffer, OutputBuffer + nWritten, nOutputBytes);
+	nBatchStartTime = CyclesGlobalClockCounter;
+}
+
 
 /**
  * Initialization: Open MIDI device.
@@ -57,33 +217,11 @@ void Midi_Init(void)
 	if (!ConfigureParams.Midi.bEnableMidi)
 		return;
 
-	if (ConfigureParams.Midi.sMidiOutFileName[0])
+	if (!Midi_OpenStreams())
 	{
-		/* Open MIDI output file */
-		pMidiFhOut = File_Open(ConfigureParams.Midi.sMidiOutFileName, "wb");
-		if (!pMidiFhOut)
-		{
-			Log_AlertDlg(LOG_ERROR, "MIDI output file open failed. MIDI support disabled.");
-			ConfigureParams.Midi.bEnableMidi = false;
-			return;
-		}
-		setvbuf(pMidiFhOut, NULL, _IONBF, 0);    /* No output buffering! */
-		Dprintf(("Opened file '%s' for MIDI output.\n",
-			 ConfigureParams.Midi.sMidiOutFileName));
-	}
-	if (ConfigureParams.Midi.sMidiInFileName[0])
-	{
-		/* Try to open MIDI input file */
-		pMidiFhIn = File_Open(ConfigureParams.Midi.sMidiInFileName, "rb");
-		if (!pMidiFhIn)
-		{
-			Log_AlertDlg(LOG_ERROR, "MIDI input file open failed. MIDI support disabled.");
-			ConfigureParams.Midi.bEnableMidi = false;
-			return;
-		}
-		setvbuf(pMidiFhIn, NULL, _IONBF, 0);    /* No input buffering! */
-		Dprintf(("Opened file '%s' for MIDI input.\n",
-			 ConfigureParams.Midi.sMidiInFileName));
+		Midi_UnInit();
+		Log_AlertDlg(LOG_ERROR, "MIDI input or output file open failed. MIDI support disabled.");
+		ConfigureParams.Midi.bEnableMidi = false;
 	}
 }
 
@@ -93,10 +231,15 @@ void Midi_Init(void)
  */
 void Midi_UnInit(void)
 {
-	pMidiFhIn = File_Close(pMidiFhIn);
-	pMidiFhOut = File_Close(pMidiFhOut);
-
+	Midi_FlushOutput();
 	CycInt_RemovePendingInterrupt(INTERRUPT_MIDI);
+
+	HostStream_Close(&MidiIn);
+	HostStream_Close(&MidiOut);
+	pMidiOut = &MidiOut;
+
+	InputHead = InputTail = 0;
+	nOutputBytes = 0;
 }
 
 
@@ -110,12 +253,23 @@ void Midi_Reset(void)
 	nRxDataByte = 1;
 
 	if (ConfigureParams.Midi.bEnableMidi)
-		CycInt_AddRelativeInterrupt(2050, INT_CPU_CYCLE, INTERRUPT_MIDI);
+		Midi_StartTimer();
 	else
 		CycInt_RemovePendingInterrupt (INTERRUPT_MIDI);
 }
 
 
+/**
+ * Poll MIDI input while the byte time interrupt isn't running,
+ * called on each VBL.
+ */
+void Midi_VBL(void)
+{
+	if (ConfigureParams.Midi.bEnableMidi && !CycInt_InterruptActive(INTERRUPT_MIDI))
+		Midi_PollInput();
+}
+
+
 /**
  * Read MIDI status register ($FFFC04).
  */
@@ -125,6 +279,12 @@ void Midi_Control_ReadByte(void)
 
 	ACIA_AddWaitCycles ();						/* Additional cycles when accessing the ACIA */
 
+	/* Programs waiting for input poll the status register,
+	 * check host for new input at most once per byte time */
+	if (ConfigureParams.Midi.bEnableMidi && !CycInt_InterruptActive(INTERRUPT_MIDI)
+	    && CyclesGlobalClockCounter - nLastPollTime >= MIDI_BYTE_CYCLES)
+		Midi_PollInput();
+
 	IoMem[0xfffc04] = MidiStatusRegister;
 }
 
@@ -190,27 +350,24 @@ void Midi_Data_WriteByte(void)
 	if (!ConfigureParams.Midi.bEnableMidi)
 		return;
 
-	if (pMidiFhOut)
+	if (HostStream_IsOpen(pMidiOut))
 	{
-		int ret;
-
-		/* Write the character to the output file: */
-		ret = fputc(nTxDataByte, pMidiFhOut);
-
-		/* If there was an error then stop the midi emulation */
-		if (ret == EOF)
-		{
-			Midi_UnInit();
-			return;
-		}
+		/* Add the byte to the output batch */
+		if (nOutputBytes == MIDI_OUTPUT_BUFFER)
+			Midi_FlushOutput();
+		if (nOutputBytes == 0)
+			nBatchStartTime = CyclesGlobalClockCounter;
+		OutputBuffer[nOutputBytes++] = nTxDataByte;
 	}
 
 	MidiStatusRegister &= ~ACIA_SR_TX_EMPTY;
+	Midi_StartTimer();
 }
 
 
 /**
- * Read and write MIDI interface data regularly
+ * Send and receive MIDI data, called once per MIDI byte time
+ * while there's something to do
  */
 void Midi_InterruptHandler_Update(void)
 {
@@ -231,40 +388,48 @@ void Midi_InterruptHandler_Update(void)
 			MidiStatusRegister |= ACIA_SR_INTERRUPT_REQUEST;
 		}
 
-		// if (pMidiFhOut)
-		//	fflush(pMidiFhOut);
-
 		MidiStatusRegister |= ACIA_SR_TX_EMPTY;
+
+		/* batch is written when it's old enough */
+		if (CyclesGlobalClockCounter - nBatchStartTime >= MIDI_BATCH_CYCLES)
+			Midi_FlushOutput();
+	}
+	else
+	{
+		/* nothing was sent during last byte time, write the batch */
+		Midi_FlushOutput();
 	}
 
 	/* Read the bytes in, if we have any */
-	if (pMidiFhIn && File_InputAvailable(pMidiFhIn))
+	nInChar = EOF;
+	if (InputHead == InputTail)
+		Midi_FillInputBuffer();
+	if (InputHead != InputTail)
 	{
-		nInChar = fgetc(pMidiFhIn);
-		if (nInChar != EOF)
-		{
-			Dprintf(("Midi: Read character $%x\n", nInChar));
-			/* Copy into our internal queue */
-			nRxDataByte = nInChar;
-			/* Do we need to generate a receive interrupt? */
-			if ((MidiControlRegister & 0x80) == 0x80)
-			{
-				Dprintf(("WriteData: Receive interrupt!\n"));
-				/* Acknowledge in MFP circuit */
-				MFP_InputOnChannel ( MFP_INT_ACIA , 0 );
-				MidiStatusRegister |= ACIA_SR_INTERRUPT_REQUEST;
-			}
-			MidiStatusRegister |= ACIA_SR_RX_FULL;
-			/* GPIP I4 - General Purpose Pin Keyboard/MIDI interrupt:
-			 * It will remain low(0) until data is read from $fffc06. */
-			MFP_GPIP &= ~0x10;
-		}
-		else
+		nInChar = InputBuffer[InputHead];
+		InputHead = (InputHead + 1) & (MIDI_INPUT_BUFFER-1);
+	}
+	/* recorded input replaces (and recording records) host input */
+	nInChar = InputRecord_Midi(nInChar);
+	if (nInChar != EOF)
+	{
+		Dprintf(("Midi: Read character $%x\n", nInChar));
+		/* Copy into our internal queue */
+		nRxDataByte = nInChar;
+		/* Do we need to generate a receive interrupt? */
+		if ((MidiControlRegister & 0x80) == 0x80)
 		{
-			Dprintf(("Midi: error during read!\n"));
-			clearerr(pMidiFhIn);
+			Dprintf(("WriteData: Receive interrupt!\n"));
+			/* Acknowledge in MFP circuit */
+			MFP_InputOnChannel ( MFP_INT_ACIA , 0 );
+			MidiStatusRegister |= ACIA_SR_INTERRUPT_REQUEST;
 		}
+		MidiStatusRegister |= ACIA_SR_RX_FULL;
+		/* GPIP I4 - General Purpose Pin Keyboard/MIDI interrupt:
+		 * It will remain low(0) until data is read from $fffc06. */
+		MFP_GPIP &= ~0x10;
 	}
 
-	CycInt_AddRelativeInterrupt(2050, INT_CPU_CYCLE, INTERRUPT_MIDI);
+	/* continue while there's something to send or receive */
+	Midi_StartTimer();
 }
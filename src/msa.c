@@ -113,6 +113,60 @@ bool MSA_FileNameIsMSA(const char *pszFileName, bool bAllowGZ)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Uncompress one .MSA track (starting with its data length word) into
+ * 'pImageBuffer' which has room for 'nBytesPerTrack' bytes.
+ * Return pointer to the next track in the .MSA data.
+ */
+Uint8 *MSA_UnCompressTrack(Uint8 *pMSAImageBuffer, Uint8 *pImageBuffer, int nBytesPerTrack)
+{
+	Uint8 Byte,Data;
+	int i,DataLength,NumBytesUnCompressed,RunLength;
+
+	/* Uncompress MSA Track, first check if is not compressed */
+	DataLength = do_get_mem_word(pMSAImageBuffer);
+	pMSAImageBuffer += sizeof(short int);
+	if (DataLength == nBytesPerTrack)
+	{
+		/* No compression on track, simply copy and continue */
+		memcpy(pImageBuffer, pMSAImageBuffer, nBytesPerTrack);
+		pMSAImageBuffer += DataLength;
+	}
+	else
+	{
+		/* Uncompress track */
+		NumBytesUnCompressed = 0;
+		while (NumBytesUnCompressed < nBytesPerTrack)
+		{
+			Byte = *pMSAImageBuffer++;
+			if (Byte != 0xE5)                 /* Compressed header?? */
+			{
+				*pImageBuffer++ = Byte;       /* No, just copy byte */
+				NumBytesUnCompressed++;
+			}
+			else
+			{
+				Data = *pMSAImageBuffer++;    /* Byte to copy */
+				RunLength = do_get_mem_word(pMSAImageBuffer);  /* For length */
+				/* Limit length to size of track, incorrect images may overflow */
+				if (RunLength+NumBytesUnCompressed > nBytesPerTrack)
+				{
+					fprintf(stderr, "MSA_UnCompress: Illegal run length -> corrupted disk image?\n");
+					RunLength = nBytesPerTrack - NumBytesUnCompressed;
+				}
+				pMSAImageBuffer += sizeof(short int);
+				for (i = 0; i < RunLength; i++)
+					*pImageBuffer++ = Data;   /* Copy byte */
+				NumBytesUnCompressed += RunLength;
+			}
+		}
+	}
+
+	return pMSAImageBuffer;
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Uncompress .MSA data into a new buffer.
@@ -121,8 +175,7 @@ Uint8 *MSA_UnCompress(Uint8 *pMSAFile, long *pImageSize)
 {
 	MSAHEADERSTRUCT *pMSAHeader;
 	Uint8 *pMSAImageBuffer, *pImageBuffer;
-	Uint8 Byte,Data;
-	int i,Track,Side,DataLength,NumBytesUnCompressed,RunLength;
+	int Track,Side;
 	Uint8 *pBuffer = NULL;
 
 	*pImageSize = 0;
@@ -159,45 +212,8 @@ Uint8 *MSA_UnCompress(Uint8 *pMSAFile, long *pImageSize)
 			{
 				int nBytesPerTrack = NUMBYTESPERSECTOR*pMSAHeader->SectorsPerTrack;
 
-				/* Uncompress MSA Track, first check if is not compressed */
-				DataLength = do_get_mem_word(pMSAImageBuffer);
-				pMSAImageBuffer += sizeof(short int);
-				if (DataLength == nBytesPerTrack)
-				{
-					/* No compression on track, simply copy and continue */
-					memcpy(pImageBuffer, pMSAImageBuffer, nBytesPerTrack);
-					pImageBuffer += nBytesPerTrack;
-					pMSAImageBuffer += DataLength;
-				}
-				else
-				{
-					/* Uncompress track */
-					NumBytesUnCompressed = 0;
-					while (NumBytesUnCompressed < nBytesPerTrack)
-					{
-						Byte = *pMSAImageBuffer++;
-						if (Byte != 0xE5)                 /* Compressed header?? */
-						{
-							*pImageBuffer++ = Byte;       /* No, just copy byte */
-							NumBytesUnCompressed++;
-						}
-						else
-						{
-							Data = *pMSAImageBuffer++;    /* Byte to copy */
-							RunLength = do_get_mem_word(pMSAImageBuffer);  /* For length */
-							/* Limit length to size of track, incorrect images may overflow */
-							if (RunLength+NumBytesUnCompressed > nBytesPerTrack)
-							{
-								fprintf(stderr, "MSA_UnCompress: Illegal run length -> corrupted disk image?\n");
-								RunLength = nBytesPerTrack - NumBytesUnCompressed;
-							}
-							pMSAImageBuffer += sizeof(short int);
-							for (i = 0; i < RunLength; i++)
-								*pImageBuffer++ = Data;   /* Copy byte */
-							NumBytesUnCompressed += RunLength;
-						}
-					}
-				}
+				pMSAImageBuffer = MSA_UnCompressTrack(pMSAImageBuffer, pImageBuffer, nBytesPerTrack);
+				pImageBuffer += nBytesPerTrack;
 			}
 		}
 
@@ -238,6 +254,79 @@ Uint8 *MSA_ReadDisk(const char *pszFileName, long *pImageSize)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Load .MSA file into memory without uncompressing the tracks, so that
+ * they can be uncompressed later with MSA_UnCompressTrack() when accessed.
+ * Set the number of tracks (for all sides), the uncompressed size of
+ * one track and an array with the offset of each track in the file.
+ * Return a pointer to the file buffer, NULL if failed.
+ */
+Uint8 *MSA_ReadDiskTracks(const char *pszFileName, int *pnTracks,
+                          int *pnBytesPerTrack, Uint32 **ppTrackOffsets)
+{
+	MSAHEADERSTRUCT *pMSAHeader;
+	Uint8 *pMsaFile;
+	Uint32 *pTrackOffsets;
+	long nFileSize, Offset;
+	int nTracks, nBytesPerTrack, DataLength, i;
+
+	pMsaFile = File_Read(pszFileName, &nFileSize, NULL);
+	if (!pMsaFile)
+		return NULL;
+
+	pMSAHeader = (MSAHEADERSTRUCT *)pMsaFile;
+	if (nFileSize < (long)sizeof(MSAHEADERSTRUCT)
+	    || pMSAHeader->ID != SDL_SwapBE16(0x0E0F))
+	{
+		free(pMsaFile);
+		return NULL;
+	}
+
+	nBytesPerTrack = NUMBYTESPERSECTOR * SDL_SwapBE16(pMSAHeader->SectorsPerTrack);
+	nTracks = (SDL_SwapBE16(pMSAHeader->EndingTrack) - SDL_SwapBE16(pMSAHeader->StartingTrack) + 1)
+	          * (SDL_SwapBE16(pMSAHeader->Sides) + 1);
+	if (nBytesPerTrack <= 0 || nTracks <= 0)
+	{
+		free(pMsaFile);
+		return NULL;
+	}
+
+	pTrackOffsets = malloc(nTracks * sizeof(Uint32));
+	if (!pTrackOffsets)
+	{
+		perror("MSA_ReadDiskTracks");
+		free(pMsaFile);
+		return NULL;
+	}
+
+	/* Find where each track starts by skipping over the data of the previous ones */
+	Offset = sizeof(MSAHEADERSTRUCT);
+	for (i = 0; i < nTracks; i++)
+	{
+		if (Offset + 2 > nFileSize)
+			break;
+		DataLength = do_get_mem_word(pMsaFile + Offset);
+		if (DataLength > nBytesPerTrack || Offset + 2 + DataLength > nFileSize)
+			break;
+		pTrackOffsets[i] = Offset;
+		Offset += 2 + DataLength;
+	}
+	if (i < nTracks)
+	{
+		fprintf(stderr, "MSA_ReadDiskTracks: track %d is truncated -> corrupted disk image?\n", i);
+		free(pTrackOffsets);
+		free(pMsaFile);
+		return NULL;
+	}
+
+	*pnTracks = nTracks;
+	*pnBytesPerTrack = nBytesPerTrack;
+	*ppTrackOffsets = pTrackOffsets;
+	return pMsaFile;
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Return number of bytes of the same byte in the passed buffer
@@ -282,21 +371,98 @@ static int MSA_FindRunOfBytes(Uint8 *pBuffer, int nBytesInBuffer)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Compress one track of 'nBytesPerTrack' bytes to 'pMSABuffer' (including
+ * the data length word). Return pointer after the compressed track.
+ */
+static Uint8 *MSA_CompressTrack(Uint8 *pMSABuffer, Uint8 *pImageBuffer, int nBytesPerTrack)
+{
+	Uint8 *pMSADataLength, *pTrackStart;
+	int nCompressedBytes, nBytesToGo, nBytesRun;
+
+	pTrackStart = pImageBuffer;
+
+	/* Skip data length (fill in later) */
+	pMSADataLength = pMSABuffer;
+	pMSABuffer += sizeof(Uint16);
+
+	/* Compress track */
+	nBytesToGo = nBytesPerTrack;
+	nCompressedBytes = 0;
+	while (nBytesToGo > 0)
+	{
+		nBytesRun = MSA_FindRunOfBytes(pImageBuffer,nBytesToGo);
+		if (nBytesRun == 0)
+		{
+			/* Just copy byte */
+			*pMSABuffer++ = *pImageBuffer++;
+			nCompressedBytes++;
+			nBytesRun = 1;
+		}
+		else
+		{
+			/* Store run! */
+			*pMSABuffer++ = 0xE5;               /* Marker */
+			*pMSABuffer++ = *pImageBuffer;      /* Byte, and follow with 16-bit length */
+			do_put_mem_word(pMSABuffer, nBytesRun);
+			pMSABuffer += sizeof(Uint16);
+			pImageBuffer += nBytesRun;
+			nCompressedBytes += 4;
+		}
+		nBytesToGo -= nBytesRun;
+	}
+
+	/* Is compressed track smaller than the original? */
+	if (nCompressedBytes < nBytesPerTrack)
+	{
+		/* Yes, store size */
+		do_put_mem_word(pMSADataLength, nCompressedBytes);
+	}
+	else
+	{
+		/* No, just store uncompressed track */
+		do_put_mem_word(pMSADataLength, nBytesPerTrack);
+		pMSABuffer = pMSADataLength + 2;
+		memcpy(pMSABuffer, pTrackStart, nBytesPerTrack);
+		pMSABuffer += nBytesPerTrack;
+	}
+
+	return pMSABuffer;
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Save compressed .MSA file from memory buffer. Returns true is all OK
  */
 bool MSA_WriteDisk(const char *pszFileName, Uint8 *pBuffer, int ImageSize)
+{
+	return MSA_WriteDiskTracks(pszFileName, pBuffer, ImageSize, NULL, NULL, NULL);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Save compressed .MSA file from memory buffer. If the .MSA file from which
+ * the image was loaded is given (see MSA_ReadDiskTracks()), its geometry
+ * is kept and tracks which aren't flagged with FLOPPY_TRACK_DIRTY in
+ * 'pTrackState' are copied from it as is, instead of being compressed
+ * again (such tracks don't need to be uncompressed in 'pBuffer').
+ * Returns true is all OK
+ */
+bool MSA_WriteDiskTracks(const char *pszFileName, Uint8 *pBuffer, int ImageSize,
+                         const Uint8 *pMSAFile, const Uint32 *pTrackOffsets,
+                         const Uint8 *pTrackState)
 {
 #ifdef SAVE_TO_MSA_IMAGES
 
 	MSAHEADERSTRUCT *pMSAHeader;
-	unsigned short int *pMSADataLength;
 	Uint8 *pMSAImageBuffer, *pMSABuffer, *pImageBuffer;
-	Uint16 nSectorsPerTrack, nSides, nCompressedBytes, nBytesPerTrack;
+	Uint16 nSectorsPerTrack, nSides, nBytesPerTrack;
 	bool nRet;
-	int nTracks,nBytesToGo,nBytesRun;
-	int Track,Side;
+	int nTracks, nTrackBlocks, DataLength;
+	int i;
 
 	/* Allocate workspace for compressed image */
 	pMSAImageBuffer = (Uint8 *)malloc(MSA_WORKSPACE_SIZE);
@@ -308,69 +474,42 @@ bool MSA_WriteDisk(const char *pszFileName, Uint8 *pBuffer, int ImageSize)
 
 	/* Store header */
 	pMSAHeader = (MSAHEADERSTRUCT *)pMSAImageBuffer;
-	pMSAHeader->ID = SDL_SwapBE16(0x0E0F);
-	Floppy_FindDiskDetails(pBuffer,ImageSize, &nSectorsPerTrack, &nSides);
-	pMSAHeader->SectorsPerTrack = SDL_SwapBE16(nSectorsPerTrack);
-	pMSAHeader->Sides = SDL_SwapBE16(nSides-1);
-	pMSAHeader->StartingTrack = SDL_SwapBE16(0);
-	nTracks = ((ImageSize / NUMBYTESPERSECTOR) / nSectorsPerTrack) / nSides;
-	pMSAHeader->EndingTrack = SDL_SwapBE16(nTracks-1);
-
-	/* Compress image */
+	if (pMSAFile)
+	{
+		/* Keep geometry of the original file */
+		memcpy(pMSAHeader, pMSAFile, sizeof(MSAHEADERSTRUCT));
+		nSectorsPerTrack = SDL_SwapBE16(pMSAHeader->SectorsPerTrack);
+		nSides = SDL_SwapBE16(pMSAHeader->Sides) + 1;
+		nTracks = SDL_SwapBE16(pMSAHeader->EndingTrack) - SDL_SwapBE16(pMSAHeader->StartingTrack) + 1;
+	}
+	else
+	{
+		pMSAHeader->ID = SDL_SwapBE16(0x0E0F);
+		Floppy_FindDiskDetails(pBuffer,ImageSize, &nSectorsPerTrack, &nSides);
+		pMSAHeader->SectorsPerTrack = SDL_SwapBE16(nSectorsPerTrack);
+		pMSAHeader->Sides = SDL_SwapBE16(nSides-1);
+		pMSAHeader->StartingTrack = SDL_SwapBE16(0);
+		nTracks = ((ImageSize / NUMBYTESPERSECTOR) / nSectorsPerTrack) / nSides;
+		pMSAHeader->EndingTrack = SDL_SwapBE16(nTracks-1);
+	}
+
+	/* Compress image, tracks are stored in alternating side order like in the image */
+	nBytesPerTrack = NUMBYTESPERSECTOR*nSectorsPerTrack;
+	nTrackBlocks = nTracks * nSides;
 	pMSABuffer = pMSAImageBuffer + sizeof(MSAHEADERSTRUCT);
-	for (Track = 0; Track < nTracks; Track++)
+	for (i = 0; i < nTrackBlocks; i++)
 	{
-		for (Side = 0; Side < nSides; Side++)
+		if (pMSAFile && !(pTrackState[i] & FLOPPY_TRACK_DIRTY))
 		{
-			/* Get track data pointer */
-			nBytesPerTrack = NUMBYTESPERSECTOR*nSectorsPerTrack;
-			pImageBuffer = pBuffer + (nBytesPerTrack*Side) + ((nBytesPerTrack*nSides)*Track);
-
-			/* Skip data length (fill in later) */
-			pMSADataLength = (Uint16 *)pMSABuffer;
-			pMSABuffer += sizeof(Uint16);
-
-			/* Compress track */
-			nBytesToGo = nBytesPerTrack;
-			nCompressedBytes = 0;
-			while (nBytesToGo > 0)
-			{
-				nBytesRun = MSA_FindRunOfBytes(pImageBuffer,nBytesToGo);
-				if (nBytesRun == 0)
-				{
-					/* Just copy byte */
-					*pMSABuffer++ = *pImageBuffer++;
-					nCompressedBytes++;
-					nBytesRun = 1;
-				}
-				else
-				{
-					/* Store run! */
-					*pMSABuffer++ = 0xE5;               /* Marker */
-					*pMSABuffer++ = *pImageBuffer;      /* Byte, and follow with 16-bit length */
-					do_put_mem_word(pMSABuffer, nBytesRun);
-					pMSABuffer += sizeof(Uint16);
-					pImageBuffer += nBytesRun;
-					nCompressedBytes += 4;
-				}
-				nBytesToGo -= nBytesRun;
-			}
-
-			/* Is compressed track smaller than the original? */
-			if (nCompressedBytes < nBytesPerTrack)
-			{
-				/* Yes, store size */
-				do_put_mem_word(pMSADataLength, nCompressedBytes);
-			}
-			else
-			{
-				/* No, just store uncompressed track */
-				do_put_mem_word(pMSADataLength, nBytesPerTrack);
-				pMSABuffer = ((Uint8 *)pMSADataLength) + 2;
-				pImageBuffer = pBuffer + (nBytesPerTrack*Side) + ((nBytesPerTrack*nSides)*Track);
-				memcpy(pMSABuffer,pImageBuffer, nBytesPerTrack);
-				pMSABuffer += nBytesPerTrack;
-			}
+			/* Unchanged track, copy it as it is in the original file */
+			DataLength = (pMSAFile[pTrackOffsets[i]] << 8) | pMSAFile[pTrackOffsets[i] + 1];
+			memcpy(pMSABuffer, pMSAFile + pTrackOffsets[i], 2 + DataLength);
+			pMSABuffer += 2 + DataLength;
+		}
+		else
+		{
+			pImageBuffer = pBuffer + nBytesPerTrack*i;
+			pMSABuffer = MSA_CompressTrack(pMSABuffer, pImageBuffer, nBytesPerTrack);
 		}
 	}
 
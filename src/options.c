@@ -21,6 +21,7 @@ const char Options_fileid[] = "Hatari options.c : " __DATE__ " " __TIME__;
 #include <SDL.h>
 
 #include "main.h"
+#include "benchmark.h"
 #include "version.h"
 #include "options.h"
 #include "configuration.h"
@@ -28,10 +29,14 @@ const char Options_fileid[] = "Hatari options.c : " __DATE__ " " __TIME__;
 #include "debugui.h"
 #include "file.h"
 #include "floppy.h"
+#include "hostStream.h"
+#include "inputRecord.h"
 #include "screen.h"
+#include "screenSnapShot.h"
 #include "sound.h"
 #include "video.h"
 #include "vdi.h"
+#include "vdidraw.h"
 #include "joy.h"
 #include "log.h"
 #include "tos.h"
@@ -81,7 +86,12 @@ enum {
 	OPT_VDI_PLANES,
 	OPT_VDI_WIDTH,
 	OPT_VDI_HEIGHT,
+	OPT_VDI_NATIVE,
+	OPT_VDI_RECORD,
 	OPT_SCREEN_CROP,        /* screen capture options */
+	OPT_SCREENSHOT_FORMAT,
+	OPT_FRAME_DUMP,
+	OPT_FRAME_DUMP_CHANGED,
 	OPT_AVIRECORD,
 	OPT_AVIRECORD_VCODEC,
 	OPT_AVIRECORD_FPS,
@@ -98,10 +108,12 @@ enum {
 	OPT_MIDI_OUT,
 	OPT_RS232_IN,
 	OPT_RS232_OUT,
+	OPT_RS232_TURBO,
 	OPT_DISKA,		/* disk options */
 	OPT_DISKB,
 	OPT_SLOWFLOPPY,
 	OPT_FASTFLOPPY,
+	OPT_TURBOFLOPPY,
 	OPT_WRITEPROT_FLOPPY,
 	OPT_WRITEPROT_HD,
 	OPT_GEMDOS_CASE,
@@ -111,9 +123,14 @@ enum {
 	OPT_IDESLAVEHDIMAGE,
 	OPT_MEMSIZE,		/* memory options */
 	OPT_MEMSTATE,
+	OPT_RECORD_INPUT,
+	OPT_RECORD_ANCHORS,
+	OPT_REPLAY_INPUT,
+	OPT_REPLAY_SEEK,
 	OPT_TOS,		/* ROM options */
 	OPT_PATCHTOS,
 	OPT_CARTRIDGE,
+	OPT_IKBDROM,
 	OPT_CPULEVEL,		/* CPU options */
 	OPT_CPUCLOCK,
 	OPT_COMPATIBLE,
@@ -126,9 +143,11 @@ enum {
 #endif
 	OPT_MACHINE,		/* system options */
 	OPT_BLITTER,
+	OPT_FASTBLITTER,
 	OPT_DSP,
 	OPT_TIMERD,
 	OPT_FASTBOOT,
+	OPT_SPINLOOPSKIP,
 	OPT_RTC,
 	OPT_MICROPHONE,		/* sound options */
 	OPT_SOUND,
@@ -153,6 +172,7 @@ enum {
 	OPT_LOGLEVEL,
 	OPT_ALERTLEVEL,
 	OPT_RUNVBLS,
+	OPT_BENCHMARK,
 	OPT_ERROR,
 	OPT_CONTINUE
 };
@@ -233,10 +253,20 @@ static const opt_t HatariOptions[] = {
 	  "<w>", "VDI mode width (320 < w <= 1280)" },
 	{ OPT_VDI_HEIGHT,     NULL, "--vdi-height",
 	  "<h>", "VDI mode height (200 < h <= 960)" },
+	{ OPT_VDI_NATIVE,     NULL, "--vdi-native",
+	  "<bool>", "Draw common VDI calls natively (faster)" },
+	{ OPT_VDI_RECORD,     NULL, "--vdi-record",
+	  "<file>", "Record VDI calls to <file> for benchmarking" },
 
 	{ OPT_HEADER, NULL, NULL, NULL, "Screen capture" },
 	{ OPT_SCREEN_CROP, NULL, "--crop",
 	  "<bool>", "Remove statusbar from screen capture" },
+	{ OPT_SCREENSHOT_FORMAT, NULL, "--screenshot-format",
+	  "<x>", "Screenshot file format (x = png/bmp/ppm/qoi)" },
+	{ OPT_FRAME_DUMP, NULL, "--frame-dump",
+	  "<dir>", "Save every displayed frame as screenshot to <dir>" },
+	{ OPT_FRAME_DUMP_CHANGED, NULL, "--frame-dump-changed",
+	  "<dir>", "Save displayed frames to <dir> when their contents change" },
 	{ OPT_AVIRECORD, NULL, "--avirecord",
 	  NULL, "Start AVI recording" },
 	{ OPT_AVIRECORD_VCODEC, NULL, "--avi-vcodec",
@@ -276,6 +306,8 @@ static const opt_t HatariOptions[] = {
 	  "<file>", "Enable serial port and use <file> as the input device" },
 	{ OPT_RS232_OUT, NULL, "--rs232-out",
 	  "<file>", "Enable serial port and use <file> as the output device" },
+	{ OPT_RS232_TURBO, NULL, "--rs232-turbo",
+	  "<bool>", "Receive serial port data as fast as it's read, ignoring baud rate" },
 	
 	{ OPT_HEADER, NULL, NULL, NULL, "Disk" },
 	{ OPT_DISKA, NULL, "--disk-a",
@@ -286,6 +318,8 @@ static const opt_t HatariOptions[] = {
 	  "<bool>", "Slow down floppy disk access emulation (deprecated, use --fastfdc)" },
 	{ OPT_FASTFLOPPY,   NULL, "--fastfdc",
 	  "<bool>", "Speed up floppy disk access emulation (can break some programs)" },
+	{ OPT_TURBOFLOPPY,  NULL, "--turbofdc",
+	  "<bool>", "Reduce floppy disk access delays to a minimum" },
 	{ OPT_WRITEPROT_FLOPPY, NULL, "--protect-floppy",
 	  "<x>", "Write protect floppy image contents (on/off/auto)" },
 	{ OPT_WRITEPROT_HD, NULL, "--protect-hd",
@@ -306,6 +340,14 @@ static const opt_t HatariOptions[] = {
 	  "<x>", "ST RAM size (x = size in MiB from 0 to 14, 0 = 512KiB)" },
 	{ OPT_MEMSTATE,   NULL, "--memstate",
 	  "<file>", "Load memory snap-shot <file>" },
+	{ OPT_RECORD_INPUT, NULL, "--record-input",
+	  "<file>", "Record emulation input to <file> for replaying" },
+	{ OPT_RECORD_ANCHORS, NULL, "--record-anchors",
+	  "<x>", "Save snap-shot anchors every <x> secs (0 = only at start)" },
+	{ OPT_REPLAY_INPUT, NULL, "--replay-input",
+	  "<file>", "Replay emulation input from <file>" },
+	{ OPT_REPLAY_SEEK, NULL, "--replay-seek",
+	  "<x>", "Start replay from <x> secs into the recording" },
 
 	{ OPT_HEADER, NULL, NULL, NULL, "ROM" },
 	{ OPT_TOS,       "-t", "--tos",
@@ -314,6 +356,8 @@ static const opt_t HatariOptions[] = {
 	  "<bool>", "Apply TOS patches (experts only, leave it enabled!)" },
 	{ OPT_CARTRIDGE, NULL, "--cartridge",
 	  "<file>", "Use ROM cartridge image <file>" },
+	{ OPT_IKBDROM, NULL, "--ikbd-rom",
+	  "<file>", "Run IKBD ROM image <file> on the 6301 core ('none' = off)" },
 
 	{ OPT_HEADER, NULL, NULL, NULL, "CPU" },
 	{ OPT_CPULEVEL,  NULL, "--cpulevel",
@@ -342,12 +386,16 @@ static const opt_t HatariOptions[] = {
 	  "<x>", "Select machine type (x = st/ste/tt/falcon)" },
 	{ OPT_BLITTER,   NULL, "--blitter",
 	  "<bool>", "Use blitter emulation (ST only)" },
+	{ OPT_FASTBLITTER,   NULL, "--fast-blitter",
+	  "<bool>", "Faster, but less cycle accurate blitter emulation" },
 	{ OPT_DSP,       NULL, "--dsp",
 	  "<x>", "DSP emulation (x = none/dummy/emu, Falcon only)" },
 	{ OPT_TIMERD,    NULL, "--timer-d",
 	  "<bool>", "Patch Timer-D (about doubles ST emulation speed)" },
 	{ OPT_FASTBOOT, NULL, "--fast-boot",
 	  "<bool>", "Patch TOS and memvalid system variables for faster boot" },
+	{ OPT_SPINLOOPSKIP, NULL, "--spinloop-skip",
+	  "<bool>", "Fast-forward RAM polling loops (old UAE CPU core, --compatible)" },
 	{ OPT_RTC,    NULL, "--rtc",
 	  "<bool>", "Enable real-time clock" },
 
@@ -400,6 +448,8 @@ static const opt_t HatariOptions[] = {
 	  "<x>", "Show dialog for log messages above given level" },
 	{ OPT_RUNVBLS, NULL, "--run-vbls",
 	  "<x>", "Exit after x VBLs" },
+	{ OPT_BENCHMARK, NULL, "--benchmark",
+	  "<file>", "Save emulation speed & subsystem CPU times to <file> on exit" },
 
 	{ OPT_ERROR, NULL, NULL, NULL, NULL }
 };
@@ -1062,6 +1112,38 @@ bool Opt_ParseParameters(int argc, const char * const argv[])
 			ok = Opt_Bool(argv[++i], OPT_SCREEN_CROP, &ConfigureParams.Screen.bCrop);
 			break;
 
+		case OPT_SCREENSHOT_FORMAT:
+			i += 1;
+			if (strcasecmp(argv[i], "png") == 0)
+			{
+#if HAVE_LIBPNG
+				ConfigureParams.Video.ScreenShotFormat = SCREENSHOT_FORMAT_PNG;
+#else
+				return Opt_ShowError(OPT_SCREENSHOT_FORMAT, argv[i], "Hatari built without PNG support");
+#endif
+			}
+			else if (strcasecmp(argv[i], "bmp") == 0)
+				ConfigureParams.Video.ScreenShotFormat = SCREENSHOT_FORMAT_BMP;
+			else if (strcasecmp(argv[i], "ppm") == 0)
+				ConfigureParams.Video.ScreenShotFormat = SCREENSHOT_FORMAT_PPM;
+			else if (strcasecmp(argv[i], "qoi") == 0)
+				ConfigureParams.Video.ScreenShotFormat = SCREENSHOT_FORMAT_QOI;
+			else
+				return Opt_ShowError(OPT_SCREENSHOT_FORMAT, argv[i], "Unknown screenshot format");
+			break;
+
+		case OPT_FRAME_DUMP:
+			i += 1;
+			if (!File_DirExists(argv[i]) || !ScreenSnapShot_SetFrameDump(argv[i], false))
+				return Opt_ShowError(OPT_FRAME_DUMP, argv[i], "Given frame dump directory doesn't exist");
+			break;
+
+		case OPT_FRAME_DUMP_CHANGED:
+			i += 1;
+			if (!File_DirExists(argv[i]) || !ScreenSnapShot_SetFrameDump(argv[i], true))
+				return Opt_ShowError(OPT_FRAME_DUMP_CHANGED, argv[i], "Given frame dump directory doesn't exist");
+			break;
+
 		case OPT_AVIRECORD:
 			AviRecordOnStartup = true;
 			break;
@@ -1141,6 +1223,18 @@ bool Opt_ParseParameters(int argc, const char * const argv[])
 			bLoadAutoSave = false;
 			break;
 
+		case OPT_VDI_NATIVE:
+			ok = Opt_Bool(argv[++i], OPT_VDI_NATIVE, &ConfigureParams.Screen.bVdiNativeDraw);
+			break;
+
+		case OPT_VDI_RECORD:
+			i++;
+			if (!VDIDraw_SetRecordFile(argv[i]))
+			{
+				return Opt_ShowError(OPT_VDI_RECORD, argv[i], "Invalid VDI record file name");
+			}
+			break;
+
 			/* devices options */
 		case OPT_JOYSTICK:
 			i++;
@@ -1188,7 +1282,8 @@ bool Opt_ParseParameters(int argc, const char * const argv[])
 
 		case OPT_MIDI_IN:
 			i += 1;
-			ok = Opt_StrCpy(OPT_MIDI_IN, true, ConfigureParams.Midi.sMidiInFileName,
+			ok = Opt_StrCpy(OPT_MIDI_IN, !HostStream_IsEndpoint(argv[i]),
+					ConfigureParams.Midi.sMidiInFileName,
 					argv[i], sizeof(ConfigureParams.Midi.sMidiInFileName),
 					&ConfigureParams.Midi.bEnableMidi);
 			break;
@@ -1202,7 +1297,8 @@ bool Opt_ParseParameters(int argc, const char * const argv[])
       
 		case OPT_RS232_IN:
 			i += 1;
-			ok = Opt_StrCpy(OPT_RS232_IN, true, ConfigureParams.RS232.szInFileName,
+			ok = Opt_StrCpy(OPT_RS232_IN, !HostStream_IsEndpoint(argv[i]),
+					ConfigureParams.RS232.szInFileName,
 					argv[i], sizeof(ConfigureParams.RS232.szInFileName),
 					&ConfigureParams.RS232.bEnableRS232);
 			break;
@@ -1214,6 +1310,10 @@ bool Opt_ParseParameters(int argc, const char * const argv[])
 					&ConfigureParams.RS232.bEnableRS232);
 			break;
 
+		case OPT_RS232_TURBO:
+			ok = Opt_Bool(argv[++i], OPT_RS232_TURBO, &ConfigureParams.RS232.bTurbo);
+			break;
+
 			/* disk options */
 		case OPT_DISKA:
 			i += 1;
@@ -1243,6 +1343,10 @@ bool Opt_ParseParameters(int argc, const char * const argv[])
 			ok = Opt_Bool(argv[++i], OPT_FASTFLOPPY, &ConfigureParams.DiskImage.FastFloppy);
 			break;
 
+		case OPT_TURBOFLOPPY:
+			ok = Opt_Bool(argv[++i], OPT_TURBOFLOPPY, &ConfigureParams.DiskImage.TurboFloppy);
+			break;
+
 		case OPT_WRITEPROT_FLOPPY:
 			i += 1;
 			if (strcasecmp(argv[i], "off") == 0)
@@ -1367,6 +1471,18 @@ bool Opt_ParseParameters(int argc, const char * const argv[])
 			}
 			break;
 
+		case OPT_IKBDROM:
+			i += 1;
+			if (strcasecmp(argv[i], "none") == 0)
+			{
+				ConfigureParams.Rom.szIkbdRomFileName[0] = '\0';
+				break;
+			}
+			ok = Opt_StrCpy(OPT_IKBDROM, true, ConfigureParams.Rom.szIkbdRomFileName,
+					argv[i], sizeof(ConfigureParams.Rom.szIkbdRomFileName),
+					NULL);
+			break;
+
 		case OPT_MEMSTATE:
 			i += 1;
 			ok = Opt_StrCpy(OPT_MEMSTATE, true, ConfigureParams.Memory.szMemoryCaptureFileName,
@@ -1379,6 +1495,38 @@ bool Opt_ParseParameters(int argc, const char * const argv[])
 			}
 			break;
 
+		case OPT_RECORD_INPUT:
+			i++;
+			if (!InputRecord_SetRecordFile(argv[i]))
+			{
+				return Opt_ShowError(OPT_RECORD_INPUT, argv[i], "Invalid input record file name or replay already set");
+			}
+			break;
+
+		case OPT_RECORD_ANCHORS:
+			i++;
+			if (!InputRecord_SetAnchorInterval(atoi(argv[i])))
+			{
+				return Opt_ShowError(OPT_RECORD_ANCHORS, argv[i], "Invalid anchor interval");
+			}
+			break;
+
+		case OPT_REPLAY_INPUT:
+			i++;
+			if (!InputRecord_SetReplayFile(argv[i]))
+			{
+				return Opt_ShowError(OPT_REPLAY_INPUT, argv[i], "Input recording missing or recording already set");
+			}
+			break;
+
+		case OPT_REPLAY_SEEK:
+			i++;
+			if (!InputRecord_SetSeek(atoi(argv[i])))
+			{
+				return Opt_ShowError(OPT_REPLAY_SEEK, argv[i], "Invalid replay seek position");
+			}
+			break;
+
 			/* CPU options */
 		case OPT_CPULEVEL:
 			/* UAE core uses cpu_level variable */
@@ -1514,6 +1662,10 @@ bool Opt_ParseParameters(int argc, const char * const argv[])
 			}
 			break;
 
+		case OPT_FASTBLITTER:
+			ok = Opt_Bool(argv[++i], OPT_FASTBLITTER, &ConfigureParams.System.bFastBlitter);
+			break;
+
 		case OPT_TIMERD:
 			ok = Opt_Bool(argv[++i], OPT_TIMERD, &ConfigureParams.System.bPatchTimerD);
 			break;
@@ -1521,6 +1673,10 @@ bool Opt_ParseParameters(int argc, const char * const argv[])
 			ok = Opt_Bool(argv[++i], OPT_FASTBOOT, &ConfigureParams.System.bFastBoot);
 			break;
 
+		case OPT_SPINLOOPSKIP:
+			ok = Opt_Bool(argv[++i], OPT_SPINLOOPSKIP, &ConfigureParams.System.bSpinLoopSkip);
+			break;
+
 		case OPT_RTC:
 			ok = Opt_Bool(argv[++i], OPT_RTC, &ConfigureParams.System.bRealTimeClock);
 			break;
@@ -1754,6 +1910,14 @@ bool Opt_ParseParameters(int argc, const char * const argv[])
 		case OPT_RUNVBLS:
 			Main_SetRunVBLs(atol(argv[++i]));
 			break;
+
+		case OPT_BENCHMARK:
+			i++;
+			if (!Benchmark_SetOutputFile(argv[i]))
+			{
+				return Opt_ShowError(OPT_BENCHMARK, argv[i], "Invalid benchmark results file name");
+			}
+			break;
 		       
 		case OPT_ERROR:
 			/* unknown option or missing option parameter */
@@ -0,0 +1,153 @@
+/*
+  Hatari - qoi.c
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  Encoder for the QOI ("Quite OK Image") format used for screenshots and
+  frame dumps, see https://qoiformat.org/qoi-specification.pdf
+
+  Images are encoded a line of RGB pixels at the time.  All pixels are
+  opaque, but the color index still tracks alpha like the decoder does:
+  its entries start as (0,0,0,0) and so never match an opaque color
+  before they've been set.
+*/
+const char Qoi_fileid[] = "Hatari qoi.c : " __DATE__ " " __TIME__;
+
+#include "main.h"
+#include "qoi.h"
+
+#define QOI_OP_INDEX	0x00
+#define QOI_OP_DIFF	0x40
+#define QOI_OP_LUMA	0x80
+#define QOI_OP_RUN	0xc0
+#define QOI_OP_RGB	0xfe
+
+#define QOI_MAX_RUN	62
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Write QOI file header for an RGB image of given size.
+ * Return true for success.
+ */
+bool Qoi_WriteHeader(FILE *fp, int width, int height)
+{
+	Uint8 header[14] = { 'q', 'o', 'i', 'f' };
+	int i;
+
+	/* big endian width & height, RGB channels, sRGB */
+	for (i = 0; i < 4; i++)
+	{
+		header[4 + i] = width >> (24 - 8 * i);
+		header[8 + i] = height >> (24 - 8 * i);
+	}
+	header[12] = 3;
+	header[13] = 0;
+	return fwrite(header, sizeof(header), 1, fp) == 1;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Initialize encoder state for a new image
+ */
+void Qoi_InitEncoder(QOI_ENCODER *enc)
+{
+	memset(enc->index, 0, sizeof(enc->index));
+	/* previous pixel starts as opaque black */
+	memset(enc->prev, 0, sizeof(enc->prev));
+	enc->run = 0;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Encode 'width' RGB pixels from 'px' to 'out', which needs to have
+ * space for QOI_LINE_BYTES(width) bytes.  A run of pixels can continue
+ * to the next line, so it's written only when it ends.
+ * Return number of bytes written to 'out'.
+ */
+int Qoi_EncodeLine(QOI_ENCODER *enc, const Uint8 *px, int width, Uint8 *out)
+{
+	Uint8 *start = out;
+	Uint8 *prev = enc->prev;
+	Uint8 *entry;
+	signed char dr, dg, db, dr_dg, db_dg;
+	int x;
+
+	for (x = 0; x < width; x++, px += 3)
+	{
+		if (px[0] == prev[0] && px[1] == prev[1] && px[2] == prev[2])
+		{
+			if (++enc->run == QOI_MAX_RUN)
+			{
+				*out++ = QOI_OP_RUN | (enc->run - 1);
+				enc->run = 0;
+			}
+			continue;
+		}
+		if (enc->run)
+		{
+			*out++ = QOI_OP_RUN | (enc->run - 1);
+			enc->run = 0;
+		}
+
+		/* alpha is always 255 */
+		entry = enc->index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + 255 * 11) % 64];
+		if (entry[0] == px[0] && entry[1] == px[1] && entry[2] == px[2] && entry[3] == 255)
+		{
+			*out++ = QOI_OP_INDEX | (entry - enc->index[0]) / 4;
+		}
+		else
+		{
+			entry[0] = px[0];
+			entry[1] = px[1];
+			entry[2] = px[2];
+			entry[3] = 255;
+			dr = px[0] - prev[0];
+			dg = px[1] - prev[1];
+			db = px[2] - prev[2];
+			dr_dg = dr - dg;
+			db_dg = db - dg;
+			if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+			{
+				*out++ = QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+			}
+			else if (dg >= -32 && dg <= 31 && dr_dg >= -8 && dr_dg <= 7 && db_dg >= -8 && db_dg <= 7)
+			{
+				*out++ = QOI_OP_LUMA | (dg + 32);
+				*out++ = (dr_dg + 8) << 4 | (db_dg + 8);
+			}
+			else
+			{
+				*out++ = QOI_OP_RGB;
+				*out++ = px[0];
+				*out++ = px[1];
+				*out++ = px[2];
+			}
+		}
+		prev[0] = px[0];
+		prev[1] = px[1];
+		prev[2] = px[2];
+	}
+	return out - start;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Write the pending pixel run and the QOI end marker.
+ * Return true for success.
+ */
+bool Qoi_WriteEnd(QOI_ENCODER *enc, FILE *fp)
+{
+	static const Uint8 trailer[] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+	if (enc->run)
+	{
+		fputc(QOI_OP_RUN | (enc->run - 1), fp);
+		enc->run = 0;
+	}
+	return fwrite(trailer, sizeof(trailer), 1, fp) == 1;
+}
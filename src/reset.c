@@ -24,6 +24,7 @@ const char Reset_fileid[] = "Hatari reset.c : " __DATE__ " " __TIME__;
 #include "midi.h"
 #include "psg.h"
 #include "reset.h"
+#include "rs232.h"
 #include "screen.h"
 #include "sound.h"
 #include "stMemory.h"
@@ -89,6 +90,7 @@ static int Reset_ST(bool bCold)
 	DebugDsp_SetDebugging();
 
 	Midi_Reset();
+	RS232_Reset();
 
 	/* Start HBL, Timer B and VBL interrupts with a 0 cycle delay */
 	Video_StartInterrupts( 0 );
@@ -9,9 +9,17 @@
   This is similar to the printing functions, we open a direct file
   (e.g. /dev/ttyS0) and send bytes over it.
   Using such method mimicks the ST exactly, and even allows us to connect
-  to an actual ST! To wait for incoming data, we create a thread which copies
-  the bytes into an input buffer. This method fits in with the internet code
-  which also reads data into a buffer.
+  to an actual ST! Instead of a device, a TCP or Unix socket or a pseudo
+  terminal can be used too (see hostStream.c).
+
+  Incoming data is polled on the emulation thread at the speed of one
+  character at the current baud rate: available host bytes are read
+  at once into a ring buffer, from which one byte is moved to the MFP
+  USART receive buffer when it's empty.  In turbo mode, next byte is
+  received as soon as the previous one is read from UDR, regardless
+  of the baud rate.  Outgoing bytes are buffered and written to the host
+  without blocking on the same polling interrupt.  While the output buffer
+  is full, the USART transmit buffer isn't reported as empty.
 */
 const char RS232_fileid[] = "Hatari rs232.c : " __DATE__ " " __TIME__;
 
@@ -22,14 +30,15 @@ const char RS232_fileid[] = "Hatari rs232.c : " __DATE__ " " __TIME__;
 # include <unistd.h>
 #endif
 
-#include <SDL.h>
-#include <SDL_thread.h>
 #include <errno.h>
 
 #include "main.h"
 #include "configuration.h"
+#include "cycInt.h"
+#include "hostStream.h"
 #include "ioMem.h"
 #include "m68000.h"
+#include "inputRecord.h"
 #include "mfp.h"
 #include "rs232.h"
 
@@ -43,11 +52,23 @@ const char RS232_fileid[] = "Hatari rs232.c : " __DATE__ " " __TIME__;
 #endif
 
 
-static FILE *hComIn = NULL;        /* Handle to file for reading */
-static FILE *hComOut = NULL;       /* Handle to file for writing */
+/* Polling interval in turbo mode, in CPU cycles at 8 MHz (1 ms) */
+#define RS232_TURBO_POLL_CYCLES  8000
+
+static HOSTSTREAM ComIn = HOSTSTREAM_INIT;      /* Stream for reading */
+static HOSTSTREAM ComOut = HOSTSTREAM_INIT;     /* Stream for writing */
+static HOSTSTREAM *pComOut = &ComOut;           /* &ComIn if they're the same socket/pty */
 
 static unsigned char InputBuffer_RS232[MAX_RS232INPUT_BUFFER];
 static int InputBuffer_Head=0, InputBuffer_Tail=0;
+static unsigned char OutputBuffer_RS232[MAX_RS232OUTPUT_BUFFER];
+static int nOutputBytes;
+
+static bool bRxFull;               /* Byte waiting in USART receive buffer */
+static Uint8 RxByte;               /* ...and its value */
+
+static int nCurrentBaud = 9600;    /* Current baud rate */
+static int nCharBits = 10;         /* Start, data, parity and stop bits per character */
 
 
 #if HAVE_TERMIOS_H
@@ -101,13 +122,11 @@ int cfsetispeed(struct termios *tios,speed_t ispeed)
 /**
  * Set serial line parameters to "raw" mode.
  */
-static bool RS232_SetRawMode(FILE *fhndl)
+static bool RS232_SetRawMode(int fd)
 {
 	struct termios termmode;
-	int fd;
 
 	memset (&termmode, 0, sizeof(termmode));    /* Init with zeroes */
-	fd = fileno(fhndl);                         /* Get file descriptor */
 
 	if (isatty(fd))
 	{
@@ -132,13 +151,11 @@ static bool RS232_SetRawMode(FILE *fhndl)
  * - Parity
  * - Start/stop bits
  */
-static bool RS232_SetBitsConfig(FILE *fhndl, int nCharSize, int nStopBits, bool bUseParity, bool bEvenParity)
+static bool RS232_SetBitsConfig(int fd, int nCharSize, int nStopBits, bool bUseParity, bool bEvenParity)
 {
 	struct termios termmode;
-	int fd;
 
 	memset (&termmode, 0, sizeof(termmode));    /* Init with zeroes */
-	fd = fileno(fhndl);
 
 	if (isatty(fd))
 	{
@@ -197,16 +214,31 @@ static bool RS232_OpenCOMPort(void)
 {
 	bool ok = true;
 
-	if (!hComOut && ConfigureParams.RS232.szOutFileName[0])
+	/* Same socket or pseudo terminal for both directions? */
+	if (!HostStream_IsOpen(&ComIn) &&
+	    HostStream_IsEndpoint(ConfigureParams.RS232.szInFileName) &&
+	    strcmp(ConfigureParams.RS232.szInFileName, ConfigureParams.RS232.szOutFileName) == 0)
+	{
+		if (!HostStream_Open(&ComIn, ConfigureParams.RS232.szInFileName, HOSTSTREAM_READWRITE))
+		{
+			Log_Printf(LOG_WARN, "RS232: Failed to open %s\n",
+				   ConfigureParams.RS232.szInFileName);
+			return false;
+		}
+		pComOut = &ComIn;
+		Dprintf(("Successfully opened RS232 input/output stream.\n"));
+		return true;
+	}
+
+	if (!HostStream_IsOpen(pComOut) && ConfigureParams.RS232.szOutFileName[0])
 	{
 		/* Create our COM file for output */
-		hComOut = fopen(ConfigureParams.RS232.szOutFileName, "wb");
-		if (hComOut)
+		pComOut = &ComOut;
+		if (HostStream_Open(&ComOut, ConfigureParams.RS232.szOutFileName, HOSTSTREAM_WRITE))
 		{
-			setvbuf(hComOut, NULL, _IONBF, 0);
 #if HAVE_TERMIOS_H
 			/* First set the output parameters to "raw" mode */
-			if (!RS232_SetRawMode(hComOut))
+			if (ComOut.fd >= 0 && !RS232_SetRawMode(ComOut.fd))
 			{
 				Log_Printf(LOG_WARN, "Can't set raw mode for %s\n",
 					   ConfigureParams.RS232.szOutFileName);
@@ -222,16 +254,14 @@ static bool RS232_OpenCOMPort(void)
 		}
 	}
 
-	if (!hComIn && ConfigureParams.RS232.szInFileName[0])
+	if (!HostStream_IsOpen(&ComIn) && ConfigureParams.RS232.szInFileName[0])
 	{
 		/* Create our COM file for input */
-		hComIn = fopen(ConfigureParams.RS232.szInFileName, "rb");
-		if (hComIn)
+		if (HostStream_Open(&ComIn, ConfigureParams.RS232.szInFileName, HOSTSTREAM_READ))
 		{
-			setvbuf(hComIn, NULL, _IONBF, 0);
 #if HAVE_TERMIOS_H
 			/* Now set the input parameters to "raw" mode */
-			if (!RS232_SetRawMode(hComIn))
+			if (ComIn.fd >= 0 && !RS232_SetRawMode(ComIn.fd))
 			{
 				Log_Printf(LOG_WARN, "Can't set raw mode for %s\n",
 					   ConfigureParams.RS232.szInFileName);
@@ -256,93 +286,146 @@ static bool RS232_OpenCOMPort(void)
  */
 static void RS232_CloseCOMPort(void)
 {
-	if (hComIn)
-	{
-		/* Close */
-		fclose(hComIn);
-		hComIn = NULL;
-	}
-	if (hComOut)
-	{
-		fclose(hComOut);
-		hComOut = NULL;
-	}
+	HostStream_Close(&ComIn);
+	HostStream_Close(&ComOut);
+	pComOut = &ComOut;
 	Dprintf(("Closed RS232 files.\n"));
 }
 
 
-/* thread stuff */
-static SDL_sem* pSemFreeBuf;       /* Semaphore to sync free space in InputBuffer_RS232 */
-static SDL_Thread *RS232Thread = NULL; /* Thread handle for reading incoming data */
+/*-----------------------------------------------------------------------*/
+/**
+ * Start the interrupt which polls the host for input and writes the
+ * output, if there's something to poll or to write.  Interval is one
+ * character at the current baud rate.
+ */
+static void RS232_StartTimer(void)
+{
+	Sint64 nCycles;
+
+	if (!HostStream_IsOpen(&ComIn) && nOutputBytes == 0)
+		return;
+
+	if (ConfigureParams.RS232.bTurbo)
+		nCycles = RS232_TURBO_POLL_CYCLES;
+	else
+		nCycles = (Sint64)8021247 * nCharBits / nCurrentBaud;	/* for a 8 MHz STF reference */
+
+	CycInt_AddRelativeInterrupt((int)nCycles << nCpuFreqShift, INT_CPU_CYCLE, INTERRUPT_RS232);
+}
 
 
 /*-----------------------------------------------------------------------*/
 /**
- * Add incoming bytes from other machine into our input buffer
+ * Read all the bytes which are available from the host into the
+ * free space of our input buffer.
  */
-static void RS232_AddBytesToInputBuffer(unsigned char *pBytes, int nBytes)
+static void RS232_FillInputBuffer(void)
 {
-	int i;
+	int nFree, nRead;
 
-	/* Copy bytes into input buffer */
-	for (i=0; i<nBytes; i++)
+	while (HostStream_IsOpen(&ComIn))
 	{
-		SDL_SemWait(pSemFreeBuf);    /* Wait for free space in buffer */
-		InputBuffer_RS232[InputBuffer_Tail] = *pBytes++;
-		InputBuffer_Tail = (InputBuffer_Tail+1) % MAX_RS232INPUT_BUFFER;
+		/* Free contiguous space after the tail, one byte is kept
+		 * unused to tell a full buffer from an empty one */
+		if (InputBuffer_Tail >= InputBuffer_Head)
+			nFree = MAX_RS232INPUT_BUFFER - InputBuffer_Tail - (InputBuffer_Head == 0);
+		else
+			nFree = InputBuffer_Head - InputBuffer_Tail - 1;
+		if (nFree <= 0)
+			break;
+
+		nRead = HostStream_Read(&ComIn, &InputBuffer_RS232[InputBuffer_Tail], nFree);
+		if (nRead <= 0)
+			break;
+		Dprintf(("RS232: Read %d bytes\n", nRead));
+
+		InputBuffer_Tail = (InputBuffer_Tail + nRead) & (MAX_RS232INPUT_BUFFER-1);
+		if (nRead < nFree)
+			break;
 	}
 }
 
 
 /*-----------------------------------------------------------------------*/
 /**
- * Thread to read incoming RS-232 data, and pass to emulator input buffer
+ * Move next byte from our input buffer to the USART receive buffer
+ * if it's empty, and raise the receive buffer full interrupt.
  */
-static int RS232_ThreadFunc(void *pData)
+static void RS232_ReceiveByte(void)
 {
-	int iInChar;
-	unsigned char cInChar;
+	if (bRxFull)
+		return;
+
+	if (InputBuffer_Head == InputBuffer_Tail)
+		RS232_FillInputBuffer();
+	if (InputBuffer_Head == InputBuffer_Tail)
+		return;
+
+	RxByte = InputBuffer_RS232[InputBuffer_Head];
+	InputBuffer_Head = (InputBuffer_Head+1) & (MAX_RS232INPUT_BUFFER-1);
+	bRxFull = true;
+	Dprintf(("RS232: Received character $%x\n", RxByte));
+
+	/* (input recording raises the interrupt itself
+	 * at deterministic points in emulation) */
+	if (!InputRecord_IsActive())
+		MFP_InputOnChannel ( MFP_INT_RCV_BUF_FULL , 0 );
+}
+
 
-	/* Check for any RS-232 incoming data */
-	while (true)
+/*-----------------------------------------------------------------------*/
+/**
+ * Write the buffered output bytes to the host.  What the host doesn't
+ * accept without blocking is kept for the next flush.  If the buffer was
+ * full and there's now space for more, raise the transmit buffer empty
+ * interrupt that RS232_TransferBytesTo() withheld.
+ */
+static void RS232_FlushOutput(void)
+{
+	bool bWasFull = (nOutputBytes == MAX_RS232OUTPUT_BUFFER);
+	int nWritten;
+
+	if (nOutputBytes == 0)
+		return;
+
+	nWritten = HostStream_TryWrite(pComOut, OutputBuffer_RS232, nOutputBytes);
+	if (nWritten < 0)
 	{
-		if (hComIn)
-		{
-			/* Read the bytes in, if we have any */
-			iInChar = fgetc(hComIn);
-			if (iInChar != EOF)
-			{
-				/* Copy into our internal queue */
-				cInChar = iInChar;
-				RS232_AddBytesToInputBuffer(&cInChar, 1);
-				/* FIXME: Use semaphores to lock MFP variables? */
-				MFP_InputOnChannel ( MFP_INT_RCV_BUF_FULL , 0 );
-				Dprintf(("RS232: Read character $%x\n", iInChar));
-				/* Sleep for a while */
-				SDL_Delay(2);
-			}
-			else
-			{
-				/*Dprintf(("RS232: Reached end of input file!\n"));*/
-				/* potential data race on hComIn modification */
-				clearerr(hComIn);
-				SDL_Delay(20);
-			}
-		}
-		else
-		{
-			/* No RS-232 connection, sleep for 0.2s */
-			SDL_Delay(200);
-		}
+		/* no receiver */
+		Dprintf(("RS232: Failed to write %d bytes\n", nOutputBytes));
+		nWritten = nOutputBytes;
 	}
+	nOutputBytes -= nWritten;
+	if (nOutputBytes)
+		memmove(OutputBuffer_RS232, OutputBuffer_RS232 + nWritten, nOutputBytes);
 
-	return true;
+	if (bWasFull && nWritten > 0)
+		MFP_InputOnChannel ( MFP_INT_TRN_BUF_EMPTY , 0 );
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Write output to the host and receive input from it, called
+ * at the speed of one character at the current baud rate.
+ */
+void RS232_InterruptHandler(void)
+{
+	/* Remove this interrupt from list and re-order */
+	CycInt_AcknowledgeInterrupt();
+
+	RS232_FlushOutput();
+	RS232_FillInputBuffer();
+	RS232_ReceiveByte();
+
+	RS232_StartTimer();
 }
 
 
 /*-----------------------------------------------------------------------*/
 /**
- * Initialize RS-232, start thread to wait for incoming data
+ * Initialize RS-232, open the input/output files and start polling them
  * (we will open a connection when first bytes are sent even
  *  if RS-232 isn't initialized for reading).
  */
@@ -358,25 +441,18 @@ void RS232_Init(void)
 			return;
 		}
 	}
-	if (hComIn)
-	{
-		/* Create semaphore */
-		if (pSemFreeBuf == NULL)
-			pSemFreeBuf = SDL_CreateSemaphore(MAX_RS232INPUT_BUFFER);
-		if (pSemFreeBuf == NULL)
-		{
-			RS232_CloseCOMPort();
-			Log_Printf(LOG_WARN, "RS232_Init: Can't create semaphore!\n");
-			return;
-		}
+	RS232_StartTimer();
+}
 
-		/* Create thread to wait for incoming bytes over RS-232 */
-		if (!RS232Thread)
-		{
-			RS232Thread = SDL_CreateThread(RS232_ThreadFunc, NULL);
-			Dprintf(("RS232 thread has been created.\n"));
-		}
-	}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Reset RS-232 emulation, restart polling after the interrupts were reset.
+ */
+void RS232_Reset(void)
+{
+	bRxFull = false;
+	RS232_StartTimer();
 }
 
 
@@ -386,26 +462,14 @@ void RS232_Init(void)
  */
 void RS232_UnInit(void)
 {
-	/* Close, kill thread and free resource */
-	if (RS232Thread)
-	{
-		/* Instead of killing the thread directly, we should
-		 * probably better inform it via IPC so that it can
-		 * terminate gracefully... but then we would need to
-		 * wait until it exits, otherwise there's a data race
-		 * on accessing/modifying hComIn.
-		 */
-		Dprintf(("Killing RS232 thread...\n"));
-		SDL_KillThread(RS232Thread);
-		RS232Thread = NULL;
-	}
+	/* write what the host accepts without blocking, drop the rest */
+	RS232_FlushOutput();
+	nOutputBytes = 0;
+	CycInt_RemovePendingInterrupt(INTERRUPT_RS232);
 	RS232_CloseCOMPort();
 
-	if (pSemFreeBuf)
-	{
-		SDL_DestroySemaphore(pSemFreeBuf);
-		pSemFreeBuf = NULL;
-	}
+	InputBuffer_Head = InputBuffer_Tail = 0;
+	bRxFull = false;
 }
 
 
@@ -441,18 +505,26 @@ void RS232_HandleUCR(Sint16 ucr)
 	Dprintf(("RS232_HandleUCR(%i) : character size=%i , stop bits=%i\n",
 	         ucr, nCharSize, nStopBits));
 
-	if (hComOut != NULL)
+	if (pComOut->fd >= 0)
 	{
-		if (!RS232_SetBitsConfig(hComOut, nCharSize, nStopBits, ucr&4, ucr&2))
+		if (!RS232_SetBitsConfig(pComOut->fd, nCharSize, nStopBits, ucr&4, ucr&2))
 			Log_Printf(LOG_WARN, "RS232_HandleUCR: failed to set bits configuration for %s\n", ConfigureParams.RS232.szOutFileName);
 	}
 
-	if (hComIn != NULL)
+	if (ComIn.fd >= 0 && pComOut != &ComIn)
 	{
-		if (!RS232_SetBitsConfig(hComIn, nCharSize, nStopBits, ucr&4, ucr&2))
+		if (!RS232_SetBitsConfig(ComIn.fd, nCharSize, nStopBits, ucr&4, ucr&2))
 			Log_Printf(LOG_WARN, "RS232_HandleUCR: failed to set bits configuration for %s\n", ConfigureParams.RS232.szInFileName);
 	}
 #endif /* HAVE_TERMIOS_H */
+
+	/* Character length for the receive timing (1.5 stop bits are rounded to 1) */
+	nCharBits = 1 + (8 - ((ucr >> 5) & 3)) + ((ucr & 4) ? 1 : 0);
+	switch ((ucr >> 3) & 3)
+	{
+		case 1: case 2:  nCharBits += 1;  break;
+		case 3:  nCharBits += 2;  break;
+	}
 }
 
 
@@ -491,9 +563,15 @@ bool RS232_SetBaudRate(int nBaud)
 #endif
 		{ -1, -1 }
 	};
+#endif /* HAVE_TERMIOS_H */
 
 	Dprintf(("RS232_SetBaudRate(%i)\n", nBaud));
 
+	if (nBaud > 0)
+		nCurrentBaud = nBaud;	/* Used for the receive timing */
+
+#if HAVE_TERMIOS_H
+
 	/* Convert baud number to baud termios constant: */
 	baudtype = -1;
 	for (i = 0; baudtable[i][0] != -1; i++)
@@ -512,10 +590,10 @@ bool RS232_SetBaudRate(int nBaud)
 	}
 
 	/* Set ouput speed: */
-	if (hComOut != NULL)
+	fd = pComOut->fd;
+	if (fd >= 0)
 	{
 		memset (&termmode, 0, sizeof(termmode));    /* Init with zeroes */
-		fd = fileno(hComOut);
 		if (isatty(fd))
 		{
 			if (tcgetattr(fd, &termmode) != 0)
@@ -529,10 +607,10 @@ bool RS232_SetBaudRate(int nBaud)
 	}
 
 	/* Set input speed: */
-	if (hComIn != NULL)
+	fd = ComIn.fd;
+	if (fd >= 0)
 	{
 		memset (&termmode, 0, sizeof(termmode));    /* Init with zeroes */
-		fd = fileno(hComIn);
 		if (isatty(fd))
 		{
 			if (tcgetattr(fd, &termmode) != 0)
@@ -617,49 +695,66 @@ void RS232_SetFlowControl(Sint16 ctrl)
  */
 bool RS232_TransferBytesTo(Uint8 *pBytes, int nBytes)
 {
+	int nCopy;
+
 	/* Make sure there's a RS-232 connection if it's enabled */
 	if (ConfigureParams.RS232.bEnableRS232)
 		RS232_OpenCOMPort();
 
 	/* Have we connected to the RS232? */
-	if (hComOut)
-	{
-		/* Send bytes directly to the COM file */
-		if (fwrite(pBytes, 1, nBytes, hComOut))
-		{
-			Dprintf(("RS232: Sent %i bytes ($%x ...)\n", nBytes, *pBytes));
-			MFP_InputOnChannel ( MFP_INT_TRN_BUF_EMPTY , 0 );
-
-			return true;   /* OK */
-		}
-	}
-
-	return false;  /* Failed */
+	if (!HostStream_IsOpen(pComOut))
+		return false;  /* Failed */
+
+	Dprintf(("RS232: Sent %i bytes ($%x ...)\n", nBytes, *pBytes));
+
+	/* Buffer the bytes, they're written to the host on next interrupt.
+	 * Programs should wait for the transmit buffer to become empty
+	 * while it's full, so instead of blocking emulation until the host
+	 * reads the output, bytes that don't fit are dropped.
+	 */
+	nCopy = MAX_RS232OUTPUT_BUFFER - nOutputBytes;
+	if (nCopy > nBytes)
+		nCopy = nBytes;
+	if (nCopy < nBytes)
+		Dprintf(("RS232: Output buffer full, dropped %d bytes\n", nBytes - nCopy));
+	memcpy(&OutputBuffer_RS232[nOutputBytes], pBytes, nCopy);
+	nOutputBytes += nCopy;
+
+	if (!CycInt_InterruptActive(INTERRUPT_RS232))
+		RS232_StartTimer();
+
+	/* Transmit buffer is empty only while there's space for more */
+	if (nOutputBytes < MAX_RS232OUTPUT_BUFFER)
+		MFP_InputOnChannel ( MFP_INT_TRN_BUF_EMPTY , 0 );
+
+	return true;   /* OK */
 }
 
 
 /*-----------------------------------------------------------------------*/
 /**
- * Read characters from our internal input buffer (bytes from other machine)
+ * Read characters from the USART receive buffer (bytes from other machine).
+ * In turbo mode, next byte is received immediately.
  */
 bool RS232_ReadBytes(Uint8 *pBytes, int nBytes)
 {
 	int i;
 
-	/* Connected? */
-	if (hComIn && InputBuffer_Head != InputBuffer_Tail)
+	/* Replayed input replaces the host one */
+	if (InputRecord_IsReplaying())
+		return InputRecord_RS232Data(pBytes, nBytes, false);
+
+	for (i = 0; i < nBytes && bRxFull; i++)
 	{
-		/* Read bytes out of input buffer */
-		for (i=0; i<nBytes; i++)
-		{
-			*pBytes++ = InputBuffer_RS232[InputBuffer_Head];
-			InputBuffer_Head = (InputBuffer_Head+1) % MAX_RS232INPUT_BUFFER;
-			SDL_SemPost(pSemFreeBuf);    /* Signal free space */
-		}
-		return true;
+		pBytes[i] = RxByte;
+		bRxFull = false;
+		if (ConfigureParams.RS232.bTurbo)
+			RS232_ReceiveByte();
 	}
+	if (i == 0)
+		return false;
 
-	return false;
+	return InputRecord_RS232Data(pBytes, i, i == nBytes);
 }
 
 
@@ -669,16 +764,8 @@ bool RS232_ReadBytes(Uint8 *pBytes, int nBytes)
  */
 bool RS232_GetStatus(void)
 {
-	/* Connected? */
-	if (hComIn)
-	{
-		/* Do we have bytes in the input buffer? */
-		if (InputBuffer_Head != InputBuffer_Tail)
-			return true;
-	}
-
-	/* No, none */
-	return false;
+	/* Input recording logs / replaces the status */
+	return InputRecord_RS232Status(bRxFull);
 }
 
 
@@ -760,7 +847,8 @@ void RS232_RSR_WriteByte(void)
 
 /*-----------------------------------------------------------------------*/
 /**
- * Read from the Transmitter Status Register.
+ * Read from the Transmitter Status Register.  Buffer empty bit is cleared
+ * while the host hasn't read enough of the output to have space for more.
  * When RS232 emulation is not enabled, we still return 0x80 to allow
  * some games to work when they don't require send/receive on the RS232 port
  * (eg : 'Treasure Trap', 'The Deep' write some debug informations to RS232)
@@ -769,7 +857,10 @@ void RS232_TSR_ReadByte(void)
 {
 	M68000_WaitState(4);
 
-	IoMem[0xfffa2d] |= 0x80;        /* Buffer empty */
+	if (nOutputBytes < MAX_RS232OUTPUT_BUFFER)
+		IoMem[0xfffa2d] |= 0x80;        /* Buffer empty */
+	else
+		IoMem[0xfffa2d] &= ~0x80;       /* Host hasn't read the output yet */
 
 	Dprintf(("RS232: Read from TSR: $%x\n", (int)IoMem[0xfffa2d]));
 }
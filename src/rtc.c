@@ -17,6 +17,7 @@ const char Rtc_fileid[] = "Hatari rtc.c : " __DATE__ " " __TIME__;
 #include <time.h>
 
 #include "main.h"
+#include "inputRecord.h"
 #include "ioMem.h"
 #include "rtc.h"
 
@@ -37,7 +38,7 @@ void Rtc_SecondsUnits_ReadByte(void)
 	/* Get system time */
 	nTimeTicks = time(NULL);
 	SystemTime = localtime(&nTimeTicks);
-	IoMem[0xfffc21] = SystemTime->tm_sec % 10;
+	IoMem[0xfffc21] = InputRecord_HostTime(SystemTime->tm_sec % 10);
 }
 
 
@@ -53,7 +54,7 @@ void Rtc_SecondsTens_ReadByte(void)
 	/* Get system time */
 	nTimeTicks = time(NULL);
 	SystemTime = localtime(&nTimeTicks);
-	IoMem[0xfffc23] = SystemTime->tm_sec / 10;
+	IoMem[0xfffc23] = InputRecord_HostTime(SystemTime->tm_sec / 10);
 }
 
 
@@ -75,7 +76,7 @@ void Rtc_MinutesUnits_ReadByte(void)
 		/* Get system time */
 		nTimeTicks = time(NULL);
 		SystemTime = localtime(&nTimeTicks);
-		IoMem[0xfffc25] = SystemTime->tm_min % 10;
+		IoMem[0xfffc25] = InputRecord_HostTime(SystemTime->tm_min % 10);
 	}
 }
 
@@ -111,7 +112,7 @@ void Rtc_MinutesTens_ReadByte(void)
 		/* Get system time */
 		nTimeTicks = time(NULL);
 		SystemTime = localtime(&nTimeTicks);
-		IoMem[0xfffc27] = SystemTime->tm_min / 10;
+		IoMem[0xfffc27] = InputRecord_HostTime(SystemTime->tm_min / 10);
 	}
 }
 
@@ -141,7 +142,7 @@ void Rtc_HoursUnits_ReadByte(void)
 	/* Get system time */
 	nTimeTicks = time(NULL);
 	SystemTime = localtime(&nTimeTicks);
-	IoMem[0xfffc29] = SystemTime->tm_hour % 10;
+	IoMem[0xfffc29] = InputRecord_HostTime(SystemTime->tm_hour % 10);
 }
 
 
@@ -157,7 +158,7 @@ void Rtc_HoursTens_ReadByte(void)
 	/* Get system time */
 	nTimeTicks = time(NULL);
 	SystemTime = localtime(&nTimeTicks);
-	IoMem[0xfffc2b] = SystemTime->tm_hour / 10;
+	IoMem[0xfffc2b] = InputRecord_HostTime(SystemTime->tm_hour / 10);
 }
 
 
@@ -173,7 +174,7 @@ void Rtc_Weekday_ReadByte(void)
 	/* Get system time */
 	nTimeTicks = time(NULL);
 	SystemTime = localtime(&nTimeTicks);
-	IoMem[0xfffc2d] = SystemTime->tm_wday;
+	IoMem[0xfffc2d] = InputRecord_HostTime(SystemTime->tm_wday);
 }
 
 
@@ -189,7 +190,7 @@ void Rtc_DayUnits_ReadByte(void)
 	/* Get system time */
 	nTimeTicks = time(NULL);
 	SystemTime = localtime(&nTimeTicks);
-	IoMem[0xfffc2f] = SystemTime->tm_mday % 10;
+	IoMem[0xfffc2f] = InputRecord_HostTime(SystemTime->tm_mday % 10);
 }
 
 
@@ -205,7 +206,7 @@ void Rtc_DayTens_ReadByte(void)
 	/* Get system time */
 	nTimeTicks = time(NULL);
 	SystemTime = localtime(&nTimeTicks);
-	IoMem[0xfffc31] = SystemTime->tm_mday / 10;
+	IoMem[0xfffc31] = InputRecord_HostTime(SystemTime->tm_mday / 10);
 }
 
 
@@ -221,7 +222,7 @@ void Rtc_MonthUnits_ReadByte(void)
 	/* Get system time */
 	nTimeTicks = time(NULL);
 	SystemTime = localtime(&nTimeTicks);
-	IoMem[0xfffc33] = (SystemTime->tm_mon + 1) % 10;
+	IoMem[0xfffc33] = InputRecord_HostTime((SystemTime->tm_mon + 1) % 10);
 }
 
 
@@ -237,7 +238,7 @@ void Rtc_MonthTens_ReadByte(void)
 	/* Get system time */
 	nTimeTicks = time(NULL);
 	SystemTime = localtime(&nTimeTicks);
-	IoMem[0xfffc35] = (SystemTime->tm_mon + 1) / 10;
+	IoMem[0xfffc35] = InputRecord_HostTime((SystemTime->tm_mon + 1) / 10);
 }
 
 
@@ -253,7 +254,7 @@ void Rtc_YearUnits_ReadByte(void)
 	/* Get system time */
 	nTimeTicks = time(NULL);
 	SystemTime = localtime(&nTimeTicks);
-	IoMem[0xfffc37] = SystemTime->tm_year % 10;
+	IoMem[0xfffc37] = InputRecord_HostTime(SystemTime->tm_year % 10);
 }
 
 
@@ -269,7 +270,7 @@ void Rtc_YearTens_ReadByte(void)
 	/* Get system time */
 	nTimeTicks = time(NULL);
 	SystemTime = localtime(&nTimeTicks);
-	IoMem[0xfffc39] = (SystemTime->tm_year - 80) / 10;
+	IoMem[0xfffc39] = InputRecord_HostTime((SystemTime->tm_year - 80) / 10);
 }
 
 
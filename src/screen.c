@@ -66,6 +66,7 @@ Uint32 ST2RGB[4096];          /* Table to convert ST 0x777 / STe 0xfff palette t
 
 /* extern for video.c */
 Uint8 *pSTScreen;
+Uint8 STScreenLineChanged[STSCREEN_MAX_LINES];	/* Lines which differ from previously displayed frame */
 FRAMEBUFFER *pFrameBuffer;    /* Pointer into current 'FrameBuffer' */
 
 static FRAMEBUFFER FrameBuffers[NUM_FRAMEBUFFERS]; /* Store frame buffer details to tell how to update */
@@ -90,6 +91,18 @@ static void (*ScreenDrawFunctionsVDI[3])(void) =
 };
 
 static bool bScreenContentsChanged;     /* true if buffer changed and requires blitting */
+
+/* Changed areas of the PC screen, collected by the conversion routines
+ * as one span per PC screen line and merged into rectangles for
+ * SDL_UpdateRects()
+ */
+#define MAX_DIRTY_RECTS 64
+static SDL_Rect DirtyRects[MAX_DIRTY_RECTS];
+static int nDirtyRects;
+static bool bDirtyFull;                 /* true if whole screen needs to be updated */
+static Uint8 *pDirtyLine, *pDirtyLineEnd; /* PC screen line of the current span */
+static Uint8 *pDirtyLeft, *pDirtyRight; /* ...and the changed part of it */
+static int nDirtyRows;                  /* how many PC screen lines the span covers */
 static bool bScrDoubleY;                /* true if double on Y */
 static int ScrUpdateFlag;               /* Bit mask of how to update screen */
 
@@ -633,6 +646,9 @@ void Screen_SetFullUpdate(void)
 	/* Update frame buffers */
 	for (i = 0; i < NUM_FRAMEBUFFERS; i++)
 		FrameBuffers[i].bFullUpdate = true;
+
+	/* Falcon & TT screen */
+	VIDEL_SetFullUpdate();
 }
 
 
@@ -1041,6 +1057,44 @@ static void Screen_SetConvertDetails(void)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Check whether any line of the ST screen needs to be converted, i.e.
+ * whether some line changed since the previously displayed frame or
+ * requires an update due to palette/resolution change.
+ */
+static bool Screen_NeedsConversion(void)
+{
+	int y, lines;
+
+	if (pFrameBuffer->bFullUpdate)
+		return true;
+
+	if (bUseVDIRes || bUseHighRes)
+	{
+		if (ScrUpdateFlag & PALETTEMASK_UPDATEMASK)
+			return true;
+		lines = bUseVDIRes ? VDIHeight : 400;
+	}
+	else
+	{
+		for (y = 0; y < NUM_VISIBLE_LINES; y++)
+		{
+			if (HBLPaletteMasks[y] & PALETTEMASK_UPDATEMASK)
+				return true;
+		}
+		lines = NUM_VISIBLE_LINES;
+	}
+
+	for (y = 0; y < lines; y++)
+	{
+		if (STScreenLineChanged[y])
+			return true;
+	}
+	return false;
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Lock full-screen for drawing
@@ -1070,6 +1124,89 @@ static void Screen_UnLock(void)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Start collecting changed areas for a new frame.
+ */
+static void Screen_ClearDirtyRects(void)
+{
+	nDirtyRects = 0;
+	bDirtyFull = false;
+	pDirtyLine = pDirtyLineEnd = NULL;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Add current span to the changed areas.  Span is merged to the
+ * previous rectangle if they're vertically adjacent (or only an unused
+ * interleaved line apart) and overlap horizontally.
+ */
+static void Screen_AddDirtySpan(void)
+{
+	SDL_Rect *rect;
+	int bpp, x, y, w, right, bottom;
+
+	if (!pDirtyLine || bDirtyFull)
+		return;
+
+	bpp = sdlscrn->format->BytesPerPixel;
+	x = (pDirtyLeft - pDirtyLine) / bpp;
+	w = (pDirtyRight - pDirtyLeft) / bpp;
+	y = (pDirtyLine - (Uint8 *)sdlscrn->pixels) / PCScreenBytesPerLine;
+	pDirtyLine = pDirtyLineEnd = NULL;
+
+	if (nDirtyRects)
+	{
+		rect = &DirtyRects[nDirtyRects-1];
+		if (y <= rect->y + rect->h + 1 && x <= rect->x + rect->w && rect->x <= x + w)
+		{
+			right = rect->x + rect->w;
+			if (x + w > right)
+				right = x + w;
+			bottom = rect->y + rect->h;
+			if (y + nDirtyRows > bottom)
+				bottom = y + nDirtyRows;
+			if (x < rect->x)
+				rect->x = x;
+			rect->w = right - rect->x;
+			rect->h = bottom - rect->y;
+			return;
+		}
+		if (nDirtyRects == MAX_DIRTY_RECTS)
+		{
+			/* too many separate areas, just update everything */
+			bDirtyFull = true;
+			return;
+		}
+	}
+	rect = &DirtyRects[nDirtyRects++];
+	rect->x = x;
+	rect->y = y;
+	rect->w = w;
+	rect->h = nDirtyRows;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Start a new span for a PC screen line, called by Convert_SpanChanged()
+ * when a conversion routine changes a line different from the current one.
+ */
+static void Screen_NewDirtySpan(Uint8 *start, Uint8 *end, int rows)
+{
+	Uint8 *pixels = sdlscrn->pixels;
+
+	Screen_AddDirtySpan();
+
+	pDirtyLine = pixels + (start - pixels) / PCScreenBytesPerLine * PCScreenBytesPerLine;
+	pDirtyLineEnd = pDirtyLine + PCScreenBytesPerLine;
+	pDirtyLeft = start;
+	pDirtyRight = end;
+	nDirtyRows = rows;
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Blit our converted ST screen to window/full-screen
@@ -1093,7 +1230,11 @@ static void Screen_Blit(void)
 # endif
 #endif
 	{
-		SDL_UpdateRects(sdlscrn, 1, &STScreenRect);
+		/* Update only the changed areas when they're known */
+		if (bDirtyFull || !nDirtyRects)
+			SDL_UpdateRects(sdlscrn, 1, &STScreenRect);
+		else
+			SDL_UpdateRects(sdlscrn, nDirtyRects, DirtyRects);
 	}
 
 	/* Swap copy/raster buffers in screen. */
@@ -1129,11 +1270,28 @@ static bool Screen_DrawFrame(bool bForceFlip)
 	 * and saved by Statusbar_OverlayBackup()
 	 */
 	Statusbar_OverlayRestore(sdlscrn);
-	
+
+	/* Forced update shows the whole screen */
+	Screen_ClearDirtyRects();
+	bDirtyFull = bForceFlip;
+
+	/* Nothing changed since previous frame? Then skip the conversion */
+	if (!Spec512_IsImage() && !bPrevFrameWasSpec512 && !Screen_NeedsConversion())
+	{
+		Statusbar_OverlayBackup(sdlscrn);
+		Statusbar_Update(sdlscrn);
+		pFrameBuffer->OverscanModeCopy = OverscanMode;
+		if (bForceFlip)
+			Screen_Blit();
+		return false;
+	}
+
 	/* Lock screen ready for drawing */
 	if (Screen_Lock())
 	{
 		bScreenContentsChanged = false;      /* Did change (ie needs blit?) */
+		if (pFrameBuffer->bFullUpdate)
+			bDirtyFull = true;
 
 		/* Set details */
 		Screen_SetConvertDetails();
@@ -1180,6 +1338,7 @@ static bool Screen_DrawFrame(bool bForceFlip)
 
 		if (pDrawFunction)
 			CALL_VAR(pDrawFunction);
+		Screen_AddDirtySpan();
 
 		/* Unlock screen */
 		Screen_UnLock();
@@ -1267,6 +1426,40 @@ static int AdjustLinePaletteRemap(int y)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if screen line 'y' needs to be converted, i.e. its update
+ * 'mask' (from AdjustLinePaletteRemap()) requests a full/palette update
+ * or its contents differ from the previously displayed frame.
+ */
+static inline bool Convert_LineChanged(int mask, int y)
+{
+	return (mask & PALETTEMASK_UPDATEMASK) || STScreenLineChanged[y];
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Called by the conversion routines for each 16 ST pixels they convert:
+ * 'start' and 'end' are the PC screen area they changed on the current
+ * line, 'rows' is 2 when the pixels are doubled also on the next line.
+ */
+static inline void Convert_SpanChanged(void *start, void *end, int rows)
+{
+	bScreenContentsChanged = true;
+
+	if ((Uint8 *)start >= pDirtyLine && (Uint8 *)start < pDirtyLineEnd)
+	{
+		if ((Uint8 *)start < pDirtyLeft)
+			pDirtyLeft = start;
+		if ((Uint8 *)end > pDirtyRight)
+			pDirtyRight = end;
+		return;
+	}
+	Screen_NewDirtySpan(start, end, rows);
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Run updates to palette(STRGBPalette[]) until get to screen line
@@ -5,6 +5,16 @@
   or at your option any later version. Read the file gpl.txt for details.
 
   Screen Snapshots.
+
+  Saving a screenshot only copies the screen surface to one of a few
+  pooled buffers, the image is encoded and written by a separate thread
+  so that emulation doesn't stall on PNG compression.  If all buffers
+  are still waiting to be written, emulation waits for the oldest one.
+
+  Besides PNG and BMP, screenshots can be saved as uncompressed PPM or
+  as QOI ("Quite OK Image" format, lossless and much faster to encode
+  than PNG), which suit bulk frame dumps: with --frame-dump, every
+  displayed frame is saved, optionally only when its contents changed.
 */
 const char ScreenSnapShot_fileid[] = "Hatari screenSnapShot.c : " __DATE__ " " __TIME__;
 
@@ -19,15 +29,43 @@ const char ScreenSnapShot_fileid[] = "Hatari screenSnapShot.c : " __DATE__ " " _
 #include "screenSnapShot.h"
 #include "statusbar.h"
 #include "video.h"
+#include "qoi.h"
+#include "pixel_convert.h"				/* inline functions */
 /* after above that bring in config.h */
 #if HAVE_LIBPNG
 # include <png.h>
 # include <assert.h>
-# include "pixel_convert.h"				/* inline functions */
 #endif
 
 
+/* Number of screen copies which can wait for writing */
+#define SNAPSHOT_BUFFERS 4
+
+typedef struct
+{
+	SDL_Surface *surface;       /* copy of the screen */
+	int height;                 /* lines to save from it */
+	int format;                 /* SCREENSHOT_FORMAT_* */
+	bool bVerbose;              /* tell user where image was saved */
+	char filename[FILENAME_MAX];
+} SNAPSHOT_JOB;
+
+static SNAPSHOT_JOB Jobs[SNAPSHOT_BUFFERS];
+static int nJobHead, nJobsQueued;           /* Next job to write, number of queued jobs */
+static SDL_Thread *pWriterThread;
+static SDL_mutex *pJobMutex;
+static SDL_cond *pJobQueuedCond, *pJobDoneCond;
+static bool bWriterQuit;
+
+static const char *FormatExtensions[] = { "png", "bmp", "ppm", "qoi" };
+
 static int nScreenShots = 0;                /* Number of screen shots saved */
+static bool bScreenShotsCounted;            /* Whether existing ones were counted */
+
+static char *FrameDumpDir;                  /* Save displayed frames here, if set */
+static bool bFrameDumpChanged;              /* ...but only when they changed */
+static Uint32 nFrameDumps;
+static Uint64 nFrameDumpHash;
 
 
 /*-----------------------------------------------------------------------*/
@@ -70,32 +108,81 @@ static void ScreenSnapShot_GetNum(void)
 }
 
 
-#if HAVE_LIBPNG
+/*-----------------------------------------------------------------------*/
 /**
- * Save given SDL surface as PNG. Return png file size > 0 for success.
+ * Convert one line of given surface to 24-bit RGB
  */
-static int ScreenSnapShot_SavePNG(SDL_Surface *surface, const char *filename)
+static void ScreenSnapShot_ConvertLine(SDL_Surface *surface, int y, Uint8 *rowbuf)
 {
-	FILE *fp = NULL;
-	int ret, bottom;
-  
-	fp = fopen(filename, "wb");
-	if (!fp)
-		return -1;
+	SDL_PixelFormat *fmt = surface->format;
+	Uint8 *src = (Uint8 *)surface->pixels + y * surface->pitch;
 
-	if (ConfigureParams.Screen.bCrop)
-		bottom = Statusbar_GetHeight();
-	else
-		bottom = 0;
+	switch (fmt->BytesPerPixel)
+	{
+	case 1:
+		PixelConvert_8to24Bits(rowbuf, src, surface->w, fmt->palette->colors);
+		break;
+	case 2:
+		PixelConvert_16to24Bits(rowbuf, (Uint16 *)src, surface->w, fmt);
+		break;
+	case 3:
+		memcpy(rowbuf, src, 3 * surface->w);
+		break;
+	case 4:
+		PixelConvert_32to24Bits(rowbuf, (Uint32 *)src, surface->w, fmt);
+		break;
+	}
+}
 
-	/* default compression/filter and configured cropping */
-	ret = ScreenSnapShot_SavePNG_ToFile(surface, fp, -1, -1, 0, 0, 0, bottom);
 
-	fclose (fp);
-	return ret;					/* >0 if OK, -1 if error */
+/*-----------------------------------------------------------------------*/
+/**
+ * Save first 'height' lines of given surface as binary PPM.
+ * Return true for success.
+ */
+static bool ScreenSnapShot_SavePPM(SDL_Surface *surface, int height, FILE *fp)
+{
+	Uint8 rowbuf[3 * surface->w];
+	int y;
+
+	fprintf(fp, "P6\n%d %d\n255\n", surface->w, height);
+	for (y = 0; y < height; y++)
+	{
+		ScreenSnapShot_ConvertLine(surface, y, rowbuf);
+		if (fwrite(rowbuf, 3 * surface->w, 1, fp) != 1)
+			return false;
+	}
+	return true;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Save first 'height' lines of given surface in QOI format.
+ * Return true for success.
+ */
+static bool ScreenSnapShot_SaveQOI(SDL_Surface *surface, int height, FILE *fp)
+{
+	Uint8 rowbuf[3 * surface->w];
+	Uint8 outbuf[QOI_LINE_BYTES(surface->w)];
+	QOI_ENCODER enc;
+	int y, len;
+
+	if (!Qoi_WriteHeader(fp, surface->w, height))
+		return false;
+	Qoi_InitEncoder(&enc);
+	for (y = 0; y < height; y++)
+	{
+		ScreenSnapShot_ConvertLine(surface, y, rowbuf);
+		len = Qoi_EncodeLine(&enc, rowbuf, surface->w, outbuf);
+		if (len && fwrite(outbuf, len, 1, fp) != 1)
+			return false;
+	}
+	return Qoi_WriteEnd(&enc, fp);
 }
 
 
+#if HAVE_LIBPNG
 /**
  * Save given SDL surface as PNG in an already opened FILE, eventually cropping some borders.
  * Return png file size > 0 for success.
@@ -212,35 +299,336 @@ png_cleanup:
 
 /*-----------------------------------------------------------------------*/
 /**
- * Save screen shot file with filename like 'grab0000.[png|bmp]',
- * 'grab0001.[png|bmp]', etc... Whether screen shots are saved as BMP
- * or PNG depends on Hatari configuration.
+ * Write given job to its file.  Return true for success.
+ */
+static bool ScreenSnapShot_WriteJob(SNAPSHOT_JOB *job)
+{
+	FILE *fp;
+	bool ok;
+
+	if (job->format == SCREENSHOT_FORMAT_BMP)
+		return SDL_SaveBMP(job->surface, job->filename) == 0;
+
+	fp = fopen(job->filename, "wb");
+	if (!fp)
+		return false;
+	switch (job->format)
+	{
+#if HAVE_LIBPNG
+	case SCREENSHOT_FORMAT_PNG:
+		/* default compression/filter, crop bottom */
+		ok = ScreenSnapShot_SavePNG_ToFile(job->surface, fp, -1, -1, 0, 0, 0,
+		                                   job->surface->h - job->height) > 0;
+		break;
+#endif
+	case SCREENSHOT_FORMAT_PPM:
+		ok = ScreenSnapShot_SavePPM(job->surface, job->height, fp);
+		break;
+	default:
+		ok = ScreenSnapShot_SaveQOI(job->surface, job->height, fp);
+		break;
+	}
+	if (fclose(fp) != 0)
+		ok = false;
+	return ok;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Writer thread: write queued screen copies until asked to quit
+ * and all of them are written
+ */
+static int ScreenSnapShot_WriterThread(void *unused)
+{
+	SNAPSHOT_JOB *job;
+
+	SDL_LockMutex(pJobMutex);
+	for (;;)
+	{
+		while (!nJobsQueued && !bWriterQuit)
+			SDL_CondWait(pJobQueuedCond, pJobMutex);
+		if (!nJobsQueued)
+			break;
+		job = &Jobs[nJobHead];
+		SDL_UnlockMutex(pJobMutex);
+
+		if (!ScreenSnapShot_WriteJob(job))
+			fprintf(stderr, "Screen dump to '%s' failed!\n", job->filename);
+		else if (job->bVerbose)
+			fprintf(stderr, "Screen dump saved to: %s\n", job->filename);
+
+		SDL_LockMutex(pJobMutex);
+		nJobHead = (nJobHead + 1) % SNAPSHOT_BUFFERS;
+		nJobsQueued--;
+		SDL_CondSignal(pJobDoneCond);
+	}
+	SDL_UnlockMutex(pJobMutex);
+	return 0;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Copy the screen to a free buffer and queue it for writing to given
+ * file in given format.  If 'bCropStatusbar' is set, statusbar isn't
+ * saved.  Return false if copy couldn't be queued.
+ */
+static bool ScreenSnapShot_QueueScreen(const char *filename, int format,
+                                       bool bCropStatusbar, bool bVerbose)
+{
+	SDL_PixelFormat *fmt = sdlscrn->format;
+	SNAPSHOT_JOB *job;
+	Uint8 *src, *dst;
+	int y, len;
+
+	if (!pWriterThread)
+	{
+		pJobMutex = SDL_CreateMutex();
+		pJobQueuedCond = SDL_CreateCond();
+		pJobDoneCond = SDL_CreateCond();
+		bWriterQuit = false;
+		if (pJobMutex && pJobQueuedCond && pJobDoneCond)
+			pWriterThread = SDL_CreateThread(ScreenSnapShot_WriterThread, NULL);
+		if (!pWriterThread)
+		{
+			Log_Printf(LOG_ERROR, "Failed to create screenshot writer thread!\n");
+			return false;
+		}
+	}
+
+	/* wait until there's a free buffer */
+	SDL_LockMutex(pJobMutex);
+	while (nJobsQueued == SNAPSHOT_BUFFERS)
+		SDL_CondWait(pJobDoneCond, pJobMutex);
+	job = &Jobs[(nJobHead + nJobsQueued) % SNAPSHOT_BUFFERS];
+	SDL_UnlockMutex(pJobMutex);
+
+	/* (re-)allocate buffer if screen format changed */
+	if (job->surface && (job->surface->w != sdlscrn->w || job->surface->h != sdlscrn->h
+	                     || job->surface->format->BitsPerPixel != fmt->BitsPerPixel
+	                     || job->surface->format->Rmask != fmt->Rmask
+	                     || job->surface->format->Gmask != fmt->Gmask
+	                     || job->surface->format->Bmask != fmt->Bmask))
+	{
+		SDL_FreeSurface(job->surface);
+		job->surface = NULL;
+	}
+	if (!job->surface)
+	{
+		job->surface = SDL_CreateRGBSurface(SDL_SWSURFACE, sdlscrn->w, sdlscrn->h,
+		                                    fmt->BitsPerPixel, fmt->Rmask, fmt->Gmask,
+		                                    fmt->Bmask, fmt->Amask);
+		if (!job->surface)
+			return false;
+	}
+	if (fmt->palette)
+		SDL_SetColors(job->surface, fmt->palette->colors, 0, fmt->palette->ncolors);
+
+	/* copy screen contents */
+	if (SDL_MUSTLOCK(sdlscrn))
+		SDL_LockSurface(sdlscrn);
+	src = sdlscrn->pixels;
+	dst = job->surface->pixels;
+	len = sdlscrn->w * fmt->BytesPerPixel;
+	for (y = 0; y < sdlscrn->h; y++)
+	{
+		memcpy(dst, src, len);
+		src += sdlscrn->pitch;
+		dst += job->surface->pitch;
+	}
+	if (SDL_MUSTLOCK(sdlscrn))
+		SDL_UnlockSurface(sdlscrn);
+
+	job->height = sdlscrn->h;
+	if (bCropStatusbar)
+		job->height -= Statusbar_GetHeight();
+	job->format = format;
+	job->bVerbose = bVerbose;
+	strncpy(job->filename, filename, sizeof(job->filename));
+	job->filename[sizeof(job->filename)-1] = '\0';
+
+	/* and give it to the writer */
+	SDL_LockMutex(pJobMutex);
+	nJobsQueued++;
+	SDL_CondSignal(pJobQueuedCond);
+	SDL_UnlockMutex(pJobMutex);
+	return true;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return configured screenshot format, BMP if PNG isn't supported
+ */
+static int ScreenSnapShot_GetFormat(void)
+{
+	int format = ConfigureParams.Video.ScreenShotFormat;
+
+	if (format < 0 || format > SCREENSHOT_FORMAT_QOI)
+		format = SCREENSHOT_FORMAT_BMP;
+#if !HAVE_LIBPNG
+	if (format == SCREENSHOT_FORMAT_PNG)
+		format = SCREENSHOT_FORMAT_BMP;
+#endif
+	return format;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Save screen shot file with filename like 'grab0000.<ext>',
+ * 'grab0001.<ext>', etc.  Image format (PNG, BMP, PPM or QOI)
+ * depends on Hatari configuration.  File is written in the background.
  */
 void ScreenSnapShot_SaveScreen(void)
 {
 	char *szFileName = malloc(FILENAME_MAX);
+	int format = ScreenSnapShot_GetFormat();
 
 	if (!szFileName)  return;
 
-	ScreenSnapShot_GetNum();
+	/* files are written in the background, so count
+	 * existing ones only once */
+	if (!bScreenShotsCounted)
+	{
+		ScreenSnapShot_GetNum();
+		bScreenShotsCounted = true;
+	}
 	/* Create our filename */
 	nScreenShots++;
-#if HAVE_LIBPNG
-	/* try first PNG */
-	sprintf(szFileName,"%s/grab%4.4d.png", Paths_GetWorkingDir(), nScreenShots);
-	if (ScreenSnapShot_SavePNG(sdlscrn, szFileName) > 0)
+	snprintf(szFileName, FILENAME_MAX, "%s/grab%4.4d.%s", Paths_GetWorkingDir(),
+	         nScreenShots, FormatExtensions[format]);
+	/* BMP is saved with statusbar, like before */
+	if (!ScreenSnapShot_QueueScreen(szFileName, format,
+	                                format != SCREENSHOT_FORMAT_BMP && ConfigureParams.Screen.bCrop,
+	                                true))
+		fprintf(stderr, "Screen dump failed!\n");
+
+	free(szFileName);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Set directory where displayed frames are saved, and whether
+ * only the frames whose contents changed are saved.
+ * Return false for invalid directory name.
+ */
+bool ScreenSnapShot_SetFrameDump(const char *dirname, bool bChangedOnly)
+{
+	if (!dirname || !*dirname)
+		return false;
+	free(FrameDumpDir);
+	FrameDumpDir = strdup(dirname);
+	bFrameDumpChanged = bChangedOnly;
+	return FrameDumpDir != NULL;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return hash of the screen contents, without statusbar
+ */
+static Uint64 ScreenSnapShot_HashScreen(void)
+{
+	Uint64 hash = 0xcbf29ce484222325ULL;
+	int x, y, words, height;
+	Uint8 *row;
+	Uint32 *p;
+
+	height = sdlscrn->h - Statusbar_GetHeight();
+	words = sdlscrn->w * sdlscrn->format->BytesPerPixel / 4;
+
+	if (SDL_MUSTLOCK(sdlscrn))
+		SDL_LockSurface(sdlscrn);
+	row = sdlscrn->pixels;
+	for (y = 0; y < height; y++, row += sdlscrn->pitch)
 	{
-		fprintf(stderr, "Screen dump saved to: %s\n", szFileName);
-		free(szFileName);
+		/* widths are multiples of 16 pixels, so lines
+		 * have whole 32-bit words even in 8-bit modes */
+		p = (Uint32 *)row;
+		for (x = 0; x < words; x++)
+			hash = (hash ^ p[x]) * 0x100000001b3ULL;
+	}
+	if (SDL_MUSTLOCK(sdlscrn))
+		SDL_UnlockSurface(sdlscrn);
+	return hash;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Save displayed frame, if frame dumping is enabled.
+ * Called after the screen has been drawn.
+ */
+void ScreenSnapShot_FrameDump(void)
+{
+	char *szFileName;
+	int format;
+	Uint64 hash;
+
+	if (!FrameDumpDir || !sdlscrn)
 		return;
+
+	if (bFrameDumpChanged)
+	{
+		hash = ScreenSnapShot_HashScreen();
+		if (nFrameDumps && hash == nFrameDumpHash)
+			return;
+		nFrameDumpHash = hash;
 	}
-#endif
-	sprintf(szFileName,"%s/grab%4.4d.bmp", Paths_GetWorkingDir(), nScreenShots);
-	if (SDL_SaveBMP(sdlscrn, szFileName))
-		fprintf(stderr, "Screen dump failed!\n");
-	else
-		fprintf(stderr, "Screen dump saved to: %s\n", szFileName);
 
+	szFileName = malloc(FILENAME_MAX);
+	if (!szFileName)
+		return;
+	format = ScreenSnapShot_GetFormat();
+	snprintf(szFileName, FILENAME_MAX, "%s%cframe%6.6u.%s", FrameDumpDir, PATHSEP,
+	         nFrameDumps, FormatExtensions[format]);
+	nFrameDumps++;
+
+	/* statusbar always changes, so it's not included */
+	if (!ScreenSnapShot_QueueScreen(szFileName, format, true, false))
+	{
+		Log_Printf(LOG_ERROR, "Saving frame to '%s' failed, frame dumping stopped!\n", szFileName);
+		free(FrameDumpDir);
+		FrameDumpDir = NULL;
+	}
 	free(szFileName);
 }
 
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Wait until all queued screenshots are written and stop the writer
+ */
+void ScreenSnapShot_UnInit(void)
+{
+	int i;
+
+	if (pWriterThread)
+	{
+		SDL_LockMutex(pJobMutex);
+		bWriterQuit = true;
+		SDL_CondSignal(pJobQueuedCond);
+		SDL_UnlockMutex(pJobMutex);
+		SDL_WaitThread(pWriterThread, NULL);
+		pWriterThread = NULL;
+	}
+	if (pJobQueuedCond)
+		SDL_DestroyCond(pJobQueuedCond);
+	if (pJobDoneCond)
+		SDL_DestroyCond(pJobDoneCond);
+	if (pJobMutex)
+		SDL_DestroyMutex(pJobMutex);
+	pJobQueuedCond = pJobDoneCond = NULL;
+	pJobMutex = NULL;
+
+	for (i = 0; i < SNAPSHOT_BUFFERS; i++)
+	{
+		if (Jobs[i].surface)
+			SDL_FreeSurface(Jobs[i].surface);
+		Jobs[i].surface = NULL;
+	}
+	nJobHead = nJobsQueued = 0;
+}
@@ -76,6 +76,7 @@ const char Sound_fileid[] = "Hatari sound.c : " __DATE__ " " __TIME__;
 
 #include "main.h"
 #include "audio.h"
+#include "benchmark.h"
 #include "cycles.h"
 #include "configuration.h"
 #include "dmaSnd.h"
@@ -232,6 +233,18 @@ static yms64	SamplesPerFrame_unrounded = 0;		/* Number of samples for the curren
 static int 	SamplesPerFrame;			/* Number of samples to generate for the current VBL */
 static int	CurrentSamplesNb = 0;			/* Number of samples already generated for the current VBL */
 
+/* YM register writes are not applied immediately, they are stored with */
+/* the sample position (in the current VBL) where they happened and are */
+/* applied when samples are generated up to that position. */
+#define	SOUND_REGLOG_SIZE	4096
+static struct
+{
+	Uint16	SamplePos;
+	Uint8	Reg;
+	Uint8	Data;
+} RegLog[ SOUND_REGLOG_SIZE ];
+static int	RegLogCount = 0;
+
 bool		Sound_BufferIndexNeedReset = false;
 
 
@@ -259,7 +272,9 @@ static ymu32	Ym2149_NoiseStepCompute	(ymu8 rNoise);
 static ymu32	Ym2149_EnvStepCompute	(ymu8 rHigh , ymu8 rLow);
 static ymsample	YM2149_NextSample	(void);
 
+static int	Sound_GetSamplePos(void);
 static int	Sound_SetSamplesPassed(bool FillFrame);
+static void	Sound_ApplyRegLog(void);
 static void	Sound_GenerateSamples(int SamplesToGenerate);
 
 
@@ -1224,6 +1239,7 @@ void Sound_Reset(void)
 	SamplesPerFrame = SAMPLES_PER_FRAME;
 	CurrentSamplesNb = 0;
 	ActiveSndBufIdxAvi = ActiveSndBufIdx;
+	RegLogCount = 0;				/* pending YM writes are lost on reset */
 //fprintf ( stderr , "Sound_Reset SoundBufferSize %d SAMPLES_PER_FRAME %d nGeneratedSamples %d , ActiveSndBufIdx %d\n" ,
 //	SoundBufferSize , SAMPLES_PER_FRAME, nGeneratedSamples , ActiveSndBufIdx );
 
@@ -1262,6 +1278,12 @@ void Sound_ResetBufferIndex(void)
  */
 void Sound_MemorySnapShot_Capture(bool bSave)
 {
+	/* Apply pending YM writes before saving, drop them when restoring */
+	if (bSave)
+		Sound_Update(false);
+	else
+		RegLogCount = 0;
+
 	/* Save/Restore details */
 	MemorySnapShot_Store(&stepA, sizeof(stepA));
 	MemorySnapShot_Store(&stepB, sizeof(stepB));
@@ -1298,17 +1320,13 @@ void Sound_MemorySnapShot_Capture(bool bSave)
 
 /*-----------------------------------------------------------------------*/
 /**
- * Find how many samples to generate and store in 'nSamplesToGenerate'
- * Also update sound cycles counter to store how many we actually did
- * so generates set amount each frame.
- * If FillFrame is true, this means we reach the end of the VBL and me must
- * add as many samples as necessary to get a total of SamplesPerFrame
- * for this VBL.
+ * Return the number of samples that should have been generated at this
+ * point of the VBL, based on the video cycles counter
  */
-static int Sound_SetSamplesPassed(bool FillFrame)
+static int Sound_GetSamplePos(void)
 {
 	int nSoundCycles;
-	int SamplesToGenerate;				/* How many samples are needed for this time-frame */
+	int SamplePos;
 
 	nSoundCycles = Cycles_GetCounter(CYCLES_COUNTER_VIDEO);
 
@@ -1316,15 +1334,33 @@ static int Sound_SetSamplesPassed(bool FillFrame)
 	/* 882/160256 samples per cpu clock cycle */
 
 	/* Total number of samples that we should have at this point of the VBL */
-	SamplesToGenerate = nSoundCycles * SamplesPerFrame
+	SamplePos = nSoundCycles * SamplesPerFrame
 		/ ClocksTimings_GetCyclesPerVBL ( ConfigureParams.System.nMachineType , nScreenRefreshRate );
 
-//if (SamplesToGenerate > SamplesPerFrame )
-//fprintf ( stderr , "over run %d %d\n" , SamplesPerFrame , SamplesToGenerate );
+//if (SamplePos > SamplesPerFrame )
+//fprintf ( stderr , "over run %d %d\n" , SamplesPerFrame , SamplePos );
 
-	if (SamplesToGenerate > SamplesPerFrame)
-		SamplesToGenerate = SamplesPerFrame;
+	if (SamplePos > SamplesPerFrame)
+		SamplePos = SamplesPerFrame;
 
+	return SamplePos;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Find how many samples to generate and store in 'nSamplesToGenerate'
+ * Also update sound cycles counter to store how many we actually did
+ * so generates set amount each frame.
+ * If FillFrame is true, this means we reach the end of the VBL and me must
+ * add as many samples as necessary to get a total of SamplesPerFrame
+ * for this VBL.
+ */
+static int Sound_SetSamplesPassed(bool FillFrame)
+{
+	int SamplesToGenerate;				/* How many samples are needed for this time-frame */
+
+	SamplesToGenerate = Sound_GetSamplePos();
 	SamplesToGenerate -= CurrentSamplesNb;		/* don't count samples that were already generated up to now */
 	if ( SamplesToGenerate < 0 )
 		SamplesToGenerate = 0;
@@ -1407,6 +1443,45 @@ static void Sound_GenerateSamples(int SamplesToGenerate)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Apply the YM register writes stored by Sound_WriteRegLater(), generating
+ * the samples before each write with the previous register values.
+ * This gives the same samples as applying each write immediately.
+ */
+static void Sound_ApplyRegLog(void)
+{
+	int	i;
+
+	for (i = 0; i < RegLogCount; i++)
+	{
+		Sound_GenerateSamples( RegLog[i].SamplePos - CurrentSamplesNb );
+		Sound_WriteReg( RegLog[i].Reg , RegLog[i].Data );
+	}
+	RegLogCount = 0;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Store a write to a YM register, to be applied at the current sample
+ * position when the samples are generated by the next Sound_Update().
+ * As PSG writes are very frequent (eg for digi sound), this avoids
+ * locking the audio and generating a few samples on each write.
+ */
+void Sound_WriteRegLater( int reg , Uint8 data )
+{
+	/* Log full, generate samples up to now (this applies the log) */
+	if (RegLogCount == SOUND_REGLOG_SIZE)
+		Sound_Update(false);
+
+	RegLog[RegLogCount].SamplePos = Sound_GetSamplePos();
+	RegLog[RegLogCount].Reg = reg;
+	RegLog[RegLogCount].Data = data;
+	RegLogCount++;
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * This is called to built samples up until this clock cycle
@@ -1418,15 +1493,19 @@ void Sound_Update(bool FillFrame)
 {
 	int OldSndBufIdx = ActiveSndBufIdx;
 	int SamplesToGenerate;
+	int SamplePosEnd;
+	int nBenchPrev = Benchmark_Enter(BENCH_SOUND);
 
 	/* Make sure that we don't interfere with the audio callback function */
 	Audio_Lock();
 
 	/* Find how many samples to generate */
 	SamplesToGenerate = Sound_SetSamplesPassed( FillFrame );
+	SamplePosEnd = CurrentSamplesNb + SamplesToGenerate;
 
-	/* And generate */
-	Sound_GenerateSamples( SamplesToGenerate );
+	/* Generate samples up to each pending YM write, then the rest */
+	Sound_ApplyRegLog();
+	Sound_GenerateSamples( SamplePosEnd - CurrentSamplesNb );
 
 	/* Allow audio callback function to occur again */
 	Audio_Unlock();
@@ -1434,6 +1513,7 @@ void Sound_Update(bool FillFrame)
 	/* Save to WAV file, if open */
 	if (bRecordingWav)
 		WAVFormat_Update(MixBuffer, OldSndBufIdx, SamplesToGenerate);
+	Benchmark_Leave(nBenchPrev);
 }
 
 
@@ -1449,6 +1529,9 @@ void Sound_Update(bool FillFrame)
 void Sound_Update_VBL(void)
 {
 	Sound_Update(true);					/* generate as many samples as needed to fill this VBL */
+
+	/* Store off PSG registers for YM file (all writes are applied now), if enabled */
+	YMFormat_UpdateRecording();
 //fprintf ( stderr , "vbl done %d %d\n" , SamplesPerFrame , CurrentSamplesNb );
 
 	CurrentSamplesNb = 0;					/* VBL is complete, reset counter for next VBL */
@@ -73,24 +73,33 @@ const char Spec512_fileid[] = "Hatari spec512.c : " __DATE__ " " __TIME__;
 
 
 /* As 68000 clock multiple of 4 this mean we can only write to the palette this many time per scanline */
-#define MAX_CYCLEPALETTES_PERLINE  ((512/4) + 1)		/* +1 for the '-1' added as a line's terminator */
+#define MAX_CYCLEPALETTES_PERLINE  (512/4)
 
-/* Store writes to palette by cycles per scan line, colour and index in ST */
+/* Max. number of palette writes stored per frame */
+#define MAX_CYCLEPALETTES  ((MAX_SCANLINES_PER_FRAME+1)*MAX_CYCLEPALETTES_PERLINE)
+
+/* Initial number of entries allocated for the palette write log */
+#define CYCLEPALETTES_INITIAL_SIZE  1024
+
+/* Store writes to palette by scan line, cycles, colour and index in ST */
 typedef struct
 {
-	int LineCycles;       /* Number of cycles into line (MUST be div by 4) */
+	Uint16 ScanLine;      /* Scan line where the write happened */
+	Uint16 LineCycles;    /* Number of cycles into line (MUST be div by 4) */
 	Uint16 Colour;        /* ST Colour value */
 	Uint16 Index;         /* Index into ST palette (0...15) */
 }
 CYCLEPALETTE;
 
-/* 314k; 1024-bytes per line */
-static CYCLEPALETTE CyclePalettes[(MAX_SCANLINES_PER_FRAME+1)*MAX_CYCLEPALETTES_PERLINE];
-static CYCLEPALETTE *pCyclePalette;
-static int nCyclePalettes[(MAX_SCANLINES_PER_FRAME+1)];  /* Number of entries in above table for each scanline */
+/* Palette writes of the frame, in the order of scan line and cycles.
+ * Grows as needed, so memory is used only when palette is written to. */
+static CYCLEPALETTE *CyclePalettes;
+static int nCyclePalettesSize;  /* Number of allocated entries in above log */
+static int nCyclePalettes;      /* Number of used entries in above log */
+/* Index of first entry for each scanline in the log, built on Spec512_StartFrame() */
+static int CyclePalettesLineStart[MAX_SCANLINES_PER_FRAME+2];
+static CYCLEPALETTE *pCyclePalette, *pCyclePaletteLineEnd;
 static int nPalettesAccesses;   /* Number of times accessed palette registers */
-static Uint16 CycleColour;
-static int CycleColourIndex;
 static int nScanLine, ScanLineCycleCount;
 static bool bIsSpec512Display;
 
@@ -124,8 +133,8 @@ bool Spec512_IsImage(void)
  */
 void Spec512_StartVBL(void)
 {
-	/* Clear number of cycle palettes on each frame */
-	memset(nCyclePalettes, 0x0, sizeof(nCyclePalettes));
+	/* Clear palette write log on each frame */
+	nCyclePalettes = 0;
 
 	/* Clear number of times accessed on entry in palette (used to check if
 	 * it is true Spectrum 512 image) */
@@ -138,18 +147,18 @@ void Spec512_StartVBL(void)
 
 /*-----------------------------------------------------------------------*/
 /**
- * Store color into table 'CyclePalettes[]' for screen conversion according
- * to cycles into frame.
+ * Append color write to the 'CyclePalettes[]' log for screen conversion
+ * according to cycles into frame.
  */
 void Spec512_StoreCyclePalette(Uint16 col, Uint32 addr)
 {
 	CYCLEPALETTE *pTmpCyclePalette;
 	int FrameCycles, ScanLine, nHorPos;
+	int CycleColourIndex;
 
 	if (!ConfigureParams.Screen.nSpec512Threshold)
 		return;
 
-	CycleColour = col;
 	CycleColourIndex = (addr-0xff8240)>>1;
 
 	/* Find number of cycles into frame */
@@ -193,31 +202,57 @@ void Spec512_StoreCyclePalette(Uint16 col, Uint32 addr)
 	/* Find scan line we are currently on and get index into cycle-palette table */
 	Video_ConvertPosition ( FrameCycles , &ScanLine , &nHorPos );	
 
-	if (ScanLine > MAX_SCANLINES_PER_FRAME)
-		return;
-
-	pTmpCyclePalette = &CyclePalettes[ (ScanLine*MAX_CYCLEPALETTES_PERLINE) + nCyclePalettes[ScanLine] ];
-
-
-	/* Do we have a previous entry at the same cycles? If so, 68000 have used a 'move.l' instruction so stagger writes */
-	if (nCyclePalettes[ScanLine] > 0)
+	/* Do we have a previous entry at the same (or later) position? If so,
+	 * 68000 have used a 'move.l' instruction so stagger writes */
+	if (nCyclePalettes > 0)
 	{
+		pTmpCyclePalette = &CyclePalettes[nCyclePalettes-1];
+
 		/* In case the ST uses a move.l or a movem.l to update colors, we need
 		 * to add at least 4 cycles between each color: */
-		if ((pTmpCyclePalette-1)->LineCycles >= nHorPos)
-			nHorPos = (pTmpCyclePalette-1)->LineCycles + 4;
+		if (pTmpCyclePalette->ScanLine > ScanLine
+		    || (pTmpCyclePalette->ScanLine == ScanLine && pTmpCyclePalette->LineCycles >= nHorPos))
+		{
+			ScanLine = pTmpCyclePalette->ScanLine;
+			nHorPos = pTmpCyclePalette->LineCycles + 4;
+		}
 
 		if ( nHorPos >= nCyclesPerLine )	/* end of line reached, continue on the next line */
 		{
 			ScanLine++;
-			pTmpCyclePalette = &CyclePalettes[ (ScanLine*MAX_CYCLEPALETTES_PERLINE) + nCyclePalettes[ScanLine] ];
-			nHorPos = nCyclePalettes[ScanLine] * 4;	/* 4 cycles per access */
+			nHorPos = 0;
 		}
 	}
 
+	if (ScanLine > MAX_SCANLINES_PER_FRAME)
+		return;
+
+	/* Grow the log if needed */
+	if (nCyclePalettes == nCyclePalettesSize)
+	{
+		int nNewSize = nCyclePalettesSize ? 2*nCyclePalettesSize : CYCLEPALETTES_INITIAL_SIZE;
+
+		/* Log can never get bigger than this as you cannot write to the palette
+		 * more than 'MAX_CYCLEPALETTES_PERLINE' times per scanline */
+		if (nCyclePalettesSize >= MAX_CYCLEPALETTES)
+			return;
+		if (nNewSize > MAX_CYCLEPALETTES)
+			nNewSize = MAX_CYCLEPALETTES;
+		pTmpCyclePalette = realloc(CyclePalettes, nNewSize * sizeof(CYCLEPALETTE));
+		if (!pTmpCyclePalette)
+		{
+			perror("Spec512_StoreCyclePalette");
+			return;
+		}
+		CyclePalettes = pTmpCyclePalette;
+		nCyclePalettesSize = nNewSize;
+	}
+
 	/* Store palette access */
+	pTmpCyclePalette = &CyclePalettes[nCyclePalettes++];
+	pTmpCyclePalette->ScanLine = ScanLine;            /* Scan line */
 	pTmpCyclePalette->LineCycles = nHorPos;           /* Cycles into scanline */
-	pTmpCyclePalette->Colour = CycleColour;           /* Store ST/STe color RGB */
+	pTmpCyclePalette->Colour = col;                   /* Store ST/STe color RGB */
 	pTmpCyclePalette->Index = CycleColourIndex;       /* And index (0...15) */
 
 	if ( 0 && LOG_TRACE_LEVEL(TRACE_VIDEO_COLOR))
@@ -226,13 +261,10 @@ void Spec512_StoreCyclePalette(Uint16 col, Uint32 addr)
 
 		Video_GetPosition ( &FrameCycles , &HblCounterVideo , &LineCycles );
 		LOG_TRACE_PRINT("spec store col line %d cyc=%d col=%x idx=%d video_cyc=%d %d@%d pc=%x instr_cyc=%d\n",
-				ScanLine, nHorPos, CycleColour, CycleColourIndex, FrameCycles,
+				ScanLine, nHorPos, col, CycleColourIndex, FrameCycles,
 				LineCycles, HblCounterVideo, M68000_GetPC(), CurrentInstrCycles);
 	}
 
-	/* Increment count (this can never overflow as you cannot write to the palette more than 'MAX_CYCLEPALETTES_PERLINE-1' times per scanline) */
-	nCyclePalettes[ScanLine]++;
-
 	/* Check if program wrote to palette registers multiple times on a frame. */
 	/* If so it must be using a spec512 image or some kind of color cycling. */
 	nPalettesAccesses++;
@@ -243,23 +275,43 @@ void Spec512_StoreCyclePalette(Uint16 col, Uint32 addr)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Add palette writes of this frame to given screen contents hash
+ */
+Uint32 Spec512_HashPalettes(Uint32 hash)
+{
+	int i;
+
+	for (i = 0; i < nCyclePalettes; i++)
+	{
+		hash = Video_HashValue(hash, (Uint32)CyclePalettes[i].ScanLine << 16 | CyclePalettes[i].LineCycles);
+		hash = Video_HashValue(hash, (Uint32)CyclePalettes[i].Index << 16 | CyclePalettes[i].Colour);
+	}
+	return hash;
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Begin palette calculation for Spectrum 512 style images,
  */
 void Spec512_StartFrame(void)
 {
-	int i;
+	int i, line;
 
 	/* Set so screen gets full-update when returns from Spectrum 512 display */
 	Screen_SetFullUpdate();
 
-	/* Set terminators on each line, so when scan during conversion we know when to stop */
-	for (i = 0; i < (nScanlinesPerFrame+1); i++)
+	/* Find where each line's writes start in the log, so when scan during
+	 * conversion we know where to start and stop */
+	for (i = 0, line = 0; i < nCyclePalettes; i++)
 	{
-		pCyclePalette = &CyclePalettes[ (i*MAX_CYCLEPALETTES_PERLINE) + nCyclePalettes[i] ];
-		pCyclePalette->LineCycles = -1;          /* Term */
+		while (line <= CyclePalettes[i].ScanLine)
+			CyclePalettesLineStart[line++] = i;
 	}
+	while (line < MAX_SCANLINES_PER_FRAME+2)
+		CyclePalettesLineStart[line++] = nCyclePalettes;
 
        /* Copy first line palette, kept in 'HBLPalettes' and store to 'STRGBPalette' */
        for (i = 0; i < 16; i++)
@@ -284,18 +336,69 @@ void Spec512_StartFrame(void)
 
 /*-----------------------------------------------------------------------*/
 /**
- * Scan whole line and build up palette - need to do this so when get to screen line we have
- * the correct 16 colours set
+ * Set palette entry according to given palette write
  */
-void Spec512_ScanWholeLine(void)
+static inline void Spec512_SetPaletteEntry(const CYCLEPALETTE *pPalette)
 {
-	/* Store pointer to line of palette cycle writes */
-	pCyclePalette = &CyclePalettes[nScanLine*MAX_CYCLEPALETTES_PERLINE];
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+	STRGBPalette[STRGBPalEndianTable[pPalette->Index]] = ST2RGB[pPalette->Colour];
+#else
+	STRGBPalette[pPalette->Index] = ST2RGB[pPalette->Colour];
+#endif
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Set up scanning of palette writes for next scan line
+ */
+static void Spec512_NextScanLine(void)
+{
+	/* Store pointers to line of palette cycle writes */
+	if (nScanLine <= MAX_SCANLINES_PER_FRAME)
+	{
+		pCyclePalette = &CyclePalettes[CyclePalettesLineStart[nScanLine]];
+		pCyclePaletteLineEnd = &CyclePalettes[CyclePalettesLineStart[nScanLine+1]];
+	}
+	else
+	{
+		pCyclePalette = pCyclePaletteLineEnd = CyclePalettes;
+	}
 	/* Ready for next scan line */
 	nScanLine++;
 
-	/* Update palette entries until we reach start of displayed screen */
 	ScanLineCycleCount = 0;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Update palette with all writes on the line before given cycle position,
+ * as calling Spec512_UpdatePaletteSpan() until reaching it would do.
+ */
+static void Spec512_UpdatePaletteUntil(int nCycles)
+{
+	while (pCyclePalette < pCyclePaletteLineEnd
+	       && pCyclePalette->LineCycles >= ScanLineCycleCount
+	       && pCyclePalette->LineCycles < nCycles
+	       && (pCyclePalette->LineCycles & 3) == 0)
+	{
+		Spec512_SetPaletteEntry(pCyclePalette);
+		pCyclePalette += 1;
+	}
+	/* Next 4 cycles span at or after given position */
+	ScanLineCycleCount += ((nCycles - ScanLineCycleCount + 3) & ~3);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Scan whole line and build up palette - need to do this so when get to screen line we have
+ * the correct 16 colours set
+ */
+void Spec512_ScanWholeLine(void)
+{
+	Spec512_NextScanLine();
 	Spec512_EndScanLine();        /* Read whole line of palettes and update 'STRGBPalette' */
 }
 
@@ -306,13 +409,9 @@ void Spec512_ScanWholeLine(void)
  */
 void Spec512_StartScanLine(void)
 {
-	int i;
 	int LineStartCycle;
 
-	/* Store pointer to line of palette cycle writes */
-	pCyclePalette = &CyclePalettes[nScanLine*MAX_CYCLEPALETTES_PERLINE];
-	/* Ready for next scan line */
-	nScanLine++;
+	Spec512_NextScanLine();
 
 	if ( nScanlinesPerFrame == SCANLINES_PER_FRAME_50HZ )
 		LineStartCycle = LINE_START_CYCLE_50;			/* The screen was 50 Hz */
@@ -320,18 +419,18 @@ void Spec512_StartScanLine(void)
 		LineStartCycle = LINE_START_CYCLE_60;			/* The screen was 60 Hz */
 
 	/* Update palette entries until we reach start of displayed screen */
-	ScanLineCycleCount = 0;
 //	for(i=0; i<((SCREEN_START_CYCLE-16)/4); i++)  /* This '16' is as we've already added in the 'move' instruction timing */
 #ifdef OLD_CYC_PAL
-	for (i=0; i<((LineStartCycle-SCREENBYTES_LEFT*2)/4 + 6); i++)	/* [NP] '6' is required to align pixels and colors */
+	/* [NP] '6' is required to align pixels and colors */
+	Spec512_UpdatePaletteUntil(((LineStartCycle-SCREENBYTES_LEFT*2)/4 + 6) * 4);
 #else
-	for (i=0; i<((LineStartCycle-SCREENBYTES_LEFT*2)/4 + 7); i++)	/* [NP] '7' is required to align pixels and colors */
+	/* [NP] '7' is required to align pixels and colors */
+	Spec512_UpdatePaletteUntil(((LineStartCycle-SCREENBYTES_LEFT*2)/4 + 7) * 4);
 #endif
-		Spec512_UpdatePaletteSpan();              /* Update palette for this 4-cycle period */
 
 	/* And skip for left border is not using overscan display to user */
-	for (i=0; i<(STScreenLeftSkipBytes/2); i++)   /* Eg, 16 bytes = 32 pixels or 8 palette periods */
-		Spec512_UpdatePaletteSpan();
+	/* Eg, 16 bytes = 32 pixels or 8 palette periods */
+	Spec512_UpdatePaletteUntil(ScanLineCycleCount + (STScreenLeftSkipBytes/2) * 4);
 }
 
 
@@ -342,8 +441,8 @@ void Spec512_StartScanLine(void)
 void Spec512_EndScanLine(void)
 {
 	/* Continue to reads palette until complete so have correct version for next line */
-	while (ScanLineCycleCount < nCyclesPerLine)
-		Spec512_UpdatePaletteSpan();
+	if (ScanLineCycleCount < nCyclesPerLine)
+		Spec512_UpdatePaletteUntil(nCyclesPerLine);
 }
 
 
@@ -353,15 +452,11 @@ void Spec512_EndScanLine(void)
  */
 void Spec512_UpdatePaletteSpan(void)
 {
-	if (pCyclePalette->LineCycles == ScanLineCycleCount)
+	if (pCyclePalette < pCyclePaletteLineEnd
+	    && pCyclePalette->LineCycles == ScanLineCycleCount)
 	{
 		/* Need to update palette with new entry */
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-		STRGBPalette[STRGBPalEndianTable[pCyclePalette->Index]] = ST2RGB[pCyclePalette->Colour];
-#else
-		STRGBPalette[pCyclePalette->Index] = ST2RGB[pCyclePalette->Colour];
-//fprintf ( stderr , "upd spec cyc %d %x %x\n" , ScanLineCycleCount , pCyclePalette->Index , pCyclePalette->Colour );
-#endif
+		Spec512_SetPaletteEntry(pCyclePalette);
 		pCyclePalette += 1;
 	}
 	ScanLineCycleCount += 4;      /* Next 4 cycles */
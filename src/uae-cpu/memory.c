@@ -58,6 +58,9 @@ addrbank *mem_banks[65536];
 addrbank mem_banks[65536];
 #endif
 
+uae_u8 *mem_hostpage_read[65536];
+uae_u8 *mem_hostpage_write[65536];
+
 #ifdef NO_INLINE_MEMORY_ACCESS
 __inline__ uae_u32 longget (uaecptr addr)
 {
@@ -668,6 +671,27 @@ static void init_mem_banks (void)
     int i;
     for (i = 0; i < 65536; i++)
 	put_mem_bank (i<<16, &dummy_bank);
+    memset(mem_hostpage_read, 0, sizeof(mem_hostpage_read));
+    memset(mem_hostpage_write, 0, sizeof(mem_hostpage_write));
+}
+
+
+/*
+ * Set the bank of a 64 kiB page and its host pointers for the inlined
+ * memory accessors. Only plain RAM and ROM can be accessed directly,
+ * writes to ROM still go through the bank to raise a bus error.
+ */
+static void map_page (addrbank *bank, int bnr)
+{
+    uaecptr addr = (uaecptr)bnr << 16;
+    uae_u8 *p = NULL;
+
+    put_mem_bank (addr, bank);
+
+    if (bank == &STmem_bank || bank == &TTmem_bank || bank == &ROMmem_bank)
+	p = bank->xlateaddr(addr);
+    mem_hostpage_read[bnr] = p;
+    mem_hostpage_write[bnr] = (bank == &ROMmem_bank) ? NULL : p;
 }
 
 
@@ -803,7 +827,7 @@ void map_banks (addrbank *bank, int start, int size)
 
     if (start >= 0x100) {
 	for (bnr = start; bnr < start + size; bnr++)
-	    put_mem_bank (bnr << 16, bank);
+	    map_page (bank, bnr);
 	return;
     }
     /* Some ROMs apparently require a 24 bit address space... */
@@ -811,5 +835,5 @@ void map_banks (addrbank *bank, int start, int size)
 	endhioffs = 0x10000;
     for (hioffs = 0; hioffs < endhioffs; hioffs += 0x100)
 	for (bnr = start; bnr < start+size; bnr++)
-	    put_mem_bank ((bnr + hioffs) << 16, bank);
+	    map_page (bank, bnr + hioffs);
 }
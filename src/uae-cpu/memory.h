@@ -70,6 +70,14 @@ extern void memory_init(uae_u32 nNewSTMemSize, uae_u32 nNewTTMemSize, uae_u32 nN
 extern void memory_uninit (void);
 extern void map_banks(addrbank *bank, int first, int count);
 
+/* Host pointers to the start of each 64 kiB page for the plain RAM and ROM
+ * banks, or NULL for pages that must go through the addrbank functions
+ * (IO, bus error, void and supervisor protected memory). ROM pages are
+ * only present in the read table, so that writes still cause bus errors. */
+extern uae_u8 *mem_hostpage_read[65536];
+extern uae_u8 *mem_hostpage_write[65536];
+#define hostpage_offset(addr) (((uaecptr)(addr)) & 0xffff)
+
 #ifndef NO_INLINE_MEMORY_ACCESS
 
 #define longget(addr) (call_mem_get_func(get_mem_bank(addr).lget, addr))
@@ -95,32 +103,53 @@ extern void byteput(uaecptr addr, uae_u32 b);
 
 static inline uae_u32 get_long(uaecptr addr)
 {
+    uae_u8 *p = mem_hostpage_read[bankindex(addr)];
+    if (p)
+	return do_get_mem_long(p + hostpage_offset(addr));
     return longget(addr);
 }
 
 static inline uae_u32 get_word(uaecptr addr)
 {
+    uae_u8 *p = mem_hostpage_read[bankindex(addr)];
+    if (p)
+	return do_get_mem_word(p + hostpage_offset(addr));
     return wordget(addr);
 }
 
 static inline uae_u32 get_byte(uaecptr addr)
 {
+    uae_u8 *p = mem_hostpage_read[bankindex(addr)];
+    if (p)
+	return p[hostpage_offset(addr)];
     return byteget(addr);
 }
 
 static inline void put_long(uaecptr addr, uae_u32 l)
 {
-    longput(addr, l);
+    uae_u8 *p = mem_hostpage_write[bankindex(addr)];
+    if (p)
+	do_put_mem_long(p + hostpage_offset(addr), l);
+    else
+	longput(addr, l);
 }
 
 static inline void put_word(uaecptr addr, uae_u32 w)
 {
-    wordput(addr, w);
+    uae_u8 *p = mem_hostpage_write[bankindex(addr)];
+    if (p)
+	do_put_mem_word(p + hostpage_offset(addr), w);
+    else
+	wordput(addr, w);
 }
 
 static inline void put_byte(uaecptr addr, uae_u32 b)
 {
-    byteput(addr, b);
+    uae_u8 *p = mem_hostpage_write[bankindex(addr)];
+    if (p)
+	p[hostpage_offset(addr)] = b;
+    else
+	byteput(addr, b);
 }
 
 static inline uae_u8 *get_real_address(uaecptr addr)
@@ -142,6 +142,8 @@ const char NewCpu_fileid[] = "Hatari newcpu.c : " __DATE__ " " __TIME__;
 #include "debugui.h"
 #include "debugcpu.h"
 #include "68kDisass.h"
+#include "configuration.h"
+#include "ioMem.h"
 
 //#define DEBUG_PREFETCH
 
@@ -880,14 +882,19 @@ void Exception(int nr, uaecptr oldpc, int ExceptionSource)
         if (bVdiAesIntercept && nr == 0x22)
         {
           /* Intercept VDI & AES exceptions (Trap #2) */
-          if(VDI_AES_Entry())
+          switch (VDI_AES_Entry())
           {
+          case VDI_ENTRY_DONE:
+            /* Call was done natively, skip the trap */
+            return;
+          case VDI_ENTRY_COMPLETE:
             /* Set 'PC' to address of 'VDI_OPCODE' illegal instruction.
              * This will call OpCode_VDI() after completion of Trap call!
              * This is used to modify specific VDI return vectors contents.
 	     */
             VDI_OldPC = currpc;
             currpc = CART_VDI_OPCODE_ADDR;
+            break;
           }
         }
 
@@ -1678,6 +1685,123 @@ static int do_specialties (void)
 }
 
 
+/*
+ * Spin-loop detection (--spinloop-skip).
+ * A small loop closed by a backward Bcc, which only contains instructions
+ * that don't write to memory and which doesn't read IO registers, can
+ * only see different data after an interrupt handler or a DMA transfer
+ * ran, which both happen from PendingInterruptFunction. So when two
+ * consecutive iterations end with the same registers and take the same
+ * number of cycles, we can add the cycles of all the iterations that would
+ * run before the next pending interrupt at once.
+ * This is done only in m68k_run_1(), i.e. in the cpu_compatible mode.
+ */
+#define SPINLOOP_MAX_SIZE	32	/* max. size of a loop in bytes */
+
+static struct {
+    bool active;
+    uaecptr start, end;		/* loop start and address of the Bcc back to it */
+    int iterations;		/* number of identical iterations seen */
+    int cycles;			/* cycles of one iteration */
+    Uint64 clock;		/* CyclesGlobalClockCounter at previous loop start */
+    Uint32 ioreads;		/* IoAccessReadCount at previous loop start */
+    uae_u32 regs[16];
+    uae_u16 sr;
+} spinloop;
+
+static void spinloop_reset(void)
+{
+    spinloop.active = false;
+}
+
+/* Only instructions without side effects other than on registers */
+static bool spinloop_opcode_ok(uae_u32 opcode)
+{
+    const struct instr *dp = &table68k[opcode];
+
+    switch (dp->mnemo) {
+     case i_TST: case i_CMP: case i_CMPA: case i_BTST: case i_Bcc: case i_NOP:
+	return true;
+     case i_MOVE: case i_MOVEA: case i_AND: case i_OR: case i_EOR:
+	return dp->dmode == Dreg || dp->dmode == Areg;
+     default:
+	return false;
+    }
+}
+
+static void spinloop_snapshot(void)
+{
+    MakeSR();
+    memcpy(spinloop.regs, regs.regs, sizeof(spinloop.regs));
+    spinloop.sr = regs.sr;
+    spinloop.clock = CyclesGlobalClockCounter;
+    spinloop.ioreads = IoAccessReadCount;
+}
+
+/* Called each time the loop branches back to its start */
+static void spinloop_iteration(void)
+{
+    int cycles = CyclesGlobalClockCounter - spinloop.clock;
+    int internal, count;
+
+    MakeSR();
+    if (regs.spcflags || IoAccessReadCount != spinloop.ioreads
+        || regs.sr != spinloop.sr
+        || memcmp(spinloop.regs, regs.regs, sizeof(spinloop.regs)) != 0)
+    {
+	spinloop.iterations = 0;
+	spinloop_snapshot();
+	return;
+    }
+
+    if (spinloop.iterations == 0 || cycles != spinloop.cycles) {
+	spinloop.cycles = cycles;
+	spinloop.iterations = 1;
+	spinloop.clock = CyclesGlobalClockCounter;
+	return;
+    }
+    spinloop.iterations++;
+    spinloop.clock = CyclesGlobalClockCounter;
+
+    /* Skip whole iterations, the one reaching the interrupt is run normally */
+    internal = INT_CONVERT_TO_INTERNAL(cycles, INT_CPU_CYCLE);
+    if (!PendingInterruptFunction || internal <= 0 || PendingInterruptCount <= internal)
+	return;
+    count = (PendingInterruptCount - 1) / internal;
+
+    PendingInterruptCount -= count * internal;
+    nCyclesMainCounter += count * cycles;
+    CyclesGlobalClockCounter += (Uint64)count * cycles;
+    spinloop.clock = CyclesGlobalClockCounter;
+}
+
+/* Called after each instruction when spin-loop detection is enabled */
+static void spinloop_check(uae_u32 opcode, uaecptr oldpc)
+{
+    uaecptr pc = m68k_getpc();
+
+    if (spinloop.active) {
+	if (oldpc < spinloop.start || oldpc > spinloop.end
+	    || !spinloop_opcode_ok(opcode))
+	    spinloop.active = false;
+	else {
+	    if (oldpc == spinloop.end && pc == spinloop.start)
+		spinloop_iteration();
+	    return;
+	}
+    }
+
+    if (pc < oldpc && oldpc - pc <= SPINLOOP_MAX_SIZE
+        && table68k[opcode].mnemo == i_Bcc && !bDspEnabled) {
+	spinloop.active = true;
+	spinloop.start = pc;
+	spinloop.end = oldpc;
+	spinloop.iterations = 0;
+	spinloop_snapshot();
+    }
+}
+
+
 /* It's really sad to have two almost identical functions for this, but we
    do it all for performance... :( */
 static void m68k_run_1 (void)
@@ -1746,6 +1870,9 @@ static void m68k_run_1 (void)
 	  nWaitStateCycles = 0;
 	}
 
+	if (ConfigureParams.System.bSpinLoopSkip)
+	    spinloop_check(opcode, BusErrorPC);
+
 	/* We can have several interrupts at the same time before the next CPU instruction */
 	/* We must check for pending interrupt and call do_specialties_interrupt() only */
 	/* if the cpu is not in the STOP state. Else, the int could be acknowledged now */
@@ -1753,6 +1880,7 @@ static void m68k_run_1 (void)
 	/* For performance, we first test PendingInterruptCount, then regs.spcflags */
 	if ( PendingInterruptCount <= 0 )
 	{
+	    spinloop_reset();
 	    while ( ( PendingInterruptCount <= 0 ) && ( PendingInterruptFunction ) && ( ( regs.spcflags & SPCFLAG_STOP ) == 0 ) )
 		CALL_VAR ( PendingInterruptFunction );		/* call the interrupt's handler */
 	    if ( MFP_UpdateNeeded == true )
@@ -1760,6 +1888,7 @@ static void m68k_run_1 (void)
 	}
 
 	if (regs.spcflags) {
+	    spinloop_reset();
 	    if (do_specialties ())
 		return;
 	}
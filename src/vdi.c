@@ -20,6 +20,7 @@ const char VDI_fileid[] = "Hatari vdi.c : " __DATE__ " " __TIME__;
 #include "screen.h"
 #include "stMemory.h"
 #include "vdi.h"
+#include "vdidraw.h"
 #include "video.h"
 #include "configuration.h"
 
@@ -159,6 +160,7 @@ void VDI_Reset(void)
 {
 	/* no VDI calls in progress */
 	VDI_OldPC = 0;
+	VDIDraw_Reset();
 }
 
 /*-----------------------------------------------------------------------*/
@@ -766,7 +768,7 @@ void VDI_Info(Uint32 bShowOpcodes)
 
 /*-----------------------------------------------------------------------*/
 /**
- * Return true for only VDI opcodes that need to be handled at Trap exit.
+ * Return true for VDI workstation open opcodes.
  */
 static inline bool VDI_isWorkstationOpen(Uint16 opcode)
 {
@@ -778,13 +780,14 @@ static inline bool VDI_isWorkstationOpen(Uint16 opcode)
 
 /**
  * Check whether this is VDI/AES call and see if we need to re-direct
- * it to our own routines. Return true if VDI_Complete() function
- * needs to be called on OS call exit, otherwise return false.
+ * it to our own routines. Return VDI_ENTRY_COMPLETE if VDI_Complete()
+ * function needs to be called on OS call exit, VDI_ENTRY_DONE if the call
+ * was already handled natively, otherwise VDI_ENTRY_PASS.
  *
  * We enter here with Trap #2, so D0 tells which OS call it is (VDI/AES)
  * and D1 is pointer to VDI/AES vectors, i.e. Control, Intin, Ptsin etc...
  */
-bool VDI_AES_Entry(void)
+int VDI_AES_Entry(void)
 {
 	Uint16 call = Regs[REG_D0];
 	Uint32 TablePtr = Regs[REG_D1];
@@ -796,7 +799,7 @@ bool VDI_AES_Entry(void)
 		if (!STMemory_ValidArea(TablePtr, 24))
 		{
 			Log_Printf(LOG_WARN, "AES call failed due to invalid parameter block address 0x%x+%i\n", TablePtr, 24);
-			return false;
+			return VDI_ENTRY_PASS;
 		}
 		/* store values for debugger "info aes" command */
 		AESControl = STMemory_ReadLong(TablePtr);
@@ -814,7 +817,7 @@ bool VDI_AES_Entry(void)
 		 * both VDI & AES as AES functions can be called
 		 * recursively and VDI calls happen inside AES calls.
 		 */
-		return false;
+		return VDI_ENTRY_PASS;
 	}
 #endif
 
@@ -824,7 +827,7 @@ bool VDI_AES_Entry(void)
 		if (!STMemory_ValidArea(TablePtr, 20))
 		{
 			Log_Printf(LOG_WARN, "VDI call failed due to invalid parameter block address 0x%x+%i\n", TablePtr, 20);
-			return false;
+			return VDI_ENTRY_PASS;
 		}
 		/* store values for extended VDI resolution handling
 		 * and debugger "info vdi" command
@@ -843,12 +846,19 @@ bool VDI_AES_Entry(void)
 			  VDI_Opcode2Name(VDIOpCode, subcode));
 		}
 #endif
-		/* Only workstation open needs to be handled at trap return */
-		return bUseVDIRes && VDI_isWorkstationOpen(VDIOpCode);
+		if (!bUseVDIRes)
+			return VDI_ENTRY_PASS;
+		/* workstation open needs to be handled at trap return */
+		if (VDI_isWorkstationOpen(VDIOpCode))
+			return VDI_ENTRY_COMPLETE;
+		if (ConfigureParams.Screen.bVdiNativeDraw || VDIDraw_IsRecording())
+			return VDIDraw_Entry(VDIControl, VDIIntin, VDIPtsin,
+			                     ConfigureParams.Screen.bVdiNativeDraw);
+		return VDI_ENTRY_PASS;
 	}
 
 	LOG_TRACE((TRACE_OS_VDI|TRACE_OS_AES), "Trap #2 with D0 = 0x%hX\n", call);
-	return false;
+	return VDI_ENTRY_PASS;
 }
 
 
@@ -873,21 +883,27 @@ void VDI_LineA(Uint32 linea, Uint32 fontbase)
 	}
 	LineABase = linea;
 	FontBase = fontbase;
+	VDIDraw_SetFonts(fontbase);
 }
 
 
 /*-----------------------------------------------------------------------*/
 /**
  * This is called on completion of a VDI Trap workstation open,
- * to modify the return structure for extended resolutions.
+ * to modify the return structure for extended resolutions, and
+ * on completion of the attribute calls tracked by native drawing.
  */
 void VDI_Complete(void)
 {
-	/* right opcode? */
-	assert(VDI_isWorkstationOpen(VDIOpCode));
 	/* not changed between entry and completion? */
 	assert(VDIOpCode == STMemory_ReadWord(VDIControl));
 
+	if (!VDI_isWorkstationOpen(VDIOpCode))
+	{
+		VDIDraw_Complete(VDIControl, VDIIntin, VDIPtsin, VDIIntout, VDIPtsout);
+		return;
+	}
+
 	STMemory_WriteWord(VDIIntout, VDIWidth-1);           /* IntOut[0] Width-1 */
 	STMemory_WriteWord(VDIIntout+1*2, VDIHeight-1);      /* IntOut[1] Height-1 */
 	STMemory_WriteWord(VDIIntout+13*2, 1 << VDIPlanes);  /* IntOut[13] #colors */
@@ -897,6 +913,9 @@ void VDI_Complete(void)
 	STMemory_WriteWord(LineABase-0x159*2, VDIHeight-1);  /* WKYRez */
 
 	VDI_LineA(LineABase, FontBase);  /* And modify Line-A structure accordingly */
+
+	if (ConfigureParams.Screen.bVdiNativeDraw || VDIDraw_IsRecording())
+		VDIDraw_Complete(VDIControl, VDIIntin, VDIPtsin, VDIIntout, VDIPtsout);
 }
 
 
@@ -0,0 +1,996 @@
+/*
+  Hatari - vdidraw.c
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  Native VDI drawing for the extended VDI resolutions.
+
+  TOS VDI drawing on large (e.g. 1920x1200) screens is slow because it's
+  all emulated 68000 code.  Here the most common drawing functions (solid
+  and hollow rectangle fills, thin solid polylines, raster copies and
+  system font text) are done directly into the interleaved bitplane
+  screen at host speed.  Attribute calls are still run by TOS, their
+  results are just tracked per workstation handle at the trap exit.
+  Everything that isn't supported here (patterns, wide or styled lines,
+  text effects, GDOS fonts...) falls back to the TOS code.
+
+  The VDI calls can also be recorded to a file, for replaying them with
+  the benchmark in tests/vdi/.  Stream is big endian, it starts with
+  "VDIR" magic and version, width, height & planes words, followed by
+  records, each of which starts with the record type word:
+  - open/attrib/draw records: contrl, intin, ptsin, intout & ptsout
+    arrays and MFDB array (for vro_cpyfm), each array as a word count
+    followed by that many words
+  - fonts record: three fonts, each as font header (44 words), offset
+    table word count & words, and font data word count & words
+*/
+const char VDIDraw_fileid[] = "Hatari vdidraw.c : " __DATE__ " " __TIME__;
+
+#include "main.h"
+#include "log.h"
+#include "memorySnapShot.h"
+#include "stMemory.h"
+#include "vdi.h"
+#include "vdidraw.h"
+
+
+#define VDIDRAW_MAX_HANDLES  128
+#define VDIDRAW_FONTS        3          /* 6x6, 8x8 and 8x16 system fonts */
+#define VDIDRAW_LINE_BUFFER  8192       /* max. bytes per raster copy line */
+
+/* VDI opcodes handled here */
+#define VDI_V_OPNWK         1
+#define VDI_V_CLSWK         2
+#define VDI_V_PLINE         6
+#define VDI_V_GTEXT         8
+#define VDI_V_GDP           11          /* sub-opcode 1 = v_bar */
+#define VDI_VST_HEIGHT      12
+#define VDI_VST_ROTATION    13
+#define VDI_VSL_TYPE        15
+#define VDI_VSL_WIDTH       16
+#define VDI_VSL_COLOR       17
+#define VDI_VST_FONT        21
+#define VDI_VST_COLOR       22
+#define VDI_VSF_INTERIOR    23
+#define VDI_VSF_COLOR       25
+#define VDI_VSWR_MODE       32
+#define VDI_VST_ALIGNMENT   39
+#define VDI_V_OPNVWK        100
+#define VDI_V_CLSVWK        101
+#define VDI_VSF_PERIMETER   104
+#define VDI_VST_EFFECTS     106
+#define VDI_VST_POINT       107
+#define VDI_VSL_ENDS        108
+#define VDI_VRO_CPYFM       109
+#define VDI_VR_RECFL        114
+#define VDI_VS_CLIP         129
+
+/* writing modes */
+#define MD_REPLACE  1
+#define MD_TRANS    2
+#define MD_XOR      3
+#define MD_ERASE    4
+
+/* font header offsets */
+#define FONT_TOP          40
+#define FONT_ASCENT       42
+#define FONT_HALF         44
+#define FONT_DESCENT      46
+#define FONT_BOTTOM       48
+#define FONT_FIRST_ADE    36
+#define FONT_LAST_ADE     38
+#define FONT_OFF_TABLE    72
+#define FONT_DAT_TABLE    76
+#define FONT_FORM_WIDTH   80
+#define FONT_FORM_HEIGHT  82
+#define FONT_HEADER_SIZE  88
+
+/* attributes of a VDI workstation, as returned by TOS */
+typedef struct
+{
+	bool bOpen;
+	Uint16 WriteMode;
+	bool bClip;
+	Sint16 ClipX1, ClipY1, ClipX2, ClipY2;
+	Uint16 LineType, LineWidth, LineColor, LineBegEnd, LineEndEnd;
+	Uint16 FillInterior, FillColor;
+	bool bFillPerimeter;
+	Uint16 TextColor, TextEffects, TextRotation, TextFont;
+	Uint16 TextHorAlign, TextVerAlign, TextCellHeight;
+} VDIDRAW_WORKSTATION;
+
+static VDIDRAW_WORKSTATION Workstation[VDIDRAW_MAX_HANDLES];
+
+static Uint32 FontHeader[VDIDRAW_FONTS];  /* system font header addresses */
+
+/* state for the drawing call in progress */
+static Uint8 *pScreen;
+static int BytesPerLine;
+static int ClipX1, ClipY1, ClipX2, ClipY2;
+static int DrawMode;
+
+static char *pszRecordFileName;
+static FILE *RecordFile;
+static bool bRecordFonts;
+
+/* VDI color index -> bitplane pixel value */
+static const Uint16 ColorMap16[16] =
+{
+	0, 15, 1, 2, 4, 6, 3, 5, 7, 8, 9, 10, 12, 14, 11, 13
+};
+static const Uint16 ColorMap4[4] = { 0, 3, 1, 2 };
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return bitplane pixel value for given VDI color index
+ */
+static int VDIDraw_MapColor(Uint16 color)
+{
+	if (color >= (1 << VDIPlanes))
+		color = 1;
+	switch (VDIPlanes)
+	{
+	case 4:
+		return ColorMap16[color];
+	case 2:
+		return ColorMap4[color];
+	default:
+		return color;
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Recording helpers, all values are stored as big endian words
+ */
+static void VDIDraw_RecordWord(Uint16 value)
+{
+	fputc(value >> 8, RecordFile);
+	fputc(value & 0xff, RecordFile);
+}
+
+static void VDIDraw_RecordWords(Uint32 addr, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		VDIDraw_RecordWord(STMemory_ReadWord(addr + 2*i));
+}
+
+static void VDIDraw_RecordArray(Uint32 addr, int count)
+{
+	if (count < 0 || !STMemory_ValidArea(addr, 2*count))
+		count = 0;
+	VDIDraw_RecordWord(count);
+	VDIDraw_RecordWords(addr, count);
+}
+
+/**
+ * Open the record file and write its header if that's not yet done.
+ * Return false if recording isn't enabled or file can't be written.
+ */
+static bool VDIDraw_RecordStart(void)
+{
+	if (!pszRecordFileName)
+		return false;
+	if (!RecordFile)
+	{
+		RecordFile = fopen(pszRecordFileName, "wb");
+		if (!RecordFile)
+		{
+			Log_Printf(LOG_WARN, "Can't open VDI record file '%s'!\n", pszRecordFileName);
+			free(pszRecordFileName);
+			pszRecordFileName = NULL;
+			return false;
+		}
+		fputs(VDIDRAW_REC_MAGIC, RecordFile);
+		VDIDraw_RecordWord(VDIDRAW_REC_VERSION);
+		VDIDraw_RecordWord(VDIWidth);
+		VDIDraw_RecordWord(VDIHeight);
+		VDIDraw_RecordWord(VDIPlanes);
+		bRecordFonts = true;
+	}
+	if (bRecordFonts && FontHeader[0] && FontHeader[1] && FontHeader[2])
+	{
+		int i, first, last, bytes;
+		Uint32 font;
+
+		VDIDraw_RecordWord(VDIDRAW_REC_FONTS);
+		for (i = 0; i < VDIDRAW_FONTS; i++)
+		{
+			font = FontHeader[i];
+			first = STMemory_ReadWord(font + FONT_FIRST_ADE);
+			last = STMemory_ReadWord(font + FONT_LAST_ADE);
+			bytes = STMemory_ReadWord(font + FONT_FORM_WIDTH)
+			        * STMemory_ReadWord(font + FONT_FORM_HEIGHT);
+			VDIDraw_RecordArray(font, FONT_HEADER_SIZE/2);
+			VDIDraw_RecordArray(STMemory_ReadLong(font + FONT_OFF_TABLE), last - first + 2);
+			VDIDraw_RecordArray(STMemory_ReadLong(font + FONT_DAT_TABLE), (bytes + 1) / 2);
+		}
+		bRecordFonts = false;
+	}
+	return true;
+}
+
+/**
+ * Record VDI call parameter arrays
+ */
+static void VDIDraw_Record(int type, Uint32 control, Uint32 intin, Uint32 ptsin,
+                           Uint32 intout, Uint32 ptsout)
+{
+	Uint16 opcode;
+
+	if (!VDIDraw_RecordStart())
+		return;
+
+	opcode = STMemory_ReadWord(control);
+	VDIDraw_RecordWord(type);
+	VDIDraw_RecordArray(control, 12);
+	VDIDraw_RecordArray(intin, STMemory_ReadWord(control+2*3));
+	VDIDraw_RecordArray(ptsin, 2*STMemory_ReadWord(control+2*1));
+	if (type == VDIDRAW_REC_DRAW)
+	{
+		VDIDraw_RecordWord(0);
+		VDIDraw_RecordWord(0);
+	}
+	else
+	{
+		VDIDraw_RecordArray(intout, STMemory_ReadWord(control+2*4));
+		VDIDraw_RecordArray(ptsout, 2*STMemory_ReadWord(control+2*2));
+	}
+	if (type == VDIDRAW_REC_DRAW && opcode == VDI_VRO_CPYFM)
+	{
+		/* source & destination MFDBs */
+		VDIDraw_RecordWord(20);
+		VDIDraw_RecordWords(STMemory_ReadLong(control+2*7), 10);
+		VDIDraw_RecordWords(STMemory_ReadLong(control+2*9), 10);
+	}
+	else
+	{
+		VDIDraw_RecordWord(0);
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Set up the drawing state for a call on given workstation.
+ * Return false if the screen isn't usable.
+ */
+static bool VDIDraw_Begin(const VDIDRAW_WORKSTATION *ws)
+{
+	Uint32 addr = STMemory_ReadLong(0x44e) & 0xffffff;
+
+	BytesPerLine = VDIWidth * VDIPlanes / 8;
+	if (addr + BytesPerLine * VDIHeight > STRamEnd)
+		return false;
+	pScreen = &STRam[addr];
+
+	ClipX1 = 0;
+	ClipY1 = 0;
+	ClipX2 = VDIWidth - 1;
+	ClipY2 = VDIHeight - 1;
+	if (ws->bClip)
+	{
+		if (ws->ClipX1 > ClipX1)  ClipX1 = ws->ClipX1;
+		if (ws->ClipY1 > ClipY1)  ClipY1 = ws->ClipY1;
+		if (ws->ClipX2 < ClipX2)  ClipX2 = ws->ClipX2;
+		if (ws->ClipY2 < ClipY2)  ClipY2 = ws->ClipY2;
+	}
+	DrawMode = ws->WriteMode;
+	return true;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Write one 16-pixel group of all bitplanes.  'mask' selects the pixels
+ * to modify and 'pattern' the ones set to the foreground color 'color'.
+ */
+static inline void VDIDraw_WriteGroup(Uint8 *p, Uint16 mask, Uint16 pattern, int color)
+{
+	Uint16 data, affected, set;
+	int plane;
+
+	switch (DrawMode)
+	{
+	case MD_XOR:
+		affected = mask & pattern;
+		for (plane = 0; plane < VDIPlanes; plane++, p += 2)
+			do_put_mem_word(p, do_get_mem_word(p) ^ affected);
+		return;
+	case MD_TRANS:
+		affected = set = mask & pattern;
+		break;
+	case MD_ERASE:
+		affected = set = mask & ~pattern;
+		break;
+	default:
+		affected = mask;
+		set = mask & pattern;
+		break;
+	}
+	if (!affected)
+		return;
+	for (plane = 0; plane < VDIPlanes; plane++, p += 2)
+	{
+		data = do_get_mem_word(p) & ~affected;
+		if (color & (1 << plane))
+			data |= set;
+		do_put_mem_word(p, data);
+	}
+}
+
+/**
+ * Draw horizontal span from x1 to x2 (inclusive) on line y,
+ * clipped to the current clipping rectangle.
+ */
+static void VDIDraw_HLine(int x1, int x2, int y, Uint16 pattern, int color)
+{
+	Uint8 *p;
+	Uint16 first, last;
+	int group, count, step;
+
+	if (y < ClipY1 || y > ClipY2)
+		return;
+	if (x1 < ClipX1)  x1 = ClipX1;
+	if (x2 > ClipX2)  x2 = ClipX2;
+	if (x1 > x2)
+		return;
+
+	step = 2 * VDIPlanes;
+	group = x1 >> 4;
+	count = (x2 >> 4) - group;
+	p = pScreen + y * BytesPerLine + group * step;
+	first = 0xffff >> (x1 & 15);
+	last = 0xffff << (15 - (x2 & 15));
+
+	if (!count)
+	{
+		VDIDraw_WriteGroup(p, first & last, pattern, color);
+		return;
+	}
+	VDIDraw_WriteGroup(p, first, pattern, color);
+	while (--count > 0)
+	{
+		p += step;
+		VDIDraw_WriteGroup(p, 0xffff, pattern, color);
+	}
+	VDIDraw_WriteGroup(p + step, last, pattern, color);
+}
+
+/**
+ * Draw a thin solid line with Bresenham's algorithm
+ */
+static void VDIDraw_Line(int x1, int y1, int x2, int y2, int color)
+{
+	int dx, dy, sx, sy, err, e2;
+
+	if (y1 == y2)
+	{
+		if (x1 > x2)
+			VDIDraw_HLine(x2, x1, y1, 0xffff, color);
+		else
+			VDIDraw_HLine(x1, x2, y1, 0xffff, color);
+		return;
+	}
+	dx = abs(x2 - x1);
+	dy = -abs(y2 - y1);
+	sx = x1 < x2 ? 1 : -1;
+	sy = y1 < y2 ? 1 : -1;
+	err = dx + dy;
+	for (;;)
+	{
+		VDIDraw_HLine(x1, x1, y1, 0xffff, color);
+		if (x1 == x2 && y1 == y2)
+			break;
+		e2 = 2 * err;
+		if (e2 >= dy)
+		{
+			err += dy;
+			x1 += sx;
+		}
+		if (e2 <= dx)
+		{
+			err += dx;
+			y1 += sy;
+		}
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * v_pline, only for solid lines that are one pixel wide
+ */
+static bool VDIDraw_Polyline(const VDIDRAW_WORKSTATION *ws, Uint32 control, Uint32 ptsin)
+{
+	int i, count, color, x1, y1, x2, y2;
+
+	count = STMemory_ReadWord(control+2*1);
+	if (ws->LineType != 1 || ws->LineWidth != 1 || ws->LineBegEnd || ws->LineEndEnd)
+		return false;
+	/* TOS skips the shared points between XORed line segments */
+	if (ws->WriteMode == MD_XOR && count > 2)
+		return false;
+	if (!STMemory_ValidArea(ptsin, 4*count) || !VDIDraw_Begin(ws))
+		return false;
+
+	color = VDIDraw_MapColor(ws->LineColor);
+	x1 = (Sint16)STMemory_ReadWord(ptsin);
+	y1 = (Sint16)STMemory_ReadWord(ptsin+2);
+	for (i = 1; i < count; i++)
+	{
+		x2 = (Sint16)STMemory_ReadWord(ptsin+4*i);
+		y2 = (Sint16)STMemory_ReadWord(ptsin+4*i+2);
+		VDIDraw_Line(x1, y1, x2, y2, color);
+		x1 = x2;
+		y1 = y2;
+	}
+	return true;
+}
+
+/**
+ * vr_recfl and v_bar with hollow or solid interior
+ */
+static bool VDIDraw_Rectangle(const VDIDRAW_WORKSTATION *ws, Uint32 ptsin, bool bPerimeter)
+{
+	int x1, y1, x2, y2, y, color, tmp;
+	Uint16 pattern;
+
+	if (ws->FillInterior == 0)
+		pattern = 0;
+	else if (ws->FillInterior == 1)
+		pattern = 0xffff;
+	else
+		return false;
+	/* perimeter would XOR the corners twice */
+	if (bPerimeter && ws->WriteMode == MD_XOR)
+		return false;
+	if (!STMemory_ValidArea(ptsin, 8) || !VDIDraw_Begin(ws))
+		return false;
+
+	x1 = (Sint16)STMemory_ReadWord(ptsin);
+	y1 = (Sint16)STMemory_ReadWord(ptsin+2);
+	x2 = (Sint16)STMemory_ReadWord(ptsin+4);
+	y2 = (Sint16)STMemory_ReadWord(ptsin+6);
+	if (x1 > x2)
+	{
+		tmp = x1; x1 = x2; x2 = tmp;
+	}
+	if (y1 > y2)
+	{
+		tmp = y1; y1 = y2; y2 = tmp;
+	}
+
+	color = VDIDraw_MapColor(ws->FillColor);
+	for (y = y1; y <= y2; y++)
+		VDIDraw_HLine(x1, x2, y, pattern, color);
+
+	if (bPerimeter)
+	{
+		VDIDraw_HLine(x1, x2, y1, 0xffff, color);
+		VDIDraw_HLine(x1, x2, y2, 0xffff, color);
+		for (y = y1 + 1; y < y2; y++)
+		{
+			VDIDraw_HLine(x1, x1, y, 0xffff, color);
+			VDIDraw_HLine(x2, x2, y, 0xffff, color);
+		}
+	}
+	return true;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * v_gtext with unrotated system font without effects
+ */
+static bool VDIDraw_Text(const VDIDRAW_WORKSTATION *ws, Uint32 control,
+                         Uint32 intin, Uint32 ptsin)
+{
+	Uint32 font = 0, offtable, data;
+	int i, count, first, last, width, height, formwidth;
+	int x, y, row, col, ch, offset, chwidth, color;
+	Uint8 bits;
+
+	if (ws->TextEffects || ws->TextRotation || ws->TextFont != 1)
+		return false;
+	for (i = 0; i < VDIDRAW_FONTS && FontHeader[i]; i++)
+	{
+		if (STMemory_ReadWord(FontHeader[i] + FONT_FORM_HEIGHT) == ws->TextCellHeight)
+		{
+			font = FontHeader[i];
+			break;
+		}
+	}
+	count = STMemory_ReadWord(control+2*3);
+	if (!font || !STMemory_ValidArea(intin, 2*count)
+	    || !STMemory_ValidArea(ptsin, 4) || !VDIDraw_Begin(ws))
+		return false;
+
+	first = STMemory_ReadWord(font + FONT_FIRST_ADE);
+	last = STMemory_ReadWord(font + FONT_LAST_ADE);
+	offtable = STMemory_ReadLong(font + FONT_OFF_TABLE);
+	data = STMemory_ReadLong(font + FONT_DAT_TABLE);
+	formwidth = STMemory_ReadWord(font + FONT_FORM_WIDTH);
+	height = ws->TextCellHeight;
+
+	/* string width for alignment */
+	width = 0;
+	for (i = 0; i < count; i++)
+	{
+		ch = STMemory_ReadWord(intin + 2*i);
+		if (ch < first || ch > last)
+			return false;
+		width += STMemory_ReadWord(offtable + 2*(ch - first + 1))
+		         - STMemory_ReadWord(offtable + 2*(ch - first));
+	}
+
+	x = (Sint16)STMemory_ReadWord(ptsin);
+	y = (Sint16)STMemory_ReadWord(ptsin+2);
+	switch (ws->TextHorAlign)
+	{
+	case 1:  x -= width / 2;  break;
+	case 2:  x -= width;  break;
+	}
+	switch (ws->TextVerAlign)
+	{
+	case 0:  y -= STMemory_ReadWord(font + FONT_TOP);  break;
+	case 1:  y -= STMemory_ReadWord(font + FONT_TOP) - STMemory_ReadWord(font + FONT_HALF);  break;
+	case 2:  y -= STMemory_ReadWord(font + FONT_TOP) - STMemory_ReadWord(font + FONT_ASCENT);  break;
+	case 3:  y -= STMemory_ReadWord(font + FONT_TOP) + STMemory_ReadWord(font + FONT_BOTTOM);  break;
+	case 4:  y -= STMemory_ReadWord(font + FONT_TOP) + STMemory_ReadWord(font + FONT_DESCENT);  break;
+	}
+
+	color = VDIDraw_MapColor(ws->TextColor);
+	for (i = 0; i < count; i++)
+	{
+		ch = STMemory_ReadWord(intin + 2*i) - first;
+		offset = STMemory_ReadWord(offtable + 2*ch);
+		chwidth = STMemory_ReadWord(offtable + 2*(ch + 1)) - offset;
+		for (row = 0; row < height; row++)
+		{
+			for (col = 0; col < chwidth; col++)
+			{
+				bits = STMemory_ReadByte(data + row * formwidth + ((offset + col) >> 3));
+				bits <<= (offset + col) & 7;
+				VDIDraw_HLine(x + col, x + col, y + row,
+				              (bits & 0x80) ? 0xffff : 0, color);
+			}
+		}
+		x += chwidth;
+	}
+	return true;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Get MFDB memory address and line width in bytes, or false
+ * if the form isn't in device specific (screen) format.
+ */
+static bool VDIDraw_GetForm(Uint32 mfdb, Uint8 **pForm, int *pBytesPerLine, int *pWidth, int *pHeight)
+{
+	Uint32 addr, size;
+
+	if (!STMemory_ValidArea(mfdb, 20))
+		return false;
+	addr = STMemory_ReadLong(mfdb) & 0xffffff;
+	if (addr == 0)
+	{
+		*pForm = pScreen;
+		*pBytesPerLine = BytesPerLine;
+		*pWidth = VDIWidth;
+		*pHeight = VDIHeight;
+		return true;
+	}
+	if (STMemory_ReadWord(mfdb+10) != 0 || STMemory_ReadWord(mfdb+12) != VDIPlanes)
+		return false;
+	*pWidth = STMemory_ReadWord(mfdb+4);
+	*pHeight = STMemory_ReadWord(mfdb+6);
+	*pBytesPerLine = STMemory_ReadWord(mfdb+8) * 2 * VDIPlanes;
+	size = *pBytesPerLine * *pHeight;
+	if (*pBytesPerLine > VDIDRAW_LINE_BUFFER || addr + size > STRamEnd)
+		return false;
+	*pForm = &STRam[addr];
+	return true;
+}
+
+/**
+ * Return 16 bits of given plane from given bit position in the line
+ */
+static inline Uint16 VDIDraw_GetBits(Uint8 *line, int bytes, int plane, int bit)
+{
+	int offset, shift;
+	Uint32 value;
+
+	if (bit < 0)
+		return VDIDraw_GetBits(line, bytes, plane, 0) >> -bit;
+	offset = ((bit >> 4) * VDIPlanes + plane) * 2;
+	shift = bit & 15;
+	value = do_get_mem_word(line + offset) << 16;
+	offset += 2 * VDIPlanes;
+	if (offset < bytes)
+		value |= do_get_mem_word(line + offset);
+	return (value << shift) >> 16;
+}
+
+/**
+ * vro_cpyfm between screen and device format memory forms
+ */
+static bool VDIDraw_CopyRaster(const VDIDRAW_WORKSTATION *ws, Uint32 control,
+                               Uint32 intin, Uint32 ptsin)
+{
+	static Uint8 LineBuffer[VDIDRAW_LINE_BUFFER];
+	Uint8 *src, *dst, *srcline, *dstline;
+	int srcbytes, dstbytes, srcw, srch, dstw, dsth;
+	int sx1, sy1, sx2, sy2, dx1, dy1, dx2, dy2;
+	int mode, bit, row, rows, step, plane, group, lastgroup, mask;
+	Uint16 s, d, m;
+
+	if (!STMemory_ValidArea(intin, 2) || !STMemory_ValidArea(ptsin, 16) || !VDIDraw_Begin(ws))
+		return false;
+	if (!VDIDraw_GetForm(STMemory_ReadLong(control+2*7), &src, &srcbytes, &srcw, &srch) ||
+	    !VDIDraw_GetForm(STMemory_ReadLong(control+2*9), &dst, &dstbytes, &dstw, &dsth))
+		return false;
+
+	mode = STMemory_ReadWord(intin);
+	sx1 = (Sint16)STMemory_ReadWord(ptsin);
+	sy1 = (Sint16)STMemory_ReadWord(ptsin+2);
+	sx2 = (Sint16)STMemory_ReadWord(ptsin+4);
+	sy2 = (Sint16)STMemory_ReadWord(ptsin+6);
+	dx1 = (Sint16)STMemory_ReadWord(ptsin+8);
+	dy1 = (Sint16)STMemory_ReadWord(ptsin+10);
+	dx2 = dx1 + sx2 - sx1;
+	dy2 = dy1 + sy2 - sy1;
+	if (mode > 15 || sx1 > sx2 || sy1 > sy2 || sx1 < 0 || sy1 < 0
+	    || sx2 >= srcw || sy2 >= srch || dx1 < 0 || dy1 < 0
+	    || dx2 >= dstw || dy2 >= dsth)
+		return false;
+	/* leave clipped copies to TOS */
+	if (ws->bClip && dst == pScreen &&
+	    (dx1 < ClipX1 || dy1 < ClipY1 || dx2 > ClipX2 || dy2 > ClipY2))
+		return false;
+
+	rows = sy2 - sy1 + 1;
+	row = 0;
+	step = 1;
+	if (src == dst && dy1 > sy1)
+	{
+		/* overlapping downwards copy, do it bottom up */
+		row = rows - 1;
+		step = -1;
+	}
+	for (; rows > 0; rows--, row += step)
+	{
+		srcline = src + (sy1 + row) * srcbytes;
+		memcpy(LineBuffer, srcline, srcbytes);
+		dstline = dst + (dy1 + row) * dstbytes;
+		lastgroup = dx2 >> 4;
+		for (group = dx1 >> 4; group <= lastgroup; group++)
+		{
+			mask = 0xffff;
+			if (group == dx1 >> 4)
+				mask &= 0xffff >> (dx1 & 15);
+			if (group == lastgroup)
+				mask &= 0xffff << (15 - (dx2 & 15));
+			bit = sx1 + group * 16 - dx1;   /* source bit position */
+			for (plane = 0; plane < VDIPlanes; plane++)
+			{
+				Uint8 *p = dstline + (group * VDIPlanes + plane) * 2;
+				s = VDIDraw_GetBits(LineBuffer, srcbytes, plane, bit);
+				d = do_get_mem_word(p);
+				m = 0;
+				if (mode & 8)  m |= ~s & ~d;
+				if (mode & 4)  m |= ~s & d;
+				if (mode & 2)  m |= s & ~d;
+				if (mode & 1)  m |= s & d;
+				do_put_mem_word(p, (d & ~mask) | (m & mask));
+			}
+		}
+	}
+	return true;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Initialize workstation attributes from v_opnwk / v_opnvwk intin
+ */
+static void VDIDraw_OpenWorkstation(Uint16 handle, Uint32 intin)
+{
+	VDIDRAW_WORKSTATION *ws = &Workstation[handle];
+	int colors = 1 << VDIPlanes;
+
+	memset(ws, 0, sizeof(*ws));
+	ws->bOpen = true;
+	ws->WriteMode = MD_REPLACE;
+	ws->LineType = STMemory_ReadWord(intin+2*1);
+	if (ws->LineType < 1 || ws->LineType > 7)
+		ws->LineType = 1;
+	ws->LineWidth = 1;
+	ws->LineColor = STMemory_ReadWord(intin+2*2);
+	ws->TextColor = STMemory_ReadWord(intin+2*6);
+	ws->FillInterior = STMemory_ReadWord(intin+2*7);
+	if (ws->FillInterior > 4)
+		ws->FillInterior = 0;
+	ws->FillColor = STMemory_ReadWord(intin+2*9);
+	if (ws->LineColor >= colors)  ws->LineColor = 1;
+	if (ws->TextColor >= colors)  ws->TextColor = 1;
+	if (ws->FillColor >= colors)  ws->FillColor = 1;
+	ws->bFillPerimeter = true;
+	ws->TextFont = 1;
+}
+
+/**
+ * Called on trap exit for the calls for which VDIDraw_Entry()
+ * returned VDI_ENTRY_COMPLETE, to track the attributes TOS set.
+ */
+void VDIDraw_Complete(Uint32 control, Uint32 intin, Uint32 ptsin,
+                      Uint32 intout, Uint32 ptsout)
+{
+	VDIDRAW_WORKSTATION *ws;
+	Uint16 opcode, handle;
+	int tmp;
+
+	opcode = STMemory_ReadWord(control);
+	handle = STMemory_ReadWord(control+2*6);
+	if (handle >= VDIDRAW_MAX_HANDLES)
+		return;
+	ws = &Workstation[handle];
+
+	if (opcode == VDI_V_OPNWK || opcode == VDI_V_OPNVWK)
+	{
+		if (handle)
+		{
+			VDIDraw_OpenWorkstation(handle, intin);
+			VDIDraw_Record(VDIDRAW_REC_OPEN, control, intin, ptsin, intout, ptsout);
+		}
+		return;
+	}
+	if (!ws->bOpen)
+		return;
+
+	switch (opcode)
+	{
+	case VDI_VSWR_MODE:
+		ws->WriteMode = STMemory_ReadWord(intout);
+		break;
+	case VDI_VS_CLIP:
+		ws->bClip = STMemory_ReadWord(intin) != 0;
+		ws->ClipX1 = STMemory_ReadWord(ptsin);
+		ws->ClipY1 = STMemory_ReadWord(ptsin+2);
+		ws->ClipX2 = STMemory_ReadWord(ptsin+4);
+		ws->ClipY2 = STMemory_ReadWord(ptsin+6);
+		if (ws->ClipX1 > ws->ClipX2)
+		{
+			tmp = ws->ClipX1; ws->ClipX1 = ws->ClipX2; ws->ClipX2 = tmp;
+		}
+		if (ws->ClipY1 > ws->ClipY2)
+		{
+			tmp = ws->ClipY1; ws->ClipY1 = ws->ClipY2; ws->ClipY2 = tmp;
+		}
+		break;
+	case VDI_VSL_TYPE:
+		ws->LineType = STMemory_ReadWord(intout);
+		break;
+	case VDI_VSL_WIDTH:
+		ws->LineWidth = STMemory_ReadWord(ptsout);
+		break;
+	case VDI_VSL_COLOR:
+		ws->LineColor = STMemory_ReadWord(intout);
+		break;
+	case VDI_VSL_ENDS:
+		ws->LineBegEnd = STMemory_ReadWord(intin);
+		ws->LineEndEnd = STMemory_ReadWord(intin+2);
+		if (ws->LineBegEnd > 2)  ws->LineBegEnd = 0;
+		if (ws->LineEndEnd > 2)  ws->LineEndEnd = 0;
+		break;
+	case VDI_VSF_INTERIOR:
+		ws->FillInterior = STMemory_ReadWord(intout);
+		break;
+	case VDI_VSF_COLOR:
+		ws->FillColor = STMemory_ReadWord(intout);
+		break;
+	case VDI_VSF_PERIMETER:
+		ws->bFillPerimeter = STMemory_ReadWord(intout) != 0;
+		break;
+	case VDI_VST_COLOR:
+		ws->TextColor = STMemory_ReadWord(intout);
+		break;
+	case VDI_VST_EFFECTS:
+		ws->TextEffects = STMemory_ReadWord(intout);
+		break;
+	case VDI_VST_ALIGNMENT:
+		ws->TextHorAlign = STMemory_ReadWord(intout);
+		ws->TextVerAlign = STMemory_ReadWord(intout+2);
+		break;
+	case VDI_VST_ROTATION:
+		ws->TextRotation = STMemory_ReadWord(intout);
+		break;
+	case VDI_VST_HEIGHT:
+	case VDI_VST_POINT:
+		ws->TextCellHeight = STMemory_ReadWord(ptsout+2*3);
+		break;
+	case VDI_VST_FONT:
+		ws->TextFont = STMemory_ReadWord(intout);
+		break;
+	default:
+		return;
+	}
+	VDIDraw_Record(VDIDRAW_REC_ATTRIB, control, intin, ptsin, intout, ptsout);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Called on VDI trap entry (after workstation opens have been checked).
+ * Draw the call natively if 'bNative' is set and it's supported.
+ * Return VDI_ENTRY_DONE if TOS call should be skipped, VDI_ENTRY_COMPLETE
+ * if VDIDraw_Complete() needs to be called at trap exit, otherwise
+ * VDI_ENTRY_PASS.
+ */
+int VDIDraw_Entry(Uint32 control, Uint32 intin, Uint32 ptsin, bool bNative)
+{
+	const VDIDRAW_WORKSTATION *ws;
+	Uint16 opcode, handle;
+	bool bDone;
+
+	opcode = STMemory_ReadWord(control);
+	handle = STMemory_ReadWord(control+2*6);
+	if (handle >= VDIDRAW_MAX_HANDLES)
+		return VDI_ENTRY_PASS;
+	ws = &Workstation[handle];
+
+	switch (opcode)
+	{
+	case VDI_V_CLSWK:
+	case VDI_V_CLSVWK:
+		Workstation[handle].bOpen = false;
+		return VDI_ENTRY_PASS;
+	case VDI_VSWR_MODE:
+	case VDI_VS_CLIP:
+	case VDI_VSL_TYPE:
+	case VDI_VSL_WIDTH:
+	case VDI_VSL_COLOR:
+	case VDI_VSL_ENDS:
+	case VDI_VSF_INTERIOR:
+	case VDI_VSF_COLOR:
+	case VDI_VSF_PERIMETER:
+	case VDI_VST_COLOR:
+	case VDI_VST_EFFECTS:
+	case VDI_VST_ALIGNMENT:
+	case VDI_VST_ROTATION:
+	case VDI_VST_HEIGHT:
+	case VDI_VST_POINT:
+	case VDI_VST_FONT:
+		return ws->bOpen ? VDI_ENTRY_COMPLETE : VDI_ENTRY_PASS;
+	case VDI_V_PLINE:
+	case VDI_V_GTEXT:
+	case VDI_V_GDP:
+	case VDI_VRO_CPYFM:
+	case VDI_VR_RECFL:
+		break;
+	default:
+		return VDI_ENTRY_PASS;
+	}
+	if (!ws->bOpen)
+		return VDI_ENTRY_PASS;
+	if (opcode == VDI_V_GDP && STMemory_ReadWord(control+2*5) != 1)
+		return VDI_ENTRY_PASS;
+
+	VDIDraw_Record(VDIDRAW_REC_DRAW, control, intin, ptsin, 0, 0);
+	if (!bNative)
+		return VDI_ENTRY_PASS;
+
+	switch (opcode)
+	{
+	case VDI_V_PLINE:
+		bDone = VDIDraw_Polyline(ws, control, ptsin);
+		break;
+	case VDI_V_GTEXT:
+		bDone = VDIDraw_Text(ws, control, intin, ptsin);
+		break;
+	case VDI_V_GDP:
+		bDone = VDIDraw_Rectangle(ws, ptsin, ws->bFillPerimeter);
+		break;
+	case VDI_VRO_CPYFM:
+		bDone = VDIDraw_CopyRaster(ws, control, intin, ptsin);
+		break;
+	default:
+		bDone = VDIDraw_Rectangle(ws, ptsin, false);
+		break;
+	}
+	if (!bDone)
+		return VDI_ENTRY_PASS;
+
+	LOG_TRACE(TRACE_OS_VDI, "VDI call %3hd done natively\n", opcode);
+	/* no output */
+	STMemory_WriteWord(control+2*2, 0);
+	STMemory_WriteWord(control+2*4, 0);
+	return VDI_ENTRY_DONE;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Set system font header table address (Line-A init A1 register)
+ */
+void VDIDraw_SetFonts(Uint32 fontbase)
+{
+	Uint32 font;
+	int i;
+
+	for (i = 0; i < VDIDRAW_FONTS; i++)
+	{
+		font = 0;
+		if (STMemory_ValidArea(fontbase + 4*i, 4))
+			font = STMemory_ReadLong(fontbase + 4*i) & 0xffffff;
+		if (!STMemory_ValidArea(font, FONT_HEADER_SIZE))
+			font = 0;
+		if (font != FontHeader[i])
+		{
+			FontHeader[i] = font;
+			bRecordFonts = true;
+		}
+	}
+}
+
+/**
+ * Forget all workstations on reset
+ */
+void VDIDraw_Reset(void)
+{
+	memset(Workstation, 0, sizeof(Workstation));
+}
+
+/**
+ * Save/restore snapshot of the tracked workstation attributes
+ */
+void VDIDraw_MemorySnapShot_Capture(bool bSave)
+{
+	MemorySnapShot_Store(Workstation, sizeof(Workstation));
+	MemorySnapShot_Store(FontHeader, sizeof(FontHeader));
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Set file where VDI calls are recorded, NULL or "none" disables
+ * recording.  Return false for an empty file name.
+ */
+bool VDIDraw_SetRecordFile(const char *pszFileName)
+{
+	VDIDraw_UnInit();
+	if (!pszFileName || strcasecmp(pszFileName, "none") == 0)
+		return true;
+	if (!*pszFileName)
+		return false;
+	pszRecordFileName = strdup(pszFileName);
+	return pszRecordFileName != NULL;
+}
+
+bool VDIDraw_IsRecording(void)
+{
+	return pszRecordFileName != NULL;
+}
+
+/**
+ * Close the record file
+ */
+void VDIDraw_UnInit(void)
+{
+	if (RecordFile)
+	{
+		fclose(RecordFile);
+		RecordFile = NULL;
+	}
+	if (pszRecordFileName)
+	{
+		free(pszRecordFileName);
+		pszRecordFileName = NULL;
+	}
+}
@@ -330,6 +330,7 @@ const char Video_fileid[] = "Hatari video.c : " __DATE__ " " __TIME__;
 
 #include "main.h"
 #include "configuration.h"
+#include "benchmark.h"
 #include "cycles.h"
 #include "fdc.h"
 #include "cycInt.h"
@@ -349,11 +350,11 @@ const char Video_fileid[] = "Hatari video.c : " __DATE__ " " __TIME__;
 #include "stMemory.h"
 #include "vdi.h"
 #include "video.h"
-#include "ymFormat.h"
 #include "falcon/videl.h"
 #include "falcon/hostscreen.h"
 #include "avi_record.h"
 #include "ikbd.h"
+#include "midi.h"
 
 
 /* The border's mask allows to keep track of all the border tricks		*/
@@ -414,6 +415,8 @@ static Uint8 *pVideoRaster;			/* Pointer to Video raster, after VideoBase in PC
 static bool bSteBorderFlag;			/* true when screen width has been switched to 336 (e.g. in Obsession) */
 static int NewSteBorderFlag = -1;		/* New value for next line */
 static bool bTTColorsSync, bTTColorsSTSync;	/* whether TT colors need conversion to SDL */
+static Uint32 TTHostColors[256];		/* TT colors last set to host palette, as RGB */
+static int nTTHostColors;			/* number of valid TTHostColors, 0 = none */
 
 bool bTTSampleHold = false;				/* TT special video mode */
 static bool bTTHypermono = false;		/* TT special video mode */
@@ -421,6 +424,10 @@ static bool bTTHypermono = false;		/* TT special video mode */
 static int TTSpecialVideoMode = 0;		/* TT special video mode */
 static int nPrevTTSpecialVideoMode = 0;	/* TT special video mode */
 
+static bool bScreenHashEnabled;			/* screen contents hash is computed on VBL once it's asked for */
+static Uint32 nScreenHash;			/* hash of the last hashed frame */
+static int nScreenHashVBL;			/* VBL count of that frame */
+
 static int LastCycleScroll8264;			/* value of Cycles_GetCounterOnWriteAccess last time ff8264 was set for the current VBL */
 static int LastCycleScroll8265;			/* value of Cycles_GetCounterOnWriteAccess last time ff8265 was set for the current VBL */
 
@@ -613,6 +620,9 @@ void Video_Reset(void)
 	HblJitterIndex = 0;
 	VblJitterIndex = 0;
 
+	/* Host palette may have been changed by Videl, set all TT colors again */
+	nTTHostColors = 0;
+
 	/* Clear framecycles counter */
 	Cycles_SetCounter(CYCLES_COUNTER_VIDEO, 0);
 
@@ -1945,6 +1955,22 @@ static void Video_StoreResolution(int y)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Compare the screen line which was just copied to pSTScreen with the same
+ * line in the previously displayed frame and flag it in STScreenLineChanged[],
+ * so that the screen conversion can skip lines which did not change.
+ */
+static void Video_CheckScreenLineChanged(int LineBytes)
+{
+	int Offset = pSTScreen - pFrameBuffer->pSTScreen;
+	int y = Offset / LineBytes;
+
+	if (y < STSCREEN_MAX_LINES)
+		STScreenLineChanged[y] = memcmp(pSTScreen, pFrameBuffer->pSTScreenCopy + Offset, LineBytes) != 0;
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Copy one line of monochrome screen into buffer for conversion later.
@@ -2015,6 +2041,7 @@ static void Video_CopyScreenLineMono(void)
 	}
 
 	/* Each screen line copied to buffer is always same length */
+	Video_CheckScreenLineChanged(SCREENBYTES_MONOLINE);
 	pSTScreen += SCREENBYTES_MONOLINE;
 }
 
@@ -2418,6 +2445,7 @@ static void Video_CopyScreenLineColor(void)
 	}
 
 	/* Each screen line copied to buffer is always same length */
+	Video_CheckScreenLineChanged(SCREENBYTES_LINE);
 	pSTScreen += SCREENBYTES_LINE;
 }
 
@@ -2428,8 +2456,19 @@ static void Video_CopyScreenLineColor(void)
  */
 static void Video_CopyVDIScreen(void)
 {
+	int LineBytes = (VDIWidth*VDIPlanes)/8;
+	int y;
+
 	/* Copy whole screen, don't care about being exact as for GEM only */
-	memcpy(pSTScreen, pVideoRaster, ((VDIWidth*VDIPlanes)/8)*VDIHeight);
+	memcpy(pSTScreen, pVideoRaster, LineBytes*VDIHeight);
+
+	/* Flag the lines which changed since previous frame */
+	for (y = 0; y < VDIHeight; y++)
+	{
+		Video_CheckScreenLineChanged(LineBytes);
+		pSTScreen += LineBytes;
+	}
+	pSTScreen = pFrameBuffer->pSTScreen;
 }
 
 
@@ -2587,6 +2626,8 @@ static void Video_ClearOnVBL(void)
 	}
 	pVideoRaster = &STRam[VideoBase];
 	pSTScreen = pFrameBuffer->pSTScreen;
+	/* Lines which don't get copied this frame need to be converted as before */
+	memset(STScreenLineChanged, 1, sizeof(STScreenLineChanged));
 
 	Video_SetScreenRasters();
 	Video_InitShifterLines();
@@ -2619,7 +2660,25 @@ void Video_GetTTRes(int *width, int *height, int *bpp)
 
 /*-----------------------------------------------------------------------*/
 /**
- * Convert TT palette to SDL palette
+ * Set given TT color to host palette, if it changed.
+ * Return true if it changed.
+ */
+static bool Video_SetTTHostColor(int idx, Uint8 r, Uint8 g, Uint8 b)
+{
+	Uint32 rgb = ((Uint32)r << 16) | ((Uint32)g << 8) | b;
+
+	if (idx < nTTHostColors && TTHostColors[idx] == rgb)
+		return false;
+	TTHostColors[idx] = rgb;
+	HostScreen_setPaletteColor(idx, r, g, b);
+	return true;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Convert TT palette to SDL palette.  SDL palette is updated (which
+ * causes whole screen to be updated) only if some of the colors
+ * changed, not just when the palette registers were written.
  */
 static void Video_UpdateTTPalette(int bpp)
 {
@@ -2627,6 +2686,7 @@ static void Video_UpdateTTPalette(int bpp)
 	Uint8 r,g,b, lowbyte, highbyte;
 	Uint16 stcolor, ttcolor;
 	int i, offset, colors;
+	bool bChanged = false;
 
 	ttpalette = 0xff8400;
 
@@ -2653,8 +2713,8 @@ static void Video_UpdateTTPalette(int bpp)
 	if ((bpp == 1) && (TTRes == TT_HIGH_RES))
 	{
 		/* Monochrome mode... palette is hardwired (?) */
-		HostScreen_setPaletteColor(0, 255, 255, 255);
-		HostScreen_setPaletteColor(1, 0, 0, 0);
+		bChanged |= Video_SetTTHostColor(0, 255, 255, 255);
+		bChanged |= Video_SetTTHostColor(1, 0, 0, 0);
 	}
 	else if (bpp == 1)
 	{
@@ -2670,7 +2730,7 @@ static void Video_UpdateTTPalette(int bpp)
 		{
 			r = g = b = highbyte;
 		}
-		HostScreen_setPaletteColor(0, r,g,b);
+		bChanged |= Video_SetTTHostColor(0, r,g,b);
 
 		ttpalette = 0xff85fe;
 		lowbyte = IoMem_ReadByte(ttpalette++);
@@ -2683,7 +2743,7 @@ static void Video_UpdateTTPalette(int bpp)
 			r = g = b = highbyte;
 		}
 		//printf("%d: (%d,%d,%d)\n", 1,r,g,b);
-		HostScreen_setPaletteColor(1, r,g,b);
+		bChanged |= Video_SetTTHostColor(1, r,g,b);
 
 	}
 	else
@@ -2700,11 +2760,15 @@ static void Video_UpdateTTPalette(int bpp)
 			{
 				r = g = b = highbyte;
 			}
-			HostScreen_setPaletteColor(i, r,g,b);
+			bChanged |= Video_SetTTHostColor(i, r,g,b);
 		}
 	}
 
-	HostScreen_updatePalette(colors);
+	if (bChanged || colors != nTTHostColors)
+	{
+		HostScreen_updatePalette(colors);
+		nTTHostColors = colors;
+	}
 	bTTColorsSync = true;
 }
 
@@ -2753,6 +2817,152 @@ bool Video_RenderTTScreen(void)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Add given bytes of emulated memory to screen contents hash.
+ * Data is read as big endian longs a byte at the time, so the result
+ * doesn't depend on the host endianess and data doesn't need to be
+ * long aligned.
+ */
+Uint32 Video_HashData(Uint32 hash, const Uint8 *data, int len)
+{
+	const Uint8 *end = data + (len & ~3);
+
+	while (data < end)
+	{
+		hash = Video_HashValue(hash, (Uint32)data[0] << 24 | data[1] << 16 | data[2] << 8 | data[3]);
+		data += 4;
+	}
+	for (len &= 3; len > 0; len--)
+		hash = Video_HashValue(hash, *data++);
+	return hash;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Hash ST/STE shifter screen lines copied during the frame, with their
+ * resolution and palette changes.  This is the same data from which
+ * Screen_Draw() converts the screen, so the hash doesn't depend on
+ * the host screen format nor zooming.
+ */
+static Uint32 Video_HashSTScreen(Uint32 hash)
+{
+	Uint32 Mask;
+	int y, i;
+
+	if (bUseVDIRes)
+	{
+		hash = Video_HashValue(hash, VDIWidth << 16 | VDIHeight);
+		hash = Video_HashValue(hash, VDIPlanes);
+		/* copied to pSTScreen only when screen is drawn */
+		hash = Video_HashData(hash, pVideoRaster, VDIWidth*VDIPlanes/8 * VDIHeight);
+		for (i = 0; i < 16; i++)
+			hash = Video_HashValue(hash, HBLPalettes[i]);
+		return hash;
+	}
+
+	hash = Video_HashValue(hash, bUseHighRes);
+	hash = Video_HashData(hash, pFrameBuffer->pSTScreen, pSTScreen - pFrameBuffer->pSTScreen);
+
+	/* Palette entries are valid only for lines where their mask bit is set */
+	for (y = 0; y < NUM_VISIBLE_LINES; y++)
+	{
+		Mask = HBLPaletteMasks[y] & ~PALETTEMASK_UPDATEMASK;
+		hash = Video_HashValue(hash, Mask);
+		for (i = 0; i < 16; i++)
+		{
+			if (Mask & (1 << i))
+				hash = Video_HashValue(hash, HBLPalettes[y*16 + i]);
+		}
+	}
+
+	if (Spec512_IsImage())
+		hash = Spec512_HashPalettes(hash);
+	return hash;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Hash TT shifter screen: mode, used palette and video RAM
+ */
+static Uint32 Video_HashTTScreen(Uint32 hash)
+{
+	int width, height, bpp;
+
+	Video_GetTTRes(&width, &height, &bpp);
+	hash = Video_HashValue(hash, TTRes);
+	hash = Video_HashValue(hash, TTSpecialVideoMode << 1 | bTTHypermono);
+
+	/* ST palette gets synched to the TT one on rendering */
+	hash = Video_HashData(hash, &IoMem[0xff8240], 16*SIZE_WORD);
+	if (bpp == 1)
+	{
+		if (TTRes != TT_HIGH_RES)
+		{
+			hash = Video_HashData(hash, &IoMem[0xff8400], SIZE_WORD);
+			hash = Video_HashData(hash, &IoMem[0xff85fe], SIZE_WORD);
+		}
+	}
+	else
+		hash = Video_HashData(hash, &IoMem[0xff8400], (1 << bpp) * SIZE_WORD);
+
+	if (STMemory_ValidArea(VideoBase, width * height * bpp / 8))
+		hash = Video_HashData(hash, &STRam[VideoBase], width * height * bpp / 8);
+	return hash;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Compute hash of the emulated screen contents for this frame,
+ * if something has asked for it.  Called on VBL before the screen
+ * is drawn (and also when the frame is skipped).
+ */
+static void Video_HashScreen(void)
+{
+	Uint32 hash = VIDEO_HASH_INIT;
+
+	if (!bScreenHashEnabled)
+		return;
+
+	if (ConfigureParams.System.nMachineType == MACHINE_FALCON && !bUseVDIRes)
+		hash = VIDEL_HashScreen(hash);
+	else if (ConfigureParams.System.nMachineType == MACHINE_TT && !bUseVDIRes)
+		hash = Video_HashTTScreen(hash);
+	else
+		hash = Video_HashSTScreen(hash);
+
+	nScreenHash = hash;
+	nScreenHashVBL = nVBLs;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return hash of the emulated screen contents from the last VBL.
+ * Hashing is enabled on the first call, so until the next VBL
+ * this returns zero.  Used for the "ScreenHash" debugger variable
+ * and the control socket, so that tests can wait for a given screen
+ * content without saving and comparing screenshots.
+ */
+Uint32 Video_GetScreenHash(void)
+{
+	bScreenHashEnabled = true;
+	return nScreenHash;
+}
+
+/**
+ * Return VBL count of the frame from which Video_GetScreenHash()
+ * value was computed.
+ */
+Uint32 Video_GetScreenHashVBL(void)
+{
+	return nScreenHashVBL;
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Draw screen (either with ST/STE shifter drawing functions or with
@@ -2760,10 +2970,14 @@ bool Video_RenderTTScreen(void)
  */
 static void Video_DrawScreen(void)
 {
+	int nBenchPrev;
+
 	/* Skip frame if need to */
 	if (nVBLs % (nFrameSkips+1))
 		return;
 
+	nBenchPrev = Benchmark_Enter(BENCH_SCREEN);
+
 	/* Use extended VDI resolution?
 	 * If so, just copy whole screen on VBL rather than per HBL */
 	if (bUseVDIRes)
@@ -2788,6 +3002,10 @@ static void Video_DrawScreen(void)
 
 		Screen_Draw();
 	}
+	Benchmark_Leave(nBenchPrev);
+
+	/* Save frame if frame dumping is enabled */
+	ScreenSnapShot_FrameDump();
 }
 
 
@@ -2912,6 +3130,7 @@ void Video_InterruptHandler_VBL ( void )
 	/* Clear any key presses which are due to be de-bounced (held for one ST frame) */
 	Keymap_DebounceAllKeys();
 
+	Video_HashScreen();
 	Video_DrawScreen();
 
 	/* Check printer status */
@@ -2942,12 +3161,13 @@ void Video_InterruptHandler_VBL ( void )
 	/* Update the IKBD's internal clock */
 	IKBD_UpdateClockOnVBL ();
 
+	/* Check for MIDI input while MIDI is otherwise idle */
+	Midi_VBL();
+
 	/* Record video frame is necessary */
 	if ( bRecordingAvi )
 		Avi_RecordVideoStream ();
 
-	/* Store off PSG registers for YM file, is enabled */
-	YMFormat_UpdateRecording();
 	/* Generate 1/50th second of sound sample data, to be played by sound thread */
 	Sound_Update_VBL();
 
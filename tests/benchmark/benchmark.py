@@ -0,0 +1,228 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2013 by the Hatari developers
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+"""
+Runs Hatari emulation speed benchmark workloads with EmuTOS, collects
+the JSON results Hatari writes with its --benchmark option and compares
+them against an earlier baseline.
+
+Each workload runs given number of VBLs with fast forwarding and without
+Hatari window / audio output (SDL dummy drivers).  Workloads running
+an Atari program autostart it from the program's directory, see
+readme.txt.
+
+NOTE: To test an uninstalled version of Hatari, set PATH to point
+to your Hatari binary directory, like this:
+	PATH=../../build/src:$PATH ./benchmark.py etos512k.img
+"""
+
+from __future__ import print_function
+import getopt, json, os, shutil, subprocess, sys, tempfile
+
+# where the bundled test disk images & programs are
+TOSBOOT = os.path.join("..", "tosboot")
+
+# name: (VBLs, Hatari options, program dir, program to autostart)
+WORKLOADS = {
+    "tosboot-st":
+        (500, ["--machine", "st", "--memsize", "1", "--monitor", "rgb"], None, None),
+    "tosboot-falcon":
+        (500, ["--machine", "falcon", "--memsize", "14", "--monitor", "vga", "--dsp", "emu"], None, None),
+    "gem-redraw":
+        (600, ["--machine", "tt", "--memsize", "4", "--vdi-planes", "4",
+               "--vdi-width", "1280", "--vdi-height", "960"], None, None),
+    "floppy":
+        (1000, ["--machine", "ste", "--memsize", "1",
+                "--disk-a", os.path.join(TOSBOOT, "bootdesk.st.gz")], None, None),
+    "gemdos-io":
+        (1000, ["--machine", "ste", "--memsize", "4"], os.path.join(TOSBOOT, "disk"), "GEMDOS.PRG"),
+    "blitter":
+        (1000, ["--machine", "ste", "--memsize", "4"], "blitter", "BLITTER.PRG"),
+    "dma-sound":
+        (1000, ["--machine", "ste", "--memsize", "4"], "dmasound", "DMASOUND.PRG"),
+    "dsp":
+        (1000, ["--machine", "falcon", "--memsize", "4", "--dsp", "emu"], "dsp", "DSP.PRG"),
+    "tt-high":
+        (500, ["--machine", "tt", "--memsize", "4", "--monitor", "mono"], None, None),
+    "tt-medium":
+        (1000, ["--machine", "tt", "--memsize", "4", "--monitor", "vga"], "ttmedium", "TTMEDIUM.PRG"),
+    "tt-low":
+        (1000, ["--machine", "tt", "--memsize", "4", "--monitor", "vga"], "ttlow", "TTLOW.PRG"),
+    "cpu-ram":
+        (1000, ["--machine", "ste", "--memsize", "4"], "cpuram", "CPURAM.PRG"),
+    "cpu-ram-mmu":
+        (1000, ["--machine", "tt", "--memsize", "4", "--cpulevel", "4", "--mmu", "on"],
+         "cpuram", "CPURAM.PRG"),
+}
+
+
+def usage(msg=None):
+    "output program usage information and exit"
+    name = os.path.basename(sys.argv[0])
+    print(__doc__)
+    print("""
+Usage: %s [options] <EmuTOS image>
+
+Options:
+\t-h, --help\t\tthis help
+\t-w, --workloads <list>\tcomma separated workloads to run (default all)
+\t-o, --output <file>\tfile for the results (default results.json)
+\t-b, --baseline <file>\tcompare results against this earlier output
+\t\t\t\t(if file doesn't exist, results are copied to it)
+\t-t, --tolerance <x>\tallowed slowdown, in percents (default 5)
+
+Workloads:
+\t%s
+
+Exit value is 1 if some workload got slower than allowed.
+""" % (name, ", ".join(sorted(WORKLOADS.keys()))))
+    if msg:
+        print("ERROR: %s\n" % msg)
+    sys.exit(1)
+
+
+class Benchmark:
+    "benchmark workload runner"
+    hataribin = "hatari"
+
+    def __init__(self, tos):
+        self.tos = os.path.abspath(tos)
+        self.workdir = tempfile.mkdtemp(prefix="hatari-bench-")
+
+    def create_config(self, path):
+        "create Hatari config without dialogs, and with device output to files"
+        cfg = open(path, "w")
+        cfg.write("[Log]\nnAlertDlgLogLevel = 0\nbConfirmQuit = FALSE\n")
+        cfg.write("[Screen]\nbShowStatusbar = FALSE\nbShowDriveLed = FALSE\n")
+        cfg.write("[HardDisk]\nbUseHardDiskDirectory = FALSE\n")
+        cfg.write("[Printer]\nbEnablePrinting = TRUE\nszPrintToFileName = %s\n"
+                  % os.path.join(self.workdir, "printer-out"))
+        cfg.write("[RS232]\nbEnableRS232 = TRUE\nszInFileName = \nszOutFileName = %s\n"
+                  % os.path.join(self.workdir, "serial-out"))
+        cfg.write("[Midi]\nbEnableMidi = TRUE\nsMidiInFileName = \nsMidiOutFileName = %s\n"
+                  % os.path.join(self.workdir, "midi-out"))
+        cfg.close()
+
+    def run(self, name):
+        "run given workload, return its results dict or None"
+        vbls, args, progdir, program = WORKLOADS[name]
+        if program:
+            if not os.path.isfile(os.path.join(progdir, program)):
+                print("SKIP: %s, '%s' program missing from '%s'" % (name, program, progdir))
+                return None
+            # GEMDOS HD directory is writable, use a copy of it
+            diskdir = os.path.join(self.workdir, "disk")
+            if os.path.exists(diskdir):
+                shutil.rmtree(diskdir)
+            shutil.copytree(progdir, diskdir)
+            # autostart program must be the last argument
+            args = args + [os.path.join(diskdir, program)]
+        config = os.path.join(self.workdir, "hatari.cfg")
+        result = os.path.join(self.workdir, name + ".json")
+        self.create_config(config)
+        allargs = [self.hataribin, "--configfile", config, "--tos", self.tos,
+                   "--fast-forward", "yes", "--run-vbls", str(vbls),
+                   "--benchmark", result] + args
+        env = os.environ.copy()
+        env.setdefault("SDL_VIDEODRIVER", "dummy")
+        env.setdefault("SDL_AUDIODRIVER", "dummy")
+        print("RUN: %s" % name)
+        log = open(os.path.join(self.workdir, name + ".log"), "w")
+        status = subprocess.call(allargs, env=env, stdout=log, stderr=subprocess.STDOUT)
+        log.close()
+        if status or not os.path.exists(result):
+            print("ERROR: %s failed, see '%s'" % (name, log.name))
+            return None
+        return json.load(open(result))
+
+    def cleanup(self):
+        "remove temporary files"
+        shutil.rmtree(self.workdir)
+
+
+def compare(results, baseline, tolerance):
+    "show results compared to baseline, return false for too large slowdown"
+    ok = True
+    print("\n%-16s %10s %10s %8s %10s   %s" % ("Workload", "VBLs/s", "baseline", "diff", "peak RSS", "top subsystems"))
+    for name in sorted(results.keys()):
+        result = results[name]
+        speed = result["vbls_per_sec"]
+        subsystems = sorted(result["subsystem_secs"].items(), key=lambda item: -item[1])
+        top = ", ".join(["%s %.1fs" % item for item in subsystems[:3] if item[1] > 0])
+        if name in baseline and baseline[name]["vbls_per_sec"] > 0:
+            old = baseline[name]["vbls_per_sec"]
+            diff = 100.0 * (speed - old) / old
+            mark = ""
+            if diff < -tolerance:
+                mark = " SLOWER"
+                ok = False
+            print("%-16s %10.1f %10.1f %+7.1f%% %8dkB   %s%s" % (name, speed, old, diff, result["peak_rss_kb"], top, mark))
+        else:
+            print("%-16s %10.1f %10s %8s %8dkB   %s" % (name, speed, "-", "-", result["peak_rss_kb"], top))
+    return ok
+
+
+def main():
+    "benchmark main function"
+    longopts = ["baseline=", "help", "output=", "tolerance=", "workloads="]
+    try:
+        opts, args = getopt.gnu_getopt(sys.argv[1:], "b:ho:t:w:", longopts)
+    except getopt.GetoptError as error:
+        usage(error)
+    baseline = {}
+    basefile = None
+    output = "results.json"
+    tolerance = 5.0
+    workloads = sorted(WORKLOADS.keys())
+    for opt, arg in opts:
+        if opt in ("-h", "--help"):
+            usage()
+        elif opt in ("-b", "--baseline"):
+            basefile = arg
+            if os.path.isfile(arg):
+                baseline = json.load(open(arg))
+        elif opt in ("-o", "--output"):
+            output = arg
+        elif opt in ("-t", "--tolerance"):
+            try:
+                tolerance = float(arg)
+            except ValueError:
+                usage("non-numeric tolerance: %s" % arg)
+        elif opt in ("-w", "--workloads"):
+            workloads = arg.split(",")
+            for name in workloads:
+                if name not in WORKLOADS:
+                    usage("unknown workload '%s'" % name)
+    if len(args) != 1 or not os.path.isfile(args[0]):
+        usage("EmuTOS image missing")
+
+    bench = Benchmark(args[0])
+    results = {}
+    for name in workloads:
+        result = bench.run(name)
+        if result:
+            results[name] = result
+    bench.cleanup()
+
+    out = open(output, "w")
+    json.dump(results, out, indent=2, sort_keys=True)
+    out.close()
+    print("Results saved to '%s'." % output)
+    if basefile and not baseline:
+        shutil.copy(output, basefile)
+        print("No earlier baseline, results copied to '%s'." % basefile)
+    if not compare(results, baseline, tolerance):
+        sys.exit(1)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,61 @@
+; Blitter benchmark workload, blitter/BLITTER.PRG (STE)
+; (assemble with TurboAss or Devpac, no relocation needed)
+;
+; Keeps the blitter scrolling the screen up by a line, going through
+; all the logical operations, skews and both HOG and shared bus modes.
+; Never exits, benchmark.py stops Hatari after the workload's VBLs.
+
+blitter         EQU $ffff8a00
+
+                clr.l   -(SP)           ; Super()
+                move.w  #$20,-(SP)
+                trap    #1
+                addq.l  #6,SP
+
+                move.w  #2,-(SP)        ; Physbase()
+                trap    #14
+                addq.l  #2,SP
+                movea.l D0,A5
+
+                lea     blitter.w,A6
+                movea.l A6,A0           ; halftone pattern
+                move.w  #$0f0f,D0
+                moveq   #15,D1
+halftone:       move.w  D0,(A0)+
+                rol.w   #1,D0
+                dbra    D1,halftone
+
+                moveq   #-1,D0
+                move.w  D0,$28(A6)      ; end masks
+                move.w  D0,$2a(A6)
+                move.w  D0,$2c(A6)
+                moveq   #2,D0
+                move.w  D0,$20(A6)      ; source X & Y increments
+                move.w  D0,$22(A6)
+                move.w  D0,$2e(A6)      ; destination X & Y increments
+                move.w  D0,$30(A6)
+                move.b  #3,$3a(A6)      ; HOP: source AND halftone
+                moveq   #0,D7           ; blit counter
+
+mainloop:       lea     160(A5),A0
+                move.l  A0,$24(A6)      ; source: screen from second line
+                move.l  A5,$32(A6)      ; destination: screen
+                move.w  #80,$36(A6)     ; words per line
+                move.w  #199,$38(A6)    ; lines
+                move.b  D7,$3b(A6)      ; OP: from the counter low bits
+                move.w  D7,D0
+                lsr.w   #4,D0
+                andi.b  #15,D0
+                move.b  D0,$3d(A6)      ; skew: from the next bits
+                move.b  #$c0,D0         ; busy & HOG mode
+                btst    #8,D7
+                beq.s   hog
+                move.b  #$80,D0         ; busy, shared with CPU
+hog:            move.b  D0,$3c(A6)
+restart:        bset    #7,$3c(A6)      ; restart until blit is done
+                nop
+                bne.s   restart
+                addq.w  #1,D7
+                bra.s   mainloop
+
+                END
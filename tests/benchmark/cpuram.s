@@ -0,0 +1,42 @@
+; CPU & RAM access benchmark workload, cpuram/CPURAM.PRG
+; (assemble with TurboAss or Devpac, no relocation needed)
+;
+; Keeps copying, checksumming and modifying a 32 kB BSS buffer with
+; long, word and byte accesses.  Never exits, benchmark.py stops Hatari
+; after the workload's VBLs.
+
+bufsize         EQU 32768
+
+                lea     buffer(PC),A0
+                move.w  #bufsize/4-1,D0
+fill:           move.l  D0,(A0)+
+                dbra    D0,fill
+
+mainloop:       lea     buffer(PC),A0   ; long copy & checksum
+                lea     bufsize/2(A0),A1
+                move.w  #bufsize/8-1,D0
+                moveq   #0,D1
+copyl:          move.l  (A0)+,D2
+                add.l   D2,D1
+                eor.l   D1,D2
+                move.l  D2,(A1)+
+                dbra    D0,copyl
+
+                lea     buffer(PC),A0   ; word read & write
+                move.w  #bufsize/2-1,D0
+modw:           move.w  (A0),D2
+                add.w   D1,D2
+                move.w  D2,(A0)+
+                dbra    D0,modw
+
+                lea     buffer(PC),A0   ; byte read-modify-write
+                move.w  #bufsize-1,D0
+modb:           add.b   D1,(A0)+
+                addq.b  #3,D1
+                dbra    D0,modb
+                bra.s   mainloop
+
+                BSS
+buffer:         DS.B bufsize
+
+                END
@@ -0,0 +1,74 @@
+; DMA sound benchmark workload, dmasound/DMASOUND.PRG (STE)
+; (assemble with TurboAss or Devpac, no relocation needed)
+;
+; Plays an 8 kB BSS buffer as a looping 50 kHz stereo DMA sound frame,
+; while modifying the samples and changing the LMC1992 volume, bass and
+; treble settings through Microwire.  Never exits, benchmark.py stops
+; Hatari after the workload's VBLs.
+
+dmasound        EQU $ffff8900
+bufsize         EQU 8192
+
+                clr.l   -(SP)           ; Super()
+                move.w  #$20,-(SP)
+                trap    #1
+                addq.l  #6,SP
+
+                lea     buffer(PC),A0   ; saw waves, different for left
+                move.w  #bufsize/2-1,D0 ; and right channels
+                moveq   #0,D1
+fill:           move.b  D1,(A0)+
+                move.b  D0,(A0)+
+                addq.b  #3,D1
+                dbra    D0,fill
+
+                lea     dmasound.w,A6
+                lea     buffer(PC),A0
+                move.l  A0,D0
+                move.b  D0,$07(A6)      ; frame start address
+                lsr.w   #8,D0
+                move.b  D0,$05(A6)
+                swap    D0
+                move.b  D0,$03(A6)
+                lea     bufsize(A0),A0
+                move.l  A0,D0
+                move.b  D0,$13(A6)      ; frame end address
+                lsr.w   #8,D0
+                move.b  D0,$11(A6)
+                swap    D0
+                move.b  D0,$0f(A6)
+                move.b  #3,$21(A6)      ; stereo, 50 kHz
+                move.b  #3,$01(A6)      ; play in loop
+                move.w  #$07ff,$24(A6)  ; Microwire mask
+                moveq   #0,D7           ; pass counter
+
+mainloop:       lea     buffer(PC),A0   ; modify the samples
+                move.w  #bufsize-1,D0
+modify:         add.b   D7,(A0)+
+                dbra    D0,modify
+
+                move.w  D7,D1           ; master volume -14..0 dB
+                andi.w  #7,D1
+                addi.w  #$04c0+33,D1
+                bsr.s   microwire
+                move.w  D7,D1           ; bass -8..+6 dB
+                andi.w  #7,D1
+                addi.w  #$0440+2,D1
+                bsr.s   microwire
+                move.w  D7,D1           ; treble +6..-8 dB
+                not.w   D1
+                andi.w  #7,D1
+                addi.w  #$0480+2,D1
+                bsr.s   microwire
+                addq.w  #1,D7
+                bra.s   mainloop
+
+microwire:      cmpi.w  #$07ff,$24(A6)  ; wait for previous transfer
+                bne.s   microwire
+                move.w  D1,$22(A6)
+                rts
+
+                BSS
+buffer:         DS.B bufsize
+
+                END
@@ -0,0 +1,73 @@
+; Falcon DSP benchmark workload, dsp/DSP.PRG
+; (assemble with TurboAss or Devpac, no relocation needed)
+;
+; Resets the DSP and loads to it through the host port bootstrap a small
+; program, which computes 1000 multiply-accumulates for every value the
+; CPU sends to it.  The CPU keeps sending values and reading the results.
+; Never exits, benchmark.py stops Hatari after the workload's VBLs.
+
+dsphost         EQU $ffffa200
+psg             EQU $ffff8800
+dspwords        EQU 11              ; DSP program size
+
+                clr.l   -(SP)           ; Super()
+                move.w  #$20,-(SP)
+                trap    #1
+                addq.l  #6,SP
+
+                lea     psg.w,A1        ; reset DSP with PSG port A bit 4
+                move.w  SR,-(SP)
+                move.w  #$2700,SR
+                move.b  #14,(A1)
+                move.b  (A1),D0
+                bset    #4,D0
+                move.b  D0,2(A1)
+                bclr    #4,D0
+                move.b  D0,2(A1)
+                move.w  (SP)+,SR
+
+                lea     dsphost.w,A0    ; bootstrap loads 512 words
+                lea     dspcode(PC),A2
+                moveq   #dspwords-1,D0
+bootcode:       bsr.s   txwait
+                move.b  (A2)+,5(A0)
+                move.b  (A2)+,6(A0)
+                move.b  (A2)+,7(A0)
+                dbra    D0,bootcode
+                move.w  #512-dspwords-1,D0
+                moveq   #0,D1
+                moveq   #0,D3
+bootpad:        bsr.s   txwait
+                move.b  D1,5(A0)
+                move.b  D1,6(A0)
+                move.b  D1,7(A0)
+                dbra    D0,bootpad
+
+mainloop:       addq.w  #1,D1
+                bsr.s   txwait
+                move.b  D1,6(A0)        ; send value << 8
+                move.b  D3,7(A0)
+rxwait:         btst    #0,2(A0)        ; wait for the result
+                beq.s   rxwait
+                move.b  5(A0),D2
+                move.b  6(A0),D2
+                move.b  7(A0),D2
+                bra.s   mainloop
+
+txwait:         btst    #1,2(A0)        ; wait until DSP can receive
+                beq.s   txwait
+                rts
+
+                DATA
+dspcode:        ; DSP56001 program, at P:0
+                DC.B $0a,$a9,$80,$00,$00,$00 ; loop: jclr #0,X:$ffe9,loop
+                DC.B $08,$44,$2b        ; movep X:$ffeb,X0
+                DC.B $20,$00,$13        ; clr A
+                DC.B $06,$e8,$83,$00,$00,$06 ; do #1000,send
+                DC.B $20,$00,$82        ; mac X0,X0,A
+                DC.B $0a,$a9,$81,$00,$00,$07 ; send: jclr #1,X:$ffe9,send
+                DC.B $08,$ce,$2b        ; movep A,X:$ffeb
+                DC.B $0c,$00,$00        ; jmp loop
+                EVEN
+
+                END
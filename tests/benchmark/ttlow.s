@@ -0,0 +1,59 @@
+; TT low resolution benchmark workload, ttlow/TTLOW.PRG
+; (assemble with TurboAss or Devpac, no relocation needed)
+;
+; Switches to TT low resolution (320x480, 8 planes) with own screen
+; buffer and keeps changing the whole screen and all the 256 colors.
+; Never exits, benchmark.py stops Hatari after the workload's VBLs.
+
+ttmode          EQU $0700           ; EsetShift() TT low
+colors          EQU 256
+scrsize         EQU 320*480
+
+                clr.l   -(SP)           ; Super()
+                move.w  #$20,-(SP)
+                trap    #1
+                addq.l  #6,SP
+
+                move.w  #ttmode,-(SP)   ; EsetShift()
+                move.w  #80,-(SP)
+                trap    #14
+                addq.l  #4,SP
+
+                lea     screen(PC),A0   ; screen at 256 byte boundary
+                move.l  A0,D0
+                addi.l  #255,D0
+                clr.b   D0
+                movea.l D0,A5
+                move.w  #-1,-(SP)       ; Setscreen(A5, A5, -1)
+                move.l  A5,-(SP)
+                move.l  A5,-(SP)
+                move.w  #5,-(SP)
+                trap    #14
+                lea     12(SP),SP
+
+                lea     $ffff8400.w,A6  ; TT palette
+                moveq   #0,D7           ; pass counter
+
+mainloop:       movea.l A5,A0           ; change whole screen
+                move.w  #scrsize/16-1,D0
+                move.l  D7,D1
+fill:           move.l  D1,(A0)+
+                move.l  D1,(A0)+
+                move.l  D1,(A0)+
+                move.l  D1,(A0)+
+                add.w   D0,D1
+                dbra    D0,fill
+
+                movea.l A6,A0           ; and all used colors
+                move.w  #colors-1,D0
+                move.w  D7,D1
+palette:        move.w  D1,(A0)+
+                addi.w  #$0123,D1
+                dbra    D0,palette
+                addq.l  #1,D7
+                bra.s   mainloop
+
+                BSS
+screen:         DS.B scrsize+256
+
+                END
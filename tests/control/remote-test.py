@@ -0,0 +1,111 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2013 by the Hatari developers
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+"""
+Tests that the Hatari control socket binary protocol rejects requests
+for addresses outside of the emulated address space (also ones which
+wrap around at 4GB) and IO addresses which would cause a bus error,
+and that Hatari still works after them.  Then tests that a pause
+request pipelined after other requests stops a running emulation.
+
+NOTE: To test an uninstalled version of Hatari, set PATH to point
+to your Hatari binary directory, like this:
+	PATH=../../build/src:$PATH ./remote-test.py etos512k.img
+"""
+
+from __future__ import print_function
+import os, sys
+
+sys.path.insert(0, os.path.join("..", "..", "tools", "hconsole"))
+import hconsole, hremote
+
+ADDRESS_ERROR = "invalid address"
+
+# (description, request method name, args)
+INVALID = (
+    ("RAM read wrapping at 4GB", "read_mem", (0xffffffff, 1)),
+    ("RAM read wrapping at 4GB", "read_mem", (0xfffffff0, 0x20)),
+    ("IO memory read past its end", "read_mem", (0xfffff0, 0x20)),
+    ("read above 24-bit address space", "read_mem", (0x1000000, 2)),
+    ("RAM write wrapping at 4GB", "write_mem", (0xffffffff, b"\0\0")),
+    ("ROM write", "write_mem", (0xe00000, b"\0\0")),
+    ("byte IO read wrapping at 4GB", "read_io", (0xffffffff, 1, 1)),
+    ("word IO read wrapping at 4GB", "read_io", (0xfffffffe, 2, 2)),
+    ("long IO read wrapping at 4GB", "read_io", (0xfffffffc, 4, 1)),
+    ("IO read past IO memory end", "read_io", (0xfffffe, 2, 2)),
+    ("IO read above 24-bit address space", "read_io", (0x1ff8240, 2, 1)),
+    ("IO write wrapping at 4GB", "write_io", (0xfffffffe, [0, 0], 2)),
+    ("IO read of bus error address", "read_io", (0xff8e00, 2, 1)),
+    ("IO write of bus error address", "write_io", (0xff8e00, [0], 2)),
+)
+
+
+def main():
+    "test main function"
+    if len(sys.argv) != 2 or not os.path.isfile(sys.argv[1]):
+        print(__doc__)
+        print("Usage: %s <EmuTOS image>\n" % os.path.basename(sys.argv[0]))
+        sys.exit(1)
+
+    os.environ.setdefault("SDL_VIDEODRIVER", "dummy")
+    os.environ.setdefault("SDL_AUDIODRIVER", "dummy")
+    hatari = hconsole.Hatari(["--machine", "ste", "--tos", sys.argv[1]])
+    remote = hremote.Remote(hatari.control)
+    remote.run_vbls(50)
+
+    failed = 0
+    for desc, method, args in INVALID:
+        try:
+            getattr(remote, method)(*args)
+            error = "request succeeded"
+        except hremote.RemoteError as value:
+            error = str(value)
+        if error.endswith(ADDRESS_ERROR):
+            print("OK: %s" % desc)
+        else:
+            print("FAIL: %s: %s" % (desc, error))
+            failed += 1
+
+    # valid requests at the end of the address space need to still work
+    remote.read_mem(0xfffff0, 0x10)
+    remote.read_io(0xff8240, 2, 16)
+    remote.run_vbls(10)
+
+    # pause after another request needs to stop run until breakpoint
+    remote.sock.settimeout(10)
+    remote.run_break(wait=False)
+    remote.info(wait=False)
+    remote.pause(wait=False)
+    try:
+        stop = remote.collect()[0]
+        if stop["stop"] == "pause":
+            print("OK: pipelined pause")
+        else:
+            print("FAIL: pipelined pause: emulation stopped for '%s'" % stop["stop"])
+            failed += 1
+    except Exception as value:
+        print("FAIL: pipelined pause: %s" % value)
+        failed += 1
+
+    if not hatari.is_running():
+        print("FAIL: Hatari exited")
+        failed += 1
+    hatari.kill_hatari()
+
+    if failed:
+        print("%d control socket tests failed!" % failed)
+        sys.exit(1)
+    print("All %d out-of-range requests were rejected, pipelined pause works." % len(INVALID))
+
+if __name__ == "__main__":
+    main()
@@ -124,6 +124,7 @@ void Video_GetPosition(int *pFrameCycles, int *pHBL, int *pLineCycles)
 	*pHBL = nHBL;
 	*pFrameCycles = 508;
 }
+Uint32 Video_GetScreenHash(void) { return 0x12345678; }
 
 /* only function needed from file.c */
 #include <sys/stat.h>
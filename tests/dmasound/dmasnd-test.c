@@ -0,0 +1,156 @@
+/*
+ * Hatari - dmasnd-test.c
+ *
+ * This file is distributed under the GNU General Public License, version 2
+ * or at your option any later version. Read the file gpl.txt for details.
+ *
+ * Golden output test for the STE DMA sound & LMC1992 code (src/dmaSnd.c).
+ *
+ * Plays a looping DMA sound frame with all sample rates, mono & stereo,
+ * all mixing modes and different bass / treble settings at several host
+ * audio frequencies, mixed with a YM square wave.  Samples are generated
+ * in varying sized blocks (like Sound_Update() does), which also wrap
+ * around the end of the mix buffer.  For each case, a checksum of the
+ * output samples and the number of end of frame interrupts is printed,
+ * so that output can be compared against the golden output.
+ */
+
+#include "main.h"
+#include "configuration.h"
+#include "audio.h"
+#include "dmaSnd.h"
+#include "cycInt.h"
+#include "ioMem.h"
+#include "sound.h"
+#include "stMemory.h"
+
+#define FRAME_START	0x10000
+#define FRAME_SIZE	1000
+#define CASE_SAMPLES	6000
+
+extern int nFrameInterrupts;
+
+static const int HostFreqs[] = { 44100, 50066, 22050 };
+static const int DmaFreqs[] = { 6258, 12517, 25033, 50066 };
+
+
+/**
+ * Send LMC1992 command through microwire and complete the transfer
+ */
+static void microwire_command(int command, int value)
+{
+	IoMem_WriteWord(0xff8924, 0x07ff);
+	DmaSnd_MicrowireMask_WriteWord();
+	IoMem_WriteWord(0xff8922, 0x400 | (command << 6) | value);
+	DmaSnd_MicrowireData_WriteWord();
+	/* enough cycles for the interrupt to do all the shifts at once */
+	PendingInterruptCount = -INT_CONVERT_TO_INTERNAL(1000, INT_CPU_CYCLE);
+	DmaSnd_InterruptHandler_Microwire();
+}
+
+/**
+ * Set DMA sound frame start & end addresses
+ */
+static void set_frame(Uint32 start, Uint32 end)
+{
+	IoMem_WriteByte(0xff8903, start >> 16);
+	IoMem_WriteByte(0xff8905, start >> 8);
+	IoMem_WriteByte(0xff8907, start);
+	IoMem_WriteByte(0xff890f, end >> 16);
+	IoMem_WriteByte(0xff8911, end >> 8);
+	IoMem_WriteByte(0xff8913, end);
+}
+
+/**
+ * Write DMA sound control register
+ */
+static void set_control(Uint16 value)
+{
+	IoMem_WriteWord(0xff8900, value);
+	DmaSnd_SoundControl_WriteWord();
+}
+
+/**
+ * Run one test case, return checksum of the generated samples
+ */
+static Uint32 run_case(int casenum, int *pIdx)
+{
+	Uint32 sum = 2166136261u;	/* FNV-1a */
+	int done, count, block, i, idx;
+	Sint16 ym;
+
+	for (done = count = 0; done < CASE_SAMPLES; done += block, count++)
+	{
+		/* stop DMA half way to test FIFO draining & DMA off mixing */
+		if (done >= CASE_SAMPLES / 2 && (nDmaSoundControl & DMASNDCTRL_PLAY))
+			set_control(0);
+
+		DmaSnd_STE_HBL_Update();
+
+		block = (count * 7 + casenum) % 41;
+		for (i = 0; i < block; i++)
+		{
+			idx = (*pIdx + i) % MIXBUFFER_SIZE;
+			ym = ((done + i) / (20 + casenum % 7)) & 1 ? 3000 : -3000;
+			MixBuffer[idx][0] = MixBuffer[idx][1] = ym;
+		}
+		DmaSnd_GenerateSamples(*pIdx, block);
+		for (i = 0; i < block; i++)
+		{
+			idx = (*pIdx + i) % MIXBUFFER_SIZE;
+			sum = (sum ^ (Uint16)MixBuffer[idx][0]) * 16777619u;
+			sum = (sum ^ (Uint16)MixBuffer[idx][1]) * 16777619u;
+		}
+		*pIdx = (*pIdx + block) % MIXBUFFER_SIZE;
+	}
+	return sum;
+}
+
+int main(int argc, char *argv[])
+{
+	int freq, rate, mono, mixing, casenum = 0;
+	int idx = MIXBUFFER_SIZE - 5000;
+	Uint32 sum, seed = 1;
+	int i;
+
+	/* looping sound frame, noise with a slow sine like sweep */
+	for (i = 0; i < FRAME_SIZE; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		STRam[FRAME_START + i] = ((seed >> 24) & 0x1f) + ((i % 200) < 100 ? i % 100 : 100 - i % 100);
+	}
+	ConfigureParams.System.nMachineType = MACHINE_STE;
+
+	for (freq = 0; freq < (int)(sizeof(HostFreqs)/sizeof(HostFreqs[0])); freq++)
+	{
+		nAudioFrequency = HostFreqs[freq];
+		DmaSnd_Reset(true);
+		for (rate = 0; rate < 4; rate++)
+		{
+			for (mono = 0; mono < 2; mono++)
+			{
+				for (mixing = 0; mixing < 3; mixing++, casenum++)
+				{
+					microwire_command(3, 0x28 - casenum % 3);	/* master volume */
+					microwire_command(5, 0x14);			/* left volume */
+					microwire_command(4, 0x14 - casenum % 5);	/* right volume */
+					microwire_command(1, casenum % 13);		/* bass */
+					microwire_command(2, (casenum * 5) % 13);	/* treble */
+					microwire_command(0, mixing);
+
+					IoMem_WriteByte(0xff8921, rate | (mono ? DMASNDMODE_MONO : 0));
+					DmaSnd_SoundModeCtrl_WriteByte();
+					set_frame(FRAME_START, FRAME_START + FRAME_SIZE - 2 * casenum);
+					nFrameInterrupts = 0;
+					set_control(DMASNDCTRL_PLAY | DMASNDCTRL_PLAYLOOP);
+
+					sum = run_case(casenum, &idx);
+					printf("%5d Hz, %5d Hz %-6s mixing %d: %08x, %d frames\n",
+					       nAudioFrequency, DmaFreqs[rate], mono ? "mono" : "stereo",
+					       mixing, sum, nFrameInterrupts);
+				}
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * Dummy stuff needed to compile STE DMA sound code for the golden test
+ */
+
+#include "main.h"
+
+/* fake tracing */
+#include "log.h"
+Uint64 LogTraceFlags = 0;
+FILE *TraceFile;
+
+/* fake Hatari configuration variables */
+#include "configuration.h"
+CNF_PARAMS ConfigureParams;
+
+/* fake CPU & cycles stuff */
+#include "m68000.h"
+struct regstruct regs;
+#include "cycles.h"
+int CurrentInstrCycles;
+#include "cycInt.h"
+int PendingInterruptCount;
+void CycInt_AcknowledgeInterrupt(void) { }
+void CycInt_AddRelativeInterrupt(int CycleTime, int CycleType, interrupt_id Handler) { }
+
+/* fake ST RAM and IO memory */
+#include "stMemory.h"
+#include "ioMem.h"
+#if ENABLE_SMALL_MEM
+static Uint8 RamMemory[16*1024*1024];
+static Uint8 IoMemory[0x10000];
+Uint8 *STRam = RamMemory;
+uae_u8 *IOmemory = IoMemory;
+#else
+Uint8 STRam[16*1024*1024];
+#endif
+
+/* fake MFP, end of frame interrupts are just counted */
+#include "mfp.h"
+Uint8 MFP_TACR;
+int nFrameInterrupts;
+void MFP_InputOnChannel(int Interrupt, int Interrupt_Delayed_Cycles) { nFrameInterrupts++; }
+void MFP_TimerA_EventCount_Interrupt(void) { }
+
+/* fake video */
+#include "screen.h"
+#include "video.h"
+void Video_GetPosition(int *pFrameCycles, int *pHBL, int *pLineCycles)
+{
+	*pFrameCycles = *pHBL = *pLineCycles = 0;
+}
+
+/* fake memory snapshot */
+#include "memorySnapShot.h"
+void MemorySnapShot_Store(void *pData, int Size) { }
+
+/* fake Falcon microwire */
+#include "crossbar.h"
+void Crossbar_InterruptHandler_Microwire(void) { }
+
+/* sound output, the test generates samples itself */
+#include "audio.h"
+int nAudioFrequency = 44100;
+#include "sound.h"
+Sint16 MixBuffer[MIXBUFFER_SIZE][2];
+void Sound_Update(bool FillFrame) { }
+
+/* subsonic filters, same as in sound.c */
+ymsample Subsonic_IIR_HPF_Left(ymsample x0)
+{
+	static	yms32	x1 = 0, y1 = 0, y0 = 0;
+
+	y1 += ((x0 - x1)<<15) - (y0<<6);  /*  64*y0  */
+	y0 = y1>>15;
+	x1 = x0;
+
+	return y0;
+}
+
+ymsample Subsonic_IIR_HPF_Right(ymsample x0)
+{
+	static	yms32	x1 = 0, y1 = 0, y0 = 0;
+
+	y1 += ((x0 - x1)<<15) - (y0<<6);  /*  64*y0  */
+	y0 = y1>>15;
+	x1 = x0;
+
+	return y0;
+}
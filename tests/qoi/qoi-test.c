@@ -0,0 +1,260 @@
+/*
+ * Hatari - qoi-test.c
+ *
+ * This file is distributed under the GNU General Public License, version 2
+ * or at your option any later version. Read the file gpl.txt for details.
+ *
+ * Round-trip test for the QOI screenshot encoder (src/qoi.c).
+ *
+ * Encodes test images line by line like screenshots are saved, decodes
+ * them with a separate decoder written from the QOI specification, and
+ * checks that the decoded pixels (including alpha) match the originals.
+ * Each case also checks that the encoder used the QOI operation the
+ * case is meant to exercise.
+ */
+
+#include "main.h"
+#include "qoi.h"
+
+#define MAX_PIXELS	(64 * 64)
+
+/* decoded operation counts */
+enum { OP_INDEX, OP_DIFF, OP_LUMA, OP_RUN, OP_RGB, OP_RGBA, OPS };
+static const char *OpNames[OPS] = { "index", "diff", "luma", "run", "rgb", "rgba" };
+
+
+/**
+ * Decode QOI image in 'data' to RGBA 'pixels', following the specification.
+ * Count the used operations to 'ops'.  Return false for errors.
+ */
+static bool qoi_decode(const Uint8 *data, long size, int width, int height,
+                       Uint8 *pixels, int *ops)
+{
+	static const Uint8 trailer[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+	Uint8 index[64][4], px[4] = { 0, 0, 0, 255 };
+	int i, run = 0, count = width * height;
+	const Uint8 *p = data + 14, *end = data + size - 8;
+	Uint8 b1, b2;
+	int dg;
+
+	if (size < 22 || memcmp(data, "qoif", 4) != 0
+	    || (data[4] << 24 | data[5] << 16 | data[6] << 8 | data[7]) != width
+	    || (data[8] << 24 | data[9] << 16 | data[10] << 8 | data[11]) != height
+	    || data[12] != 3 || data[13] != 0)
+	{
+		fprintf(stderr, "ERROR: invalid header\n");
+		return false;
+	}
+	memset(index, 0, sizeof(index));
+	memset(ops, 0, OPS * sizeof(*ops));
+
+	for (i = 0; i < count; i++)
+	{
+		if (run > 0)
+		{
+			run--;
+		}
+		else
+		{
+			if (p >= end)
+			{
+				fprintf(stderr, "ERROR: data ends at pixel %d\n", i);
+				return false;
+			}
+			b1 = *p++;
+			if (b1 == 0xfe)
+			{
+				px[0] = *p++;
+				px[1] = *p++;
+				px[2] = *p++;
+				ops[OP_RGB]++;
+			}
+			else if (b1 == 0xff)
+			{
+				px[0] = *p++;
+				px[1] = *p++;
+				px[2] = *p++;
+				px[3] = *p++;
+				ops[OP_RGBA]++;
+			}
+			else if ((b1 & 0xc0) == 0x00)
+			{
+				memcpy(px, index[b1], 4);
+				ops[OP_INDEX]++;
+			}
+			else if ((b1 & 0xc0) == 0x40)
+			{
+				px[0] += ((b1 >> 4) & 3) - 2;
+				px[1] += ((b1 >> 2) & 3) - 2;
+				px[2] += (b1 & 3) - 2;
+				ops[OP_DIFF]++;
+			}
+			else if ((b1 & 0xc0) == 0x80)
+			{
+				b2 = *p++;
+				dg = (b1 & 0x3f) - 32;
+				px[0] += dg - 8 + ((b2 >> 4) & 0x0f);
+				px[1] += dg;
+				px[2] += dg - 8 + (b2 & 0x0f);
+				ops[OP_LUMA]++;
+			}
+			else
+			{
+				run = b1 & 0x3f;
+				ops[OP_RUN]++;
+			}
+			memcpy(index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64], px, 4);
+		}
+		memcpy(pixels + 4 * i, px, 4);
+	}
+	if (run > 0 || p != end || memcmp(end, trailer, sizeof(trailer)) != 0)
+	{
+		fprintf(stderr, "ERROR: extra data or invalid end marker\n");
+		return false;
+	}
+	return true;
+}
+
+
+/**
+ * Encode given RGB image with the Hatari QOI encoder, decode it and
+ * compare the result.  'op' is the operation that the case needs to use.
+ * Return true if test passed.
+ */
+static bool test_case(const char *name, const Uint8 *rgb, int width, int height, int op)
+{
+	Uint8 line[QOI_LINE_BYTES(MAX_PIXELS)];
+	Uint8 data[14 + QOI_LINE_BYTES(MAX_PIXELS) + 8];
+	Uint8 pixels[4 * MAX_PIXELS];
+	QOI_ENCODER enc;
+	int ops[OPS];
+	int y, i, len;
+	long size;
+	FILE *fp;
+
+	fp = tmpfile();
+	if (!fp)
+	{
+		perror("tmpfile");
+		return false;
+	}
+	Qoi_WriteHeader(fp, width, height);
+	Qoi_InitEncoder(&enc);
+	for (y = 0; y < height; y++)
+	{
+		len = Qoi_EncodeLine(&enc, rgb + 3 * width * y, width, line);
+		fwrite(line, len, 1, fp);
+	}
+	Qoi_WriteEnd(&enc, fp);
+	size = ftell(fp);
+	rewind(fp);
+	if (size > (long)sizeof(data) || fread(data, size, 1, fp) != 1)
+	{
+		fprintf(stderr, "ERROR: reading encoded '%s' image failed\n", name);
+		fclose(fp);
+		return false;
+	}
+	fclose(fp);
+
+	if (!qoi_decode(data, size, width, height, pixels, ops))
+	{
+		fprintf(stderr, "FAIL: %s\n", name);
+		return false;
+	}
+	for (i = 0; i < width * height; i++)
+	{
+		if (memcmp(pixels + 4 * i, rgb + 3 * i, 3) != 0 || pixels[4 * i + 3] != 255)
+		{
+			fprintf(stderr, "FAIL: %s, pixel %d: %02x%02x%02x, decoded %02x%02x%02x/%02x\n",
+			        name, i, rgb[3*i], rgb[3*i+1], rgb[3*i+2],
+			        pixels[4*i], pixels[4*i+1], pixels[4*i+2], pixels[4*i+3]);
+			return false;
+		}
+	}
+	if (!ops[op])
+	{
+		fprintf(stderr, "FAIL: %s, no '%s' operations used\n", name, OpNames[op]);
+		return false;
+	}
+	printf("OK: %-14s %4ld bytes (index %d, diff %d, luma %d, run %d, rgb %d)\n",
+	       name, size, ops[OP_INDEX], ops[OP_DIFF], ops[OP_LUMA], ops[OP_RUN], ops[OP_RGB]);
+	return true;
+}
+
+
+/**
+ * Set 'count' RGB pixels from array of 0xRRGGBB colors
+ */
+static void set_pixels(Uint8 *rgb, const Uint32 *colors, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		rgb[3 * i] = colors[i] >> 16;
+		rgb[3 * i + 1] = colors[i] >> 8;
+		rgb[3 * i + 2] = colors[i];
+	}
+}
+
+
+int main(int argc, char *argv[])
+{
+	/* opaque black hashes to an index entry which hasn't been set yet */
+	static const Uint32 black[] = { 0xffffff, 0x000000, 0xff0000, 0xffffff, 0xff0000 };
+	static const Uint32 index[] = { 0x123456, 0xabcdef, 0x123456, 0xfedcba, 0xabcdef, 0x123456 };
+	static const Uint32 diff[] = { 0x808080, 0x818081, 0x7f7f80, 0x7e7e7e, 0x7f7e7f, 0x7f7f7f };
+	static const Uint32 luma[] = { 0x404040, 0x4a4c4e, 0x383c40, 0x585a5c, 0x404040, 0x404840 };
+	static const Uint32 rgbs[] = { 0xff0000, 0x00ff00, 0x0000ff, 0xc08020, 0x20c080, 0x8020c0 };
+	Uint8 rgb[3 * MAX_PIXELS];
+	Uint32 colors[MAX_PIXELS], seed = 1;
+	bool ok = true;
+	int i;
+
+	set_pixels(rgb, black, 5);
+	ok &= test_case("black", rgb, 5, 1, OP_INDEX);
+	set_pixels(rgb, index, 6);
+	ok &= test_case("index", rgb, 6, 1, OP_INDEX);
+	set_pixels(rgb, diff, 6);
+	ok &= test_case("diff", rgb, 3, 2, OP_DIFF);
+	set_pixels(rgb, luma, 6);
+	ok &= test_case("luma", rgb, 2, 3, OP_LUMA);
+	set_pixels(rgb, rgbs, 6);
+	ok &= test_case("rgb", rgb, 6, 1, OP_RGB);
+
+	/* runs longer than 62 pixels, continuing over lines, starting
+	 * from the initial black pixel and ending the image */
+	for (i = 0; i < 64 * 4; i++)
+		colors[i] = (i >= 70 && i < 200) ? 0x00ff00 : 0;
+	set_pixels(rgb, colors, 64 * 4);
+	ok &= test_case("run", rgb, 64, 4, OP_RUN);
+
+	/* a screen-like image with few colors, and noise with all kinds of ops */
+	for (i = 0; i < MAX_PIXELS; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		colors[i] = (i / 7 % 3 == 0) ? 0 : ((seed >> 16) % 4) * 0x554422;
+	}
+	set_pixels(rgb, colors, MAX_PIXELS);
+	ok &= test_case("palette", rgb, 64, 64, OP_INDEX);
+	for (i = 0; i < MAX_PIXELS; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		if ((seed >> 16) % 5 == 0)
+			colors[i] = seed >> 8 & 0xffffff;
+		else if (i > 0)
+			colors[i] = colors[i-1] + ((seed >> 12) % 3) * 0x010101;
+		else
+			colors[i] = 0;
+	}
+	set_pixels(rgb, colors, MAX_PIXELS);
+	ok &= test_case("noise", rgb, 64, 64, OP_RGB);
+
+	if (!ok)
+	{
+		fprintf(stderr, "QOI round-trip test FAILED.\n");
+		return 1;
+	}
+	printf("QOI round-trip test passed.\n");
+	return 0;
+}
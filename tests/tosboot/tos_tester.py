@@ -22,6 +22,14 @@ indicates the used combination, for example:
         etos512k-falcon-rgb-gemdos-14M.png
         etos512k-st-mono-floppy-1M.png
 
+With the --jobs option, test combinations are run in parallel, each
+in its own working directory with its own Hatari control socket.
+Instead of screenshot files, screen content is then fetched with the
+binary control protocol and its hash is compared against the hashes
+from a reference run (given with --reference).  Test report lists
+also how long each combination took, and with how many VBLs, so
+that emulation speed regressions show up with the functional ones.
+
 
 NOTE: If you want to test the latest, uninstalled version of Hatari,
 you need to set PATH to point to your Hatari binary directory, like
@@ -35,6 +43,7 @@ you also need to specify hconsole.py location with:
 """
 
 import getopt, os, signal, select, sys, time
+import hashlib, multiprocessing, shutil, socket, struct, subprocess, threading
 
 def add_hconsole_paths():
     "add most likely hconsole locations to module import path"
@@ -51,7 +60,7 @@ def add_hconsole_paths():
                  "/usr/share/hatari/hconsole"]
 
 add_hconsole_paths()
-import hconsole
+import hconsole, hremote
 
 
 def warning(msg):
@@ -201,6 +210,8 @@ class Config:
 
     # defaults
     fast = False
+    jobs = 0
+    reference = None
     bools = []
     disks = ("floppy", "gemdos")
     graphics = ("mono", "rgb", "vdi1")
@@ -208,9 +219,9 @@ class Config:
     memsizes = (0, 4, 14)
 
     def __init__(self, argv):
-        longopts = ["bool=", "disks=", "fast", "graphics=", "help", "machines=", "memsizes="]
+        longopts = ["bool=", "disks=", "fast", "graphics=", "help", "jobs=", "machines=", "memsizes=", "reference="]
         try:
-            opts, paths = getopt.gnu_getopt(argv[1:], "b:d:fg:hm:s:", longopts)
+            opts, paths = getopt.gnu_getopt(argv[1:], "b:d:fg:hj:m:r:s:", longopts)
         except getopt.GetoptError as error:
             self.usage(error)
         self.handle_options(opts)
@@ -246,6 +257,20 @@ class Config:
                 unknown, self.disks = validate(args, self.all_disks)
             elif opt in ("-g", "--graphics"):
                 unknown, self.graphics = validate(args, self.all_graphics)
+            elif opt in ("-j", "--jobs"):
+                try:
+                    self.jobs = int(arg)
+                except ValueError:
+                    self.usage("non-numeric job count: %s" % arg)
+                if self.jobs < 0:
+                    self.usage("negative job count: %s" % arg)
+                if not self.jobs:
+                    self.jobs = multiprocessing.cpu_count()
+                self.fast = True
+            elif opt in ("-r", "--reference"):
+                if not os.path.isfile(arg):
+                    self.usage("screenshot hash reference file '%s' missing" % arg)
+                self.reference = arg
             elif opt in ("-m", "--machines"):
                 unknown, self.machines = validate(args, self.all_machines)
             elif opt in ("-s", "--memsizes"):
@@ -273,6 +298,9 @@ Options:
 \t-m, --machines\t%s
 \t-s, --memsizes\t%s
 \t-b, --bool\t(extra boolean Hatari options to test)
+\t-j, --jobs\tnumber of tests to run in parallel (0 = host cores),
+\t\t\timplies --fast
+\t-r, --reference\tscreenshot hash file from an earlier parallel run
 
 Multiple values for an option need to be comma separated. If some
 option isn't given, default list of values will be used for that.
@@ -284,7 +312,11 @@ For example:
 \t--memsizes 0,4,14 \\
 \t--graphics mono,rgb \\
 \t-bool --compatible,--rtc
-""" % (name, self.all_disks, self.all_graphics, self.all_machines, self.all_memsizes, name))
+
+Or, to run tests on all host cores and to check for screen
+changes since an earlier run:
+  %s --jobs 0 --reference old-hashes.txt <TOS images>
+""" % (name, self.all_disks, self.all_graphics, self.all_machines, self.all_memsizes, name, name))
         if msg:
             print("ERROR: %s\n" % msg)
         sys.exit(1)
@@ -373,11 +405,14 @@ class Tester:
     printout  = output + "printer-out"
     serialout = output + "serial-out"
     fifofile  = output + "midi-out"
+    blankdisk = "blank-a.st.gz"
     bootauto  = "bootauto.st.gz" # TOS old not to support GEMDOS HD either
     bootdesk  = "bootdesk.st.gz"
     hdimage   = "hd.img"
     ideimage  = "hd.img"	 # for now use the same image as for ACSI
     results   = None
+    notes     = {}
+    stages    = ("Hatari init", "Test program running", "Test program test-cases", "Test program output")
     
     def __init__(self):
         "test setup initialization"
@@ -411,7 +446,7 @@ class Tester:
         dummy.write("[Log]\nnAlertDlgLogLevel = 0\nbConfirmQuit = FALSE\n")
         dummy.write("[Screen]\nnMaxWidth=832\nnMaxHeight=576\nbCrop = TRUE\nbAllowOverscan=FALSE\n")
         dummy.write("[HardDisk]\nbUseHardDiskDirectory = FALSE\n")
-        dummy.write("[Floppy]\nszDiskAFileName = blank-a.st.gz\n")
+        dummy.write("[Floppy]\nszDiskAFileName = %s\n" % self.blankdisk)
         dummy.write("[Printer]\nbEnablePrinting = TRUE\nszPrintToFileName = %s\n" % self.printout)
         dummy.write("[RS232]\nbEnableRS232 = TRUE\nszInFileName = \nszOutFileName = %s\n" % self.serialout)
         dummy.write("[Midi]\nbEnableMidi = TRUE\nsMidiInFileName = \nsMidiOutFileName = %s\n" % self.fifofile)
@@ -551,8 +586,8 @@ class Tester:
         return (init_ok, prog_ok, tests_ok, output_ok)
 
     
-    def prepare_test(self, config, tos, machine, monitor, disk, memory, extra):
-        "compose test ID and Hatari command line args, then call .test()"
+    def test_args(self, config, tos, machine, monitor, disk, memory, extra):
+        "return test ID and Hatari command line args for given combination"
         identity = "%s-%s-%s-%s-%sM" % (tos.name, machine, monitor, disk, memory)
         testargs = ["--tos", tos.path, "--machine", machine, "--memsize", str(memory)]
         
@@ -590,7 +625,11 @@ class Tester:
             testargs += ["--ide-master", self.ideimage]
         else:
             raise AssertionError("unknown disk type '%s'" % disk)
+        return (identity, testargs)
 
+    def prepare_test(self, config, tos, machine, monitor, disk, memory, extra):
+        "compose test ID and Hatari command line args, then call .test()"
+        identity, testargs = self.test_args(config, tos, machine, monitor, disk, memory, extra)
         results = self.test(identity, testargs, tos, memory)
         self.results[tos.name].append((identity, results))
 
@@ -629,8 +668,8 @@ class Tester:
     
     def summary(self):
         "summarize test results"
-        cases = [0, 0, 0, 0]
-        passed = [0, 0, 0, 0]
+        cases = [0] * len(self.stages)
+        passed = [0] * len(self.stages)
         tosnames = self.results.keys()
         tosnames.sort()
         
@@ -645,7 +684,10 @@ class Tester:
             for config, results in configs:
                 # convert True/False bools to FAIL/pass strings
                 values = [("FAIL","pass")[int(r)] for r in results]
-                report.write("  - %s: %s\n" % (config, values))
+                if config in self.notes:
+                    report.write("  - %s: %s, %s\n" % (config, values, self.notes[config]))
+                else:
+                    report.write("  - %s: %s\n" % (config, values))
                 # update statistics
                 for idx in range(len(results)):
                     cases[idx] += 1
@@ -653,7 +695,7 @@ class Tester:
         
         report.write("\nSummary of FAIL/pass values:\n")
         idx = 0
-        for line in ("Hatari init", "Test program running", "Test program test-cases", "Test program output"):
+        for line in self.stages:
             passes, total = passed[idx], cases[idx]
             if passes < total:
                 if not passes:
@@ -673,13 +715,245 @@ class Tester:
             print line.strip()
 
 
+# -----------------------------------------------
+class ParallelJob(Tester):
+    "single test combination run in its own directory by ParallelTester"
+    socketname = "control.socket"
+    logname = "hatari.log"
+
+    def __init__(self, tester, tos, identity, testargs, memory):
+        "set up job paths, all absolute as Hatari is run in job directory"
+        self.tos, self.identity, self.memory = tos, identity, memory
+        self.jobdir = os.path.abspath(tester.jobsdir + identity) + os.path.sep
+        self.output     = self.jobdir
+        self.dummycfg   = self.jobdir + Tester.dummycfg
+        self.printout   = self.jobdir + "printer-out"
+        self.serialout  = self.jobdir + "serial-out"
+        self.fifofile   = self.jobdir + "midi-out"
+        self.textoutput = self.jobdir + Tester.textoutput
+        self.blankdisk  = os.path.abspath(Tester.blankdisk)
+        self.testargs = testargs
+        # (init, prog, tests, output, screenshot) results
+        self.results = (False, False, False, False, False)
+        self.secs = 0.0
+        self.vbls = 0
+        self.screen = None
+
+    def setup(self):
+        "create job directory with its own config, fifo and test disk dir"
+        if os.path.exists(self.jobdir):
+            shutil.rmtree(self.jobdir)
+        os.makedirs(self.jobdir)
+        os.mkfifo(self.fifofile)
+        self.create_config()
+        # test program writes to its GEMDOS HD directory
+        shutil.copytree("disk", self.jobdir + "disk", symlinks=True)
+        args = []
+        for arg in self.testargs:
+            if arg == self.testprg:
+                arg = self.jobdir + self.testprg
+            elif arg == self.hdimage:
+                shutil.copy(self.hdimage, self.jobdir)
+                arg = self.jobdir + self.hdimage
+            elif os.path.exists(arg):
+                arg = os.path.abspath(arg)
+            args.append(arg)
+        return args
+
+    def wait_output(self, fifo, deadline):
+        "wait until test program writes to fifo, return (prog_ok, tests_ok)"
+        line = ""
+        while time.time() < deadline:
+            sets = select.select([fifo], [], [], deadline - time.time())
+            if not sets[0]:
+                break
+            data = os.read(fifo, 256)
+            if not data:
+                # no writer yet (or anymore)
+                time.sleep(0.1)
+                continue
+            line += data
+            if "\n" in line:
+                break
+        if not line:
+            return (False, False)
+        return (True, (line.strip() == "success"))
+
+    def get_screen(self, control):
+        "switch control socket to binary protocol, fetch VBLs and screen"
+        control.settimeout(10)
+        remote = hremote.Remote(control)
+        self.vbls = remote.info()["vbls"]
+        width, height, data = remote.screenshot()
+        self.screen = (width, height, data)
+        return hashlib.sha1(struct.pack(">HH", width, height) + data).hexdigest()
+
+    def save_screen(self, path):
+        "save fetched screen as PPM image"
+        width, height, data = self.screen
+        ppm = open(path, "wb")
+        ppm.write("P6\n%d %d\n255\n" % (width, height))
+        ppm.write(data)
+        ppm.close()
+
+    def run(self, hataribin):
+        "run Hatari for the test, return screen hash or None"
+        args = self.setup()
+        server = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        server.bind(self.jobdir + self.socketname)
+        server.listen(1)
+        server.settimeout(0.5)
+        # no windows or audio devices needed for parallel runs
+        env = os.environ.copy()
+        env.setdefault("SDL_VIDEODRIVER", "dummy")
+        env.setdefault("SDL_AUDIODRIVER", "dummy")
+        allargs = [hataribin, "--configfile", self.dummycfg,
+                   "--control-socket", self.jobdir + self.socketname] + args
+        log = open(self.jobdir + self.logname, "w")
+        start = time.time()
+        hatari = subprocess.Popen(allargs, cwd=self.jobdir, env=env,
+                                  stdout=log, stderr=subprocess.STDOUT)
+        control = fifo = None
+        screenhash = None
+        init_ok = prog_ok = tests_ok = output_ok = False
+        try:
+            while not control:
+                try:
+                    control = server.accept()[0]
+                except socket.timeout:
+                    if hatari.poll() is not None or time.time() > start + self.tos.fullwait:
+                        raise
+            init_ok = True
+            fifo = os.open(self.fifofile, os.O_RDONLY | os.O_NONBLOCK)
+            if self.tos.memwait:
+                # pass memory test
+                time.sleep(self.tos.memwait)
+                control.sendall("hatari-event keypress %s\n" % hconsole.Scancode.Space)
+            prog_ok, tests_ok = self.wait_output(fifo, start + self.tos.fullwait)
+            self.secs = time.time() - start
+            # small wait to guarantee all test program output got to screen
+            time.sleep(0.2)
+            screenhash = self.get_screen(control)
+        except (socket.error, hremote.RemoteError) as error:
+            warning("%s: %s" % (self.identity, error))
+        if not self.secs:
+            self.secs = time.time() - start
+        if fifo is not None:
+            os.close(fifo)
+        if control:
+            control.close()
+        server.close()
+        if hatari.poll() is None:
+            hatari.kill()
+        hatari.wait()
+        log.close()
+        if tests_ok:
+            output_ok = self.verify_output(self.identity, self.tos, self.memory)
+        self.results = (init_ok, prog_ok, tests_ok, output_ok, False)
+        return screenhash
+
+
+class ParallelTester(Tester):
+    "test driver running test combinations in parallel"
+    jobsdir = Tester.output + "jobs" + os.path.sep
+    hashes  = Tester.output + "screenshot-hashes.txt"
+    stages  = Tester.stages + ("Screenshot hash",)
+
+    def __init__(self, config):
+        "test setup initialization"
+        self.jobcount = config.jobs
+        self.reference = {}
+        if config.reference:
+            for line in open(config.reference).readlines():
+                items = line.split()
+                if len(items) == 2:
+                    self.reference[items[0]] = items[1]
+        if os.path.exists(self.jobsdir):
+            shutil.rmtree(self.jobsdir)
+        os.makedirs(self.jobsdir)
+        self.queue = []
+        self.lock = threading.Lock()
+        self.notes = {}
+        self.screenhashes = {}
+
+    def prepare_test(self, config, tos, machine, monitor, disk, memory, extra):
+        "compose test ID and Hatari command line args, then queue the test"
+        identity, testargs = self.test_args(config, tos, machine, monitor, disk, memory, extra)
+        self.queue.append(ParallelJob(self, tos, identity, testargs, memory))
+
+    def check_screen(self, job, screenhash):
+        "compare screen hash to reference, return (ok, description)"
+        if not screenhash:
+            return (False, "no screenshot")
+        job.save_screen(self.output + job.identity + ".ppm")
+        self.screenhashes[job.identity] = screenhash
+        if job.identity not in self.reference:
+            return (True, "NEW screenshot")
+        if self.reference[job.identity] != screenhash:
+            return (False, "screenshot DIFFERS")
+        return (True, "screenshot matches")
+
+    def worker(self):
+        "run queued tests until there are no more of them"
+        while True:
+            self.lock.acquire()
+            if not self.queue:
+                self.lock.release()
+                return
+            job = self.queue.pop(0)
+            print "RUN: %s" % job.identity
+            self.lock.release()
+
+            screenhash = job.run(hconsole.Hatari.hataribin)
+
+            self.lock.acquire()
+            shot_ok, shot = self.check_screen(job, screenhash)
+            job.results = job.results[:-1] + (shot_ok,)
+            rate = 0.0
+            if job.secs > 0:
+                rate = job.vbls / job.secs
+            self.notes[job.identity] = "%.1fs, %d VBLs (%.1f VBLs/s), %s" % (job.secs, job.vbls, rate, shot)
+            self.results[job.tos.name].append((job.identity, job.results))
+            print "DONE: %s: %s" % (job.identity, self.notes[job.identity])
+            if False not in job.results:
+                shutil.rmtree(job.jobdir)
+            self.lock.release()
+
+    def run(self, config):
+        "run all TOS boot test combinations on given number of threads"
+        Tester.run(self, config)
+        start = time.time()
+        print "Running %d tests with %d parallel jobs..." % (len(self.queue), self.jobcount)
+        threads = []
+        for i in range(min(self.jobcount, len(self.queue))):
+            thread = threading.Thread(target=self.worker)
+            thread.start()
+            threads.append(thread)
+        for thread in threads:
+            thread.join()
+        print "...all tests done in %.1fs." % (time.time() - start)
+        for configs in self.results.values():
+            configs.sort()
+        hashes = open(self.hashes, "w")
+        for identity in sorted(self.screenhashes.keys()):
+            hashes.write("%s %s\n" % (identity, self.screenhashes[identity]))
+        hashes.close()
+
+    def cleanup_all_files(self):
+        "parallel jobs clean up after themselves"
+        pass
+
+
 # -----------------------------------------------
 def main():
     "tester main function"
     info = "Hatari TOS bootup tester"
     print "\n%s\n%s\n" % (info, "-"*len(info))
     config = Config(sys.argv)
-    tester = Tester()
+    if config.jobs:
+        tester = ParallelTester(config)
+    else:
+        tester = Tester()
     tester.run(config)
     tester.summary()
 
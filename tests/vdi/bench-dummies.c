@@ -0,0 +1,26 @@
+/*
+ * Dummy stuff needed to compile native VDI drawing code for the benchmark
+ */
+
+#include "main.h"
+
+/* fake tracing */
+#include "log.h"
+Uint64 LogTraceFlags = 0;
+FILE *TraceFile;
+void Log_Printf(LOGTYPE nType, const char *psFormat, ...) { }
+
+/* fake ST RAM */
+#include "stMemory.h"
+Uint8 STRam[16*1024*1024];
+Uint32 STRamEnd = 4*1024*1024;
+
+/* fake memory snapshot */
+#include "memorySnapShot.h"
+void MemorySnapShot_Store(void *pData, int Size) { }
+
+/* VDI resolution, set from recording */
+#include "vdi.h"
+int VDIWidth = 640;
+int VDIHeight = 480;
+int VDIPlanes = 4;
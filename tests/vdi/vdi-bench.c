@@ -0,0 +1,232 @@
+/*
+ * Hatari - vdi-bench.c
+ *
+ * This file is distributed under the GNU General Public License, version 2
+ * or at your option any later version. Read the file gpl.txt for details.
+ *
+ * Replay VDI calls recorded with Hatari --vdi-record option through
+ * the native VDI drawing code and report how long that took.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "main.h"
+#include "stMemory.h"
+#include "vdi.h"
+#include "vdidraw.h"
+
+/* where VDI arrays & forms are put in the fake ST RAM */
+#define ADDR_FONTTABLE  0x000800
+#define ADDR_CONTRL     0x001000
+#define ADDR_INTIN      0x002000
+#define ADDR_PTSIN      0x004000
+#define ADDR_INTOUT     0x006000
+#define ADDR_PTSOUT     0x007000
+#define ADDR_MFDB       0x008000
+#define ADDR_FONTS      0x010000
+#define ADDR_SCREEN     0x100000
+#define ADDR_FORMS      0x200000
+
+#define MAX_ARRAY_WORDS 0x1000  /* max words per array area */
+#define FORM_SIZE       0x80000
+
+static Uint8 *Data, *DataEnd, *Pos;
+
+
+/**
+ * Read next big endian word from the recording
+ */
+static int ReadWord(void)
+{
+	int value;
+
+	if (Pos + 2 > DataEnd)
+	{
+		fprintf(stderr, "ERROR: truncated recording!\n");
+		exit(1);
+	}
+	value = (Pos[0] << 8) | Pos[1];
+	Pos += 2;
+	return value;
+}
+
+/**
+ * Copy next recorded array to given address, return its word count
+ */
+static int ReadArray(Uint32 addr)
+{
+	int i, count = ReadWord();
+
+	for (i = 0; i < count; i++)
+	{
+		Uint16 value = ReadWord();
+		if (i < MAX_ARRAY_WORDS)
+			STMemory_WriteWord(addr + 2*i, value);
+	}
+	return count;
+}
+
+/**
+ * Load the three system fonts & set their header table
+ */
+static void ReadFonts(void)
+{
+	Uint32 addr = ADDR_FONTS, header, offsets, data;
+	int i, count;
+
+	for (i = 0; i < 3; i++)
+	{
+		header = addr;
+		addr += 2 * ReadArray(header);
+		offsets = addr;
+		addr += 2 * ReadArray(offsets);
+		data = addr;
+		count = ReadWord();
+		while (count-- > 0)
+		{
+			STMemory_WriteWord(addr, ReadWord());
+			addr += 2;
+		}
+		STMemory_WriteLong(header + 72, offsets);
+		STMemory_WriteLong(header + 76, data);
+		STMemory_WriteLong(ADDR_FONTTABLE + 4*i, header);
+	}
+	VDIDraw_SetFonts(ADDR_FONTTABLE);
+}
+
+/**
+ * Point vro_cpyfm MFDBs to the fake ST RAM
+ */
+static void FixMFDBs(void)
+{
+	int i;
+	Uint32 mfdb;
+
+	for (i = 0; i < 2; i++)
+	{
+		mfdb = ADDR_MFDB + 20*i;
+		if (STMemory_ReadLong(mfdb))
+			STMemory_WriteLong(mfdb, ADDR_FORMS + FORM_SIZE*i);
+		STMemory_WriteLong(ADDR_CONTRL + 2*7 + 4*i, mfdb);
+	}
+}
+
+/**
+ * Replay the whole recording once.  Return the number of drawing calls,
+ * and the number of natively done ones in 'native'.
+ */
+static int Replay(int *native)
+{
+	int type, calls = 0;
+
+	*native = 0;
+	Pos = Data + 12;
+	while (Pos < DataEnd)
+	{
+		type = ReadWord();
+		if (type == VDIDRAW_REC_FONTS)
+		{
+			ReadFonts();
+			continue;
+		}
+		ReadArray(ADDR_CONTRL);
+		ReadArray(ADDR_INTIN);
+		ReadArray(ADDR_PTSIN);
+		ReadArray(ADDR_INTOUT);
+		ReadArray(ADDR_PTSOUT);
+		ReadArray(ADDR_MFDB);
+		switch (type)
+		{
+		case VDIDRAW_REC_OPEN:
+		case VDIDRAW_REC_ATTRIB:
+			VDIDraw_Complete(ADDR_CONTRL, ADDR_INTIN, ADDR_PTSIN,
+			                 ADDR_INTOUT, ADDR_PTSOUT);
+			break;
+		case VDIDRAW_REC_DRAW:
+			FixMFDBs();
+			if (VDIDraw_Entry(ADDR_CONTRL, ADDR_INTIN, ADDR_PTSIN, true) == VDI_ENTRY_DONE)
+				(*native)++;
+			calls++;
+			break;
+		default:
+			fprintf(stderr, "ERROR: unknown record type %d!\n", type);
+			exit(1);
+		}
+	}
+	return calls;
+}
+
+int main(int argc, const char *argv[])
+{
+	int i, loops, calls = 0, native = 0;
+	Uint32 checksum, size, offset;
+	clock_t start, end;
+	double secs;
+	FILE *fp;
+	long len;
+
+	if (argc < 2 || argc > 3)
+	{
+		fprintf(stderr, "usage: %s <VDI recording> [loops]\n", argv[0]);
+		return 1;
+	}
+	loops = (argc == 3 ? atoi(argv[2]) : 1);
+
+	fp = fopen(argv[1], "rb");
+	if (!fp || fseek(fp, 0, SEEK_END) || (len = ftell(fp)) < 12)
+	{
+		fprintf(stderr, "ERROR: can't read '%s'!\n", argv[1]);
+		return 1;
+	}
+	rewind(fp);
+	Data = malloc(len);
+	if (!Data || fread(Data, len, 1, fp) != 1)
+	{
+		fprintf(stderr, "ERROR: reading '%s' failed!\n", argv[1]);
+		return 1;
+	}
+	fclose(fp);
+	DataEnd = Data + len;
+	if (memcmp(Data, VDIDRAW_REC_MAGIC, 4) != 0)
+	{
+		fprintf(stderr, "ERROR: '%s' isn't a VDI recording!\n", argv[1]);
+		return 1;
+	}
+	Pos = Data + 4;
+	if (ReadWord() != VDIDRAW_REC_VERSION)
+	{
+		fprintf(stderr, "ERROR: unsupported VDI recording version!\n");
+		return 1;
+	}
+	VDIWidth = ReadWord();
+	VDIHeight = ReadWord();
+	VDIPlanes = ReadWord();
+	size = VDIWidth * VDIHeight * VDIPlanes / 8;
+	STMemory_WriteLong(0x44e, ADDR_SCREEN);
+
+	start = clock();
+	for (i = 0; i < loops; i++)
+	{
+		VDIDraw_Reset();
+		calls = Replay(&native);
+	}
+	end = clock();
+	secs = (double)(end - start) / CLOCKS_PER_SEC;
+
+	/* FNV-1a hash of the screen */
+	checksum = 2166136261u;
+	for (offset = 0; offset < size; offset++)
+		checksum = (checksum ^ STRam[ADDR_SCREEN + offset]) * 16777619u;
+
+	printf("%dx%dx%d screen, %d drawing calls, %d (%d%%) done natively\n",
+	       VDIWidth, VDIHeight, VDIPlanes, calls, native,
+	       calls ? 100 * native / calls : 0);
+	printf("%d replays took %.3f secs", loops, secs);
+	if (secs > 0)
+		printf(", %.0f calls/sec", loops * calls / secs);
+	printf("\nscreen checksum: 0x%08x\n", checksum);
+	free(Data);
+	return 0;
+}
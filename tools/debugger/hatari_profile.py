@@ -28,6 +28,9 @@ Tool output will contain at least:
 If profile data contains other information (e.g. cache misses),
 that is also shown.
 
+If the profiled program marked named profiling regions through
+the NF_PROFILE native feature, -s option shows also their costs.
+
 Provided symbol information should be in same format as for Hatari
 debugger 'symbols' command.  Note that files containing absolute
 addresses and ones containing relatives addresses need to be given
@@ -891,6 +894,10 @@ class EmulatorProfile(Output):
         # <symbol/objectfile name>: (in disassembly)
         # _biostrap:
         self.r_function = re.compile("^([-_.a-zA-Z0-9]+):$")
+        # named profiling regions, after caller information:
+        # region <name>: <entries> (<field1>, <field2>...)
+        self.r_region = re.compile("^region (.+): ([0-9]+) \((.*)\)$")
+        self.regions = None		# list of (name, costs) tuples
 
         self.stats = None		# InstructionStats instance
         self.callgrind = None		# ProfileCallgrind instance
@@ -1063,6 +1070,25 @@ class EmulatorProfile(Output):
         self._change_function(function, None, 0)
         return line
 
+    def _parse_regions(self, fobj, line):
+        "parse named profiling region costs"
+        self.regions = []
+        while line:
+            self.linenro += 1
+            line = line.strip()
+            if not line.startswith('#'):
+                match = self.r_region.match(line)
+                if not match:
+                    break
+                name, entries, costs = match.groups()
+                # entries go to the calls field
+                costs = [int(entries)] + [int(x) for x in costs.split(',')]
+                if len(costs) != self.stats.items:
+                    self.error_exit("invalid number of region fields on line %d:\n\t'%s'" % (self.linenro, line))
+                self.regions.append((name, costs))
+            line = fobj.readline()
+        return line
+
     def parse_profile(self, fobj, fname):
         "parse profile data"
         self.profile = {}
@@ -1076,6 +1102,8 @@ class EmulatorProfile(Output):
         line = self._parse_disassembly(fobj, line)
         # caller information
         line, self.linenro = self.callers.parse_callers(fobj, self.linenro, line)
+        # named profiling regions
+        line = self._parse_regions(fobj, line)
         # unrecognized lines
         if line:
             self.error_exit("unrecognized line %d:\n\t'%s'" % (self.linenro, line))
@@ -1288,6 +1316,26 @@ class ProfileStats(ProfileOutput):
             info = (stats.max_val[i], name, addr, stats.max_line[i])
             self.write("- max = %d,%s at 0x%x, on line %d\n" % info)
             self.write("- %d in total\n" % stats.totals[i])
+        if profobj.regions:
+            self.output_regions(profobj)
+
+    def output_regions(self, profobj):
+        "output named profiling region costs"
+        stats = profobj.stats
+        self.write("\nProfiling regions:\n")
+        for name, costs in profobj.regions:
+            self.write("%s:\n" % name)
+            for i in range(stats.items):
+                if i == stats.callcount_field:
+                    self.write("- %d entries\n" % costs[i])
+                    continue
+                if stats.totals[i]:
+                    info = " (%.2f%%)" % (100.0 * costs[i] / stats.totals[i])
+                else:
+                    info = ""
+                if i == stats.cycles_field:
+                    info += ", %.5fs" % stats.get_time(costs)
+                self.write("- %s = %d%s\n" % (stats.names[i], costs[i], info))
 
     def do_output(self, profobj):
         "output enabled lists"
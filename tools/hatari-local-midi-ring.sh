@@ -12,36 +12,20 @@ count=$1
 shift
 args=$*
 
-# open fifos
-for i in $(seq $count); do
-	mkfifo midi$i
-done
-
 # show full path
 hatari=$(which hatari)
 
-# run MIDI ring Hatari instances
-catpids=""
-for i in $(seq $(($count-1))); do
-	next=$(($i+1))
-	echo $hatari --midi-in midi$i --midi-out midi$next $args &
-	hatari --midi-in midi$i --midi-out midi$next $args &
-	# Without this Hataris would deadlock as fifos
-	# block the process until both ends are opened.
-	# Hatari opens midi output first (for writing),
-	# so this needs to read it.
-	cat midi$next >/dev/null &
-	catpids="$catpids $!"
-done
-# and join the beginning and end of the MIDI ring
-echo $hatari --midi-in midi$count --midi-out midi1 $args &
-hatari --midi-in midi$count --midi-out midi1 $args &
-cat midi1 >/dev/null &
-catpids="$catpids $!"
-
-# after connections are open, fifo files can be removed
-sleep 2
+# run MIDI ring Hatari instances, linked with Unix sockets.
+#
+# Whichever of the two instances using the same socket starts
+# first, creates it and waits for the other one to connect.
+# Sockets are removed when the instance which created them exits.
 for i in $(seq $count); do
-	rm midi$i
+	next=$(($i % $count + 1))
+	echo $hatari --midi-in unix:midi$i --midi-out unix:midi$next $args &
+	$hatari --midi-in unix:midi$i --midi-out unix:midi$next $args &
+	# give the instance time to create its sockets,
+	# so that the next one connects to them
+	sleep 1
 done
-kill -9 $catpids
+wait
@@ -0,0 +1,211 @@
+#!/usr/bin/env python
+#
+# Client for the Hatari binary remote control protocol.
+#
+# Can be used on Hatari control socket connection created
+# e.g. with hconsole.py Hatari class:
+#	import hconsole, hremote
+#	hatari = hconsole.Hatari(["--machine", "ste"])
+#	remote = hremote.Remote(hatari.control)
+#	remote.run_vbls(100)
+#	print(remote.read_mem(0x4ba, 4))
+#
+# Requests can be pipelined by giving wait=False to the methods,
+# and then fetching all the results at once with collect():
+#	for addr in range(0x10000, 0x20000, 0x1000):
+#		remote.read_mem(addr, 16, wait=False)
+#	results = remote.collect()
+#
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+import struct
+
+VERSION = 1
+
+# request opcodes
+INFO = 1
+MEM_READ = 2
+MEM_WRITE = 3
+IO_READ = 4
+IO_WRITE = 5
+REGS_READ = 6
+REGS_WRITE = 7
+RUN_CYCLES = 8
+RUN_VBLS = 9
+RUN_BREAK = 10
+PAUSE = 11
+SCREENSHOT = 12
+DEBUG = 13
+SCREEN_HASH = 14
+
+# reply status values
+STATUS = ("OK", "unknown opcode", "invalid arguments",
+          "invalid address", "operation failed")
+
+# why emulation stopped
+STOP = (None, "cycles", "vbls", "pause", "debugger")
+
+# register numbers for REGS_WRITE
+REGS = ("d0", "d1", "d2", "d3", "d4", "d5", "d6", "d7",
+        "a0", "a1", "a2", "a3", "a4", "a5", "a6", "a7", "pc", "sr")
+
+
+class RemoteError(Exception):
+    pass
+
+
+class Remote:
+    "Hatari binary remote control protocol client"
+
+    def __init__(self, sock):
+        self.sock = sock
+        self.seq = 0
+        self.queued = []
+        self.pending = []
+        sock.sendall(b"hatari-binary\n")
+        magic, version = struct.unpack(">4sI", self._recv(8))
+        if magic != b"HBIN" or version != VERSION:
+            raise RemoteError("unsupported Hatari binary protocol (%s v%d)" % (magic, version))
+
+    def _recv(self, size):
+        data = b""
+        while len(data) < size:
+            chunk = self.sock.recv(size - len(data))
+            if not chunk:
+                raise RemoteError("Hatari closed the connection")
+            data += chunk
+        return data
+
+    def _call(self, opcode, payload, decode, wait):
+        self.seq = (self.seq + 1) & 0xffff
+        self.queued.append(struct.pack(">BBHI", opcode, 0, self.seq, len(payload)) + payload)
+        self.pending.append((opcode, self.seq, decode))
+        if wait:
+            return self.collect()[-1]
+        return None
+
+    def send(self):
+        "send queued requests without waiting for their replies"
+        if self.queued:
+            self.sock.sendall(b"".join(self.queued))
+            self.queued = []
+
+    def collect(self):
+        "send queued requests, return list of results for all pending ones"
+        self.send()
+        pending, self.pending = self.pending, []
+        results = []
+        error = None
+        for opcode, seq, decode in pending:
+            rop, status, rseq, size = struct.unpack(">BBHI", self._recv(8))
+            data = self._recv(size)
+            if rop != opcode or rseq != seq:
+                raise RemoteError("reply %d/%d for request %d/%d" % (rop, rseq, opcode, seq))
+            if status:
+                # read rest of the replies before raising the error
+                if not error:
+                    if status < len(STATUS):
+                        error = "request %d failed: %s" % (opcode, STATUS[status])
+                    else:
+                        error = "request %d failed: %d" % (opcode, status)
+                results.append(None)
+            else:
+                results.append(decode(data))
+        if error:
+            raise RemoteError(error)
+        return results
+
+    # decoders
+    def _none(self, data):
+        return None
+
+    def _raw(self, data):
+        return data
+
+    def _stop(self, data):
+        stop, reason, pc, chi, clo, vbls = struct.unpack(">BBxxIIII", data)
+        return {"stop": STOP[stop], "reason": reason, "pc": pc,
+                "cycles": (chi << 32) | clo, "vbls": vbls}
+
+    # requests
+    def info(self, wait=True):
+        "return dict of protocol version, machine type, RAM size, cycles and VBLs"
+        def decode(data):
+            version, machine, ram, chi, clo, vbls = struct.unpack(">6I", data)
+            return {"version": version, "machine": machine, "ram": ram,
+                    "cycles": (chi << 32) | clo, "vbls": vbls}
+        return self._call(INFO, b"", decode, wait)
+
+    def read_mem(self, addr, size, wait=True):
+        "return bytes from RAM, ROM or (without side-effects) IO memory"
+        return self._call(MEM_READ, struct.pack(">II", addr, size), self._raw, wait)
+
+    def write_mem(self, addr, data, wait=True):
+        "write given bytes to RAM"
+        return self._call(MEM_WRITE, struct.pack(">I", addr) + data, self._none, wait)
+
+    def read_io(self, addr, width=2, count=1, wait=True):
+        "return list of IO register values read through their handlers"
+        fmt = {1: "B", 2: "H", 4: "I"}[width]
+        def decode(data):
+            return list(struct.unpack(">%d%s" % (count, fmt), data))
+        return self._call(IO_READ, struct.pack(">IHH", addr, width, count), decode, wait)
+
+    def write_io(self, addr, values, width=2, wait=True):
+        "write given list of values to IO registers through their handlers"
+        fmt = {1: "B", 2: "H", 4: "I"}[width]
+        payload = struct.pack(">IHH%d%s" % (len(values), fmt), addr, width, len(values), *values)
+        return self._call(IO_WRITE, payload, self._none, wait)
+
+    def regs(self, wait=True):
+        "return dict of CPU register values"
+        def decode(data):
+            return dict(zip(REGS, struct.unpack(">18I", data)))
+        return self._call(REGS_READ, b"", decode, wait)
+
+    def set_regs(self, values, wait=True):
+        "set CPU registers from given name:value dict"
+        payload = b"".join([struct.pack(">HI", REGS.index(name.lower()), value & 0xffffffff)
+                            for name, value in values.items()])
+        return self._call(REGS_WRITE, payload, self._none, wait)
+
+    def run_cycles(self, cycles, wait=True):
+        "run emulation for given number of cycles, return stop info dict"
+        return self._call(RUN_CYCLES, struct.pack(">I", cycles), self._stop, wait)
+
+    def run_vbls(self, vbls, wait=True):
+        "run emulation for given number of VBLs, return stop info dict"
+        return self._call(RUN_VBLS, struct.pack(">I", vbls), self._stop, wait)
+
+    def run_break(self, wait=True):
+        "run emulation until debugger is invoked e.g. by a breakpoint"
+        return self._call(RUN_BREAK, b"", self._stop, wait)
+
+    def pause(self, wait=True):
+        "stop emulation started with wait=False run request"
+        return self._call(PAUSE, b"", self._none, wait)
+
+    def screenshot(self, wait=True):
+        "return (width, height, RGB bytes) tuple of Hatari screen"
+        def decode(data):
+            width, height = struct.unpack(">HH", data[:4])
+            return (width, height, data[4:])
+        return self._call(SCREENSHOT, b"", decode, wait)
+
+    def debug(self, command, wait=True):
+        "execute given debugger command, e.g. for setting breakpoints"
+        return self._call(DEBUG, command.encode("ASCII"), self._none, wait)
+
+    def screen_hash(self, wait=True):
+        "return (hash, VBL) tuple of emulated screen contents, hashing starts on first request"
+        def decode(data):
+            return struct.unpack(">II", data)
+        return self._call(SCREEN_HASH, b"", decode, wait)